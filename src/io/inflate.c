@@ -0,0 +1,504 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "stream.h"
+#include "inflate.h"
+
+#define INFLATEI_HEADER		0
+#define INFLATEI_STORED		1
+#define INFLATEI_CODES		2
+#define INFLATEI_MATCH		3
+#define INFLATEI_DONE		4
+#define INFLATEI_ERROR		5
+
+// Zero bytes that a refill can read past the end of good data.
+#define INFLATEI_MAX_OVERRUN	4
+
+// ===========================================================================
+// Tables (RFC 1951, 3.2.5 to 3.2.7)
+// ===========================================================================
+
+static const uint16_t LENGTH_BASE[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t LENGTH_EXTRA[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t DISTANCE_BASE[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t DISTANCE_EXTRA[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static const uint8_t CODELENGTH_ORDER[19] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+// CRC-32 of each byte value (IEEE 802.3 polynomial, reflected), as used by zip and gzip.
+static const uint32_t CRC32_TABLE[256] = {
+	0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F, 0xE963A535, 0x9E6495A3,
+	0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988, 0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91,
+	0x1DB71064, 0x6AB020F2, 0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+	0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9, 0xFA0F3D63, 0x8D080DF5,
+	0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172, 0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B,
+	0x35B5A8FA, 0x42B2986C, 0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+	0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423, 0xCFBA9599, 0xB8BDA50F,
+	0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924, 0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D,
+	0x76DC4190, 0x01DB7106, 0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+	0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D, 0x91646C97, 0xE6635C01,
+	0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E, 0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457,
+	0x65B0D9C6, 0x12B7E950, 0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+	0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7, 0xA4D1C46D, 0xD3D6F4FB,
+	0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0, 0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9,
+	0x5005713C, 0x270241AA, 0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+	0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81, 0xB7BD5C3B, 0xC0BA6CAD,
+	0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A, 0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683,
+	0xE3630B12, 0x94643B84, 0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+	0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB, 0x196C3671, 0x6E6B06E7,
+	0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC, 0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5,
+	0xD6D6A3E8, 0xA1D1937E, 0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+	0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55, 0x316E8EEF, 0x4669BE79,
+	0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236, 0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F,
+	0xC5BA3BBE, 0xB2BD0B28, 0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+	0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F, 0x72076785, 0x05005713,
+	0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38, 0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21,
+	0x86D3D2D4, 0xF1D4E242, 0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+	0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69, 0x616BFFD3, 0x166CCF45,
+	0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2, 0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB,
+	0xAED16A4A, 0xD9D65ADC, 0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+	0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693, 0x54DE5729, 0x23D967BF,
+	0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94, 0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
+};
+
+// ===========================================================================
+// Private Functions
+// ===========================================================================
+
+static int inflatei_reverse(int code, int bits)
+{
+	code = ((code & 0xAAAA) >> 1) | ((code & 0x5555) << 1);
+	code = ((code & 0xCCCC) >> 2) | ((code & 0x3333) << 2);
+	code = ((code & 0xF0F0) >> 4) | ((code & 0x0F0F) << 4);
+	code = ((code & 0xFF00) >> 8) | ((code & 0x00FF) << 8);
+	return code >> (16 - bits);
+}
+
+// Gets the next byte from the source, starting a new span if need be. Past the end, this is zero.
+static int inflatei_next_byte(inflate_t *inflate)
+{
+	const unsigned char *span;
+	int n, c;
+
+	if (inflate->in < inflate->in_end)
+		return *(inflate->in++);
+
+	if ((n = STREAM_Peek(inflate->source, &span)) > 0)
+	{
+		STREAM_Advance(inflate->source, n);
+		inflate->in = span + 1;
+		inflate->in_end = span + n;
+		return span[0];
+	}
+	// no span - a byte at a time.
+	if (n == 0 && (c = STREAM_GetChar(inflate->source)) != EOF)
+		return c;
+
+	inflate->overrun++;
+	return 0;
+}
+
+static void inflatei_refill(inflate_t *inflate)
+{
+	while (inflate->bitcount <= 24)
+	{
+		inflate->bits |= (uint32_t)inflatei_next_byte(inflate) << inflate->bitcount;
+		inflate->bitcount += 8;
+	}
+}
+
+static int inflatei_bits(inflate_t *inflate, int count)
+{
+	int out;
+	if (inflate->bitcount < count)
+		inflatei_refill(inflate);
+	out = inflate->bits & ((1 << count) - 1);
+	inflate->bits >>= count;
+	inflate->bitcount -= count;
+	return out;
+}
+
+// Builds a decoding table from code lengths. Returns nonzero if the lengths make a bad code.
+static int inflatei_build(inflate_huffman_t *huffman, const uint8_t *sizes, int count)
+{
+	int i, j, code = 0, k = 0;
+	int counts[16], next[16];
+
+	memset(counts, 0, sizeof(counts));
+	memset(huffman->fast, 0, sizeof(huffman->fast));
+	for (i = 0; i < count; i++)
+		counts[sizes[i]]++;
+	counts[0] = 0;
+
+	for (i = 1; i < 16; i++)
+	{
+		next[i] = code;
+		huffman->firstcode[i] = code;
+		huffman->firstsymbol[i] = k;
+		code += counts[i];
+		// over-subscribed.
+		if (counts[i] && code - 1 >= (1 << i))
+			return 1;
+		huffman->maxcode[i] = code << (16 - i);
+		code <<= 1;
+		k += counts[i];
+	}
+	huffman->maxcode[16] = 0x10000;
+
+	for (i = 0; i < count; i++)
+	{
+		int s = sizes[i];
+		if (!s)
+			continue;
+		k = next[s] - huffman->firstcode[s] + huffman->firstsymbol[s];
+		huffman->size[k] = s;
+		huffman->value[k] = i;
+		if (s <= INFLATE_FAST_BITS)
+		{
+			// every index that starts with this code.
+			for (j = inflatei_reverse(next[s], s); j < (1 << INFLATE_FAST_BITS); j += (1 << s))
+				huffman->fast[j] = (uint16_t)((s << 9) | i);
+		}
+		next[s]++;
+	}
+	return 0;
+}
+
+// Decodes a symbol. Returns -1 if the bits are not a code.
+static int inflatei_decode(inflate_t *inflate, inflate_huffman_t *huffman)
+{
+	int b, s, k;
+
+	if (inflate->bitcount < 16)
+		inflatei_refill(inflate);
+
+	if ((b = huffman->fast[inflate->bits & ((1 << INFLATE_FAST_BITS) - 1)]))
+	{
+		s = b >> 9;
+		inflate->bits >>= s;
+		inflate->bitcount -= s;
+		return b & 0x1FF;
+	}
+
+	// longer code - find its length.
+	k = inflatei_reverse(inflate->bits & 0xFFFF, 16);
+	for (s = INFLATE_FAST_BITS + 1; k >= huffman->maxcode[s]; s++) ;
+	if (s >= 16)
+		return -1;
+	b = (k >> (16 - s)) - huffman->firstcode[s] + huffman->firstsymbol[s];
+	if (b >= 288 || huffman->size[b] != s)
+		return -1;
+	inflate->bits >>= s;
+	inflate->bitcount -= s;
+	return huffman->value[b];
+}
+
+static int inflatei_fixed(inflate_t *inflate)
+{
+	uint8_t sizes[288];
+	memset(sizes, 8, 144);
+	memset(sizes + 144, 9, 112);
+	memset(sizes + 256, 7, 24);
+	memset(sizes + 280, 8, 8);
+	if (inflatei_build(&(inflate->lengths), sizes, 288))
+		return 1;
+	memset(sizes, 5, 30);
+	return inflatei_build(&(inflate->distances), sizes, 30);
+}
+
+static int inflatei_dynamic(inflate_t *inflate)
+{
+	inflate_huffman_t codelengths;
+	uint8_t sizes[286 + 30];
+	uint8_t lengthsizes[19];
+	int i, n, c, repeat, fill;
+	int hlit = inflatei_bits(inflate, 5) + 257;
+	int hdist = inflatei_bits(inflate, 5) + 1;
+	int hclen = inflatei_bits(inflate, 4) + 4;
+
+	if (hlit > 286 || hdist > 30)
+		return 1;
+
+	memset(lengthsizes, 0, sizeof(lengthsizes));
+	for (i = 0; i < hclen; i++)
+		lengthsizes[CODELENGTH_ORDER[i]] = inflatei_bits(inflate, 3);
+	if (inflatei_build(&codelengths, lengthsizes, 19))
+		return 1;
+
+	n = 0;
+	while (n < hlit + hdist)
+	{
+		if ((c = inflatei_decode(inflate, &codelengths)) < 0)
+			return 1;
+		if (c < 16)
+		{
+			sizes[n++] = c;
+			continue;
+		}
+
+		if (c == 16)
+		{
+			if (!n)
+				return 1;
+			fill = sizes[n - 1];
+			repeat = inflatei_bits(inflate, 2) + 3;
+		}
+		else if (c == 17)
+		{
+			fill = 0;
+			repeat = inflatei_bits(inflate, 3) + 3;
+		}
+		else
+		{
+			fill = 0;
+			repeat = inflatei_bits(inflate, 7) + 11;
+		}
+
+		if (n + repeat > hlit + hdist)
+			return 1;
+		memset(sizes + n, fill, repeat);
+		n += repeat;
+	}
+
+	// no end of block code.
+	if (!sizes[256])
+		return 1;
+	if (inflatei_build(&(inflate->lengths), sizes, hlit))
+		return 1;
+	return inflatei_build(&(inflate->distances), sizes + hlit, hdist);
+}
+
+// Reads a block header. Returns nonzero if bad.
+static int inflatei_header(inflate_t *inflate)
+{
+	int len, nlen;
+
+	if (inflate->final)
+	{
+		inflate->state = INFLATEI_DONE;
+		return 0;
+	}
+
+	inflate->final = inflatei_bits(inflate, 1);
+	switch (inflatei_bits(inflate, 2))
+	{
+		case 0:
+			// to the byte boundary.
+			inflatei_bits(inflate, inflate->bitcount & 7);
+			len = inflatei_bits(inflate, 16);
+			nlen = inflatei_bits(inflate, 16);
+			if (len != (~nlen & 0xFFFF))
+				return 1;
+			inflate->remaining = len;
+			inflate->state = INFLATEI_STORED;
+			return 0;
+		case 1:
+			inflate->state = INFLATEI_CODES;
+			return inflatei_fixed(inflate);
+		case 2:
+			inflate->state = INFLATEI_CODES;
+			return inflatei_dynamic(inflate);
+		default:
+			return 1;
+	}
+}
+
+// Copies stored bytes. Returns the new position.
+static int inflatei_stored(inflate_t *inflate, unsigned char *out, int pos, int end)
+{
+	int amount;
+
+	// whole bytes already read into the bit buffer go first.
+	while (inflate->remaining && pos < end && inflate->bitcount >= 8)
+	{
+		out[pos++] = inflate->bits & 0xFF;
+		inflate->bits >>= 8;
+		inflate->bitcount -= 8;
+		inflate->remaining--;
+	}
+
+	while (inflate->remaining && pos < end)
+	{
+		if (inflate->in < inflate->in_end)
+		{
+			amount = inflate->remaining < end - pos ? inflate->remaining : end - pos;
+			if (amount > inflate->in_end - inflate->in)
+				amount = inflate->in_end - inflate->in;
+			memcpy(out + pos, inflate->in, amount);
+			inflate->in += amount;
+			pos += amount;
+			inflate->remaining -= amount;
+		}
+		else
+		{
+			out[pos++] = inflatei_next_byte(inflate);
+			inflate->remaining--;
+		}
+	}
+
+	if (!inflate->remaining)
+		inflate->state = INFLATEI_HEADER;
+	return pos;
+}
+
+// Copies match bytes. Returns the new position.
+static int inflatei_copy(inflate_t *inflate, unsigned char *out, int pos, int end)
+{
+	int amount = inflate->remaining < end - pos ? inflate->remaining : end - pos;
+	unsigned char *dest = out + pos;
+	unsigned char *src = dest - inflate->distance;
+
+	inflate->remaining -= amount;
+	pos += amount;
+	if (inflate->distance >= amount)
+		memcpy(dest, src, amount);
+	// overlapping - repeats the last bytes.
+	else while (amount--)
+		*(dest++) = *(src++);
+
+	inflate->state = inflate->remaining ? INFLATEI_MATCH : INFLATEI_CODES;
+	return pos;
+}
+
+// Decodes literals and matches until the end of the block or buffer. Returns the new position, or -1 if bad.
+static int inflatei_codes(inflate_t *inflate, unsigned char *out, int pos, int end)
+{
+	int symbol, d;
+
+	while (pos < end)
+	{
+		if ((symbol = inflatei_decode(inflate, &(inflate->lengths))) < 0)
+			return -1;
+
+		if (symbol < 256)
+		{
+			out[pos++] = symbol;
+			continue;
+		}
+
+		if (symbol == 256)
+		{
+			inflate->state = INFLATEI_HEADER;
+			return pos;
+		}
+
+		if ((symbol -= 257) >= 29)
+			return -1;
+		inflate->remaining = LENGTH_BASE[symbol] + inflatei_bits(inflate, LENGTH_EXTRA[symbol]);
+
+		if ((d = inflatei_decode(inflate, &(inflate->distances))) < 0 || d >= 30)
+			return -1;
+		inflate->distance = DISTANCE_BASE[d] + inflatei_bits(inflate, DISTANCE_EXTRA[d]);
+		// reaches back before the history.
+		if (inflate->distance > pos)
+			return -1;
+
+		pos = inflatei_copy(inflate, out, pos, end);
+		if (inflate->state == INFLATEI_MATCH)
+			return pos;
+	}
+
+	return pos;
+}
+
+// ===========================================================================
+// Public Functions
+// ===========================================================================
+
+// ---------------------------------------------------------------
+// void INFLATE_Init(inflate_t *inflate, stream_t *source)
+// See inflate.h
+// ---------------------------------------------------------------
+void INFLATE_Init(inflate_t *inflate, stream_t *source)
+{
+	inflate->source = source;
+	inflate->in = NULL;
+	inflate->in_end = NULL;
+	inflate->overrun = 0;
+	inflate->bits = 0;
+	inflate->bitcount = 0;
+	inflate->state = INFLATEI_HEADER;
+	inflate->final = 0;
+	inflate->remaining = 0;
+	inflate->distance = 0;
+}
+
+// ---------------------------------------------------------------
+// int INFLATE_Decode(inflate_t *inflate, unsigned char *out, int pos, int end)
+// See inflate.h
+// ---------------------------------------------------------------
+int INFLATE_Decode(inflate_t *inflate, unsigned char *out, int pos, int end)
+{
+	int start = pos;
+
+	while (pos < end && inflate->state != INFLATEI_DONE)
+	{
+		switch (inflate->state)
+		{
+			case INFLATEI_HEADER:
+				if (inflatei_header(inflate))
+					pos = -1;
+				break;
+			case INFLATEI_STORED:
+				pos = inflatei_stored(inflate, out, pos, end);
+				break;
+			case INFLATEI_CODES:
+				pos = inflatei_codes(inflate, out, pos, end);
+				break;
+			case INFLATEI_MATCH:
+				pos = inflatei_copy(inflate, out, pos, end);
+				break;
+			case INFLATEI_ERROR:
+				return -1;
+		}
+
+		// bad codes, or the data ended early.
+		if (pos < 0 || inflate->overrun > INFLATEI_MAX_OVERRUN)
+		{
+			inflate->state = INFLATEI_ERROR;
+			return -1;
+		}
+	}
+
+	// the end of the last block.
+	if (inflate->state == INFLATEI_HEADER && inflate->final)
+		inflate->state = INFLATEI_DONE;
+
+	return pos - start;
+}
+
+// ---------------------------------------------------------------
+// uint32_t INFLATE_CRC32(uint32_t crc, const unsigned char *data, size_t length)
+// See inflate.h
+// ---------------------------------------------------------------
+uint32_t INFLATE_CRC32(uint32_t crc, const unsigned char *data, size_t length)
+{
+	crc = ~crc;
+	while (length--)
+		crc = CRC32_TABLE[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
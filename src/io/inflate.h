@@ -0,0 +1,104 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#ifndef __INFLATE_H__
+#define __INFLATE_H__
+
+#include <stdint.h>
+#include "stream.h"
+
+/** Size of the DEFLATE history window in bytes - the furthest back that a match can reach. */
+#define INFLATE_WINDOW_SIZE		32768
+
+/** Bits of code looked up at once in a Huffman table. Longer codes are decoded a bit length at a time. */
+#define INFLATE_FAST_BITS		9
+
+/**
+ * Huffman decoding table.
+ */
+typedef struct {
+
+	/** Codes up to INFLATE_FAST_BITS long, by their (reversed) bits: (length << 9) | symbol, or 0 if longer. */
+	uint16_t fast[1 << INFLATE_FAST_BITS];
+	/** First canonical code of each bit length. */
+	uint16_t firstcode[16];
+	/** One past the last code of each bit length, shifted up to 16 bits. */
+	int maxcode[17];
+	/** Index of the first symbol of each bit length in the sorted lists. */
+	uint16_t firstsymbol[16];
+	/** Code length of each sorted symbol. */
+	uint8_t size[288];
+	/** Each sorted symbol. */
+	uint16_t value[288];
+
+} inflate_huffman_t;
+
+/**
+ * Decoder state for raw DEFLATE data (RFC 1951).
+ */
+typedef struct {
+
+	/** The compressed data. */
+	stream_t *source;
+	/** Unread bytes of the source's current span. */
+	const unsigned char *in;
+	/** End of the source's current span. */
+	const unsigned char *in_end;
+	/** Bytes of zeros read past the end of the source. */
+	int overrun;
+
+	/** Bits read, but not used yet (lowest first). */
+	uint32_t bits;
+	/** Amount of bits in bits. */
+	int bitcount;
+
+	/** Decoding state. */
+	int state;
+	/** If nonzero, the current block is the last. */
+	int final;
+	/** Bytes left in the current stored block, or in the current match. */
+	int remaining;
+	/** Distance of the current match. */
+	int distance;
+
+	/** Literal/length table of the current block. */
+	inflate_huffman_t lengths;
+	/** Distance table of the current block. */
+	inflate_huffman_t distances;
+
+} inflate_t;
+
+/**
+ * Sets up a decoder for raw DEFLATE data (no zlib or gzip header).
+ * @param inflate the decoder.
+ * @param source the stream to read the compressed data from.
+ */
+void INFLATE_Init(inflate_t *inflate, stream_t *source);
+
+/**
+ * Decodes bytes into a buffer.
+ * Everything before the starting position is the history that matches copy from, so it must hold
+ * the last INFLATE_WINDOW_SIZE bytes decoded (or all of them, if fewer).
+ * @param inflate the decoder.
+ * @param out the output buffer.
+ * @param pos the position in the buffer to decode to.
+ * @param end the end of the buffer.
+ * @return the amount of bytes decoded, 0 if there is no more data, or -1 if the data is bad.
+ */
+int INFLATE_Decode(inflate_t *inflate, unsigned char *out, int pos, int end);
+
+/**
+ * Continues a CRC-32 (as used by zip archives) over more bytes.
+ * @param crc the CRC-32 of the bytes before (0 to start).
+ * @param data the bytes.
+ * @param length the amount of bytes.
+ * @return the CRC-32 of all of the bytes so far.
+ */
+uint32_t INFLATE_CRC32(uint32_t crc, const unsigned char *data, size_t length);
+
+#endif
@@ -9,8 +9,22 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdarg.h>
+#include <limits.h>
+#include <errno.h>
+#include <pthread.h>
 #include "stream_config.h"
 #include "stream.h"
+#include "inflate.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #ifndef min
 #define min(x,y) ((x) < (y) ? (x) : (y))
@@ -32,6 +46,21 @@ static stream_t* STREAM_Init()
 	out->file = NULL;
 	out->file_origin_pos = -1;
 	out->file_opened = 0;
+	out->file_positional = 0;
+	out->file_readahead = NULL;
+
+	out->fd = -1;
+
+	out->extents = NULL;
+	out->extent_count = 0;
+	out->extent_index = 0;
+	out->extent_pos = 0;
+	out->extent_memory = NULL;
+
+	out->inflate = NULL;
+
+	out->map_base = NULL;
+	out->map_length = 0;
 	
 	out->buffer = NULL;
 	out->buffer_length = -1;
@@ -40,10 +69,31 @@ static stream_t* STREAM_Init()
 
 	out->pos = 0;
 	out->length = STREAM_NO_LENGTH;
+	out->error = 0;
+
+	out->crc_check = 0;
+	out->crc_expected = 0;
+	out->crc = 0;
+	out->crc_span = NULL;
 	
 	return out;
 }
 
+// Adds bytes read from a stream to its CRC-32, and checks it after the last byte.
+static void STREAM_CRCUpdate(stream_t *stream, const unsigned char *data, size_t length)
+{
+	stream->crc = INFLATE_CRC32(stream->crc, data, length);
+	if (stream->pos >= stream->length && stream->crc != stream->crc_expected)
+		stream->error = 1;
+}
+
+// Checks a stream with a CRC-32 that ran out of bytes: it is an error if that is before its length.
+static void STREAM_CRCEnded(stream_t *stream)
+{
+	if (stream->pos < stream->length)
+		stream->error = 1;
+}
+
 static int STREAM_AllocateBuffer(stream_t *stream, size_t length)
 {
 	stream->buffer = (unsigned char *)STREAM_MALLOC(sizeof(unsigned char) * length);
@@ -65,6 +115,12 @@ static char* STREAM_TypeName(stream_type_t type)
 	{
 		case STREAMI_FILE: return "File";
 		case STREAMI_BUFFER: return "Buffer";
+		case STREAMI_MMAP: return "Mapped";
+		case STREAMI_OUT_FILE: return "Output File";
+		case STREAMI_OUT_FD: return "Output Descriptor";
+		case STREAMI_OUT_BUFFER: return "Output Buffer";
+		case STREAMI_EXTENTS: return "Extents";
+		case STREAMI_INFLATE: return "Inflate";
 		case STREAMI_UNKNOWN: return "!UNKNOWN!";
 	}
 	
@@ -81,6 +137,10 @@ typedef struct {
 	int    (*reset)(stream_t*);
 	int    (*get_char)(stream_t*);
 	int    (*read_data)(stream_t*, void*, size_t, size_t);
+	int    (*peek)(stream_t*, const unsigned char**);
+	void   (*advance)(stream_t*, int);
+	int    (*write_data)(stream_t*, const void*, size_t);
+	int    (*flush)(stream_t*);
 	
 } streamfuncs_t;
 
@@ -89,10 +149,45 @@ typedef struct {
 // STREAMI_FILE
 // ===========================================================================
 
+// Read-ahead state of a buffered file stream.
+typedef struct {
+
+	/** The stream. */
+	stream_t *stream;
+	/** Thread that fills the buffer. */
+	pthread_t thread;
+	/** Guards everything below. */
+	pthread_mutex_t mutex;
+	/** Signalled when the buffer is filled or swapped out, or the thread must stop. */
+	pthread_cond_t cond;
+
+	/** Buffer being filled (belongs to the thread while not ready). */
+	unsigned char *buffer;
+	/** Amount of bytes filled - 0 at the end of the stream. */
+	size_t content_length;
+	/** Stream position of the next fill. */
+	size_t next;
+	/** If nonzero, the buffer is filled and can be swapped in. */
+	int ready;
+	/** If nonzero, the thread must stop. */
+	int stop;
+
+} streami_readahead_t;
+
+static void streami_readahead_stop(streami_readahead_t *ra);
+static void streami_readahead_free(streami_readahead_t *ra);
+
 static int streami_file_destroy(stream_t *stream)
 {
+	if (stream->file_readahead)
+	{
+		streami_readahead_stop((streami_readahead_t*)stream->file_readahead);
+		streami_readahead_free((streami_readahead_t*)stream->file_readahead);
+		stream->file_readahead = NULL;
+	}
+
 	if (stream->file_opened)
-		if (!fclose(stream->file))
+		if (fclose(stream->file))
 			return 1;
 		
 	if (stream->buffer)
@@ -101,29 +196,163 @@ static int streami_file_destroy(stream_t *stream)
 	return 0;
 }
 
+static int streami_readahead_start(stream_t *stream);
+
 static int streami_file_reset(stream_t *stream)
 {
-	if (fseek(stream->file, stream->file_origin_pos, SEEK_SET))
+	streami_readahead_t *ra = (streami_readahead_t*)stream->file_readahead;
+	if (ra)
+		streami_readahead_stop(ra);
+
+	if (!stream->file_positional && fseek(stream->file, stream->file_origin_pos, SEEK_SET))
+	{
+		if (ra)
+		{
+			streami_readahead_free(ra);
+			stream->file_readahead = NULL;
+		}
 		return 1;
+	}
 
 	if (stream->buffer)
 		stream->buffer_pos = -1;
 	
 	stream->pos = 0;
 
+	if (ra && streami_readahead_start(stream))
+	{
+		// carry on without it.
+		streami_readahead_free(ra);
+		stream->file_readahead = NULL;
+	}
+
 	return 0;
 }
 
+// Reads from a stream position (offset from the origin), leaving the file's position alone.
+static size_t streami_file_read_at(stream_t *stream, void *destination, size_t amount, size_t pos)
+{
+	size_t offset = stream->file_origin_pos + pos;
+#ifdef _WIN32
+	if (fseek(stream->file, offset, SEEK_SET))
+		return 0;
+	return fread(destination, 1, amount, stream->file);
+#else
+	size_t total = 0;
+	int fd = fileno(stream->file);
+	while (total < amount)
+	{
+		ssize_t got = pread(fd, (unsigned char*)destination + total, amount - total, offset + total);
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got <= 0)
+			break;
+		total += got;
+	}
+	return total;
+#endif
+}
+
+// Reads the next buffer's worth of bytes, starting at a stream position.
+static size_t streami_file_read_buffer(stream_t *stream, unsigned char *destination, size_t pos)
+{
+	size_t amount;
+	if (stream->length == STREAM_NO_LENGTH)
+		amount = stream->buffer_length;
+	else
+		amount = min(stream->length - pos, stream->buffer_length);
+
+	if (stream->file_positional)
+		return streami_file_read_at(stream, destination, amount, pos);
+	else
+		return fread(destination, 1, amount, stream->file);
+}
+
+static void* streami_readahead_thread(void *arg)
+{
+	streami_readahead_t *ra = (streami_readahead_t*)arg;
+	size_t buf;
+
+	pthread_mutex_lock(&(ra->mutex));
+	while (!ra->stop)
+	{
+		if (ra->ready)
+		{
+			pthread_cond_wait(&(ra->cond), &(ra->mutex));
+			continue;
+		}
+		pthread_mutex_unlock(&(ra->mutex));
+		buf = streami_file_read_buffer(ra->stream, ra->buffer, ra->next);
+		pthread_mutex_lock(&(ra->mutex));
+		ra->content_length = buf;
+		ra->next += buf;
+		ra->ready = 1;
+		pthread_cond_broadcast(&(ra->cond));
+	}
+	pthread_mutex_unlock(&(ra->mutex));
+	return NULL;
+}
+
+// Starts filling from the stream's position. Returns nonzero if the thread couldn't be created.
+static int streami_readahead_start(stream_t *stream)
+{
+	streami_readahead_t *ra = (streami_readahead_t*)stream->file_readahead;
+	ra->next = stream->pos;
+	ra->ready = 0;
+	ra->stop = 0;
+	return pthread_create(&(ra->thread), NULL, streami_readahead_thread, ra);
+}
+
+static void streami_readahead_stop(streami_readahead_t *ra)
+{
+	pthread_mutex_lock(&(ra->mutex));
+	ra->stop = 1;
+	pthread_cond_broadcast(&(ra->cond));
+	pthread_mutex_unlock(&(ra->mutex));
+	pthread_join(ra->thread, NULL);
+}
+
+static void streami_readahead_free(streami_readahead_t *ra)
+{
+	pthread_cond_destroy(&(ra->cond));
+	pthread_mutex_destroy(&(ra->mutex));
+	STREAM_FREE(ra->buffer);
+	STREAM_FREE(ra);
+}
+
+// Swaps in the buffer filled by the read-ahead thread. Returns 0 at the end of the stream.
+static size_t streami_readahead_swap(stream_t *stream)
+{
+	streami_readahead_t *ra = (streami_readahead_t*)stream->file_readahead;
+	unsigned char *filled;
+	size_t buf;
+
+	pthread_mutex_lock(&(ra->mutex));
+	while (!ra->ready)
+		pthread_cond_wait(&(ra->cond), &(ra->mutex));
+	// stays ready at the end, so the thread stays idle.
+	if ((buf = ra->content_length))
+	{
+		filled = ra->buffer;
+		ra->buffer = stream->buffer;
+		stream->buffer = filled;
+		ra->ready = 0;
+		pthread_cond_broadcast(&(ra->cond));
+	}
+	pthread_mutex_unlock(&(ra->mutex));
+	return buf;
+}
+
 static int streami_file_fill_buffer(stream_t *stream)
 {
 	// fill buffer if at end.
 	if (stream->buffer_pos < 0 || stream->buffer_pos >= stream->buffer_content_length)
 	{
 		size_t buf;
-		if (stream->length == STREAM_NO_LENGTH)
-			buf = fread(stream->buffer, 1, stream->buffer_length, stream->file);
+		if (stream->file_readahead)
+			buf = streami_readahead_swap(stream);
 		else
-			buf = fread(stream->buffer, 1, min(stream->length - stream->pos, stream->buffer_length), stream->file);
+			buf = streami_file_read_buffer(stream, stream->buffer, stream->pos);
 		
 		if (!buf)
 			return EOF;
@@ -196,11 +425,36 @@ static int streami_file_read_data(stream_t *stream, void *destination, size_t si
 	return out;
 }
 
+static int streami_file_peek(stream_t *stream, const unsigned char **ptr)
+{
+	*ptr = NULL;
+	if (stream->length != STREAM_NO_LENGTH && stream->pos >= stream->length)
+		return EOF;
+	// no span without a buffer.
+	if (!stream->buffer)
+		return 0;
+	if (streami_file_fill_buffer(stream) == EOF)
+		return EOF;
+
+	*ptr = &(stream->buffer[stream->buffer_pos]);
+	return stream->buffer_content_length - stream->buffer_pos;
+}
+
+static void streami_file_advance(stream_t *stream, int amount)
+{
+	stream->buffer_pos += amount;
+	stream->pos += amount;
+}
+
 static streamfuncs_t STREAMI_FILE_STREAMFUNCS = {
 	streami_file_destroy,
 	streami_file_reset,
 	streami_file_get_char,
 	streami_file_read_data,
+	streami_file_peek,
+	streami_file_advance,
+	NULL,
+	NULL,
 };
 
 // ===========================================================================
@@ -239,6 +493,7 @@ static int streami_buffer_read_data(stream_t *stream, void *destination, size_t
 		if (stream->buffer_content_length - stream->buffer_pos < size)
 		{
 			memcpy(ptr, &(stream->buffer[stream->buffer_pos]), stream->buffer_content_length - stream->buffer_pos);
+			stream->pos += stream->buffer_content_length - stream->buffer_pos;
 			stream->buffer_pos = stream->buffer_content_length;
 			return out;
 		}
@@ -246,6 +501,8 @@ static int streami_buffer_read_data(stream_t *stream, void *destination, size_t
 		{
 			memcpy(ptr, &(stream->buffer[stream->buffer_pos]), size);
 			stream->buffer_pos += size;
+			stream->pos += size;
+			ptr += size;
 			out++;
 		}
 	}
@@ -253,157 +510,809 @@ static int streami_buffer_read_data(stream_t *stream, void *destination, size_t
 	return out;
 }
 
+static int streami_buffer_peek(stream_t *stream, const unsigned char **ptr)
+{
+	if (stream->buffer_pos >= stream->buffer_length)
+	{
+		*ptr = NULL;
+		return EOF;
+	}
+
+	*ptr = &(stream->buffer[stream->buffer_pos]);
+	return stream->buffer_length - stream->buffer_pos;
+}
+
+static void streami_buffer_advance(stream_t *stream, int amount)
+{
+	stream->buffer_pos += amount;
+	stream->pos += amount;
+}
+
 static streamfuncs_t STREAMI_BUFFER_STREAMFUNCS = {
 	streami_buffer_destroy,
 	streami_buffer_reset,
 	streami_buffer_get_char,
 	streami_buffer_read_data,
+	streami_buffer_peek,
+	streami_buffer_advance,
+	NULL,
+	NULL,
 };
 
-// ...........................................................................
+// ===========================================================================
+// STREAMI_MMAP
+// ===========================================================================
 
-static streamfuncs_t* STREAM_funcs(stream_type_t type)
+// Reading is the same as a buffer - only closing differs.
+static int streami_mmap_destroy(stream_t *stream)
 {
-	switch (type)
-	{
-		case STREAMI_FILE: return &STREAMI_FILE_STREAMFUNCS;
-		case STREAMI_BUFFER: return &STREAMI_BUFFER_STREAMFUNCS;
-		case STREAMI_UNKNOWN: return NULL;
-	}
-	
-	return NULL;
+#ifndef _WIN32
+	if (munmap(stream->map_base, stream->map_length))
+		return 1;
+#endif
+	return 0;
 }
 
-#define STREAMI_FUNC(s,f) (STREAM_funcs((s)->type))->f
-
+static streamfuncs_t STREAMI_MMAP_STREAMFUNCS = {
+	streami_mmap_destroy,
+	streami_buffer_reset,
+	streami_buffer_get_char,
+	streami_buffer_read_data,
+	streami_buffer_peek,
+	streami_buffer_advance,
+	NULL,
+	NULL,
+};
 
 // ===========================================================================
-// Public Functions
+// STREAMI_EXTENTS
 // ===========================================================================
 
-// ---------------------------------------------------------------
-// stream_t* STREAM_Open(char *filename)
-// See stream.h
-// ---------------------------------------------------------------
-stream_t* STREAM_Open(char *filename)
+static int streami_extents_destroy(stream_t *stream)
 {
-	FILE *fp = fopen(filename, "rb");
-	if (!fp)
-		return NULL;
-	
-	stream_t *out;
-	if (!(out = STREAM_OpenFile(fp)))
-		return NULL;
-
-	out->file_opened = 1;
-	
-	return out;
+	// memory extents read in place - the buffer is not ours.
+	if (!stream->extent_memory)
+		STREAM_FREE(stream->buffer);
+	STREAM_FREE(stream->extents);
+	return 0;
 }
 
-// ---------------------------------------------------------------
-// stream_t* STREAM_OpenBufferedFile(char *filename, int buffer_size)
-// See stream.h
-// ---------------------------------------------------------------
-stream_t* STREAM_OpenBuffered(char *filename, int buffer_size)
+static int streami_extents_reset(stream_t *stream)
 {
-	FILE *fp = fopen(filename, "rb");
-	if (!fp)
-		return NULL;
-
-	stream_t *out;
-	if (!(out = STREAM_OpenBufferedFile(fp, buffer_size)))
-		return NULL;
-	
-	out->file_opened = 1;
-	
-	return out;
+	stream->extent_index = 0;
+	stream->extent_pos = 0;
+	stream->buffer_pos = -1;
+	stream->buffer_content_length = 0;
+	stream->pos = 0;
+	return 0;
 }
 
-// ---------------------------------------------------------------
-// stream_t* STREAM_OpenFile(FILE *file)
-// See stream.h
-// ---------------------------------------------------------------
-stream_t* STREAM_OpenFile(FILE *file)
+static int streami_extents_fill_buffer(stream_t *stream)
 {
-	long int cur = ftell(file);
-	if (fseek(file, 0, SEEK_END))
-		return STREAM_OpenFileSection(file, STREAM_NO_LENGTH);
+	// fill buffer if at end.
+	if (stream->buffer_pos < 0 || stream->buffer_pos >= stream->buffer_content_length)
+	{
+		stream_extent_t *extent;
+		size_t amount = 0;
 
-	long int end = ftell(file);
-	fseek(file, cur, SEEK_SET);
-	return STREAM_OpenFileSection(file, end - cur);
+		if (stream->extent_index >= stream->extent_count)
+			return EOF;
+
+		if (stream->extent_memory)
+		{
+			// the rest of the section, in place.
+			extent = &(stream->extents[stream->extent_index++]);
+			stream->buffer = stream->extent_memory + extent->offset + stream->extent_pos;
+			amount = extent->length - stream->extent_pos;
+			stream->extent_pos = 0;
+		}
+		else while (amount < stream->buffer_length && stream->extent_index < stream->extent_count)
+		{
+			size_t want, got;
+			extent = &(stream->extents[stream->extent_index]);
+			want = min(extent->length - stream->extent_pos, stream->buffer_length - amount);
+			got = streami_file_read_at(stream, stream->buffer + amount, want, extent->offset + stream->extent_pos);
+			amount += got;
+			stream->extent_pos += got;
+			if (stream->extent_pos == extent->length)
+			{
+				stream->extent_index++;
+				stream->extent_pos = 0;
+			}
+			// short read - the file ends early.
+			else if (got < want)
+			{
+				stream->extent_index = stream->extent_count;
+				break;
+			}
+		}
+
+		if (!amount)
+			return EOF;
+		stream->buffer_content_length = amount;
+		stream->buffer_pos = 0;
+	}
+	
+	return stream->buffer_content_length - stream->buffer_pos;
 }
 
-// ---------------------------------------------------------------
-// stream_t* STREAM_OpenBufferedFile(FILE *file, int buffer_size)
-// See stream.h
-// ---------------------------------------------------------------
-stream_t* STREAM_OpenBufferedFile(FILE *file, int buffer_size)
+static int streami_extents_get_char(stream_t *stream)
 {
-	long int cur = ftell(file);
-	if (fseek(file, 0, SEEK_END))
-		return STREAM_OpenBufferedFileSection(file, STREAM_NO_LENGTH, buffer_size);
-		
-	long int end = ftell(file);
-	fseek(file, cur, SEEK_SET);
-	return STREAM_OpenBufferedFileSection(file, end - cur, buffer_size);
+	if (streami_extents_fill_buffer(stream) == EOF)
+		return EOF;
+	stream->pos++;
+	return stream->buffer[stream->buffer_pos++] & 0x0FF;
 }
 
-// ---------------------------------------------------------------
-// stream_t* STREAM_OpenFileSection(FILE *file, size_t length)
-// See stream.h
-// ---------------------------------------------------------------
-stream_t* STREAM_OpenFileSection(FILE *file, size_t length)
+static int streami_extents_read_data(stream_t *stream, void *destination, size_t size, size_t count)
 {
-	stream_t *out = STREAM_Init();
-	if (!out)
-		return NULL;
+	int out = 0;
+	unsigned char *ptr = destination;
 	
-	out->file = file;
-	out->file_origin_pos = ftell(file);
+	while (count--)
+	{
+		size_t copied = 0;
+		while (copied < size)
+		{
+			// fill buffer if at end.
+			if (streami_extents_fill_buffer(stream) == EOF)
+				return out;
+			
+			size_t amount = min(stream->buffer_content_length - stream->buffer_pos, size - copied);
+			memcpy(ptr, &(stream->buffer[stream->buffer_pos]), amount);
+			stream->buffer_pos += amount;
+			stream->pos += amount;
+			copied += amount;
+			ptr += amount;
+		}
+		out++;
+	}
 
-	out->pos = 0;
-	out->length = length;
-	
-	out->type = STREAMI_FILE;
 	return out;
 }
 
-// ---------------------------------------------------------------
-// stream_t* STREAM_OpenBufferedFileSection(FILE *file, size_t length, int buffer_size)
-// See stream.h
-// ---------------------------------------------------------------
-stream_t* STREAM_OpenBufferedFileSection(FILE *file, size_t length, int buffer_size)
+static int streami_extents_peek(stream_t *stream, const unsigned char **ptr)
 {
-	stream_t *out = STREAM_Init();
-	// make sure valid size.
-	buffer_size = buffer_size < 1 ? 1 : buffer_size;
-	if (STREAM_AllocateBuffer(out, buffer_size))
+	if (streami_extents_fill_buffer(stream) == EOF)
 	{
-		STREAM_FreeAllocated(out);
-		return NULL;
+		*ptr = NULL;
+		return EOF;
 	}
-	
-	out->file = file;
-	out->file_origin_pos = ftell(file);
-	
-	out->pos = 0;
-	out->length = length;
-	
-	out->type = STREAMI_FILE;
-	return out;	
+
+	*ptr = &(stream->buffer[stream->buffer_pos]);
+	return stream->buffer_content_length - stream->buffer_pos;
 }
 
-// ---------------------------------------------------------------
-// stream_t* STREAM_OpenBuffer(unsigned char *buffer, size_t length)
-// See stream.h
-// ---------------------------------------------------------------
-stream_t* STREAM_OpenBuffer(unsigned char *buffer, size_t length)
+static streamfuncs_t STREAMI_EXTENTS_STREAMFUNCS = {
+	streami_extents_destroy,
+	streami_extents_reset,
+	streami_extents_get_char,
+	streami_extents_read_data,
+	streami_extents_peek,
+	streami_file_advance,
+	NULL,
+	NULL,
+};
+
+// ===========================================================================
+// STREAMI_INFLATE
+// ===========================================================================
+
+// Bytes decoded at a time, after the kept history.
+#define STREAMI_INFLATE_CHUNK_SIZE	32768
+
+static int streami_inflate_destroy(stream_t *stream)
 {
-	stream_t *out = STREAM_Init();
-	if (!out)
-		return NULL;
-	
+	STREAM_Close(((inflate_t*)stream->inflate)->source);
+	STREAM_FREE(stream->inflate);
+	STREAM_FREE(stream->buffer);
+	return 0;
+}
+
+static int streami_inflate_reset(stream_t *stream)
+{
+	inflate_t *inflate = (inflate_t*)stream->inflate;
+	if (STREAM_Reset(inflate->source))
+		return 1;
+	INFLATE_Init(inflate, inflate->source);
+	stream->buffer_pos = -1;
+	stream->buffer_content_length = 0;
+	stream->pos = 0;
+	return 0;
+}
+
+static int streami_inflate_fill_buffer(stream_t *stream)
+{
+	// fill buffer if at end.
+	if (stream->buffer_pos < 0 || stream->buffer_pos >= stream->buffer_content_length)
+	{
+		int keep, end, amount;
+
+		if (stream->length != STREAM_NO_LENGTH && stream->pos >= stream->length)
+			return EOF;
+
+		// the last window of output stays in front, for matches to copy from.
+		keep = min(stream->buffer_content_length, INFLATE_WINDOW_SIZE);
+		memmove(stream->buffer, stream->buffer + stream->buffer_content_length - keep, keep);
+		stream->buffer_content_length = keep;
+		stream->buffer_pos = keep;
+
+		end = stream->buffer_length;
+		if (stream->length != STREAM_NO_LENGTH && stream->length - stream->pos < (size_t)(end - keep))
+			end = keep + (int)(stream->length - stream->pos);
+
+		if ((amount = INFLATE_Decode((inflate_t*)stream->inflate, stream->buffer, keep, end)) <= 0)
+		{
+			// bad data, or the data ended before the stream's length.
+			if (amount < 0 || stream->length != STREAM_NO_LENGTH)
+				stream->error = 1;
+			return EOF;
+		}
+		stream->buffer_content_length += amount;
+	}
+	
+	return stream->buffer_content_length - stream->buffer_pos;
+}
+
+static int streami_inflate_get_char(stream_t *stream)
+{
+	if (streami_inflate_fill_buffer(stream) == EOF)
+		return EOF;
+	stream->pos++;
+	return stream->buffer[stream->buffer_pos++] & 0x0FF;
+}
+
+static int streami_inflate_read_data(stream_t *stream, void *destination, size_t size, size_t count)
+{
+	int out = 0;
+	unsigned char *ptr = destination;
+	
+	while (count--)
+	{
+		size_t copied = 0;
+		while (copied < size)
+		{
+			// fill buffer if at end.
+			if (streami_inflate_fill_buffer(stream) == EOF)
+				return stream->error ? -1 : out;
+			
+			size_t amount = min(stream->buffer_content_length - stream->buffer_pos, size - copied);
+			memcpy(ptr, &(stream->buffer[stream->buffer_pos]), amount);
+			stream->buffer_pos += amount;
+			stream->pos += amount;
+			copied += amount;
+			ptr += amount;
+		}
+		out++;
+	}
+
+	return out;
+}
+
+static int streami_inflate_peek(stream_t *stream, const unsigned char **ptr)
+{
+	if (streami_inflate_fill_buffer(stream) == EOF)
+	{
+		*ptr = NULL;
+		return EOF;
+	}
+
+	*ptr = &(stream->buffer[stream->buffer_pos]);
+	return stream->buffer_content_length - stream->buffer_pos;
+}
+
+static streamfuncs_t STREAMI_INFLATE_STREAMFUNCS = {
+	streami_inflate_destroy,
+	streami_inflate_reset,
+	streami_inflate_get_char,
+	streami_inflate_read_data,
+	streami_inflate_peek,
+	streami_file_advance,
+	NULL,
+	NULL,
+};
+
+// ===========================================================================
+// STREAMI_OUT_FILE, STREAMI_OUT_FD, STREAMI_OUT_BUFFER
+// ===========================================================================
+
+// Writes bytes straight to the sink. Returns nonzero on error.
+static int streami_out_sink(stream_t *stream, const unsigned char *data, size_t length)
+{
+	if (stream->type == STREAMI_OUT_FILE)
+		return fwrite(data, 1, length, stream->file) != length;
+
+	while (length)
+	{
+		int amount = write(stream->fd, data, min(length, INT_MAX));
+		if (amount < 0 && errno == EINTR)
+			continue;
+		if (amount <= 0)
+			return 1;
+		data += amount;
+		length -= amount;
+	}
+	return 0;
+}
+
+// Writes the buffered bytes to the sink. Returns nonzero on error.
+static int streami_out_drain(stream_t *stream)
+{
+	int err = 0;
+	if (stream->buffer_content_length)
+		err = streami_out_sink(stream, stream->buffer, stream->buffer_content_length);
+	stream->buffer_content_length = 0;
+	return err;
+}
+
+// Grows a buffer output stream to fit an amount of bytes more. Returns nonzero if out of memory.
+static int streami_out_grow(stream_t *stream, size_t length)
+{
+	size_t needed = stream->buffer_content_length + length;
+	size_t capacity = stream->buffer_length;
+	unsigned char *newbuffer;
+
+	if (needed <= capacity)
+		return 0;
+	if (needed > INT_MAX)
+		return 1;
+	while (capacity < needed)
+		capacity = min(capacity * 2, INT_MAX);
+	if (!(newbuffer = (unsigned char*)STREAM_REALLOC(stream->buffer, capacity)))
+		return 1;
+	stream->buffer = newbuffer;
+	stream->buffer_length = capacity;
+	return 0;
+}
+
+// Makes room in the buffer for an amount of bytes more (if possible). Returns nonzero on error.
+static int streami_out_make_room(stream_t *stream, size_t length)
+{
+	if (stream->type == STREAMI_OUT_BUFFER)
+		return streami_out_grow(stream, length);
+	if (stream->buffer_content_length + length > stream->buffer_length)
+		return streami_out_drain(stream);
+	return 0;
+}
+
+static int streami_out_destroy(stream_t *stream)
+{
+	if (stream->type != STREAMI_OUT_BUFFER)
+	{
+		streami_out_drain(stream);
+		if (stream->type == STREAMI_OUT_FILE)
+		{
+			if (stream->file_opened)
+				fclose(stream->file);
+			else
+				fflush(stream->file);
+		}
+	}
+	STREAM_FREE(stream->buffer);
+	return 0;
+}
+
+static int streami_out_reset(stream_t *stream)
+{
+	// can't unwrite.
+	return 1;
+}
+
+static int streami_out_get_char(stream_t *stream)
+{
+	return EOF;
+}
+
+static int streami_out_read_data(stream_t *stream, void *destination, size_t size, size_t count)
+{
+	return -1;
+}
+
+static int streami_out_peek(stream_t *stream, const unsigned char **ptr)
+{
+	*ptr = NULL;
+	return EOF;
+}
+
+static void streami_out_advance(stream_t *stream, int amount)
+{
+	// Nothing to advance.
+}
+
+static int streami_out_write_data(stream_t *stream, const void *data, size_t length)
+{
+	if (streami_out_make_room(stream, length))
+		return 1;
+
+	// too big to buffer - the buffer is empty, so nothing is reordered.
+	if (stream->buffer_content_length + length > stream->buffer_length)
+	{
+		if (streami_out_sink(stream, (const unsigned char*)data, length))
+			return 1;
+	}
+	else
+	{
+		memcpy(stream->buffer + stream->buffer_content_length, data, length);
+		stream->buffer_content_length += length;
+	}
+	stream->pos += length;
+	return 0;
+}
+
+static int streami_out_flush(stream_t *stream)
+{
+	if (stream->type == STREAMI_OUT_BUFFER)
+		return 0;
+	if (streami_out_drain(stream))
+		return 1;
+	if (stream->type == STREAMI_OUT_FILE && fflush(stream->file))
+		return 1;
+	return 0;
+}
+
+static streamfuncs_t STREAMI_OUT_STREAMFUNCS = {
+	streami_out_destroy,
+	streami_out_reset,
+	streami_out_get_char,
+	streami_out_read_data,
+	streami_out_peek,
+	streami_out_advance,
+	streami_out_write_data,
+	streami_out_flush,
+};
+
+// ...........................................................................
+
+static streamfuncs_t* STREAM_funcs(stream_type_t type)
+{
+	switch (type)
+	{
+		case STREAMI_FILE: return &STREAMI_FILE_STREAMFUNCS;
+		case STREAMI_BUFFER: return &STREAMI_BUFFER_STREAMFUNCS;
+		case STREAMI_MMAP: return &STREAMI_MMAP_STREAMFUNCS;
+		case STREAMI_OUT_FILE:
+		case STREAMI_OUT_FD:
+		case STREAMI_OUT_BUFFER: return &STREAMI_OUT_STREAMFUNCS;
+		case STREAMI_EXTENTS: return &STREAMI_EXTENTS_STREAMFUNCS;
+		case STREAMI_INFLATE: return &STREAMI_INFLATE_STREAMFUNCS;
+		case STREAMI_UNKNOWN: return NULL;
+	}
+	
+	return NULL;
+}
+
+#define STREAMI_FUNC(s,f) (STREAM_funcs((s)->type))->f
+
+
+// ===========================================================================
+// Public Functions
+// ===========================================================================
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_Open(char *filename)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_Open(char *filename)
+{
+	stream_t *out;
+	if ((out = STREAM_OpenMapped(filename)))
+		return out;
+
+	FILE *fp = fopen(filename, "rb");
+	if (!fp)
+		return NULL;
+	
+	if (!(out = STREAM_OpenFile(fp)))
+		return NULL;
+
+	out->file_opened = 1;
+	
+	return out;
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenBufferedFile(char *filename, int buffer_size)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenBuffered(char *filename, int buffer_size)
+{
+	FILE *fp = fopen(filename, "rb");
+	if (!fp)
+		return NULL;
+
+	stream_t *out;
+	if (!(out = STREAM_OpenBufferedFile(fp, buffer_size)))
+		return NULL;
+	
+	out->file_opened = 1;
+	
+	return out;
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenFile(FILE *file)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenFile(FILE *file)
+{
+	long int cur = ftell(file);
+	if (fseek(file, 0, SEEK_END))
+		return STREAM_OpenFileSection(file, STREAM_NO_LENGTH);
+
+	long int end = ftell(file);
+	fseek(file, cur, SEEK_SET);
+	return STREAM_OpenFileSection(file, end - cur);
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenBufferedFile(FILE *file, int buffer_size)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenBufferedFile(FILE *file, int buffer_size)
+{
+	long int cur = ftell(file);
+	if (fseek(file, 0, SEEK_END))
+		return STREAM_OpenBufferedFileSection(file, STREAM_NO_LENGTH, buffer_size);
+		
+	long int end = ftell(file);
+	fseek(file, cur, SEEK_SET);
+	return STREAM_OpenBufferedFileSection(file, end - cur, buffer_size);
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenFileSection(FILE *file, size_t length)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenFileSection(FILE *file, size_t length)
+{
+	stream_t *out = STREAM_Init();
+	if (!out)
+		return NULL;
+	
+	out->file = file;
+	out->file_origin_pos = ftell(file);
+
+	out->pos = 0;
+	out->length = length;
+	
+	out->type = STREAMI_FILE;
+	return out;
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenBufferedFileSection(FILE *file, size_t length, int buffer_size)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenBufferedFileSection(FILE *file, size_t length, int buffer_size)
+{
+	stream_t *out = STREAM_Init();
+	// make sure valid size.
+	buffer_size = buffer_size < 1 ? 1 : buffer_size;
+	if (STREAM_AllocateBuffer(out, buffer_size))
+	{
+		STREAM_FreeAllocated(out);
+		return NULL;
+	}
+	
+	out->file = file;
+	out->file_origin_pos = ftell(file);
+	
+	out->pos = 0;
+	out->length = length;
+	
+	out->type = STREAMI_FILE;
+	return out;	
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenFileSectionAt(FILE *file, size_t offset, size_t length, int buffer_size)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenFileSectionAt(FILE *file, size_t offset, size_t length, int buffer_size)
+{
+	stream_t *out = STREAM_Init();
+	if (!out)
+		return NULL;
+	// make sure valid size.
+	buffer_size = buffer_size < 1 ? 1 : buffer_size;
+	if (STREAM_AllocateBuffer(out, buffer_size))
+	{
+		STREAM_FreeAllocated(out);
+		return NULL;
+	}
+	
+	out->file = file;
+	out->file_origin_pos = offset;
+	out->file_positional = 1;
+	
+	out->pos = 0;
+	out->length = length;
+	
+	out->type = STREAMI_FILE;
+	return out;	
+}
+
+// ---------------------------------------------------------------
+// int STREAM_SetReadAhead(stream_t *stream)
+// See stream.h
+// ---------------------------------------------------------------
+int STREAM_SetReadAhead(stream_t *stream)
+{
+	streami_readahead_t *ra;
+
+	// only before the first read.
+	if (!stream || stream->type != STREAMI_FILE || !stream->buffer || stream->file_readahead || stream->buffer_pos >= 0)
+		return 1;
+
+	if (!(ra = (streami_readahead_t*)STREAM_MALLOC(sizeof(streami_readahead_t))))
+		return 1;
+	if (!(ra->buffer = (unsigned char*)STREAM_MALLOC(sizeof(unsigned char) * stream->buffer_length)))
+	{
+		STREAM_FREE(ra);
+		return 1;
+	}
+	ra->stream = stream;
+	pthread_mutex_init(&(ra->mutex), NULL);
+	pthread_cond_init(&(ra->cond), NULL);
+
+	stream->file_readahead = ra;
+	if (streami_readahead_start(stream))
+	{
+		streami_readahead_free(ra);
+		stream->file_readahead = NULL;
+		return 1;
+	}
+	return 0;
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenMapped(char *filename)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenMapped(char *filename)
+{
+#ifdef _WIN32
+	return NULL;
+#else
+	struct stat st;
+	stream_t *out;
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &st) || !S_ISREG(st.st_mode))
+	{
+		close(fd);
+		return NULL;
+	}
+
+	out = STREAM_OpenMappedSection(fd, 0, st.st_size);
+	close(fd);
+	return out;
+#endif
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenMappedSection(int fd, size_t offset, size_t length)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenMappedSection(int fd, size_t offset, size_t length)
+{
+#ifdef _WIN32
+	return NULL;
+#else
+	struct stat st;
+	size_t delta;
+	void *base;
+	stream_t *out;
+
+	// empty mappings are not allowed, and pages past the end of the file fault.
+	if (!length || length > INT_MAX || fstat(fd, &st) || offset + length > (size_t)st.st_size)
+		return NULL;
+
+	// mapping offsets must be page-aligned.
+	delta = offset % sysconf(_SC_PAGESIZE);
+	if ((base = mmap(NULL, length + delta, PROT_READ, MAP_PRIVATE, fd, offset - delta)) == MAP_FAILED)
+		return NULL;
+	madvise(base, length + delta, MADV_SEQUENTIAL);
+
+	if (!(out = STREAM_Init()))
+	{
+		munmap(base, length + delta);
+		return NULL;
+	}
+
+	out->type = STREAMI_MMAP;
+	out->map_base = base;
+	out->map_length = length + delta;
+	out->buffer = (unsigned char*)base + delta;
+	out->buffer_pos = 0;
+	out->buffer_content_length = length;
+	out->buffer_length = length;
+	out->pos = 0;
+	out->length = length;
+	return out;
+#endif
+}
+
+// Creates an extents stream with a merged copy of a list of sections.
+static stream_t* STREAM_InitExtents(stream_extent_t *extents, int count)
+{
+	int i;
+	stream_t *out = STREAM_Init();
+	if (!out)
+		return NULL;
+
+	if (!(out->extents = (stream_extent_t*)STREAM_MALLOC(sizeof(stream_extent_t) * (count > 0 ? count : 1))))
+	{
+		STREAM_FreeAllocated(out);
+		return NULL;
+	}
+
+	out->length = 0;
+	for (i = 0; i < count; i++)
+	{
+		stream_extent_t *last = out->extent_count ? &(out->extents[out->extent_count - 1]) : NULL;
+		if (!extents[i].length)
+			continue;
+		if (last && last->offset + last->length == extents[i].offset)
+			last->length += extents[i].length;
+		else
+			out->extents[out->extent_count++] = extents[i];
+		out->length += extents[i].length;
+	}
+
+	out->type = STREAMI_EXTENTS;
+	out->pos = 0;
+	return out;
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenFileExtents(FILE *file, stream_extent_t *extents, int count, int buffer_size)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenFileExtents(FILE *file, stream_extent_t *extents, int count, int buffer_size)
+{
+	stream_t *out = STREAM_InitExtents(extents, count);
+	if (!out)
+		return NULL;
+	// make sure valid size.
+	buffer_size = buffer_size < 1 ? 1 : buffer_size;
+	if (STREAM_AllocateBuffer(out, buffer_size))
+	{
+		STREAM_FREE(out->extents);
+		STREAM_FreeAllocated(out);
+		return NULL;
+	}
+	out->file = file;
+	out->file_origin_pos = 0;
+	out->file_positional = 1;
+	return out;
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenBufferExtents(unsigned char *buffer, stream_extent_t *extents, int count)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenBufferExtents(unsigned char *buffer, stream_extent_t *extents, int count)
+{
+	stream_t *out = STREAM_InitExtents(extents, count);
+	if (!out)
+		return NULL;
+	out->extent_memory = buffer;
+	return out;
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenBuffer(unsigned char *buffer, size_t length)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenBuffer(unsigned char *buffer, size_t length)
+{
+	stream_t *out = STREAM_Init();
+	if (!out)
+		return NULL;
+	
 	out->type = STREAMI_BUFFER;
 	out->buffer = buffer;
 	out->buffer_pos = 0;
@@ -415,6 +1324,112 @@ stream_t* STREAM_OpenBuffer(unsigned char *buffer, size_t length)
 	return out;
 }
 
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenInflate(stream_t *source, size_t length)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenInflate(stream_t *source, size_t length)
+{
+	stream_t *out = STREAM_Init();
+	if (!out)
+		return NULL;
+
+	if (!(out->inflate = STREAM_MALLOC(sizeof(inflate_t))))
+	{
+		STREAM_FreeAllocated(out);
+		return NULL;
+	}
+	if (STREAM_AllocateBuffer(out, INFLATE_WINDOW_SIZE + STREAMI_INFLATE_CHUNK_SIZE))
+	{
+		STREAM_FREE(out->inflate);
+		STREAM_FreeAllocated(out);
+		return NULL;
+	}
+
+	INFLATE_Init((inflate_t*)out->inflate, source);
+	out->type = STREAMI_INFLATE;
+	out->buffer_content_length = 0;
+	out->pos = 0;
+	out->length = length;
+
+	return out;
+}
+
+// Creates an output stream with a buffer.
+static stream_t* STREAM_InitWrite(stream_type_t type, int buffer_size)
+{
+	stream_t *out = STREAM_Init();
+	if (!out)
+		return NULL;
+	// make sure valid size.
+	buffer_size = buffer_size < 1 ? 1 : buffer_size;
+	if (STREAM_AllocateBuffer(out, buffer_size))
+	{
+		STREAM_FreeAllocated(out);
+		return NULL;
+	}
+	out->type = type;
+	out->buffer_pos = 0;
+	out->buffer_content_length = 0;
+	out->pos = 0;
+	return out;
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenWrite(char *filename, int buffer_size)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenWrite(char *filename, int buffer_size)
+{
+	stream_t *out;
+	FILE *fp = fopen(filename, "wb");
+	if (!fp)
+		return NULL;
+
+	if (!(out = STREAM_OpenWriteFile(fp, buffer_size)))
+	{
+		fclose(fp);
+		return NULL;
+	}
+	out->file_opened = 1;
+	return out;
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenWriteFile(FILE *file, int buffer_size)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenWriteFile(FILE *file, int buffer_size)
+{
+	stream_t *out = STREAM_InitWrite(STREAMI_OUT_FILE, buffer_size);
+	if (!out)
+		return NULL;
+	out->file = file;
+	return out;
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenWriteFD(int fd, int buffer_size)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenWriteFD(int fd, int buffer_size)
+{
+	stream_t *out = STREAM_InitWrite(STREAMI_OUT_FD, buffer_size);
+	if (!out)
+		return NULL;
+	out->fd = fd;
+	return out;
+}
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenWriteBuffer(int capacity)
+// See stream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenWriteBuffer(int capacity)
+{
+	return STREAM_InitWrite(STREAMI_OUT_BUFFER, capacity);
+}
+
 // ---------------------------------------------------------------
 // int STREAM_Reset(stream_t *stream)
 // See stream.h
@@ -427,6 +1442,9 @@ int STREAM_Reset(stream_t *stream)
 	if ((STREAMI_FUNC(stream, reset))(stream))
 		return 1;
 	
+	stream->error = 0;
+	stream->crc = 0;
+	stream->crc_span = NULL;
 	return 0;
 }
 
@@ -448,6 +1466,42 @@ inline size_t STREAM_Length(stream_t *stream)
 	return stream->length;
 }
 
+// ---------------------------------------------------------------
+// int STREAM_Error(stream_t *stream)
+// See stream.h
+// ---------------------------------------------------------------
+int STREAM_Error(stream_t *stream)
+{
+	return stream != NULL && stream->error;
+}
+
+// ---------------------------------------------------------------
+// void STREAM_SetCRC32(stream_t *stream, uint32_t crc)
+// See stream.h
+// ---------------------------------------------------------------
+void STREAM_SetCRC32(stream_t *stream, uint32_t crc)
+{
+	stream->crc_check = 1;
+	stream->crc_expected = crc;
+	stream->crc = 0;
+	stream->crc_span = NULL;
+	// nothing to read, so check it now.
+	if (stream->length == 0 && crc != 0)
+		stream->error = 1;
+}
+
+// ---------------------------------------------------------------
+// const unsigned char* STREAM_GetMemory(stream_t *stream)
+// See stream.h
+// ---------------------------------------------------------------
+const unsigned char* STREAM_GetMemory(stream_t *stream)
+{
+	if (stream == NULL || (stream->type != STREAMI_BUFFER && stream->type != STREAMI_MMAP && stream->type != STREAMI_OUT_BUFFER))
+		return NULL;
+	
+	return stream->buffer;
+}
+
 // ---------------------------------------------------------------
 // int STREAM_GetChar(stream_t *stream)
 // See stream.h
@@ -457,7 +1511,56 @@ int STREAM_GetChar(stream_t *stream)
 	if (stream == NULL)
 		return EOF;
 	
-	return (STREAMI_FUNC(stream, get_char))(stream);
+	int c = (STREAMI_FUNC(stream, get_char))(stream);
+	if (stream->crc_check)
+	{
+		unsigned char b = (unsigned char)c;
+		stream->crc_span = NULL;
+		if (c == EOF)
+			STREAM_CRCEnded(stream);
+		else
+			STREAM_CRCUpdate(stream, &b, 1);
+	}
+	return c;
+}
+
+// ---------------------------------------------------------------
+// int STREAM_Peek(stream_t *stream, const unsigned char **ptr)
+// See stream.h
+// ---------------------------------------------------------------
+int STREAM_Peek(stream_t *stream, const unsigned char **ptr)
+{
+	if (stream == NULL)
+	{
+		*ptr = NULL;
+		return EOF;
+	}
+
+	int out = (STREAMI_FUNC(stream, peek))(stream, ptr);
+	if (stream->crc_check)
+	{
+		stream->crc_span = *ptr;
+		if (out == EOF)
+			STREAM_CRCEnded(stream);
+	}
+	return out;
+}
+
+// ---------------------------------------------------------------
+// void STREAM_Advance(stream_t *stream, int amount)
+// See stream.h
+// ---------------------------------------------------------------
+void STREAM_Advance(stream_t *stream, int amount)
+{
+	if (stream == NULL || amount <= 0)
+		return;
+
+	(STREAMI_FUNC(stream, advance))(stream, amount);
+	if (stream->crc_check && stream->crc_span)
+	{
+		STREAM_CRCUpdate(stream, stream->crc_span, amount);
+		stream->crc_span += amount;
+	}
 }
 
 // ---------------------------------------------------------------
@@ -467,6 +1570,47 @@ int STREAM_GetChar(stream_t *stream)
 int STREAM_ReadLine(stream_t *stream, char *out, int max)
 {
 	int amt = 0;
+	int n, take, seg;
+	const unsigned char *span, *lf, *cr;
+
+	// scan the stream's span for the newline, and copy everything before it but carriage returns.
+	while (max > 0 && (n = STREAM_Peek(stream, &span)) > 0)
+	{
+		take = min(n, max);
+		lf = (const unsigned char*)memchr(span, 0x0A, take);
+		if (lf)
+			take = lf - span;
+		max -= take;
+		STREAM_Advance(stream, take);
+
+		while (take)
+		{
+			cr = (const unsigned char*)memchr(span, 0x0D, take);
+			seg = cr ? cr - span : take;
+			memcpy(out, span, seg);
+			out += seg;
+			amt += seg;
+			span += seg + (cr ? 1 : 0);
+			take -= seg + (cr ? 1 : 0);
+		}
+
+		if (lf)
+		{
+			STREAM_Advance(stream, 1);
+			*out = '\0';
+			return amt;
+		}
+	}
+
+	if (max > 0 && n == EOF)
+	{
+		if (!amt)
+			return EOF;
+		*out = '\0';
+		return amt;
+	}
+
+	// no span - a character at a time.
 	while (max--)
 	{
 		int c = STREAM_GetChar(stream);
@@ -495,6 +1639,71 @@ int STREAM_ReadLine(stream_t *stream, char *out, int max)
 	return amt;
 }
 
+// ---------------------------------------------------------------
+// int STREAM_ReadLineView(stream_t *stream, const char **line, char *scratch, int max)
+// See stream.h
+// ---------------------------------------------------------------
+int STREAM_ReadLineView(stream_t *stream, const char **line, char *scratch, int max)
+{
+	int n, amt = 0, found = 0, take;
+	const unsigned char *span, *lf;
+
+	*line = NULL;
+	if ((n = STREAM_Peek(stream, &span)) == EOF)
+		return EOF;
+
+	if (n > 0)
+	{
+		lf = (const unsigned char*)memchr(span, 0x0A, n);
+		// the whole line is in the span (or is the rest of the stream).
+		if (lf || (stream->length != STREAM_NO_LENGTH && stream->pos + n >= stream->length))
+		{
+			amt = lf ? lf - span : n;
+			STREAM_Advance(stream, lf ? amt + 1 : amt);
+			*line = (const char*)span;
+			if (amt && span[amt - 1] == 0x0D)
+				amt--;
+			return amt;
+		}
+	}
+
+	// straddles the span - copy it.
+	while (!found && amt < max)
+	{
+		if ((n = STREAM_Peek(stream, &span)) == EOF)
+			break;
+		if (n > 0)
+		{
+			take = min(n, max - amt);
+			if ((lf = (const unsigned char*)memchr(span, 0x0A, take)))
+			{
+				take = lf - span;
+				found = 1;
+			}
+			memcpy(scratch + amt, span, take);
+			amt += take;
+			STREAM_Advance(stream, found ? take + 1 : take);
+		}
+		else
+		{
+			int c = STREAM_GetChar(stream);
+			if (c == EOF)
+				break;
+			if (c == 0x0A)
+				found = 1;
+			else
+				scratch[amt++] = (char)(c & 0xFF);
+		}
+	}
+
+	if (!amt && !found)
+		return EOF;
+	*line = scratch;
+	if (amt && scratch[amt - 1] == 0x0D)
+		amt--;
+	return amt;
+}
+
 // ---------------------------------------------------------------
 // int STREAM_Get(stream_t *stream, unsigned char *out, int max)
 // See stream.h
@@ -523,7 +1732,92 @@ int STREAM_Read(stream_t *stream, void *destination, size_t size, size_t count)
 	if (stream == NULL)
 		return -1;
 	
-	return (STREAMI_FUNC(stream, read_data))(stream, destination, size, count);
+	size_t start = stream->pos;
+	int out = (STREAMI_FUNC(stream, read_data))(stream, destination, size, count);
+	if (stream->crc_check)
+	{
+		stream->crc_span = NULL;
+		if (stream->pos > start)
+			STREAM_CRCUpdate(stream, (const unsigned char*)destination, stream->pos - start);
+		if (out >= 0 && (size_t)out < count)
+			STREAM_CRCEnded(stream);
+	}
+	return out;
+}
+
+// ---------------------------------------------------------------
+// int STREAM_Write(stream_t *stream, const void *data, size_t length)
+// See stream.h
+// ---------------------------------------------------------------
+int STREAM_Write(stream_t *stream, const void *data, size_t length)
+{
+	if (stream == NULL || !STREAMI_FUNC(stream, write_data))
+		return 1;
+	
+	return (STREAMI_FUNC(stream, write_data))(stream, data, length);
+}
+
+// ---------------------------------------------------------------
+// int STREAM_Printf(stream_t *stream, const char *format, ...)
+// See stream.h
+// ---------------------------------------------------------------
+int STREAM_Printf(stream_t *stream, const char *format, ...)
+{
+	va_list args;
+	int amount, room;
+	char *text;
+
+	if (stream == NULL || !STREAMI_FUNC(stream, write_data))
+		return -1;
+
+	// format straight into the buffer if it fits.
+	room = stream->buffer_length - stream->buffer_content_length;
+	va_start(args, format);
+	amount = vsnprintf((char*)stream->buffer + stream->buffer_content_length, room, format, args);
+	va_end(args);
+	if (amount < 0)
+		return -1;
+
+	if (amount >= room)
+	{
+		if (streami_out_make_room(stream, amount + 1))
+			return -1;
+		room = stream->buffer_length - stream->buffer_content_length;
+		if (amount < room)
+		{
+			va_start(args, format);
+			vsnprintf((char*)stream->buffer + stream->buffer_content_length, room, format, args);
+			va_end(args);
+		}
+		else
+		{
+			// bigger than the whole buffer.
+			if (!(text = (char*)STREAM_MALLOC(amount + 1)))
+				return -1;
+			va_start(args, format);
+			vsnprintf(text, amount + 1, format, args);
+			va_end(args);
+			room = streami_out_write_data(stream, text, amount);
+			STREAM_FREE(text);
+			return room ? -1 : amount;
+		}
+	}
+
+	stream->buffer_content_length += amount;
+	stream->pos += amount;
+	return amount;
+}
+
+// ---------------------------------------------------------------
+// int STREAM_Flush(stream_t *stream)
+// See stream.h
+// ---------------------------------------------------------------
+int STREAM_Flush(stream_t *stream)
+{
+	if (stream == NULL || !STREAMI_FUNC(stream, flush))
+		return 1;
+	
+	return (STREAMI_FUNC(stream, flush))(stream);
 }
 
 // ---------------------------------------------------------------
@@ -560,10 +1854,35 @@ void STREAM_Dump(stream_t *stream)
 		printf("FILE\n");
 		printf("\tOrigin Pos: %d\n", stream->file_origin_pos);
 		printf("\tOpened? %s\n", stream->file_opened ? "YES" : "NO");
+		printf("\tPositional? %s\n", stream->file_positional ? "YES" : "NO");
+		printf("\tRead-ahead? %s\n", stream->file_readahead ? "YES" : "NO");
+	}
+	if (stream->type == STREAMI_MMAP)
+	{
+		printf("MMAP\n");
+		printf("\tMapping length: %d\n", (int)stream->map_length);
+	}
+	if (stream->type == STREAMI_EXTENTS)
+	{
+		printf("EXTENTS\n");
+		printf("\tCount: %d\n", stream->extent_count);
+		printf("\tCurrent: %d\n", stream->extent_index);
+		printf("\tIn memory? %s\n", stream->extent_memory ? "YES" : "NO");
+	}
+	if (stream->type == STREAMI_INFLATE)
+	{
+		printf("INFLATE\n");
+		printf("\tSource:\n");
+		STREAM_Dump(((inflate_t*)stream->inflate)->source);
+	}
+	if (stream->type == STREAMI_OUT_FD)
+	{
+		printf("FD\n");
+		printf("\tDescriptor: %d\n", stream->fd);
 	}
 	if (stream->type == STREAMI_BUFFER || stream->buffer)
 	{
-		printf("BUFFER%s\n", stream->type != STREAMI_BUFFER ? " (Backing)" : "");
+		printf("BUFFER%s\n", stream->type == STREAMI_FILE ? " (Backing)" : "");
 		printf("\tTotal length: %d\n", stream->buffer_length);
 		printf("\tContent length: %d\n", stream->buffer_content_length);
 		printf("\tCurrent pos: %d\n", stream->buffer_pos);
@@ -10,9 +10,13 @@
 #define __STREAM_H__
 
 #include <stdio.h>
+#include <stdint.h>
 
 #define STREAM_NO_LENGTH	-1
 
+/** Default buffer size for output streams, in bytes. */
+#define STREAM_WRITE_BUFFER_SIZE	65536
+
 /**
  * Stream type.
  */
@@ -24,9 +28,33 @@ typedef enum {
 	STREAMI_FILE,
 	/** In-memory buffer. */
 	STREAMI_BUFFER,
+	/** Memory-mapped file (read like a buffer). */
+	STREAMI_MMAP,
+	/** Output to an open file. */
+	STREAMI_OUT_FILE,
+	/** Output to a file descriptor. */
+	STREAMI_OUT_FD,
+	/** Output to a growing in-memory buffer. */
+	STREAMI_OUT_BUFFER,
+	/** Several sections of a file or memory, read in order. */
+	STREAMI_EXTENTS,
+	/** DEFLATE-compressed data from another stream, decompressed. */
+	STREAMI_INFLATE,
 	
 } stream_type_t;
 
+/**
+ * A section of a file or memory (see STREAM_OpenFileExtents()).
+ */
+typedef struct {
+
+	/** Byte offset of the section. */
+	size_t offset;
+	/** Length of the section in bytes. */
+	size_t length;
+
+} stream_extent_t;
+
 /**
  * Stream implementation.
  */
@@ -41,20 +69,57 @@ typedef struct {
 	size_t file_origin_pos;
 	/** If this opened a file. */
 	int file_opened;
+	/** If nonzero, reads are positional (from the origin plus the stream position), not from the file's own position. */
+	int file_positional;
+	/** If not NULL, the read-ahead state of a buffered file (see STREAM_SetReadAhead()). */
+	void *file_readahead;
+
+	/** If STREAMI_OUT_FD, the file descriptor. */
+	int fd;
+
+	/** If STREAMI_EXTENTS, the sections to read in order (adjacent ones merged). */
+	stream_extent_t *extents;
+	/** If STREAMI_EXTENTS, the amount of sections. */
+	int extent_count;
+	/** If STREAMI_EXTENTS, the section that the next read starts in. */
+	int extent_index;
+	/** If STREAMI_EXTENTS, the position in that section. */
+	size_t extent_pos;
+	/** If STREAMI_EXTENTS over memory, the memory that the offsets are from (else the file is read positionally). */
+	unsigned char *extent_memory;
+
+	/** If STREAMI_INFLATE, the decoder state (which has the source stream). */
+	void *inflate;
 
-	/** If STREAM_BUFFER or STREAM_FILE plus buffer. */
+	/** If STREAM_MMAP, the start of the mapping (page-aligned, at or before the buffer). */
+	void *map_base;
+	/** If STREAM_MMAP, the length of the mapping. */
+	size_t map_length;
+
+	/** If STREAM_BUFFER or STREAM_MMAP, or STREAM_FILE plus buffer, or any output stream. */
 	unsigned char *buffer;
 	/** Buffer max length. */
 	int buffer_length;
-	/** Buffer content length. */
+	/** Buffer content length (for output streams, the bytes not written to the sink yet). */
 	int buffer_content_length;
 	/** Current buffer position. */
 	int buffer_pos;
 
-	/** Current stream position. */
+	/** Current stream position (for output streams, the amount of bytes written). */
 	size_t pos;
 	/** Max stream length. */
 	size_t length;
+	/** If nonzero, the stream stopped on bad or missing data instead of its end (see STREAM_Error()). */
+	int error;
+
+	/** If nonzero, the CRC-32 of the bytes read is checked at the end of the stream (see STREAM_SetCRC32()). */
+	int crc_check;
+	/** The expected CRC-32 of the stream. */
+	uint32_t crc_expected;
+	/** The CRC-32 of the bytes read so far. */
+	uint32_t crc;
+	/** The span from the last peek, for the CRC-32 of advanced bytes. */
+	const unsigned char *crc_span;
 	
 } stream_t;
 
@@ -62,6 +127,7 @@ typedef struct {
 
 /**
  * Creates a new stream from a file.
+ * Regular files are memory-mapped (see STREAM_OpenMapped()), others are read through stdio.
  * @param filename the name of the file to open.
  * @return a new lexer stream or NULL if it couldn't be opened or allocated.
  */
@@ -112,6 +178,83 @@ stream_t* STREAM_OpenFileSection(FILE *stream, size_t length);
  */
 stream_t* STREAM_OpenBufferedFileSection(FILE *stream, size_t length, int buffer_size);
 
+/**
+ * Creates a new stream from a section of an open file with a backing buffer, read with positional reads.
+ * The stream keeps its own absolute position and never moves the file's position, so any number of these
+ * streams can be open on one file and read in any order (or from different threads, except on Windows).
+ * Pending writes to the file must be flushed before reading.
+ * @param file the open stream (must be seekable).
+ * @param offset the byte offset of the section in the file (the "stream origin").
+ * @param length the length of the section in bytes.
+ * @param buffer_size the size of the internal buffer in bytes. Values less than 1 are set to 1.
+ * @return a new stream or NULL if it couldn't be allocated.
+ */
+stream_t* STREAM_OpenFileSectionAt(FILE *stream, size_t offset, size_t length, int buffer_size);
+
+/**
+ * Turns on read-ahead for a buffered file stream: a background thread fills a second buffer
+ * with the next part of the file while the current buffer is read, so I/O overlaps with other work.
+ * This must be called before the first read from the stream. From then on, the file belongs to the stream's
+ * thread until the stream is closed - nothing else may read it or move its position (positional streams
+ * from STREAM_OpenFileSectionAt() on the same file are still fine).
+ * @param stream the stream.
+ * @return 0 if successful, or nonzero if the stream is not a buffered file stream, or the thread or buffer couldn't be created.
+ */
+int STREAM_SetReadAhead(stream_t *stream);
+
+/**
+ * Creates a new stream that reads a whole file through a read-only memory mapping.
+ * The kernel is advised that the mapping will be read sequentially.
+ * The file descriptor is closed right away - the mapping stays valid until the stream is closed.
+ * @param filename the name of the file to open.
+ * @return a new stream, or NULL if the file couldn't be opened or mapped (not a regular file, empty, or no mmap on this platform).
+ */
+stream_t* STREAM_OpenMapped(char *filename);
+
+/**
+ * Creates a new stream that reads a section of an open file through a read-only memory mapping.
+ * The kernel is advised that the mapping will be read sequentially.
+ * The file descriptor is NOT closed by the stream, and can be closed while the stream is open.
+ * @param fd the open file descriptor.
+ * @param offset the byte offset of the section in the file.
+ * @param length the length of the section in bytes.
+ * @return a new stream, or NULL if the section couldn't be mapped (empty, past the end of the file, or no mmap on this platform).
+ */
+stream_t* STREAM_OpenMappedSection(int fd, size_t offset, size_t length);
+
+/**
+ * Creates a new stream that reads several sections of an open file in order, as though they were one.
+ * Sections that are adjacent in the file are merged and read together. Like STREAM_OpenFileSectionAt(),
+ * the file is read positionally and its position is not used or moved.
+ * @param file the open stream (must be seekable).
+ * @param extents the sections (copied - the array need not outlive the stream).
+ * @param count the amount of sections.
+ * @param buffer_size the size of the internal buffer in bytes. Values less than 1 are set to 1.
+ * @return a new stream or NULL if it couldn't be allocated.
+ */
+stream_t* STREAM_OpenFileExtents(FILE *file, stream_extent_t *extents, int count, int buffer_size);
+
+/**
+ * Creates a new stream that reads several sections of a binary char buffer in order, as though they were one.
+ * Each section is read in place - peeking spans one section at a time.
+ * @param buffer the bytes that the section offsets are from.
+ * @param extents the sections (copied - the array need not outlive the stream).
+ * @param count the amount of sections.
+ * @return a new stream or NULL if it couldn't be allocated.
+ */
+stream_t* STREAM_OpenBufferExtents(unsigned char *buffer, stream_extent_t *extents, int count);
+
+/**
+ * Creates a new stream that decompresses raw DEFLATE data (RFC 1951, no zlib or gzip header) read from another stream.
+ * The data is decoded into the stream's buffer, so it has a span (see STREAM_Peek()).
+ * Closing this stream closes the source stream. Resetting it resets the source and decodes from the start.
+ * Bad or truncated data reads as the end of the stream, and sets the stream's error (see STREAM_Error()).
+ * @param source the stream of compressed data.
+ * @param length the decompressed length, or STREAM_NO_LENGTH if unknown (then decoding stops at the end of the data).
+ * @return a new stream or NULL if it couldn't be allocated (the source is not closed).
+ */
+stream_t* STREAM_OpenInflate(stream_t *source, size_t length);
+
 /**
  * Creates a new stream from a binary char buffer.
  * @param buffer the stream of bytes.
@@ -120,6 +263,42 @@ stream_t* STREAM_OpenBufferedFileSection(FILE *stream, size_t length, int buffer
  */
 stream_t* STREAM_OpenBuffer(unsigned char *buffer, size_t length);
 
+/**
+ * Creates a new output stream that writes to a file, replacing its contents.
+ * The file is closed when the stream is closed.
+ * @param filename the name of the file to write.
+ * @param buffer_size the size of the internal buffer in bytes (see STREAM_WRITE_BUFFER_SIZE). Values less than 1 are set to 1.
+ * @return a new stream or NULL if the file couldn't be opened or the stream allocated.
+ */
+stream_t* STREAM_OpenWrite(char *filename, int buffer_size);
+
+/**
+ * Creates a new output stream that writes to an open file, from its current position.
+ * The file is NOT closed when the stream is closed.
+ * @param file the open file.
+ * @param buffer_size the size of the internal buffer in bytes (see STREAM_WRITE_BUFFER_SIZE). Values less than 1 are set to 1.
+ * @return a new stream or NULL if it couldn't be allocated.
+ */
+stream_t* STREAM_OpenWriteFile(FILE *file, int buffer_size);
+
+/**
+ * Creates a new output stream that writes to a file descriptor (a file, pipe, socket, etc.).
+ * The descriptor is NOT closed when the stream is closed.
+ * @param fd the file descriptor.
+ * @param buffer_size the size of the internal buffer in bytes (see STREAM_WRITE_BUFFER_SIZE). Values less than 1 are set to 1.
+ * @return a new stream or NULL if it couldn't be allocated.
+ */
+stream_t* STREAM_OpenWriteFD(int fd, int buffer_size);
+
+/**
+ * Creates a new output stream that writes to memory that grows as needed.
+ * The written bytes are at STREAM_GetMemory(), and there are STREAM_Tell() of them.
+ * The memory is freed when the stream is closed.
+ * @param capacity the amount of bytes to allocate at first.
+ * @return a new stream or NULL if it couldn't be allocated.
+ */
+stream_t* STREAM_OpenWriteBuffer(int capacity);
+
 /**
  * Resets a stream to the beginning.
  * Some contiguous streams cannot be reset.
@@ -145,6 +324,34 @@ size_t STREAM_Tell(stream_t *stream);
  */
 size_t STREAM_Length(stream_t *stream);
 
+/**
+ * Sets the CRC-32 that a stream's content must have (as in zip archives), and checks it as bytes are read.
+ * After the last byte is read, a mismatch sets the stream's error (see STREAM_Error()), and so does
+ * the stream ending before its length. The stream must have a length, and must be read from the start.
+ * @param stream the stream.
+ * @param crc the expected CRC-32.
+ */
+void STREAM_SetCRC32(stream_t *stream, uint32_t crc);
+
+/**
+ * Checks if a stream stopped on bad data instead of its end.
+ * Reads return EOF (or fewer elements) either way, so check this after a read comes up short.
+ * Decompressing streams set this on corrupt data, or data that ends before the stream's length,
+ * and streams with a CRC-32 to check set it on a mismatch (see STREAM_SetCRC32()).
+ * @param stream the stream.
+ * @return nonzero if the stream had a read error, 0 if not.
+ */
+int STREAM_Error(stream_t *stream);
+
+/**
+ * Gets the memory that a stream reads directly from, if it does.
+ * Byte N of the stream is at the returned address plus N, and stays valid until the stream is closed.
+ * For buffer output streams, this is the memory written to, valid until the next write.
+ * @param stream the stream.
+ * @return the start of the stream's memory, or NULL if the stream does not read from memory (stdio files).
+ */
+const unsigned char* STREAM_GetMemory(stream_t *stream);
+
 /**
  * Gets a single character from the stream.
  * @param stream the stream.
@@ -152,6 +359,23 @@ size_t STREAM_Length(stream_t *stream);
  */
 int STREAM_GetChar(stream_t *stream);
 
+/**
+ * Gets the span of bytes that a stream will read next without another read call - its buffer or memory.
+ * Peeking does not advance the stream: call STREAM_Advance() for the bytes used from the span.
+ * Unbuffered file streams have no span, so their bytes must be read with the other functions.
+ * @param stream the stream.
+ * @param ptr the output pointer to the start of the span (NULL if none). Valid until the next call on this stream.
+ * @return the amount of bytes in the span, 0 if the stream has no span, or EOF for end of stream.
+ */
+int STREAM_Peek(stream_t *stream, const unsigned char **ptr);
+
+/**
+ * Advances a stream past bytes in its current span (see STREAM_Peek()).
+ * @param stream the stream.
+ * @param amount the amount of bytes to advance. Must not be more than the span length returned by the last peek.
+ */
+void STREAM_Advance(stream_t *stream, int amount);
+
 /**
  * Gets a full line from a stream, minus the newline (or carriage return).
  * Character output is null-terminated if max is not reached.
@@ -162,6 +386,19 @@ int STREAM_GetChar(stream_t *stream);
  */
 int STREAM_ReadLine(stream_t *stream, char *out, int max);
 
+/**
+ * Gets a full line from a stream without copying it where possible, minus the newline (and a carriage return before it).
+ * If the line is in the stream's current span (see STREAM_Peek()), the output points into the stream.
+ * Otherwise (it straddles the span, or the stream has none) the line is copied into scratch.
+ * Copied lines longer than max are cut at max characters, and the rest is read as the next line.
+ * @param stream the stream.
+ * @param line the output pointer to the line's characters (NOT null-terminated). Valid until the next call on this stream.
+ * @param scratch the buffer for copied lines.
+ * @param max the size of scratch in characters.
+ * @return the length of the line, or EOF if the stream was at its end.
+ */
+int STREAM_ReadLineView(stream_t *stream, const char **line, char *scratch, int max);
+
 /**
  * Reads a set of bytes from the stream.
  * @param stream the stream.
@@ -181,8 +418,34 @@ int STREAM_Get(stream_t *stream, unsigned char *out, int max);
  */
 int STREAM_Read(stream_t *stream, void *destination, size_t size, size_t count);
 
+/**
+ * Writes bytes to an output stream.
+ * Small writes are gathered in the stream's buffer - writes larger than the buffer go straight to the sink.
+ * @param stream the output stream.
+ * @param data the bytes to write.
+ * @param length the amount of bytes.
+ * @return 0 if successful, or nonzero on a write error (or if this is not an output stream).
+ */
+int STREAM_Write(stream_t *stream, const void *data, size_t length);
+
+/**
+ * Writes formatted text to an output stream (see printf()).
+ * @param stream the output stream.
+ * @param format the format string.
+ * @return the amount of characters written, or -1 on an error (or if this is not an output stream).
+ */
+int STREAM_Printf(stream_t *stream, const char *format, ...);
+
+/**
+ * Writes everything in an output stream's buffer to its sink (and flushes the file, if the sink is one).
+ * @param stream the output stream.
+ * @return 0 if successful, or nonzero on a write error (or if this is not an output stream).
+ */
+int STREAM_Flush(stream_t *stream);
+
 /**
  * Closes a stream.
+ * Output streams are flushed first - call STREAM_Flush() beforehand to check for write errors.
  * If the stream had to open a file to read from it, the file will be closed.
  * If a backing buffer was created, it too will be freed.
  * If this is a buffer encapsulation (via STREAM_OpenBuffer()), the encapsulated buffer will NOT BE FREED.
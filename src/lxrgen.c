@@ -0,0 +1,636 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+/*
+ * Lexer kernel generator.
+ * Reads a kernel description and writes a C source file that defines a function that creates the
+ * kernel, with its lookups specialized at compile time (see LXRK_CreateGenerated()): byte class tables,
+ * keyword matching switched on length and first byte, and the delimiter/comment trie as a switch on
+ * node and byte. The kernel is built and compiled the usual way first, and the output is written
+ * from the compiled kernel, so a generated kernel scans exactly the same tokens as a built one.
+ *
+ * Description statements (C-style comments allowed, subtypes are numbers or C identifiers):
+ *
+ *     function <name>;                 Name of the function to generate (required).
+ *     include "<header>";              Header to include (for subtype constants).
+ *     comment "<start>" "<end>";       Multi-line comment delimiters.
+ *     linecomment "<start>";           Line comment delimiter.
+ *     string "<start>" "<end>";        String delimiter characters.
+ *     delimiter "<text>" <subtype>;    Delimiter.
+ *     keyword "<text>" <subtype>;      Keyword.
+ *     cikeyword "<text>" <subtype>;    Case-insensitive keyword.
+ *     decimal "<char>";                Decimal separator character.
+ *     escape "<char>";                 String escape character.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "parser/parser.h"
+#include "struct/mt_arena.h"
+#include "struct/mt_intern.h"
+
+#define LXRGEN_SPLASH "Lexer Kernel Generator (C) 2018-2025 Matt Tropiano"
+
+// Most includes in one description.
+#define LXRGEN_INCLUDES_MAX	16
+
+// Description keywords.
+typedef enum {
+
+	LXRGEN_FUNCTION,
+	LXRGEN_INCLUDE,
+	LXRGEN_COMMENT,
+	LXRGEN_LINECOMMENT,
+	LXRGEN_STRING,
+	LXRGEN_DELIMITER,
+	LXRGEN_KEYWORD,
+	LXRGEN_CIKEYWORD,
+	LXRGEN_DECIMAL,
+	LXRGEN_ESCAPE,
+
+	LXRGEN_COUNT
+
+} lxrgen_keyword_t;
+
+// MUST BE IN THE SAME ORDER AS lxrgen_keyword_t!
+static char* lxrgen_keywords[LXRGEN_COUNT] =
+{
+	"function", "include", "comment", "linecomment", "string",
+	"delimiter", "keyword", "cikeyword", "decimal", "escape",
+};
+
+// Description delimiter.
+#define LXRGEN_SEMICOLON	0
+
+/**
+ * Generator state.
+ */
+typedef struct {
+
+	/** The description parser. */
+	parser_t *parser;
+	/** The description file name. */
+	char *name;
+	/** Arena for all description text. */
+	mt_arena_t *arena;
+	/** Interned identifiers. */
+	mt_intern_t *intern;
+
+	/** The kernel being described. */
+	lexer_kernel_t *kernel;
+	/** Generated function name. */
+	const char *function;
+	/** Included headers. */
+	char *includes[LXRGEN_INCLUDES_MAX];
+	/** Amount of included headers. */
+	int include_count;
+	/** Subtype text (numbers or identifiers, interned). The kernel's subtypes are indices into this. */
+	const char **subtypes;
+	/** Amount of subtypes. */
+	int subtype_count;
+	/** Subtype capacity. */
+	int subtype_capacity;
+
+} lxrgen_t;
+
+// A keyword test under a first byte.
+typedef struct {
+
+	int c;
+	int entry;
+
+} lxrgen_test_t;
+
+// ===========================================================================
+// Description Parsing
+// ===========================================================================
+
+// Creates the kernel for lexing descriptions.
+static lexer_kernel_t* lxrgen_description_kernel()
+{
+	int i;
+	lexer_kernel_t *kernel = LXRK_Create();
+	if (!kernel)
+		return NULL;
+	LXRK_AddCommentDelimiter(kernel, "/*", "*/");
+	LXRK_AddLineCommentDelimiter(kernel, "//");
+	LXRK_AddStringDelimiters(kernel, '"', '"');
+	LXRK_AddDelimiter(kernel, ";", LXRGEN_SEMICOLON);
+	for (i = 0; i < LXRGEN_COUNT; i++)
+		LXRK_AddKeyword(kernel, lxrgen_keywords[i], i);
+	if (LXRK_Compile(kernel))
+	{
+		LXRK_Destroy(kernel);
+		return NULL;
+	}
+	return kernel;
+}
+
+// Prints a description error at the current token. Always returns 1.
+static int lxrgen_error(lxrgen_t *gen, char *message)
+{
+	fprintf(stderr, "ERROR: %s, line %d: %s\n", gen->name, PARSER_Current(gen->parser)->line_number, message);
+	return 1;
+}
+
+// Matches a string and copies its text. Returns NULL if not a string (or out of memory).
+static char* lxrgen_string(lxrgen_t *gen)
+{
+	char *out;
+	if (!PARSER_IsType(gen->parser, LXRT_STRING))
+		return NULL;
+	out = LXR_CopyTokenText(gen->parser->lexer, PARSER_Current(gen->parser), gen->arena);
+	PARSER_Next(gen->parser);
+	return out;
+}
+
+// Matches a single-character string. Returns the character, or -1 if not one.
+static int lxrgen_char(lxrgen_t *gen)
+{
+	int out;
+	char *s = lxrgen_string(gen);
+	if (!s)
+		return -1;
+	out = strlen(s) == 1 ? (unsigned char)s[0] : -1;
+	return out;
+}
+
+// Matches a subtype and adds its text to the subtype list. Returns its index, or -1 if not a subtype.
+static int lxrgen_subtype(lxrgen_t *gen)
+{
+	lexer_token_t *token = PARSER_Current(gen->parser);
+	if (token->type == LXRT_NUMBER)
+	{
+		if (token->subtype == LXRTN_FLOAT)
+			return -1;
+	}
+	else if (token->type != LXRT_IDENTIFIER && token->type != LXRT_KEYWORD)
+		return -1;
+
+	if (gen->subtype_count == gen->subtype_capacity)
+	{
+		int capacity = gen->subtype_capacity ? gen->subtype_capacity * 2 : 64;
+		const char **subtypes = (const char**)realloc(gen->subtypes, sizeof(const char*) * capacity);
+		if (!subtypes)
+			return -1;
+		gen->subtypes = subtypes;
+		gen->subtype_capacity = capacity;
+	}
+	if (!(gen->subtypes[gen->subtype_count] = LXR_InternTokenText(gen->parser->lexer, token, gen->intern)))
+		return -1;
+	PARSER_Next(gen->parser);
+	return gen->subtype_count++;
+}
+
+// Parses one statement (the keyword is current). Returns nonzero if bad.
+static int lxrgen_statement(lxrgen_t *gen)
+{
+	char *a = NULL, *b = NULL;
+	int c, d, subtype, out = 0;
+	int keyword = PARSER_Current(gen->parser)->subtype;
+	PARSER_Next(gen->parser);
+
+	switch (keyword)
+	{
+		case LXRGEN_FUNCTION:
+			if (!PARSER_IsType(gen->parser, LXRT_IDENTIFIER))
+				return lxrgen_error(gen, "expected function name");
+			gen->function = LXR_InternTokenText(gen->parser->lexer, PARSER_Current(gen->parser), gen->intern);
+			PARSER_Next(gen->parser);
+			break;
+
+		case LXRGEN_INCLUDE:
+			if (gen->include_count == LXRGEN_INCLUDES_MAX)
+				return lxrgen_error(gen, "too many includes");
+			if (!(a = lxrgen_string(gen)))
+				return lxrgen_error(gen, "expected header name");
+			gen->includes[gen->include_count++] = a;
+			break;
+
+		case LXRGEN_COMMENT:
+			if (!(a = lxrgen_string(gen)) || !(b = lxrgen_string(gen)) || !strlen(a) || !strlen(b))
+				out = lxrgen_error(gen, "expected comment start and end");
+			else
+				LXRK_AddCommentDelimiter(gen->kernel, a, b);
+			break;
+
+		case LXRGEN_LINECOMMENT:
+			if (!(a = lxrgen_string(gen)) || !strlen(a))
+				out = lxrgen_error(gen, "expected line comment start");
+			else
+				LXRK_AddLineCommentDelimiter(gen->kernel, a);
+			break;
+
+		case LXRGEN_STRING:
+			if ((c = lxrgen_char(gen)) < 0 || (d = lxrgen_char(gen)) < 0)
+				return lxrgen_error(gen, "expected string start and end characters");
+			LXRK_AddStringDelimiters(gen->kernel, (char)c, (char)d);
+			break;
+
+		case LXRGEN_DELIMITER:
+		case LXRGEN_KEYWORD:
+		case LXRGEN_CIKEYWORD:
+			if (!(a = lxrgen_string(gen)) || !strlen(a))
+				out = lxrgen_error(gen, "expected text");
+			else if ((subtype = lxrgen_subtype(gen)) < 0)
+				out = lxrgen_error(gen, "expected subtype (integer or identifier)");
+			else if (keyword == LXRGEN_DELIMITER)
+				LXRK_AddDelimiter(gen->kernel, a, subtype);
+			else if (keyword == LXRGEN_KEYWORD)
+				LXRK_AddKeyword(gen->kernel, a, subtype);
+			else
+				LXRK_AddCaseInsensitiveKeyword(gen->kernel, a, subtype);
+			break;
+
+		case LXRGEN_DECIMAL:
+			if ((c = lxrgen_char(gen)) < 0)
+				return lxrgen_error(gen, "expected decimal separator character");
+			LXRK_SetDecimalSeparator(gen->kernel, (char)c);
+			break;
+
+		case LXRGEN_ESCAPE:
+			if ((c = lxrgen_char(gen)) < 0)
+				return lxrgen_error(gen, "expected escape character");
+			LXRK_SetStringEscapeChar(gen->kernel, (char)c);
+			break;
+	}
+
+	if (out)
+		return out;
+
+	if (!PARSER_MatchSubtype(gen->parser, LXRT_DELIMITER, LXRGEN_SEMICOLON))
+		return lxrgen_error(gen, "expected \";\"");
+	return 0;
+}
+
+// Reads a description. Returns nonzero if bad.
+static int lxrgen_read(lxrgen_t *gen)
+{
+	PARSER_Next(gen->parser);
+	while (PARSER_Peek(gen->parser, 0))
+	{
+		if (!PARSER_IsType(gen->parser, LXRT_KEYWORD))
+			return lxrgen_error(gen, "expected statement");
+		if (lxrgen_statement(gen))
+			return 1;
+	}
+	if (!gen->function)
+		return lxrgen_error(gen, "no function name (\"function <name>;\")");
+	return 0;
+}
+
+// ===========================================================================
+// Code Writing
+// ===========================================================================
+
+// Writes a C string literal.
+static void lxrgen_write_string(FILE *out, const char *s, int length)
+{
+	int i;
+	fputc('"', out);
+	for (i = 0; i < length; i++)
+	{
+		unsigned char c = (unsigned char)s[i];
+		if (c == '"' || c == '\\' || c == '?')
+			fprintf(out, "\\%c", c);
+		else if (c < 32 || c > 126)
+			fprintf(out, "\\%03o", c);
+		else
+			fputc(c, out);
+	}
+	fputc('"', out);
+}
+
+// Writes a byte as a case label value.
+static void lxrgen_write_byte(FILE *out, int c)
+{
+	if (c == '\'' || c == '\\')
+		fprintf(out, "'\\%c'", c);
+	else if (c >= 32 && c <= 126)
+		fprintf(out, "'%c'", c);
+	else
+		fprintf(out, "%d", c);
+}
+
+// Sorts keyword tests by first byte, then entry order.
+static int lxrgen_compare_test(const void *a, const void *b)
+{
+	const lxrgen_test_t *ta = (const lxrgen_test_t*)a;
+	const lxrgen_test_t *tb = (const lxrgen_test_t*)b;
+	return ta->c != tb->c ? ta->c - tb->c : ta->entry - tb->entry;
+}
+
+// Writes the tests under one first byte, from tests[start] to tests[end - 1].
+static void lxrgen_write_tests(lxrgen_t *gen, FILE *out, lxrgen_test_t *tests, int start, int end)
+{
+	int i;
+	for (i = start; i < end; i++)
+	{
+		lexer_kernel_keyword_t *entry = &(gen->kernel->keywords.entries[tests[i].entry]);
+		const char *type = gen->subtypes[entry->type];
+		if (entry->length == 1)
+		{
+			// first byte is the whole keyword - anything after this can't match.
+			fprintf(out, "\t\t\t\t\treturn %s;\n", type);
+			return;
+		}
+		fprintf(out, "\t\t\t\t\tif (%s(text + 1, ", entry->case_insensitive ? "strnicmp" : "memcmp");
+		lxrgen_write_string(out, entry->keyword + 1, entry->length - 1);
+		fprintf(out, ", %d) == 0)\n\t\t\t\t\t\treturn %s;\n", entry->length - 1, type);
+	}
+	fprintf(out, "\t\t\t\t\tbreak;\n");
+}
+
+// Checks if two first bytes have the same tests.
+static int lxrgen_same_tests(lxrgen_test_t *tests, int a, int aend, int b, int bend)
+{
+	if (aend - a != bend - b)
+		return 0;
+	while (a < aend)
+		if (tests[a++].entry != tests[b++].entry)
+			return 0;
+	return 1;
+}
+
+// Writes the keyword lookup function. Returns nonzero if out of memory.
+static int lxrgen_write_keywords(lxrgen_t *gen, FILE *out)
+{
+	lexer_kernel_keywords_t *kw = &(gen->kernel->keywords);
+	int i, j, k, length, maxlength = 0, count, *group;
+	lxrgen_test_t *tests;
+
+	if (!(tests = (lxrgen_test_t*)malloc(sizeof(lxrgen_test_t) * (kw->entry_count * 2 + 1))))
+		return 1;
+	if (!(group = (int*)malloc(sizeof(int) * (kw->entry_count * 2 + 1))))
+	{
+		free(tests);
+		return 1;
+	}
+
+	for (i = 0; i < kw->entry_count; i++)
+		if (kw->entries[i].length > maxlength)
+			maxlength = kw->entries[i].length;
+
+	fprintf(out, "// Gets a keyword type from a slice of text.\n");
+	fprintf(out, "static int keyword_type(const char *text, int length)\n{\n");
+	fprintf(out, "\tswitch (length)\n\t{\n");
+	for (length = 1; length <= maxlength; length++)
+	{
+		// entries are in case-folded order, case-sensitive first, so tests keep that precedence.
+		count = 0;
+		for (i = 0; i < kw->entry_count; i++)
+		{
+			lexer_kernel_keyword_t *entry = &(kw->entries[i]);
+			if (entry->length != length)
+				continue;
+			int c = (unsigned char)entry->keyword[0];
+			if (entry->case_insensitive && tolower(c) != toupper(c))
+			{
+				tests[count].c = tolower(c);
+				tests[count++].entry = i;
+				tests[count].c = toupper(c);
+				tests[count++].entry = i;
+			}
+			else
+			{
+				tests[count].c = c;
+				tests[count++].entry = i;
+			}
+		}
+		if (!count)
+			continue;
+		qsort(tests, count, sizeof(lxrgen_test_t), &lxrgen_compare_test);
+
+		// group[i] is the index one past the end of the tests that start at i, for each first byte.
+		for (i = 0; i < count; i = j)
+		{
+			for (j = i; j < count && tests[j].c == tests[i].c; j++) ;
+			group[i] = j;
+		}
+
+		fprintf(out, "\t\tcase %d:\n", length);
+		fprintf(out, "\t\t\tswitch ((unsigned char)text[0])\n\t\t\t{\n");
+		for (i = 0; i < count; i = group[i])
+		{
+			if (tests[i].c < 0)
+				continue;
+			// bytes with the same tests share a case (like the two cases of a case-insensitive letter).
+			fprintf(out, "\t\t\t\tcase ");
+			lxrgen_write_byte(out, tests[i].c);
+			fprintf(out, ":\n");
+			for (k = group[i]; k < count; k = group[k])
+			{
+				if (tests[k].c >= 0 && lxrgen_same_tests(tests, i, group[i], k, group[k]))
+				{
+					fprintf(out, "\t\t\t\tcase ");
+					lxrgen_write_byte(out, tests[k].c);
+					fprintf(out, ":\n");
+					tests[k].c = -1;
+				}
+			}
+			lxrgen_write_tests(gen, out, tests, i, group[i]);
+		}
+		fprintf(out, "\t\t\t}\n\t\t\tbreak;\n");
+	}
+	fprintf(out, "\t}\n\treturn -1;\n}\n\n");
+
+	free(group);
+	free(tests);
+	return 0;
+}
+
+// Writes the trie step function and node tables.
+static void lxrgen_write_trie(lxrgen_t *gen, FILE *out)
+{
+	lexer_kernel_t *kernel = gen->kernel;
+	int i, c;
+
+	fprintf(out, "// Gets the next delimiter trie node from a node and a character.\n");
+	fprintf(out, "static int trie_next(int node, int c)\n{\n");
+	fprintf(out, "\tswitch (node)\n\t{\n");
+	for (i = 0; i < kernel->trie_count; i++)
+	{
+		int children = 0;
+		for (c = 0; c < 256; c++)
+			if (kernel->trie[i].next[c] != LXRK_TRIE_NONE)
+				children++;
+		if (!children)
+			continue;
+
+		fprintf(out, "\t\tcase %d:\n", i);
+		fprintf(out, "\t\t\tswitch (c)\n\t\t\t{\n");
+		for (c = 0; c < 256; c++)
+		{
+			if (kernel->trie[i].next[c] == LXRK_TRIE_NONE)
+				continue;
+			fprintf(out, "\t\t\t\tcase ");
+			lxrgen_write_byte(out, c);
+			fprintf(out, ": return %d;\n", kernel->trie[i].next[c]);
+		}
+		fprintf(out, "\t\t\t}\n\t\t\tbreak;\n");
+	}
+	fprintf(out, "\t}\n\treturn LXRK_TRIE_NONE;\n}\n\n");
+
+	fprintf(out, "// Delimiter type of each trie node.\n");
+	fprintf(out, "static const int delimiter_type[%d] =\n{\n", kernel->trie_count);
+	for (i = 0; i < kernel->trie_count; i++)
+	{
+		if (kernel->trie[i].delimiter_type >= 0)
+			fprintf(out, "\t%s,\n", gen->subtypes[kernel->trie[i].delimiter_type]);
+		else
+			fprintf(out, "\t-1,\n");
+	}
+	fprintf(out, "};\n\n");
+
+	fprintf(out, "// Comment end of each trie node.\n");
+	fprintf(out, "static char* const comment_end[%d] =\n{\n", kernel->trie_count);
+	for (i = 0; i < kernel->trie_count; i++)
+	{
+		fprintf(out, "\t");
+		if (kernel->trie[i].comment_end)
+			lxrgen_write_string(out, kernel->trie[i].comment_end, strlen(kernel->trie[i].comment_end));
+		else
+			fprintf(out, "NULL");
+		fprintf(out, ",\n");
+	}
+	fprintf(out, "};\n\n");
+
+	fprintf(out, "// Line comment flag of each trie node.\n");
+	fprintf(out, "static const char line_comment[%d] =\n{", kernel->trie_count);
+	for (i = 0; i < kernel->trie_count; i++)
+		fprintf(out, "%s%d,", i % 16 ? " " : "\n\t", kernel->trie[i].line_comment ? 1 : 0);
+	fprintf(out, "\n};\n\n");
+}
+
+// Writes the generated source. Returns nonzero if out of memory.
+static int lxrgen_write(lxrgen_t *gen, FILE *out)
+{
+	lexer_kernel_t *kernel = gen->kernel;
+	int i;
+
+	fprintf(out, "/*****************************************************************************\n");
+	fprintf(out, " * Generated by lxrgen from %s - DO NOT EDIT.\n", gen->name);
+	fprintf(out, " *****************************************************************************/\n\n");
+	fprintf(out, "#include <stdio.h>\n");
+	fprintf(out, "#include <string.h>\n");
+	fprintf(out, "#include \"parser/lexer_kernel.h\"\n");
+	for (i = 0; i < gen->include_count; i++)
+		fprintf(out, "#include \"%s\"\n", gen->includes[i]);
+	fprintf(out, "\n");
+
+	fprintf(out, "// Class bits for each byte value.\n");
+	fprintf(out, "static const uint16_t char_class[256] =\n{");
+	for (i = 0; i < 256; i++)
+		fprintf(out, "%s0x%04x,", i % 8 ? " " : "\n\t", kernel->char_class[i]);
+	fprintf(out, "\n};\n\n");
+
+	fprintf(out, "// String end character for each string start character.\n");
+	fprintf(out, "static const char string_end[256] =\n{");
+	for (i = 0; i < 256; i++)
+		fprintf(out, "%s%d,", i % 16 ? " " : "\n\t", kernel->string_end[i]);
+	fprintf(out, "\n};\n\n");
+
+	if (lxrgen_write_keywords(gen, out))
+		return 1;
+	lxrgen_write_trie(gen, out);
+
+	fprintf(out, "static const lexer_kernel_generated_t generated =\n{\n");
+	fprintf(out, "\tchar_class,\n\tstring_end,\n\t");
+	lxrgen_write_byte(out, (unsigned char)kernel->decimal_char);
+	fprintf(out, ",\n\t");
+	lxrgen_write_byte(out, (unsigned char)kernel->escape_char);
+	fprintf(out, ",\n");
+	fprintf(out, "\tkeyword_type,\n\ttrie_next,\n\tdelimiter_type,\n\tcomment_end,\n\tline_comment,\n");
+	fprintf(out, "\t%d,\n};\n\n", kernel->trie_count);
+
+	fprintf(out, "lexer_kernel_t* %s()\n{\n", gen->function);
+	fprintf(out, "\treturn LXRK_CreateGenerated(&generated);\n}\n");
+	return 0;
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+static void print_usage()
+{
+	printf("Usage: lxrgen [description] [output]\n");
+	printf("    [description] is the kernel description file.\n");
+	printf("    [output]      is the C source file to write.\n");
+}
+
+int main(int argc, char** argv)
+{
+	lxrgen_t gen;
+	lexer_kernel_t *kernel;
+	lexer_t *lexer;
+	FILE *out;
+	int err = 1;
+
+	if (argc < 3)
+	{
+		printf(LXRGEN_SPLASH "\n");
+		print_usage();
+		return 2;
+	}
+
+	memset(&gen, 0, sizeof(lxrgen_t));
+	gen.name = argv[1];
+
+	if (!(gen.arena = MT_ArenaCreate(0)) || !(gen.intern = MT_InternCreate(gen.arena, 256)))
+	{
+		fprintf(stderr, "ERROR: Out of memory.\n");
+		return 4;
+	}
+	if (!(kernel = lxrgen_description_kernel()) || !(lexer = LXR_Create(kernel)) || !(gen.parser = PARSER_Create(lexer)))
+	{
+		fprintf(stderr, "ERROR: Out of memory.\n");
+		return 4;
+	}
+	if (LXR_PushStream(lexer, gen.name))
+	{
+		fprintf(stderr, "ERROR: Could not open %s.\n", gen.name);
+		return 3;
+	}
+	if (!(gen.kernel = LXRK_Create()))
+	{
+		fprintf(stderr, "ERROR: Out of memory.\n");
+		return 4;
+	}
+
+	if (!lxrgen_read(&gen))
+	{
+		if (LXRK_Compile(gen.kernel))
+			fprintf(stderr, "ERROR: Out of memory.\n");
+		else if (!(out = fopen(argv[2], "w")))
+			fprintf(stderr, "ERROR: Could not open %s for writing.\n", argv[2]);
+		else
+		{
+			if (lxrgen_write(&gen, out))
+				fprintf(stderr, "ERROR: Out of memory.\n");
+			else
+				err = 0;
+			if (fclose(out))
+				err = 1;
+			if (err)
+				remove(argv[2]);
+		}
+	}
+
+	if (gen.subtypes)
+		free(gen.subtypes);
+	MT_InternDestroy(gen.intern);
+	MT_ArenaDestroy(gen.arena);
+	LXRK_Destroy(gen.kernel);
+	PARSER_Destroy(gen.parser);
+	LXR_Destroy(lexer);
+	LXRK_Destroy(kernel);
+	return err ? 5 : 0;
+}
@@ -0,0 +1,30 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#ifndef __MAPCONFIG_H__
+#define __MAPCONFIG_H__
+
+// Configuration for memory management in other systems.
+
+#ifndef MAP_MALLOC
+#define MAP_MALLOC(s)		malloc((s))
+#endif
+
+#ifndef MAP_FREE
+#define MAP_FREE(s)			free((s))
+#endif
+
+#ifndef MAP_REALLOC
+#define MAP_REALLOC(p,s)	realloc((p),(s))
+#endif
+
+#ifndef MAP_CALLOC
+#define MAP_CALLOC(n,s)		calloc((n),(s))
+#endif
+
+#endif
@@ -0,0 +1,447 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "map_config.h"
+#include "mapdata.h"
+#include "maperrno.h"
+#include "udmf.h"
+#include "io/stream.h"
+#include "wadio/wadstream.h"
+
+// Size of the stack buffer used when decoding from streams.
+#define MAP_CHUNK_SIZE 8192
+
+// Little-endian reads.
+#define MAP_RDI16(p) ((int16_t)((p)[0] | ((p)[1] << 8)))
+#define MAP_RDU16(p) ((int32_t)((p)[0] | ((p)[1] << 8)))
+// Unsigned index, 0xFFFF = none.
+#define MAP_RDIDX(p) ((p)[0] == 0xFF && (p)[1] == 0xFF ? MAP_NO_INDEX : MAP_RDU16(p))
+
+// Decodes "count" records from "src" into data, starting at record "start".
+typedef void (*mapdecodefunc_t)(mapdata_t *data, const unsigned char *src, int start, int count);
+
+// ===========================================================================
+// Private Functions
+// ===========================================================================
+
+// Lays out a column at an offset into the block, and advances the offset.
+// If base is NULL, only the offset is advanced.
+static void* MAP_Column(unsigned char *base, size_t *offset, int count, size_t size)
+{
+	void *out = base ? base + *offset : NULL;
+	*offset += ((size_t)count * size + (MAP_COLUMN_ALIGN - 1)) & ~((size_t)MAP_COLUMN_ALIGN - 1);
+	return out;
+}
+
+// Assigns all columns from a base pointer. Returns the total size of the columns.
+static size_t MAP_DataLayout(mapdata_t *data, unsigned char *base, mapdatacount_t *count)
+{
+	size_t off = 0;
+	int i, j;
+
+	data->things.count = count->things;
+	data->things.x = MAP_Column(base, &off, count->things, sizeof(int32_t));
+	data->things.y = MAP_Column(base, &off, count->things, sizeof(int32_t));
+	data->things.z = MAP_Column(base, &off, count->things, sizeof(int32_t));
+	data->things.angle = MAP_Column(base, &off, count->things, sizeof(int32_t));
+	data->things.type = MAP_Column(base, &off, count->things, sizeof(int32_t));
+	data->things.flags = MAP_Column(base, &off, count->things, sizeof(int32_t));
+	data->things.id = MAP_Column(base, &off, count->things, sizeof(int32_t));
+	data->things.special = MAP_Column(base, &off, count->things, sizeof(int32_t));
+	for (i = 0; i < MAP_ARGS; i++)
+		data->things.arg[i] = MAP_Column(base, &off, count->things, sizeof(int32_t));
+
+	data->linedefs.count = count->linedefs;
+	data->linedefs.v1 = MAP_Column(base, &off, count->linedefs, sizeof(int32_t));
+	data->linedefs.v2 = MAP_Column(base, &off, count->linedefs, sizeof(int32_t));
+	data->linedefs.flags = MAP_Column(base, &off, count->linedefs, sizeof(int32_t));
+	data->linedefs.special = MAP_Column(base, &off, count->linedefs, sizeof(int32_t));
+	data->linedefs.id = MAP_Column(base, &off, count->linedefs, sizeof(int32_t));
+	for (i = 0; i < MAP_ARGS; i++)
+		data->linedefs.arg[i] = MAP_Column(base, &off, count->linedefs, sizeof(int32_t));
+	data->linedefs.front = MAP_Column(base, &off, count->linedefs, sizeof(int32_t));
+	data->linedefs.back = MAP_Column(base, &off, count->linedefs, sizeof(int32_t));
+
+	data->sidedefs.count = count->sidedefs;
+	data->sidedefs.offsetx = MAP_Column(base, &off, count->sidedefs, sizeof(int32_t));
+	data->sidedefs.offsety = MAP_Column(base, &off, count->sidedefs, sizeof(int32_t));
+	data->sidedefs.texturetop = MAP_Column(base, &off, count->sidedefs, sizeof(mapname_t));
+	data->sidedefs.texturebottom = MAP_Column(base, &off, count->sidedefs, sizeof(mapname_t));
+	data->sidedefs.texturemiddle = MAP_Column(base, &off, count->sidedefs, sizeof(mapname_t));
+	data->sidedefs.sector = MAP_Column(base, &off, count->sidedefs, sizeof(int32_t));
+
+	data->vertexes.count = count->vertexes;
+	data->vertexes.x = MAP_Column(base, &off, count->vertexes, sizeof(int32_t));
+	data->vertexes.y = MAP_Column(base, &off, count->vertexes, sizeof(int32_t));
+
+	data->sectors.count = count->sectors;
+	data->sectors.heightfloor = MAP_Column(base, &off, count->sectors, sizeof(int32_t));
+	data->sectors.heightceiling = MAP_Column(base, &off, count->sectors, sizeof(int32_t));
+	data->sectors.texturefloor = MAP_Column(base, &off, count->sectors, sizeof(mapname_t));
+	data->sectors.textureceiling = MAP_Column(base, &off, count->sectors, sizeof(mapname_t));
+	data->sectors.lightlevel = MAP_Column(base, &off, count->sectors, sizeof(int32_t));
+	data->sectors.special = MAP_Column(base, &off, count->sectors, sizeof(int32_t));
+	data->sectors.id = MAP_Column(base, &off, count->sectors, sizeof(int32_t));
+
+	data->segs.count = count->segs;
+	data->segs.v1 = MAP_Column(base, &off, count->segs, sizeof(int32_t));
+	data->segs.v2 = MAP_Column(base, &off, count->segs, sizeof(int32_t));
+	data->segs.angle = MAP_Column(base, &off, count->segs, sizeof(int32_t));
+	data->segs.linedef = MAP_Column(base, &off, count->segs, sizeof(int32_t));
+	data->segs.direction = MAP_Column(base, &off, count->segs, sizeof(int32_t));
+	data->segs.offset = MAP_Column(base, &off, count->segs, sizeof(int32_t));
+
+	data->subsectors.count = count->subsectors;
+	data->subsectors.segcount = MAP_Column(base, &off, count->subsectors, sizeof(int32_t));
+	data->subsectors.firstseg = MAP_Column(base, &off, count->subsectors, sizeof(int32_t));
+
+	data->nodes.count = count->nodes;
+	data->nodes.x = MAP_Column(base, &off, count->nodes, sizeof(int32_t));
+	data->nodes.y = MAP_Column(base, &off, count->nodes, sizeof(int32_t));
+	data->nodes.dx = MAP_Column(base, &off, count->nodes, sizeof(int32_t));
+	data->nodes.dy = MAP_Column(base, &off, count->nodes, sizeof(int32_t));
+	for (i = 0; i < 2; i++)
+		for (j = 0; j < 4; j++)
+			data->nodes.bbox[i][j] = MAP_Column(base, &off, count->nodes, sizeof(int32_t));
+	data->nodes.child[0] = MAP_Column(base, &off, count->nodes, sizeof(int32_t));
+	data->nodes.child[1] = MAP_Column(base, &off, count->nodes, sizeof(int32_t));
+
+	return off;
+}
+
+static void MAP_DecodeDoomThings(mapdata_t *data, const unsigned char *src, int start, int count)
+{
+	mapthings_t *t = &(data->things);
+	int i, end = start + count;
+	for (i = start; i < end; i++, src += MAP_DOOM_THING_SIZE)
+	{
+		t->x[i] = MAP_RDI16(src) * MAP_FRACUNIT;
+		t->y[i] = MAP_RDI16(src + 2) * MAP_FRACUNIT;
+		t->angle[i] = MAP_RDI16(src + 4);
+		t->type[i] = MAP_RDU16(src + 6);
+		t->flags[i] = MAP_RDU16(src + 8);
+	}
+}
+
+static void MAP_DecodeHexenThings(mapdata_t *data, const unsigned char *src, int start, int count)
+{
+	mapthings_t *t = &(data->things);
+	int i, end = start + count;
+	for (i = start; i < end; i++, src += MAP_HEXEN_THING_SIZE)
+	{
+		t->id[i] = MAP_RDU16(src);
+		t->x[i] = MAP_RDI16(src + 2) * MAP_FRACUNIT;
+		t->y[i] = MAP_RDI16(src + 4) * MAP_FRACUNIT;
+		t->z[i] = MAP_RDI16(src + 6) * MAP_FRACUNIT;
+		t->angle[i] = MAP_RDI16(src + 8);
+		t->type[i] = MAP_RDU16(src + 10);
+		t->flags[i] = MAP_RDU16(src + 12);
+		t->special[i] = src[14];
+		t->arg[0][i] = src[15];
+		t->arg[1][i] = src[16];
+		t->arg[2][i] = src[17];
+		t->arg[3][i] = src[18];
+		t->arg[4][i] = src[19];
+	}
+}
+
+static void MAP_DecodeDoomLinedefs(mapdata_t *data, const unsigned char *src, int start, int count)
+{
+	maplinedefs_t *l = &(data->linedefs);
+	int i, end = start + count;
+	for (i = start; i < end; i++, src += MAP_DOOM_LINEDEF_SIZE)
+	{
+		l->v1[i] = MAP_RDU16(src);
+		l->v2[i] = MAP_RDU16(src + 2);
+		l->flags[i] = MAP_RDU16(src + 4);
+		l->special[i] = MAP_RDU16(src + 6);
+		l->id[i] = MAP_RDU16(src + 8);
+		l->front[i] = MAP_RDIDX(src + 10);
+		l->back[i] = MAP_RDIDX(src + 12);
+	}
+}
+
+static void MAP_DecodeHexenLinedefs(mapdata_t *data, const unsigned char *src, int start, int count)
+{
+	maplinedefs_t *l = &(data->linedefs);
+	int i, end = start + count;
+	for (i = start; i < end; i++, src += MAP_HEXEN_LINEDEF_SIZE)
+	{
+		l->v1[i] = MAP_RDU16(src);
+		l->v2[i] = MAP_RDU16(src + 2);
+		l->flags[i] = MAP_RDU16(src + 4);
+		l->special[i] = src[6];
+		l->arg[0][i] = src[7];
+		l->arg[1][i] = src[8];
+		l->arg[2][i] = src[9];
+		l->arg[3][i] = src[10];
+		l->arg[4][i] = src[11];
+		l->front[i] = MAP_RDIDX(src + 12);
+		l->back[i] = MAP_RDIDX(src + 14);
+	}
+}
+
+static void MAP_DecodeSidedefs(mapdata_t *data, const unsigned char *src, int start, int count)
+{
+	mapsidedefs_t *s = &(data->sidedefs);
+	int i, end = start + count;
+	for (i = start; i < end; i++, src += MAP_SIDEDEF_SIZE)
+	{
+		s->offsetx[i] = MAP_RDI16(src) * MAP_FRACUNIT;
+		s->offsety[i] = MAP_RDI16(src + 2) * MAP_FRACUNIT;
+		memcpy(s->texturetop[i], src + 4, MAP_NAME_LENGTH);
+		memcpy(s->texturebottom[i], src + 12, MAP_NAME_LENGTH);
+		memcpy(s->texturemiddle[i], src + 20, MAP_NAME_LENGTH);
+		s->sector[i] = MAP_RDU16(src + 28);
+	}
+}
+
+static void MAP_DecodeVertexes(mapdata_t *data, const unsigned char *src, int start, int count)
+{
+	mapvertexes_t *v = &(data->vertexes);
+	int i, end = start + count;
+	for (i = start; i < end; i++, src += MAP_VERTEX_SIZE)
+	{
+		v->x[i] = MAP_RDI16(src) * MAP_FRACUNIT;
+		v->y[i] = MAP_RDI16(src + 2) * MAP_FRACUNIT;
+	}
+}
+
+static void MAP_DecodeSectors(mapdata_t *data, const unsigned char *src, int start, int count)
+{
+	mapsectors_t *s = &(data->sectors);
+	int i, end = start + count;
+	for (i = start; i < end; i++, src += MAP_SECTOR_SIZE)
+	{
+		s->heightfloor[i] = MAP_RDI16(src) * MAP_FRACUNIT;
+		s->heightceiling[i] = MAP_RDI16(src + 2) * MAP_FRACUNIT;
+		memcpy(s->texturefloor[i], src + 4, MAP_NAME_LENGTH);
+		memcpy(s->textureceiling[i], src + 12, MAP_NAME_LENGTH);
+		s->lightlevel[i] = MAP_RDI16(src + 20);
+		s->special[i] = MAP_RDU16(src + 22);
+		s->id[i] = MAP_RDU16(src + 24);
+	}
+}
+
+static void MAP_DecodeSegs(mapdata_t *data, const unsigned char *src, int start, int count)
+{
+	mapsegs_t *s = &(data->segs);
+	int i, end = start + count;
+	for (i = start; i < end; i++, src += MAP_SEG_SIZE)
+	{
+		s->v1[i] = MAP_RDU16(src);
+		s->v2[i] = MAP_RDU16(src + 2);
+		s->angle[i] = MAP_RDU16(src + 4);
+		s->linedef[i] = MAP_RDU16(src + 6);
+		s->direction[i] = MAP_RDI16(src + 8);
+		s->offset[i] = MAP_RDI16(src + 10) * MAP_FRACUNIT;
+	}
+}
+
+static void MAP_DecodeSubsectors(mapdata_t *data, const unsigned char *src, int start, int count)
+{
+	mapsubsectors_t *s = &(data->subsectors);
+	int i, end = start + count;
+	for (i = start; i < end; i++, src += MAP_SUBSECTOR_SIZE)
+	{
+		s->segcount[i] = MAP_RDU16(src);
+		s->firstseg[i] = MAP_RDU16(src + 2);
+	}
+}
+
+static void MAP_DecodeNodes(mapdata_t *data, const unsigned char *src, int start, int count)
+{
+	mapnodes_t *n = &(data->nodes);
+	int i, j, end = start + count;
+	for (i = start; i < end; i++, src += MAP_NODE_SIZE)
+	{
+		n->x[i] = MAP_RDI16(src) * MAP_FRACUNIT;
+		n->y[i] = MAP_RDI16(src + 2) * MAP_FRACUNIT;
+		n->dx[i] = MAP_RDI16(src + 4) * MAP_FRACUNIT;
+		n->dy[i] = MAP_RDI16(src + 6) * MAP_FRACUNIT;
+		for (j = 0; j < 4; j++)
+		{
+			n->bbox[0][j][i] = MAP_RDI16(src + 8 + (j * 2)) * MAP_FRACUNIT;
+			n->bbox[1][j][i] = MAP_RDI16(src + 16 + (j * 2)) * MAP_FRACUNIT;
+		}
+		n->child[0][i] = MAP_RDU16(src + 24);
+		n->child[1][i] = MAP_RDU16(src + 26);
+	}
+}
+
+// Gets the amount of whole records in a map entry.
+static int MAP_RecordCount(wad_t *wad, mapindexentry_t *map, maplump_t lump, int recsize)
+{
+	wadentry_t *entry;
+	if (map->lumps[lump] < 0)
+		return 0;
+	entry = WAD_GetEntry(wad, map->lumps[lump]);
+	return entry->length > 0 ? entry->length / recsize : 0;
+}
+
+// Decodes all records of one entry.
+// Buffer WADs are decoded in place, others are streamed through a stack buffer.
+static int MAP_DecodeLump(wad_t *wad, mapdata_t *data, int index, int count, int recsize, mapdecodefunc_t decode)
+{
+	unsigned char chunk[MAP_CHUNK_SIZE];
+	wadentry_t *entry;
+	stream_t *stream;
+	int start, n, max;
+
+	if (index < 0 || count <= 0)
+		return 0;
+
+	entry = WAD_GetEntry(wad, index);
+	if (wad->type == WI_BUFFER)
+	{
+		decode(data, wad->handle.buffer + (entry->offset - sizeof(wadheader_t)), 0, count);
+		return 0;
+	}
+
+	if (!(stream = STREAM_OpenWADStream(wad, entry)))
+	{
+		maperrno = MAPERROR_WAD_ERROR;
+		return 1;
+	}
+
+	max = MAP_CHUNK_SIZE / recsize;
+	start = 0;
+	while (start < count && (n = STREAM_Read(stream, chunk, recsize, count - start < max ? count - start : max)) > 0)
+	{
+		decode(data, chunk, start, n);
+		start += n;
+	}
+	STREAM_Close(stream);
+
+	if (start < count)
+	{
+		maperrno = MAPERROR_WAD_ERROR;
+		return 1;
+	}
+	return 0;
+}
+
+// ===========================================================================
+// Public Functions
+// ===========================================================================
+
+// ---------------------------------------------------------------
+// mapdata_t* MAP_DataCreate(mapformat_t format, mapdatacount_t *count)
+// See mapdata.h
+// ---------------------------------------------------------------
+mapdata_t* MAP_DataCreate(mapformat_t format, mapdatacount_t *count)
+{
+	mapdata_t layout, *out;
+	size_t header, size;
+	unsigned char *base;
+
+	maperrno = MAPERROR_NO_ERROR;
+
+	// Header is padded so that the columns after it start aligned.
+	header = (sizeof(mapdata_t) + (MAP_COLUMN_ALIGN - 1)) & ~((size_t)MAP_COLUMN_ALIGN - 1);
+	size = header + MAP_DataLayout(&layout, NULL, count) + MAP_COLUMN_ALIGN;
+
+	if (!(out = (mapdata_t*)MAP_CALLOC(1, size)))
+	{
+		maperrno = MAPERROR_OUT_OF_MEMORY;
+		return NULL;
+	}
+
+	base = (unsigned char*)out + header;
+	base += (MAP_COLUMN_ALIGN - ((uintptr_t)base % MAP_COLUMN_ALIGN)) % MAP_COLUMN_ALIGN;
+	MAP_DataLayout(out, base, count);
+	out->format = format;
+	out->size = size;
+	return out;
+}
+
+// ---------------------------------------------------------------
+// mapdata_t* MAP_DataRead(wad_t *wad, mapindexentry_t *map)
+// See mapdata.h
+// ---------------------------------------------------------------
+mapdata_t* MAP_DataRead(wad_t *wad, mapindexentry_t *map)
+{
+	mapdatacount_t count;
+	mapdata_t *out;
+	int hexen, err;
+	int thingsize, linesize;
+
+	maperrno = MAPERROR_NO_ERROR;
+
+	if (!wad || !map)
+	{
+		maperrno = MAPERROR_WAD_ERROR;
+		return NULL;
+	}
+	if (wad->type != WI_FILE && wad->type != WI_BUFFER)
+	{
+		maperrno = MAPERROR_NOT_SUPPORTED;
+		return NULL;
+	}
+	if (map->format == MF_UDMF)
+	{
+		if (map->lumps[ML_TEXTMAP] < 0)
+		{
+			maperrno = MAPERROR_MISSING_LUMP;
+			return NULL;
+		}
+		return MAP_ParseUDMF(STREAM_OpenWADStream(wad, WAD_GetEntry(wad, map->lumps[ML_TEXTMAP])), "TEXTMAP");
+	}
+	if (map->format != MF_DOOM && map->format != MF_HEXEN)
+	{
+		maperrno = MAPERROR_NOT_SUPPORTED;
+		return NULL;
+	}
+
+	hexen = map->format == MF_HEXEN;
+	thingsize = hexen ? MAP_HEXEN_THING_SIZE : MAP_DOOM_THING_SIZE;
+	linesize = hexen ? MAP_HEXEN_LINEDEF_SIZE : MAP_DOOM_LINEDEF_SIZE;
+
+	count.things = MAP_RecordCount(wad, map, ML_THINGS, thingsize);
+	count.linedefs = MAP_RecordCount(wad, map, ML_LINEDEFS, linesize);
+	count.sidedefs = MAP_RecordCount(wad, map, ML_SIDEDEFS, MAP_SIDEDEF_SIZE);
+	count.vertexes = MAP_RecordCount(wad, map, ML_VERTEXES, MAP_VERTEX_SIZE);
+	count.sectors = MAP_RecordCount(wad, map, ML_SECTORS, MAP_SECTOR_SIZE);
+	count.segs = MAP_RecordCount(wad, map, ML_SEGS, MAP_SEG_SIZE);
+	count.subsectors = MAP_RecordCount(wad, map, ML_SSECTORS, MAP_SUBSECTOR_SIZE);
+	count.nodes = MAP_RecordCount(wad, map, ML_NODES, MAP_NODE_SIZE);
+
+	if (!(out = MAP_DataCreate(map->format, &count)))
+		return NULL;
+
+	err = MAP_DecodeLump(wad, out, map->lumps[ML_THINGS], count.things, thingsize, hexen ? &MAP_DecodeHexenThings : &MAP_DecodeDoomThings)
+		|| MAP_DecodeLump(wad, out, map->lumps[ML_LINEDEFS], count.linedefs, linesize, hexen ? &MAP_DecodeHexenLinedefs : &MAP_DecodeDoomLinedefs)
+		|| MAP_DecodeLump(wad, out, map->lumps[ML_SIDEDEFS], count.sidedefs, MAP_SIDEDEF_SIZE, &MAP_DecodeSidedefs)
+		|| MAP_DecodeLump(wad, out, map->lumps[ML_VERTEXES], count.vertexes, MAP_VERTEX_SIZE, &MAP_DecodeVertexes)
+		|| MAP_DecodeLump(wad, out, map->lumps[ML_SECTORS], count.sectors, MAP_SECTOR_SIZE, &MAP_DecodeSectors)
+		|| MAP_DecodeLump(wad, out, map->lumps[ML_SEGS], count.segs, MAP_SEG_SIZE, &MAP_DecodeSegs)
+		|| MAP_DecodeLump(wad, out, map->lumps[ML_SSECTORS], count.subsectors, MAP_SUBSECTOR_SIZE, &MAP_DecodeSubsectors)
+		|| MAP_DecodeLump(wad, out, map->lumps[ML_NODES], count.nodes, MAP_NODE_SIZE, &MAP_DecodeNodes);
+
+	if (err)
+	{
+		MAP_DataDestroy(out);
+		return NULL;
+	}
+
+	return out;
+}
+
+// ---------------------------------------------------------------
+// int MAP_DataDestroy(mapdata_t *data)
+// See mapdata.h
+// ---------------------------------------------------------------
+int MAP_DataDestroy(mapdata_t *data)
+{
+	if (!data)
+		return 1;
+	MAP_FREE(data);
+	return 0;
+}
@@ -0,0 +1,278 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#ifndef __MAPDATA_H__
+#define __MAPDATA_H__
+
+#include <stdint.h>
+#include "wad/wad.h"
+#include "mapindex.h"
+
+// Fixed-point format for coordinates (16.16, like the Doom engine).
+// All positions, heights, and distances in map space use it; everything else
+// (angles, flags, specials, indices, light levels) is kept as stored.
+#define MAP_FRACBITS		16
+#define MAP_FRACUNIT		(1 << MAP_FRACBITS)
+
+// Amount of special arguments on things and linedefs.
+#define MAP_ARGS			5
+// Length of texture/flat names.
+#define MAP_NAME_LENGTH		8
+// Index value for "no reference" (for example, no back sidedef).
+#define MAP_NO_INDEX		-1
+// Byte alignment of each data column.
+#define MAP_COLUMN_ALIGN	32
+
+// Binary record sizes.
+#define MAP_DOOM_THING_SIZE		10
+#define MAP_HEXEN_THING_SIZE	20
+#define MAP_DOOM_LINEDEF_SIZE	14
+#define MAP_HEXEN_LINEDEF_SIZE	16
+#define MAP_SIDEDEF_SIZE		30
+#define MAP_VERTEX_SIZE			4
+#define MAP_SECTOR_SIZE			26
+#define MAP_SEG_SIZE			12
+#define MAP_SUBSECTOR_SIZE		4
+#define MAP_NODE_SIZE			28
+
+/**
+ * A texture or flat name.
+ * Not null-terminated if all 8 characters are used!
+ */
+typedef char mapname_t[MAP_NAME_LENGTH];
+
+/**
+ * Thing columns.
+ * Coordinates are 16.16 fixed-point.
+ */
+typedef struct {
+
+	/** Amount of things. */
+	int count;
+	/** Position. */
+	int32_t *x;
+	int32_t *y;
+	/** Height offset (Hexen/UDMF, else 0). */
+	int32_t *z;
+	/** Angle in degrees. */
+	int32_t *angle;
+	/** Editor number. */
+	int32_t *type;
+	/** Flags. */
+	int32_t *flags;
+	/** Thing id (Hexen/UDMF, else 0). */
+	int32_t *id;
+	/** Special (Hexen/UDMF, else 0). */
+	int32_t *special;
+	/** Special arguments (Hexen/UDMF, else 0). */
+	int32_t *arg[MAP_ARGS];
+
+} mapthings_t;
+
+/**
+ * Linedef columns.
+ */
+typedef struct {
+
+	/** Amount of linedefs. */
+	int count;
+	/** Start and end vertex. */
+	int32_t *v1;
+	int32_t *v2;
+	/** Flags. */
+	int32_t *flags;
+	/** Special. */
+	int32_t *special;
+	/** Sector tag (Doom) or line id (UDMF), else 0. */
+	int32_t *id;
+	/** Special arguments (Hexen/UDMF, else 0). */
+	int32_t *arg[MAP_ARGS];
+	/** Front and back sidedef, or MAP_NO_INDEX. */
+	int32_t *front;
+	int32_t *back;
+
+} maplinedefs_t;
+
+/**
+ * Sidedef columns.
+ * Offsets are 16.16 fixed-point.
+ */
+typedef struct {
+
+	/** Amount of sidedefs. */
+	int count;
+	/** Texture offsets. */
+	int32_t *offsetx;
+	int32_t *offsety;
+	/** Textures. */
+	mapname_t *texturetop;
+	mapname_t *texturebottom;
+	mapname_t *texturemiddle;
+	/** Facing sector. */
+	int32_t *sector;
+
+} mapsidedefs_t;
+
+/**
+ * Vertex columns.
+ * Coordinates are 16.16 fixed-point.
+ */
+typedef struct {
+
+	/** Amount of vertices. */
+	int count;
+	/** Position. */
+	int32_t *x;
+	int32_t *y;
+
+} mapvertexes_t;
+
+/**
+ * Sector columns.
+ * Heights are 16.16 fixed-point.
+ */
+typedef struct {
+
+	/** Amount of sectors. */
+	int count;
+	/** Heights. */
+	int32_t *heightfloor;
+	int32_t *heightceiling;
+	/** Flats. */
+	mapname_t *texturefloor;
+	mapname_t *textureceiling;
+	/** Light level. */
+	int32_t *lightlevel;
+	/** Special. */
+	int32_t *special;
+	/** Tag/id. */
+	int32_t *id;
+
+} mapsectors_t;
+
+/**
+ * Seg columns (binary maps only).
+ * Offsets are 16.16 fixed-point.
+ */
+typedef struct {
+
+	/** Amount of segs. */
+	int count;
+	/** Start and end vertex. */
+	int32_t *v1;
+	int32_t *v2;
+	/** Binary angle (0 - 65535). */
+	int32_t *angle;
+	/** Linedef. */
+	int32_t *linedef;
+	/** 0 = same direction as linedef, 1 = opposite. */
+	int32_t *direction;
+	/** Offset along linedef. */
+	int32_t *offset;
+
+} mapsegs_t;
+
+/**
+ * Subsector columns (binary maps only).
+ */
+typedef struct {
+
+	/** Amount of subsectors. */
+	int count;
+	/** Amount of segs. */
+	int32_t *segcount;
+	/** First seg. */
+	int32_t *firstseg;
+
+} mapsubsectors_t;
+
+/**
+ * Node columns (binary maps only).
+ * Partition lines and bounding boxes are 16.16 fixed-point.
+ */
+typedef struct {
+
+	/** Amount of nodes. */
+	int count;
+	/** Partition line. */
+	int32_t *x;
+	int32_t *y;
+	int32_t *dx;
+	int32_t *dy;
+	/** Right [0] and left [1] bounding boxes: top, bottom, left, right. */
+	int32_t *bbox[2][4];
+	/** Right [0] and left [1] children (bit 15 set = subsector). */
+	int32_t *child[2];
+
+} mapnodes_t;
+
+/**
+ * Amounts of each kind of map object, for allocation.
+ */
+typedef struct {
+
+	int things;
+	int linedefs;
+	int sidedefs;
+	int vertexes;
+	int sectors;
+	int segs;
+	int subsectors;
+	int nodes;
+
+} mapdatacount_t;
+
+/**
+ * Decoded map data.
+ * This structure and all of its columns are one allocation.
+ */
+typedef struct {
+
+	/** Source map format. */
+	mapformat_t format;
+	/** Total allocated size in bytes. */
+	size_t size;
+
+	mapthings_t things;
+	maplinedefs_t linedefs;
+	mapsidedefs_t sidedefs;
+	mapvertexes_t vertexes;
+	mapsectors_t sectors;
+	mapsegs_t segs;
+	mapsubsectors_t subsectors;
+	mapnodes_t nodes;
+
+} mapdata_t;
+
+/**
+ * Creates a new, zeroed map data structure with room for a set amount of each object.
+ * @param format the map format.
+ * @param count the amount of each kind of object.
+ * @return a newly-allocated map data structure, or NULL on error (sets maperrno).
+ */
+mapdata_t* MAP_DataCreate(mapformat_t format, mapdatacount_t *count);
+
+/**
+ * Reads and decodes a map from a WAD.
+ * Binary lumps are read with STREAM_OpenWADStream (or directly from memory for buffer WADs).
+ * Trailing bytes that do not make a full record are ignored.
+ * UDMF maps are parsed from their TEXTMAP with MAP_ParseUDMF (see udmf.h).
+ * @param wad the WAD to read from (not WI_MAP).
+ * @param map the map to read (from a MAP_IndexCreate on the same WAD).
+ * @return newly-allocated map data, or NULL on error (sets maperrno).
+ */
+mapdata_t* MAP_DataRead(wad_t *wad, mapindexentry_t *map);
+
+/**
+ * Destroys map data.
+ * @param data the data to destroy.
+ * @return 0 if successful, nonzero if not.
+ */
+int MAP_DataDestroy(mapdata_t *data);
+
+#endif
@@ -0,0 +1,30 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#include <stdio.h>
+#include "maperrno.h"
+
+int maperrno = MAPERROR_NO_ERROR;
+
+static char *maperr[MAPERROR_COUNT] = {
+	"No error.",
+	"WAD error.",
+	"Operation not supported for this WAD or map format.",
+	"Out of memory.",
+	"Bad map format.",
+	"Map is missing a required entry.",
+	"Could not parse map data.",
+};
+
+char* strmaperror(int n)
+{
+	if (n < 0 || n >= MAPERROR_COUNT)
+		return NULL;
+	else
+		return maperr[n];
+}
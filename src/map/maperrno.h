@@ -0,0 +1,35 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#ifndef __MAPERRNO_H__
+#define __MAPERRNO_H__
+
+// This is meant to be used like <errno.h>. Map reading errors are raised here.
+// All calls into MAP_Data* functions manipulate this value.
+
+#define MAPERROR_NO_ERROR				0
+#define MAPERROR_WAD_ERROR				1
+#define MAPERROR_NOT_SUPPORTED			2
+#define MAPERROR_OUT_OF_MEMORY			3
+#define MAPERROR_BAD_FORMAT				4
+#define MAPERROR_MISSING_LUMP			5
+#define MAPERROR_PARSE_ERROR			6
+#define MAPERROR_COUNT					7
+
+/**
+ * Map error number.
+ * If this is MAPERROR_WAD_ERROR, waderrno has the cause.
+ */
+extern int maperrno;
+
+/**
+ * Get the string representation of an error.
+ */
+char* strmaperror(int n);
+
+#endif
@@ -0,0 +1,261 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "mapfilter.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// How a test result is combined into a mask.
+#define MASKOP_SET	0
+#define MASKOP_AND	1
+#define MASKOP_OR	2
+
+// ===========================================================================
+// Private Functions
+// ===========================================================================
+
+// Combines a scalar test result (0 or 1) into a mask byte.
+static inline void MAP_MaskApply(uint8_t *mask, int result, int op)
+{
+	uint8_t m = (uint8_t)(-result);
+	switch (op)
+	{
+		case MASKOP_SET: *mask = m; break;
+		case MASKOP_AND: *mask &= m; break;
+		case MASKOP_OR: *mask |= m; break;
+	}
+}
+
+#ifdef __SSE2__
+
+// Packs four vectors of 32-bit lane masks (0 or -1) into one vector of 16 byte masks.
+static inline __m128i MAP_VecPack(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+	return _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+}
+
+// Combines 16 byte masks into a mask.
+static inline void MAP_VecApply(uint8_t *mask, __m128i m, int op)
+{
+	__m128i *p = (__m128i*)mask;
+	switch (op)
+	{
+		case MASKOP_SET: _mm_storeu_si128(p, m); break;
+		case MASKOP_AND: _mm_storeu_si128(p, _mm_and_si128(_mm_loadu_si128(p), m)); break;
+		case MASKOP_OR: _mm_storeu_si128(p, _mm_or_si128(_mm_loadu_si128(p), m)); break;
+	}
+}
+
+// Lane mask of values outside of [lo, hi].
+static inline __m128i MAP_VecOutside(const int32_t *column, __m128i lo, __m128i hi)
+{
+	__m128i v = _mm_loadu_si128((const __m128i*)column);
+	return _mm_or_si128(_mm_cmplt_epi32(v, lo), _mm_cmpgt_epi32(v, hi));
+}
+
+// Lane mask of values where (value & bits) == want.
+static inline __m128i MAP_VecBits(const int32_t *column, __m128i bits, __m128i want)
+{
+	__m128i v = _mm_loadu_si128((const __m128i*)column);
+	return _mm_cmpeq_epi32(_mm_and_si128(v, bits), want);
+}
+
+#endif
+
+// Range test kernel. If invert is nonzero, tests for values outside of the range.
+static inline void MAP_MaskRange(const int32_t *column, int count, int32_t lo, int32_t hi, uint8_t *mask, int op, int invert)
+{
+	int i = 0;
+
+#ifdef __SSE2__
+	__m128i vlo = _mm_set1_epi32(lo);
+	__m128i vhi = _mm_set1_epi32(hi);
+	__m128i vinv = invert ? _mm_setzero_si128() : _mm_set1_epi32(-1);
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i m = MAP_VecPack(
+			_mm_xor_si128(MAP_VecOutside(column + i, vlo, vhi), vinv),
+			_mm_xor_si128(MAP_VecOutside(column + i + 4, vlo, vhi), vinv),
+			_mm_xor_si128(MAP_VecOutside(column + i + 8, vlo, vhi), vinv),
+			_mm_xor_si128(MAP_VecOutside(column + i + 12, vlo, vhi), vinv)
+		);
+		MAP_VecApply(mask + i, m, op);
+	}
+#endif
+
+	for (; i < count; i++)
+		MAP_MaskApply(mask + i, ((column[i] >= lo) & (column[i] <= hi)) ^ (invert != 0), op);
+}
+
+// Bit test kernel. If invert is nonzero, tests for (value & bits) != want.
+static inline void MAP_MaskBits(const int32_t *column, int count, int32_t bits, int32_t want, uint8_t *mask, int op, int invert)
+{
+	int i = 0;
+
+#ifdef __SSE2__
+	__m128i vbits = _mm_set1_epi32(bits);
+	__m128i vwant = _mm_set1_epi32(want);
+	__m128i vinv = invert ? _mm_set1_epi32(-1) : _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i m = MAP_VecPack(
+			_mm_xor_si128(MAP_VecBits(column + i, vbits, vwant), vinv),
+			_mm_xor_si128(MAP_VecBits(column + i + 4, vbits, vwant), vinv),
+			_mm_xor_si128(MAP_VecBits(column + i + 8, vbits, vwant), vinv),
+			_mm_xor_si128(MAP_VecBits(column + i + 12, vbits, vwant), vinv)
+		);
+		MAP_VecApply(mask + i, m, op);
+	}
+#endif
+
+	for (; i < count; i++)
+		MAP_MaskApply(mask + i, ((column[i] & bits) == want) ^ (invert != 0), op);
+}
+
+// ===========================================================================
+// Public Functions
+// ===========================================================================
+
+// ---------------------------------------------------------------
+// void MAP_ThingFilterInit(mapthingfilter_t *filter)
+// See mapfilter.h
+// ---------------------------------------------------------------
+void MAP_ThingFilterInit(mapthingfilter_t *filter)
+{
+	memset(filter, 0, sizeof(mapthingfilter_t));
+}
+
+// ---------------------------------------------------------------
+// int MAP_ThingFilterAddTypes(mapthingfilter_t *filter, int32_t lo, int32_t hi)
+// See mapfilter.h
+// ---------------------------------------------------------------
+int MAP_ThingFilterAddTypes(mapthingfilter_t *filter, int32_t lo, int32_t hi)
+{
+	if (filter->type_count >= MAPFILTER_TYPES_MAX)
+		return 1;
+	filter->types[filter->type_count].lo = lo < hi ? lo : hi;
+	filter->types[filter->type_count].hi = lo < hi ? hi : lo;
+	filter->type_count++;
+	return 0;
+}
+
+// ---------------------------------------------------------------
+// int MAP_FilterThings(mapthings_t *things, mapthingfilter_t *filter, uint8_t *mask)
+// See mapfilter.h
+// ---------------------------------------------------------------
+int MAP_FilterThings(mapthings_t *things, mapthingfilter_t *filter, uint8_t *mask)
+{
+	int i, count = things->count;
+
+	if (count <= 0)
+		return 0;
+
+	if (filter->type_count)
+	{
+		MAP_MaskSetRange(things->type, count, &(filter->types[0]), mask);
+		for (i = 1; i < filter->type_count; i++)
+			MAP_MaskOrRange(things->type, count, &(filter->types[i]), mask);
+	}
+	else
+	{
+		memset(mask, MAPFILTER_MATCH, count);
+	}
+
+	if (filter->flags_all)
+		MAP_MaskAndBits(things->flags, count, filter->flags_all, filter->flags_all, mask);
+	if (filter->flags_any)
+		MAP_MaskAndAnyBits(things->flags, count, filter->flags_any, mask);
+	if (filter->flags_none)
+		MAP_MaskAndBits(things->flags, count, filter->flags_none, 0, mask);
+
+	if (filter->use_box)
+	{
+		MAP_MaskAndRange(things->x, count, &(filter->box_x), mask);
+		MAP_MaskAndRange(things->y, count, &(filter->box_y), mask);
+	}
+
+	if (filter->use_angle)
+	{
+		if (filter->angle.lo <= filter->angle.hi)
+			MAP_MaskAndRange(things->angle, count, &(filter->angle), mask);
+		else // wraps around: not in the gap between hi and lo.
+			MAP_MaskRange(things->angle, count, filter->angle.hi + 1, filter->angle.lo - 1, mask, MASKOP_AND, 1);
+	}
+
+	return MAP_MaskCount(mask, count);
+}
+
+// ---------------------------------------------------------------
+// void MAP_MaskSetRange(const int32_t *column, int count, maprange_t *range, uint8_t *mask)
+// See mapfilter.h
+// ---------------------------------------------------------------
+void MAP_MaskSetRange(const int32_t *column, int count, maprange_t *range, uint8_t *mask)
+{
+	MAP_MaskRange(column, count, range->lo, range->hi, mask, MASKOP_SET, 0);
+}
+
+// ---------------------------------------------------------------
+// void MAP_MaskAndRange(const int32_t *column, int count, maprange_t *range, uint8_t *mask)
+// See mapfilter.h
+// ---------------------------------------------------------------
+void MAP_MaskAndRange(const int32_t *column, int count, maprange_t *range, uint8_t *mask)
+{
+	MAP_MaskRange(column, count, range->lo, range->hi, mask, MASKOP_AND, 0);
+}
+
+// ---------------------------------------------------------------
+// void MAP_MaskOrRange(const int32_t *column, int count, maprange_t *range, uint8_t *mask)
+// See mapfilter.h
+// ---------------------------------------------------------------
+void MAP_MaskOrRange(const int32_t *column, int count, maprange_t *range, uint8_t *mask)
+{
+	MAP_MaskRange(column, count, range->lo, range->hi, mask, MASKOP_OR, 0);
+}
+
+// ---------------------------------------------------------------
+// void MAP_MaskAndBits(const int32_t *column, int count, int32_t bits, int32_t want, uint8_t *mask)
+// See mapfilter.h
+// ---------------------------------------------------------------
+void MAP_MaskAndBits(const int32_t *column, int count, int32_t bits, int32_t want, uint8_t *mask)
+{
+	MAP_MaskBits(column, count, bits, want, mask, MASKOP_AND, 0);
+}
+
+// ---------------------------------------------------------------
+// void MAP_MaskAndAnyBits(const int32_t *column, int count, int32_t bits, uint8_t *mask)
+// See mapfilter.h
+// ---------------------------------------------------------------
+void MAP_MaskAndAnyBits(const int32_t *column, int count, int32_t bits, uint8_t *mask)
+{
+	MAP_MaskBits(column, count, bits, 0, mask, MASKOP_AND, 1);
+}
+
+// ---------------------------------------------------------------
+// int MAP_MaskCount(const uint8_t *mask, int count)
+// See mapfilter.h
+// ---------------------------------------------------------------
+int MAP_MaskCount(const uint8_t *mask, int count)
+{
+	int i = 0, out = 0;
+
+#ifdef __SSE2__
+	__m128i ones = _mm_set1_epi8(1);
+	__m128i sum = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16)
+		sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_and_si128(_mm_loadu_si128((const __m128i*)(mask + i)), ones), _mm_setzero_si128()));
+	out = _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+#endif
+
+	for (; i < count; i++)
+		out += mask[i] & 1;
+	return out;
+}
@@ -0,0 +1,142 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#ifndef __MAPFILTER_H__
+#define __MAPFILTER_H__
+
+#include <stdint.h>
+#include "mapdata.h"
+
+// Maximum amount of type ranges in a filter.
+#define MAPFILTER_TYPES_MAX 64
+
+// Mask values.
+#define MAPFILTER_MATCH		0xFF
+#define MAPFILTER_NOMATCH	0x00
+
+/**
+ * An inclusive range of values.
+ */
+typedef struct {
+
+	int32_t lo;
+	int32_t hi;
+
+} maprange_t;
+
+/**
+ * Thing filter criteria.
+ * All set criteria must pass for a thing to match.
+ */
+typedef struct {
+
+	/** Amount of type ranges. If 0, any type passes. */
+	int type_count;
+	/** Type ranges - a thing passes if its type is in any of them. */
+	maprange_t types[MAPFILTER_TYPES_MAX];
+
+	/** Flags that must all be set. */
+	int32_t flags_all;
+	/** Flags of which at least one must be set (0 = no test). */
+	int32_t flags_any;
+	/** Flags that must all be clear. */
+	int32_t flags_none;
+
+	/** If nonzero, test position box. */
+	int use_box;
+	/** Position box (16.16 fixed-point, inclusive). */
+	maprange_t box_x;
+	maprange_t box_y;
+
+	/** If nonzero, test angle. */
+	int use_angle;
+	/** Angle range in degrees. If lo > hi, the range wraps around (for example, 315 to 45). */
+	maprange_t angle;
+
+} mapthingfilter_t;
+
+/**
+ * Initializes a thing filter that matches everything.
+ * @param filter the filter to initialize.
+ */
+void MAP_ThingFilterInit(mapthingfilter_t *filter);
+
+/**
+ * Adds a range of types to a thing filter.
+ * @param filter the filter.
+ * @param lo the lowest type, inclusive.
+ * @param hi the highest type, inclusive.
+ * @return 0 if added, nonzero if the filter is full.
+ */
+int MAP_ThingFilterAddTypes(mapthingfilter_t *filter, int32_t lo, int32_t hi);
+
+/**
+ * Filters things.
+ * Each criterion is applied to its whole column at once with compare-and-mask kernels (SSE2 if available).
+ * @param things the thing columns.
+ * @param filter the filter criteria.
+ * @param mask the output mask, one byte per thing (MAPFILTER_MATCH or MAPFILTER_NOMATCH). Must hold things->count bytes.
+ * @return the amount of matching things.
+ */
+int MAP_FilterThings(mapthings_t *things, mapthingfilter_t *filter, uint8_t *mask);
+
+/**
+ * Sets every byte in a mask from an inclusive range test over a column.
+ * @param column the column to test.
+ * @param count the amount of values.
+ * @param range the range to test against.
+ * @param mask the output mask.
+ */
+void MAP_MaskSetRange(const int32_t *column, int count, maprange_t *range, uint8_t *mask);
+
+/**
+ * ANDs an inclusive range test over a column into a mask.
+ * @param column the column to test.
+ * @param count the amount of values.
+ * @param range the range to test against.
+ * @param mask the mask.
+ */
+void MAP_MaskAndRange(const int32_t *column, int count, maprange_t *range, uint8_t *mask);
+
+/**
+ * ORs an inclusive range test over a column into a mask.
+ * @param column the column to test.
+ * @param count the amount of values.
+ * @param range the range to test against.
+ * @param mask the mask.
+ */
+void MAP_MaskOrRange(const int32_t *column, int count, maprange_t *range, uint8_t *mask);
+
+/**
+ * ANDs a bit test, ((value & bits) == want), over a column into a mask.
+ * @param column the column to test.
+ * @param count the amount of values.
+ * @param bits the bits to test.
+ * @param want the expected result of (value & bits).
+ * @param mask the mask.
+ */
+void MAP_MaskAndBits(const int32_t *column, int count, int32_t bits, int32_t want, uint8_t *mask);
+
+/**
+ * ANDs an any-bit test, ((value & bits) != 0), over a column into a mask.
+ * @param column the column to test.
+ * @param count the amount of values.
+ * @param bits the bits to test.
+ * @param mask the mask.
+ */
+void MAP_MaskAndAnyBits(const int32_t *column, int count, int32_t bits, uint8_t *mask);
+
+/**
+ * Counts the set bytes in a mask.
+ * @param mask the mask.
+ * @param count the amount of bytes.
+ * @return the amount of MAPFILTER_MATCH bytes.
+ */
+int MAP_MaskCount(const uint8_t *mask, int count);
+
+#endif
@@ -0,0 +1,260 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "map_config.h"
+#include "mapindex.h"
+
+// MUST BE ALPHABETICAL! (same order as maplump_t)
+static const char* map_lump_names[ML_COUNT] =
+{
+	"BEHAVIOR",
+	"BLOCKMAP",
+	"DIALOGUE",
+	"ENDMAP",
+	"GL_NODES",
+	"GL_PVS",
+	"GL_SEGS",
+	"GL_SSECT",
+	"GL_VERT",
+	"LINEDEFS",
+	"NODES",
+	"PWADINFO",
+	"REJECT",
+	"SCRIPTS",
+	"SECTORS",
+	"SEGS",
+	"SIDEDEFS",
+	"SSECTORS",
+	"TEXTMAP",
+	"THINGS",
+	"VERTEXES",
+	"ZNODES",
+};
+
+static const char* map_format_names[MF_COUNT] =
+{
+	"Unknown",
+	"Doom",
+	"Hexen",
+	"UDMF",
+};
+
+// ===========================================================================
+// Private Functions
+// ===========================================================================
+
+// Adds a new, blank map to the index, expanding it if needed.
+static mapindexentry_t* MAP_IndexAdd(mapindex_t *index, int header)
+{
+	mapindexentry_t *out;
+	int i;
+
+	if (index->count == index->capacity)
+	{
+		int newcap = index->capacity * 2;
+		mapindexentry_t *newmaps = (mapindexentry_t*)MAP_REALLOC(index->maps, sizeof(mapindexentry_t) * newcap);
+		if (!newmaps)
+			return NULL;
+		index->maps = newmaps;
+		index->capacity = newcap;
+	}
+
+	out = &(index->maps[index->count++]);
+	out->header = header;
+	out->count = 0;
+	out->format = MF_UNKNOWN;
+	for (i = 0; i < ML_COUNT; i++)
+		out->lumps[i] = -1;
+	return out;
+}
+
+// Scans the entries after a map header and fills in the map.
+// Returns the index of the first entry after the map.
+static int MAP_IndexScan(wad_t *wad, mapindexentry_t *map, int start, int len)
+{
+	int i, lump;
+	int udmf = MAP_GetLumpType(WAD_GetEntry(wad, start)->name) == ML_TEXTMAP;
+
+	for (i = start; i < len; i++)
+	{
+		lump = MAP_GetLumpType(WAD_GetEntry(wad, i)->name);
+		if (lump < 0 || map->lumps[lump] >= 0)
+			break;
+		// a binary map cannot contain UDMF-only entries.
+		if (!udmf && (lump == ML_TEXTMAP || lump == ML_ENDMAP))
+			break;
+
+		map->lumps[lump] = i;
+		if (lump == ML_ENDMAP)
+		{
+			i++;
+			break;
+		}
+	}
+
+	map->count = i - start;
+	if (udmf)
+		map->format = MF_UDMF;
+	else if (map->lumps[ML_BEHAVIOR] >= 0)
+		map->format = MF_HEXEN;
+	else
+		map->format = MF_DOOM;
+
+	return i;
+}
+
+// ===========================================================================
+// Public Functions
+// ===========================================================================
+
+// ---------------------------------------------------------------
+// mapindex_t* MAP_IndexCreate(wad_t *wad)
+// See mapindex.h
+// ---------------------------------------------------------------
+mapindex_t* MAP_IndexCreate(wad_t *wad)
+{
+	mapindex_t *out;
+	int i, next, len;
+
+	if (!wad)
+		return NULL;
+
+	out = (mapindex_t*)MAP_MALLOC(sizeof(mapindex_t));
+	if (!out)
+		return NULL;
+	out->maps = (mapindexentry_t*)MAP_MALLOC(sizeof(mapindexentry_t) * MAPINDEX_INITSIZE);
+	if (!out->maps)
+	{
+		MAP_FREE(out);
+		return NULL;
+	}
+	out->count = 0;
+	out->capacity = MAPINDEX_INITSIZE;
+
+	len = WAD_EntryCount(wad);
+	i = 0;
+	while (i < len - 1)
+	{
+		next = MAP_GetLumpType(WAD_GetEntry(wad, i + 1)->name);
+		if ((next == ML_THINGS || next == ML_TEXTMAP) && MAP_GetLumpType(WAD_GetEntry(wad, i)->name) < 0)
+		{
+			mapindexentry_t *map = MAP_IndexAdd(out, i);
+			if (!map)
+			{
+				MAP_IndexDestroy(out);
+				return NULL;
+			}
+			i = MAP_IndexScan(wad, map, i + 1, len);
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	return out;
+}
+
+// ---------------------------------------------------------------
+// int MAP_IndexDestroy(mapindex_t *index)
+// See mapindex.h
+// ---------------------------------------------------------------
+int MAP_IndexDestroy(mapindex_t *index)
+{
+	if (!index)
+		return 1;
+	MAP_FREE(index->maps);
+	MAP_FREE(index);
+	return 0;
+}
+
+// ---------------------------------------------------------------
+// int MAP_IndexCount(mapindex_t *index)
+// See mapindex.h
+// ---------------------------------------------------------------
+int MAP_IndexCount(mapindex_t *index)
+{
+	return index ? index->count : 0;
+}
+
+// ---------------------------------------------------------------
+// mapindexentry_t* MAP_IndexGet(mapindex_t *index, int n)
+// See mapindex.h
+// ---------------------------------------------------------------
+mapindexentry_t* MAP_IndexGet(mapindex_t *index, int n)
+{
+	if (!index || n < 0 || n >= index->count)
+		return NULL;
+	return &(index->maps[n]);
+}
+
+// ---------------------------------------------------------------
+// mapindexentry_t* MAP_IndexFind(mapindex_t *index, wad_t *wad, const char *name)
+// See mapindex.h
+// ---------------------------------------------------------------
+mapindexentry_t* MAP_IndexFind(mapindex_t *index, wad_t *wad, const char *name)
+{
+	int i;
+	if (!index || !wad)
+		return NULL;
+
+	for (i = 0; i < index->count; i++)
+	{
+		if (strncmp(WAD_GetEntry(wad, index->maps[i].header)->name, name, 8) == 0)
+			return &(index->maps[i]);
+	}
+	return NULL;
+}
+
+// ---------------------------------------------------------------
+// int MAP_GetLumpType(const char *name)
+// See mapindex.h
+// ---------------------------------------------------------------
+int MAP_GetLumpType(const char *name)
+{
+	int lo = 0, hi = ML_COUNT - 1;
+	int mid, c;
+
+	// Binary search - table is alphabetical.
+	while (lo <= hi)
+	{
+		mid = (lo + hi) / 2;
+		c = strncmp(name, map_lump_names[mid], 8);
+		if (c == 0)
+			return mid;
+		else if (c < 0)
+			hi = mid - 1;
+		else
+			lo = mid + 1;
+	}
+	return -1;
+}
+
+// ---------------------------------------------------------------
+// const char* MAP_GetLumpName(maplump_t lump)
+// See mapindex.h
+// ---------------------------------------------------------------
+const char* MAP_GetLumpName(maplump_t lump)
+{
+	if (lump < 0 || lump >= ML_COUNT)
+		return NULL;
+	return map_lump_names[lump];
+}
+
+// ---------------------------------------------------------------
+// const char* MAP_GetFormatName(mapformat_t format)
+// See mapindex.h
+// ---------------------------------------------------------------
+const char* MAP_GetFormatName(mapformat_t format)
+{
+	if (format < 0 || format >= MF_COUNT)
+		return map_format_names[MF_UNKNOWN];
+	return map_format_names[format];
+}
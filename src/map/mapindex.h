@@ -0,0 +1,160 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#ifndef __MAPINDEX_H__
+#define __MAPINDEX_H__
+
+#include "wad/wad.h"
+
+#define MAPINDEX_INITSIZE 16
+
+/**
+ * Recognized map data entry (lump) types.
+ * These are in alphabetical order by name.
+ */
+typedef enum {
+
+	ML_BEHAVIOR,
+	ML_BLOCKMAP,
+	ML_DIALOGUE,
+	ML_ENDMAP,
+	ML_GL_NODES,
+	ML_GL_PVS,
+	ML_GL_SEGS,
+	ML_GL_SSECT,
+	ML_GL_VERT,
+	ML_LINEDEFS,
+	ML_NODES,
+	ML_PWADINFO,
+	ML_REJECT,
+	ML_SCRIPTS,
+	ML_SECTORS,
+	ML_SEGS,
+	ML_SIDEDEFS,
+	ML_SSECTORS,
+	ML_TEXTMAP,
+	ML_THINGS,
+	ML_VERTEXES,
+	ML_ZNODES,
+
+	ML_COUNT
+
+} maplump_t;
+
+/**
+ * Map data formats.
+ */
+typedef enum {
+
+	/** Unknown format. */
+	MF_UNKNOWN,
+	/** Binary Doom format. */
+	MF_DOOM,
+	/** Binary Hexen format (has a BEHAVIOR entry). */
+	MF_HEXEN,
+	/** UDMF (has a TEXTMAP entry). */
+	MF_UDMF,
+
+	MF_COUNT
+
+} mapformat_t;
+
+/**
+ * A single map found in a WAD.
+ */
+typedef struct {
+
+	/** Index of the map header entry. */
+	int header;
+	/** Amount of recognized map entries directly after the header. */
+	int count;
+	/** Map data format. */
+	mapformat_t format;
+	/** Entry index of each map entry type (by maplump_t), or -1 if not present. */
+	int lumps[ML_COUNT];
+
+} mapindexentry_t;
+
+/**
+ * An index of all maps in a WAD, built in one pass over the entry list.
+ * Stores entry indices only - the WAD must outlive the index and not change while it is used.
+ */
+typedef struct {
+
+	/** The indexed maps, in entry order. */
+	mapindexentry_t *maps;
+	/** Amount of maps. */
+	int count;
+	/** Capacity of the map list. */
+	int capacity;
+
+} mapindex_t;
+
+/**
+ * Builds an index of all of the maps in a WAD.
+ * Every entry followed by a THINGS or TEXTMAP entry is a map header, and the map
+ * is the contiguous run of recognized map entries after it (up to and including ENDMAP, for UDMF).
+ * Works on all WAD implementations, including WI_MAP.
+ * @param wad the WAD to index.
+ * @return a newly-allocated map index, or NULL on error.
+ */
+mapindex_t* MAP_IndexCreate(wad_t *wad);
+
+/**
+ * Destroys a map index.
+ * @param index the index to destroy.
+ * @return 0 if successful, nonzero if not.
+ */
+int MAP_IndexDestroy(mapindex_t *index);
+
+/**
+ * Gets the amount of maps in an index.
+ * @param index the index.
+ * @return the amount of maps, or 0 if index is NULL.
+ */
+int MAP_IndexCount(mapindex_t *index);
+
+/**
+ * Gets a map in an index.
+ * @param index the index.
+ * @param n the map index (not the entry index).
+ * @return a pointer to the map, or NULL if out of range.
+ */
+mapindexentry_t* MAP_IndexGet(mapindex_t *index, int n);
+
+/**
+ * Finds a map in an index by its header entry name.
+ * @param index the index.
+ * @param wad the WAD that the index was created from.
+ * @param name the header name (case-sensitive, up to 8 characters).
+ * @return a pointer to the first map with a matching header name, or NULL if not found.
+ */
+mapindexentry_t* MAP_IndexFind(mapindex_t *index, wad_t *wad, const char *name);
+
+/**
+ * Gets the map entry type for an entry name.
+ * @param name the entry name (up to 8 characters, need not be null-terminated at 8).
+ * @return the corresponding maplump_t, or -1 if not a recognized map entry name.
+ */
+int MAP_GetLumpType(const char *name);
+
+/**
+ * Gets the name of a map entry type.
+ * @param lump the map entry type.
+ * @return the entry name, or NULL if bad type.
+ */
+const char* MAP_GetLumpName(maplump_t lump);
+
+/**
+ * Gets the name of a map format.
+ * @param format the map format.
+ * @return the format name.
+ */
+const char* MAP_GetFormatName(mapformat_t format);
+
+#endif
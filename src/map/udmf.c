@@ -0,0 +1,777 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "map_config.h"
+#include "udmf.h"
+#include "udmf_kernel.h"
+#include "maperrno.h"
+#include "parser/lexer.h"
+#include "struct/mt_arena.h"
+
+#define UDMF_RECORDS_INITSIZE 64
+// Most records in one record block.
+#define UDMF_RECORDS_BLOCKMAX 4096
+// Longest namespace text considered.
+#define UDMF_NAMESPACE_LENGTH 32
+
+// Thing flags while parsing (Hexen-style, plus friend). Translated when the block ends.
+#define UDMF_TF_SKILL12		0x0001
+#define UDMF_TF_SKILL3		0x0002
+#define UDMF_TF_SKILL45		0x0004
+#define UDMF_TF_AMBUSH		0x0008
+#define UDMF_TF_DORMANT		0x0010
+#define UDMF_TF_CLASS1		0x0020
+#define UDMF_TF_CLASS2		0x0040
+#define UDMF_TF_CLASS3		0x0080
+#define UDMF_TF_SINGLE		0x0100
+#define UDMF_TF_COOP		0x0200
+#define UDMF_TF_DM			0x0400
+#define UDMF_TF_FRIEND		0x10000
+
+// Linedef activation (Hexen-style).
+#define UDMF_LF_SPAC_SHIFT	10
+#define UDMF_LF_SPAC_MASK	0x1C00
+
+/**
+ * Parsed value types.
+ */
+typedef enum {
+
+	UV_INT,
+	UV_FLOAT,
+	UV_STRING,
+	UV_BOOLEAN,
+
+} udmfvaluetype_t;
+
+/**
+ * A parsed value.
+ */
+typedef struct {
+
+	udmfvaluetype_t type;
+	int32_t i;
+	double f;
+	mapname_t s;
+
+} udmfvalue_t;
+
+typedef struct {
+	int32_t x, y, z, angle, type, flags, id, special, arg[MAP_ARGS];
+} udmfthing_t;
+
+typedef struct {
+	int32_t v1, v2, flags, special, id, arg[MAP_ARGS], front, back;
+} udmflinedef_t;
+
+typedef struct {
+	int32_t offsetx, offsety;
+	mapname_t texturetop, texturebottom, texturemiddle;
+	int32_t sector;
+} udmfsidedef_t;
+
+typedef struct {
+	int32_t x, y;
+} udmfvertex_t;
+
+typedef struct {
+	int32_t heightfloor, heightceiling;
+	mapname_t texturefloor, textureceiling;
+	int32_t lightlevel, special, id;
+} udmfsector_t;
+
+/**
+ * A block of fixed-size records. The records follow this header.
+ */
+typedef struct udmfblock_s {
+
+	struct udmfblock_s *next;
+	int count;
+	int capacity;
+
+} udmfblock_t;
+
+// Gets a block's records.
+#define UDMF_BLOCK_RECORDS(b) ((void*)((b) + 1))
+
+/**
+ * A growable list of fixed-size records, kept in blocks (so adding never moves records).
+ */
+typedef struct {
+
+	udmfblock_t *first;
+	udmfblock_t *last;
+	int count;
+
+} udmfrecords_t;
+
+/**
+ * Parse state.
+ */
+typedef struct {
+
+	lexer_t *lexer;
+	/** Current token (owned by the lexer), or NULL at the end. */
+	lexer_token_t *token;
+	/** If nonzero, no more tokens. */
+	int eof;
+	/** If nonzero, translate thing/linedef flags to Doom-style bits. */
+	int doomflags;
+
+	udmfrecords_t things;
+	udmfrecords_t linedefs;
+	udmfrecords_t sidedefs;
+	udmfrecords_t vertexes;
+	udmfrecords_t sectors;
+
+	/** Arena for everything allocated while parsing, freed all at once. */
+	mt_arena_t *arena;
+
+} udmfstate_t;
+
+// Assigns a key/value to a record.
+typedef void (*udmfassignfunc_t)(udmfstate_t *state, void *record, int key, udmfvalue_t *value);
+
+static lexer_kernel_t *udmf_kernel = NULL;
+static pthread_once_t udmf_kernel_once = PTHREAD_ONCE_INIT;
+
+// ===========================================================================
+// Private Functions
+// ===========================================================================
+
+// Adds a new record to a list, returning it (uninitialized), or NULL if out of memory.
+static void* UDMF_AddRecord(udmfstate_t *state, udmfrecords_t *records, size_t size)
+{
+	udmfblock_t *block = records->last;
+	if (!block || block->count == block->capacity)
+	{
+		int capacity = block ? block->capacity * 2 : UDMF_RECORDS_INITSIZE;
+		if (capacity > UDMF_RECORDS_BLOCKMAX)
+			capacity = UDMF_RECORDS_BLOCKMAX;
+		if (!(block = (udmfblock_t*)MT_ArenaAlloc(state->arena, sizeof(udmfblock_t) + capacity * size)))
+			return NULL;
+		block->next = NULL;
+		block->count = 0;
+		block->capacity = capacity;
+		if (records->last)
+			records->last->next = block;
+		else
+			records->first = block;
+		records->last = block;
+	}
+	records->count++;
+	return (unsigned char*)UDMF_BLOCK_RECORDS(block) + (block->count++ * size);
+}
+
+// Sets a texture name to "-".
+static void UDMF_NoTexture(mapname_t name)
+{
+	memset(name, 0, MAP_NAME_LENGTH);
+	name[0] = '-';
+}
+
+// Narrows an integer to 32 bits, clamped to the int32 range.
+static int32_t UDMF_ClampInt(int64_t value)
+{
+	if (value > INT32_MAX)
+		return INT32_MAX;
+	if (value < INT32_MIN)
+		return INT32_MIN;
+	return (int32_t)value;
+}
+
+// Narrows a float to a 32-bit integer (toward zero), clamped to the int32 range. NaN is 0.
+static int32_t UDMF_ClampFloat(double value)
+{
+	if (value >= 2147483647.0)
+		return INT32_MAX;
+	if (value <= -2147483648.0)
+		return INT32_MIN;
+	if (value != value)
+		return 0;
+	return (int32_t)value;
+}
+
+// Gets a value as an integer.
+static int32_t UDMF_Int(udmfvalue_t *value)
+{
+	switch (value->type)
+	{
+		case UV_FLOAT: return UDMF_ClampFloat(value->f);
+		case UV_STRING: return 0;
+		default: return value->i;
+	}
+}
+
+// Gets a value as 16.16 fixed-point, clamped to what fixed point can hold.
+static int32_t UDMF_Fixed(udmfvalue_t *value)
+{
+	switch (value->type)
+	{
+		case UV_FLOAT: return UDMF_ClampFloat(value->f * MAP_FRACUNIT + (value->f < 0.0 ? -0.5 : 0.5));
+		case UV_STRING: return 0;
+		default: return UDMF_ClampInt((int64_t)value->i * MAP_FRACUNIT);
+	}
+}
+
+// Sets or clears bits by a value's truth.
+static int32_t UDMF_Bits(int32_t flags, int32_t bits, udmfvalue_t *value)
+{
+	return UDMF_Int(value) ? (flags | bits) : (flags & ~bits);
+}
+
+// Gets the next token.
+static void UDMF_Next(udmfstate_t *state)
+{
+	state->eof = (state->token = LXR_NextToken(state->lexer)) == NULL;
+}
+
+// Matches a delimiter and advances if matched.
+static int UDMF_MatchDelimiter(udmfstate_t *state, int delimiter)
+{
+	if (!state->eof && state->token->type == LXRT_DELIMITER && state->token->subtype == delimiter)
+	{
+		UDMF_Next(state);
+		return 1;
+	}
+	return 0;
+}
+
+// Parses a value. Returns nonzero if bad.
+static int UDMF_ParseValue(udmfstate_t *state, udmfvalue_t *value)
+{
+	lexer_token_t *token;
+	int negative = 0;
+
+	if (UDMF_MatchDelimiter(state, UDMFD_MINUS))
+		negative = 1;
+	else
+		UDMF_MatchDelimiter(state, UDMFD_PLUS);
+
+	if (state->eof)
+		return 1;
+
+	token = state->token;
+	switch (token->type)
+	{
+		case LXRT_NUMBER:
+		{
+			// the lexer decodes the value.
+			if (token->subtype == LXRTN_FLOAT)
+			{
+				value->type = UV_FLOAT;
+				value->f = negative ? -token->decimal : token->decimal;
+			}
+			else
+			{
+				value->type = UV_INT;
+				value->i = UDMF_ClampInt(negative ? -token->integer : token->integer);
+			}
+		}
+		break;
+
+		case LXRT_STRING:
+		{
+			if (negative)
+				return 1;
+			value->type = UV_STRING;
+			char text[MAP_NAME_LENGTH + 1];
+			LXR_GetTokenText(state->lexer, token, text, MAP_NAME_LENGTH + 1);
+			memset(value->s, 0, MAP_NAME_LENGTH);
+			memcpy(value->s, text, strnlen(text, MAP_NAME_LENGTH));
+		}
+		break;
+
+		case LXRT_KEYWORD:
+		{
+			if (negative || (token->subtype != UDMFK_TRUE && token->subtype != UDMFK_FALSE))
+				return 1;
+			value->type = UV_BOOLEAN;
+			value->i = token->subtype == UDMFK_TRUE;
+		}
+		break;
+
+		default:
+			return 1;
+	}
+
+	UDMF_Next(state);
+	return 0;
+}
+
+static void UDMF_AssignThing(udmfstate_t *state, void *record, int key, udmfvalue_t *value)
+{
+	udmfthing_t *t = (udmfthing_t*)record;
+	switch (key)
+	{
+		case UDMFK_X: t->x = UDMF_Fixed(value); break;
+		case UDMFK_Y: t->y = UDMF_Fixed(value); break;
+		case UDMFK_HEIGHT: t->z = UDMF_Fixed(value); break;
+		case UDMFK_ANGLE: t->angle = UDMF_Int(value); break;
+		case UDMFK_TYPE: t->type = UDMF_Int(value); break;
+		case UDMFK_ID: t->id = UDMF_Int(value); break;
+		case UDMFK_SPECIAL: t->special = UDMF_Int(value); break;
+		case UDMFK_ARG0: case UDMFK_ARG1: case UDMFK_ARG2: case UDMFK_ARG3: case UDMFK_ARG4:
+			t->arg[key - UDMFK_ARG0] = UDMF_Int(value);
+			break;
+		// skill pairs share a bit: set if either one is true, so the second key can't clear the first.
+		case UDMFK_SKILL1: case UDMFK_SKILL2:
+			if (UDMF_Int(value))
+				t->flags |= UDMF_TF_SKILL12;
+			break;
+		case UDMFK_SKILL3: t->flags = UDMF_Bits(t->flags, UDMF_TF_SKILL3, value); break;
+		case UDMFK_SKILL4: case UDMFK_SKILL5:
+			if (UDMF_Int(value))
+				t->flags |= UDMF_TF_SKILL45;
+			break;
+		case UDMFK_AMBUSH: t->flags = UDMF_Bits(t->flags, UDMF_TF_AMBUSH, value); break;
+		case UDMFK_DORMANT: t->flags = UDMF_Bits(t->flags, UDMF_TF_DORMANT, value); break;
+		case UDMFK_CLASS1: t->flags = UDMF_Bits(t->flags, UDMF_TF_CLASS1, value); break;
+		case UDMFK_CLASS2: t->flags = UDMF_Bits(t->flags, UDMF_TF_CLASS2, value); break;
+		case UDMFK_CLASS3: t->flags = UDMF_Bits(t->flags, UDMF_TF_CLASS3, value); break;
+		case UDMFK_SINGLE: t->flags = UDMF_Bits(t->flags, UDMF_TF_SINGLE, value); break;
+		case UDMFK_COOP: t->flags = UDMF_Bits(t->flags, UDMF_TF_COOP, value); break;
+		case UDMFK_DM: t->flags = UDMF_Bits(t->flags, UDMF_TF_DM, value); break;
+		case UDMFK_FRIEND: t->flags = UDMF_Bits(t->flags, UDMF_TF_FRIEND, value); break;
+	}
+}
+
+// Translates parsed thing flags to the namespace's binary flags.
+static void UDMF_FinishThing(udmfstate_t *state, udmfthing_t *t)
+{
+	int32_t f = t->flags;
+	if (state->doomflags)
+	{
+		t->flags = f & (UDMF_TF_SKILL12 | UDMF_TF_SKILL3 | UDMF_TF_SKILL45 | UDMF_TF_AMBUSH);
+		if (!(f & UDMF_TF_SINGLE))
+			t->flags |= 0x0010;
+		if (!(f & UDMF_TF_DM))
+			t->flags |= 0x0020;
+		if (!(f & UDMF_TF_COOP))
+			t->flags |= 0x0040;
+		if (f & UDMF_TF_FRIEND)
+			t->flags |= 0x0080;
+	}
+	else
+	{
+		t->flags = f & ~UDMF_TF_FRIEND;
+	}
+}
+
+static void UDMF_AssignLinedef(udmfstate_t *state, void *record, int key, udmfvalue_t *value)
+{
+	udmflinedef_t *l = (udmflinedef_t*)record;
+	switch (key)
+	{
+		case UDMFK_V1: l->v1 = UDMF_Int(value); break;
+		case UDMFK_V2: l->v2 = UDMF_Int(value); break;
+		case UDMFK_SIDEFRONT: l->front = UDMF_Int(value); break;
+		case UDMFK_SIDEBACK: l->back = UDMF_Int(value); break;
+		case UDMFK_ID: l->id = UDMF_Int(value); break;
+		case UDMFK_SPECIAL: l->special = UDMF_Int(value); break;
+		case UDMFK_ARG0: case UDMFK_ARG1: case UDMFK_ARG2: case UDMFK_ARG3: case UDMFK_ARG4:
+			l->arg[key - UDMFK_ARG0] = UDMF_Int(value);
+			break;
+		case UDMFK_BLOCKING: l->flags = UDMF_Bits(l->flags, 0x0001, value); break;
+		case UDMFK_BLOCKMONSTERS: l->flags = UDMF_Bits(l->flags, 0x0002, value); break;
+		case UDMFK_TWOSIDED: l->flags = UDMF_Bits(l->flags, 0x0004, value); break;
+		case UDMFK_DONTPEGTOP: l->flags = UDMF_Bits(l->flags, 0x0008, value); break;
+		case UDMFK_DONTPEGBOTTOM: l->flags = UDMF_Bits(l->flags, 0x0010, value); break;
+		case UDMFK_SECRET: l->flags = UDMF_Bits(l->flags, 0x0020, value); break;
+		case UDMFK_BLOCKSOUND: l->flags = UDMF_Bits(l->flags, 0x0040, value); break;
+		case UDMFK_DONTDRAW: l->flags = UDMF_Bits(l->flags, 0x0080, value); break;
+		case UDMFK_MAPPED: l->flags = UDMF_Bits(l->flags, 0x0100, value); break;
+		// 0x0200 is "pass use" in Doom-style flags, and "repeat special" in Hexen-style flags.
+		case UDMFK_PASSUSE:
+			if (state->doomflags)
+				l->flags = UDMF_Bits(l->flags, 0x0200, value);
+			break;
+		case UDMFK_REPEATSPECIAL:
+			if (!state->doomflags)
+				l->flags = UDMF_Bits(l->flags, 0x0200, value);
+			break;
+		case UDMFK_PLAYERCROSS: case UDMFK_PLAYERUSE: case UDMFK_MONSTERCROSS:
+		case UDMFK_IMPACT: case UDMFK_PLAYERPUSH: case UDMFK_MISSILECROSS:
+			if (UDMF_Int(value))
+				l->flags = (l->flags & ~UDMF_LF_SPAC_MASK) | ((key - UDMFK_PLAYERCROSS) << UDMF_LF_SPAC_SHIFT);
+			break;
+	}
+}
+
+static void UDMF_AssignSidedef(udmfstate_t *state, void *record, int key, udmfvalue_t *value)
+{
+	udmfsidedef_t *s = (udmfsidedef_t*)record;
+	switch (key)
+	{
+		case UDMFK_OFFSETX: s->offsetx = UDMF_Fixed(value); break;
+		case UDMFK_OFFSETY: s->offsety = UDMF_Fixed(value); break;
+		case UDMFK_SECTOR: s->sector = UDMF_Int(value); break;
+		case UDMFK_TEXTURETOP: if (value->type == UV_STRING) memcpy(s->texturetop, value->s, MAP_NAME_LENGTH); break;
+		case UDMFK_TEXTUREBOTTOM: if (value->type == UV_STRING) memcpy(s->texturebottom, value->s, MAP_NAME_LENGTH); break;
+		case UDMFK_TEXTUREMIDDLE: if (value->type == UV_STRING) memcpy(s->texturemiddle, value->s, MAP_NAME_LENGTH); break;
+	}
+}
+
+static void UDMF_AssignVertex(udmfstate_t *state, void *record, int key, udmfvalue_t *value)
+{
+	udmfvertex_t *v = (udmfvertex_t*)record;
+	switch (key)
+	{
+		case UDMFK_X: v->x = UDMF_Fixed(value); break;
+		case UDMFK_Y: v->y = UDMF_Fixed(value); break;
+	}
+}
+
+static void UDMF_AssignSector(udmfstate_t *state, void *record, int key, udmfvalue_t *value)
+{
+	udmfsector_t *s = (udmfsector_t*)record;
+	switch (key)
+	{
+		case UDMFK_HEIGHTFLOOR: s->heightfloor = UDMF_Fixed(value); break;
+		case UDMFK_HEIGHTCEILING: s->heightceiling = UDMF_Fixed(value); break;
+		case UDMFK_LIGHTLEVEL: s->lightlevel = UDMF_Int(value); break;
+		case UDMFK_SPECIAL: s->special = UDMF_Int(value); break;
+		case UDMFK_ID: s->id = UDMF_Int(value); break;
+		case UDMFK_TEXTUREFLOOR: if (value->type == UV_STRING) memcpy(s->texturefloor, value->s, MAP_NAME_LENGTH); break;
+		case UDMFK_TEXTURECEILING: if (value->type == UV_STRING) memcpy(s->textureceiling, value->s, MAP_NAME_LENGTH); break;
+	}
+}
+
+// Parses "key = value;" statements up to and including the closing brace of a block.
+// If assign is NULL, the block's contents are skipped. Returns nonzero if bad.
+static int UDMF_ParseBlock(udmfstate_t *state, void *record, udmfassignfunc_t assign)
+{
+	lexer_token_t *token;
+	udmfvalue_t value;
+	int key;
+
+	while (!UDMF_MatchDelimiter(state, UDMFD_RBRACE))
+	{
+		if (state->eof)
+			return 1;
+
+		token = state->token;
+		if (token->type == LXRT_KEYWORD)
+			key = token->subtype;
+		else if (token->type == LXRT_IDENTIFIER)
+			key = -1;
+		else
+			return 1;
+
+		UDMF_Next(state);
+		if (!UDMF_MatchDelimiter(state, UDMFD_EQUALS))
+			return 1;
+		if (UDMF_ParseValue(state, &value))
+			return 1;
+		if (!UDMF_MatchDelimiter(state, UDMFD_SEMICOLON))
+			return 1;
+
+		if (assign && key >= 0)
+			assign(state, record, key, &value);
+	}
+	return 0;
+}
+
+// Parses a whole TEXTMAP. Returns nonzero if bad.
+static int UDMF_Parse(udmfstate_t *state)
+{
+	lexer_token_t *token;
+	udmfvalue_t value;
+	char nsname[UDMF_NAMESPACE_LENGTH];
+	int key;
+
+	UDMF_Next(state);
+	while (!state->eof)
+	{
+		// the block or assignment name; what follows it says which one it is.
+		token = state->token;
+		if (token->type == LXRT_KEYWORD)
+			key = token->subtype;
+		else if (token->type == LXRT_IDENTIFIER)
+			key = -1;
+		else
+			return 1;
+		UDMF_Next(state);
+
+		if (key == UDMFK_NAMESPACE)
+		{
+			if (!UDMF_MatchDelimiter(state, UDMFD_EQUALS))
+				return 1;
+			if (state->eof || state->token->type != LXRT_STRING)
+				return 1;
+			LXR_GetTokenText(state->lexer, state->token, nsname, UDMF_NAMESPACE_LENGTH);
+			state->doomflags =
+				stricmp(nsname, "doom") == 0
+				|| stricmp(nsname, "heretic") == 0
+				|| stricmp(nsname, "strife") == 0;
+			UDMF_Next(state);
+			if (!UDMF_MatchDelimiter(state, UDMFD_SEMICOLON))
+				return 1;
+		}
+		else if (UDMF_MatchDelimiter(state, UDMFD_LBRACE))
+		{
+			switch (key)
+			{
+				case UDMFK_THING:
+				{
+					udmfthing_t *t;
+					if (!(t = (udmfthing_t*)UDMF_AddRecord(state, &(state->things), sizeof(udmfthing_t))))
+						return 1;
+					memset(t, 0, sizeof(udmfthing_t));
+					if (UDMF_ParseBlock(state, t, &UDMF_AssignThing))
+						return 1;
+					UDMF_FinishThing(state, t);
+				}
+				break;
+
+				case UDMFK_LINEDEF:
+				{
+					udmflinedef_t *l;
+					if (!(l = (udmflinedef_t*)UDMF_AddRecord(state, &(state->linedefs), sizeof(udmflinedef_t))))
+						return 1;
+					memset(l, 0, sizeof(udmflinedef_t));
+					l->id = -1;
+					l->front = MAP_NO_INDEX;
+					l->back = MAP_NO_INDEX;
+					if (UDMF_ParseBlock(state, l, &UDMF_AssignLinedef))
+						return 1;
+				}
+				break;
+
+				case UDMFK_SIDEDEF:
+				{
+					udmfsidedef_t *s;
+					if (!(s = (udmfsidedef_t*)UDMF_AddRecord(state, &(state->sidedefs), sizeof(udmfsidedef_t))))
+						return 1;
+					memset(s, 0, sizeof(udmfsidedef_t));
+					UDMF_NoTexture(s->texturetop);
+					UDMF_NoTexture(s->texturebottom);
+					UDMF_NoTexture(s->texturemiddle);
+					if (UDMF_ParseBlock(state, s, &UDMF_AssignSidedef))
+						return 1;
+				}
+				break;
+
+				case UDMFK_VERTEX:
+				{
+					udmfvertex_t *v;
+					if (!(v = (udmfvertex_t*)UDMF_AddRecord(state, &(state->vertexes), sizeof(udmfvertex_t))))
+						return 1;
+					memset(v, 0, sizeof(udmfvertex_t));
+					if (UDMF_ParseBlock(state, v, &UDMF_AssignVertex))
+						return 1;
+				}
+				break;
+
+				case UDMFK_SECTOR:
+				{
+					udmfsector_t *s;
+					if (!(s = (udmfsector_t*)UDMF_AddRecord(state, &(state->sectors), sizeof(udmfsector_t))))
+						return 1;
+					memset(s, 0, sizeof(udmfsector_t));
+					s->lightlevel = 160;
+					if (UDMF_ParseBlock(state, s, &UDMF_AssignSector))
+						return 1;
+				}
+				break;
+
+				default:
+				{
+					// Unknown block.
+					if (UDMF_ParseBlock(state, NULL, NULL))
+						return 1;
+				}
+				break;
+			}
+		}
+		else if (UDMF_MatchDelimiter(state, UDMFD_EQUALS))
+		{
+			// Global assignment (even if named like a known block).
+			if (UDMF_ParseValue(state, &value))
+				return 1;
+			if (!UDMF_MatchDelimiter(state, UDMFD_SEMICOLON))
+				return 1;
+		}
+		else
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// Copies the parsed records into map data columns.
+static void UDMF_Fill(udmfstate_t *state, mapdata_t *data)
+{
+	int i, j, k;
+	udmfblock_t *block;
+
+	for (i = 0, block = state->things.first; block; block = block->next)
+	{
+		udmfthing_t *things = (udmfthing_t*)UDMF_BLOCK_RECORDS(block);
+		for (k = 0; k < block->count; k++, i++)
+		{
+			data->things.x[i] = things[k].x;
+			data->things.y[i] = things[k].y;
+			data->things.z[i] = things[k].z;
+			data->things.angle[i] = things[k].angle;
+			data->things.type[i] = things[k].type;
+			data->things.flags[i] = things[k].flags;
+			data->things.id[i] = things[k].id;
+			data->things.special[i] = things[k].special;
+			for (j = 0; j < MAP_ARGS; j++)
+				data->things.arg[j][i] = things[k].arg[j];
+		}
+	}
+
+	for (i = 0, block = state->linedefs.first; block; block = block->next)
+	{
+		udmflinedef_t *linedefs = (udmflinedef_t*)UDMF_BLOCK_RECORDS(block);
+		for (k = 0; k < block->count; k++, i++)
+		{
+			data->linedefs.v1[i] = linedefs[k].v1;
+			data->linedefs.v2[i] = linedefs[k].v2;
+			data->linedefs.flags[i] = linedefs[k].flags;
+			data->linedefs.special[i] = linedefs[k].special;
+			data->linedefs.id[i] = linedefs[k].id;
+			for (j = 0; j < MAP_ARGS; j++)
+				data->linedefs.arg[j][i] = linedefs[k].arg[j];
+			data->linedefs.front[i] = linedefs[k].front;
+			data->linedefs.back[i] = linedefs[k].back;
+		}
+	}
+
+	for (i = 0, block = state->sidedefs.first; block; block = block->next)
+	{
+		udmfsidedef_t *sidedefs = (udmfsidedef_t*)UDMF_BLOCK_RECORDS(block);
+		for (k = 0; k < block->count; k++, i++)
+		{
+			data->sidedefs.offsetx[i] = sidedefs[k].offsetx;
+			data->sidedefs.offsety[i] = sidedefs[k].offsety;
+			memcpy(data->sidedefs.texturetop[i], sidedefs[k].texturetop, MAP_NAME_LENGTH);
+			memcpy(data->sidedefs.texturebottom[i], sidedefs[k].texturebottom, MAP_NAME_LENGTH);
+			memcpy(data->sidedefs.texturemiddle[i], sidedefs[k].texturemiddle, MAP_NAME_LENGTH);
+			data->sidedefs.sector[i] = sidedefs[k].sector;
+		}
+	}
+
+	for (i = 0, block = state->vertexes.first; block; block = block->next)
+	{
+		udmfvertex_t *vertexes = (udmfvertex_t*)UDMF_BLOCK_RECORDS(block);
+		for (k = 0; k < block->count; k++, i++)
+		{
+			data->vertexes.x[i] = vertexes[k].x;
+			data->vertexes.y[i] = vertexes[k].y;
+		}
+	}
+
+	for (i = 0, block = state->sectors.first; block; block = block->next)
+	{
+		udmfsector_t *sectors = (udmfsector_t*)UDMF_BLOCK_RECORDS(block);
+		for (k = 0; k < block->count; k++, i++)
+		{
+			data->sectors.heightfloor[i] = sectors[k].heightfloor;
+			data->sectors.heightceiling[i] = sectors[k].heightceiling;
+			memcpy(data->sectors.texturefloor[i], sectors[k].texturefloor, MAP_NAME_LENGTH);
+			memcpy(data->sectors.textureceiling[i], sectors[k].textureceiling, MAP_NAME_LENGTH);
+			data->sectors.lightlevel[i] = sectors[k].lightlevel;
+			data->sectors.special[i] = sectors[k].special;
+			data->sectors.id[i] = sectors[k].id;
+		}
+	}
+}
+
+// Creates the shared kernel (once, see MAP_UDMFKernel).
+static void UDMF_InitKernel()
+{
+	udmf_kernel = UDMF_CreateKernel();
+}
+
+// ===========================================================================
+// Public Functions
+// ===========================================================================
+
+// ---------------------------------------------------------------
+// lexer_kernel_t* MAP_UDMFKernel()
+// See udmf.h
+// ---------------------------------------------------------------
+lexer_kernel_t* MAP_UDMFKernel()
+{
+	pthread_once(&udmf_kernel_once, UDMF_InitKernel);
+	return udmf_kernel;
+}
+
+// ---------------------------------------------------------------
+// mapdata_t* MAP_ParseUDMF(stream_t *stream, char *name)
+// See udmf.h
+// ---------------------------------------------------------------
+mapdata_t* MAP_ParseUDMF(stream_t *stream, char *name)
+{
+	lexer_kernel_t *kernel;
+	lexer_t *lexer;
+	udmfstate_t state;
+	mapdatacount_t count;
+	mapdata_t *out = NULL;
+
+	maperrno = MAPERROR_NO_ERROR;
+
+	if (!stream)
+	{
+		maperrno = MAPERROR_WAD_ERROR;
+		return NULL;
+	}
+
+	if (!(kernel = MAP_UDMFKernel()) || !(lexer = LXR_Create(kernel)))
+	{
+		STREAM_Close(stream);
+		maperrno = MAPERROR_OUT_OF_MEMORY;
+		return NULL;
+	}
+	lexer->options.zero_copy = 1;
+	if (LXR_PushStreamHandle(lexer, name, stream))
+	{
+		STREAM_Close(stream);
+		LXR_Destroy(lexer);
+		maperrno = MAPERROR_OUT_OF_MEMORY;
+		return NULL;
+	}
+
+	memset(&state, 0, sizeof(udmfstate_t));
+	if (!(state.arena = MT_ArenaCreate(0)))
+	{
+		LXR_Destroy(lexer);
+		maperrno = MAPERROR_OUT_OF_MEMORY;
+		return NULL;
+	}
+	state.lexer = lexer;
+
+	if (UDMF_Parse(&state))
+	{
+		maperrno = MAPERROR_PARSE_ERROR;
+	}
+	else
+	{
+		count.things = state.things.count;
+		count.linedefs = state.linedefs.count;
+		count.sidedefs = state.sidedefs.count;
+		count.vertexes = state.vertexes.count;
+		count.sectors = state.sectors.count;
+		count.segs = 0;
+		count.subsectors = 0;
+		count.nodes = 0;
+		if ((out = MAP_DataCreate(MF_UDMF, &count)))
+			UDMF_Fill(&state, out);
+	}
+
+	MT_ArenaDestroy(state.arena);
+	LXR_Destroy(lexer);
+	return out;
+}
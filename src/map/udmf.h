@@ -0,0 +1,38 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#ifndef __UDMF_H__
+#define __UDMF_H__
+
+#include "io/stream.h"
+#include "parser/lexer_kernel.h"
+#include "mapdata.h"
+
+/**
+ * Gets the lexer kernel used for UDMF parsing.
+ * The kernel is created on first call (generated from udmf.lxk, so it is already compiled), and shared 
+ * (read-only) by all parses after that. Safe to call from multiple threads: the first call creates it exactly once,
+ * and if that fails, every call returns NULL.
+ * The keys, block names and namespace are case-insensitive keywords, so each key
+ * is interned to a keyword subtype while lexing.
+ * @return the kernel, or NULL if it could not be allocated.
+ */
+lexer_kernel_t* MAP_UDMFKernel();
+
+/**
+ * Parses a UDMF TEXTMAP into map data.
+ * Thing and linedef flags are translated to their binary equivalents (Doom-style bits for the
+ * "doom", "heretic" and "strife" namespaces, Hexen-style for others). Unknown keys and blocks are skipped.
+ * Texture names longer than 8 characters are truncated.
+ * @param stream the stream to read. It is closed when parsing completes, successful or not.
+ * @param name the name of the stream (for the lexer).
+ * @return newly-allocated map data (format MF_UDMF), or NULL on error (sets maperrno).
+ */
+mapdata_t* MAP_ParseUDMF(stream_t *stream, char *name);
+
+#endif
@@ -0,0 +1,487 @@
+/*****************************************************************************
+ * Generated by lxrgen from src/map/udmf.lxk - DO NOT EDIT.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "parser/lexer_kernel.h"
+#include "udmf_kernel.h"
+
+// Class bits for each byte value.
+static const uint16_t char_class[256] =
+{
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x00c0, 0x0090, 0x0080, 0x0080, 0x0080, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x00a0, 0x0000, 0x2000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x1000, 0x0a00, 0x0000, 0x0a00, 0x4000, 0x0800,
+	0x0006, 0x0006, 0x0006, 0x0006, 0x0006, 0x0006, 0x0006, 0x0006,
+	0x0006, 0x0006, 0x0000, 0x0800, 0x0000, 0x0800, 0x0000, 0x0000,
+	0x0000, 0x0005, 0x0005, 0x0005, 0x0005, 0x0105, 0x0005, 0x0001,
+	0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001,
+	0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001,
+	0x0401, 0x0001, 0x0001, 0x0000, 0x8000, 0x0000, 0x0000, 0x0008,
+	0x0000, 0x0005, 0x0005, 0x0005, 0x0005, 0x0105, 0x0005, 0x0001,
+	0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001,
+	0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001, 0x0001,
+	0x0401, 0x0001, 0x0001, 0x0800, 0x0000, 0x0800, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+};
+
+// String end character for each string start character.
+static const char string_end[256] =
+{
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 34, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+// Gets a keyword type from a slice of text.
+static int keyword_type(const char *text, int length)
+{
+	switch (length)
+	{
+		case 1:
+			switch ((unsigned char)text[0])
+			{
+				case 'X':
+				case 'x':
+					return UDMFK_X;
+				case 'Y':
+				case 'y':
+					return UDMFK_Y;
+			}
+			break;
+		case 2:
+			switch ((unsigned char)text[0])
+			{
+				case 'D':
+				case 'd':
+					if (strnicmp(text + 1, "m", 1) == 0)
+						return UDMFK_DM;
+					break;
+				case 'I':
+				case 'i':
+					if (strnicmp(text + 1, "d", 1) == 0)
+						return UDMFK_ID;
+					break;
+				case 'V':
+				case 'v':
+					if (strnicmp(text + 1, "1", 1) == 0)
+						return UDMFK_V1;
+					if (strnicmp(text + 1, "2", 1) == 0)
+						return UDMFK_V2;
+					break;
+			}
+			break;
+		case 4:
+			switch ((unsigned char)text[0])
+			{
+				case 'A':
+				case 'a':
+					if (strnicmp(text + 1, "rg0", 3) == 0)
+						return UDMFK_ARG0;
+					if (strnicmp(text + 1, "rg1", 3) == 0)
+						return UDMFK_ARG1;
+					if (strnicmp(text + 1, "rg2", 3) == 0)
+						return UDMFK_ARG2;
+					if (strnicmp(text + 1, "rg3", 3) == 0)
+						return UDMFK_ARG3;
+					if (strnicmp(text + 1, "rg4", 3) == 0)
+						return UDMFK_ARG4;
+					break;
+				case 'C':
+				case 'c':
+					if (strnicmp(text + 1, "oop", 3) == 0)
+						return UDMFK_COOP;
+					break;
+				case 'T':
+				case 't':
+					if (strnicmp(text + 1, "rue", 3) == 0)
+						return UDMFK_TRUE;
+					if (strnicmp(text + 1, "ype", 3) == 0)
+						return UDMFK_TYPE;
+					break;
+			}
+			break;
+		case 5:
+			switch ((unsigned char)text[0])
+			{
+				case 'A':
+				case 'a':
+					if (strnicmp(text + 1, "ngle", 4) == 0)
+						return UDMFK_ANGLE;
+					break;
+				case 'F':
+				case 'f':
+					if (strnicmp(text + 1, "alse", 4) == 0)
+						return UDMFK_FALSE;
+					break;
+				case 'T':
+				case 't':
+					if (strnicmp(text + 1, "hing", 4) == 0)
+						return UDMFK_THING;
+					break;
+			}
+			break;
+		case 6:
+			switch ((unsigned char)text[0])
+			{
+				case 'A':
+				case 'a':
+					if (strnicmp(text + 1, "mbush", 5) == 0)
+						return UDMFK_AMBUSH;
+					break;
+				case 'C':
+				case 'c':
+					if (strnicmp(text + 1, "lass1", 5) == 0)
+						return UDMFK_CLASS1;
+					if (strnicmp(text + 1, "lass2", 5) == 0)
+						return UDMFK_CLASS2;
+					if (strnicmp(text + 1, "lass3", 5) == 0)
+						return UDMFK_CLASS3;
+					break;
+				case 'F':
+				case 'f':
+					if (strnicmp(text + 1, "riend", 5) == 0)
+						return UDMFK_FRIEND;
+					break;
+				case 'H':
+				case 'h':
+					if (strnicmp(text + 1, "eight", 5) == 0)
+						return UDMFK_HEIGHT;
+					break;
+				case 'I':
+				case 'i':
+					if (strnicmp(text + 1, "mpact", 5) == 0)
+						return UDMFK_IMPACT;
+					break;
+				case 'M':
+				case 'm':
+					if (strnicmp(text + 1, "apped", 5) == 0)
+						return UDMFK_MAPPED;
+					break;
+				case 'S':
+				case 's':
+					if (strnicmp(text + 1, "ecret", 5) == 0)
+						return UDMFK_SECRET;
+					if (strnicmp(text + 1, "ector", 5) == 0)
+						return UDMFK_SECTOR;
+					if (strnicmp(text + 1, "ingle", 5) == 0)
+						return UDMFK_SINGLE;
+					if (strnicmp(text + 1, "kill1", 5) == 0)
+						return UDMFK_SKILL1;
+					if (strnicmp(text + 1, "kill2", 5) == 0)
+						return UDMFK_SKILL2;
+					if (strnicmp(text + 1, "kill3", 5) == 0)
+						return UDMFK_SKILL3;
+					if (strnicmp(text + 1, "kill4", 5) == 0)
+						return UDMFK_SKILL4;
+					if (strnicmp(text + 1, "kill5", 5) == 0)
+						return UDMFK_SKILL5;
+					break;
+				case 'V':
+				case 'v':
+					if (strnicmp(text + 1, "ertex", 5) == 0)
+						return UDMFK_VERTEX;
+					break;
+			}
+			break;
+		case 7:
+			switch ((unsigned char)text[0])
+			{
+				case 'D':
+				case 'd':
+					if (strnicmp(text + 1, "ormant", 6) == 0)
+						return UDMFK_DORMANT;
+					break;
+				case 'L':
+				case 'l':
+					if (strnicmp(text + 1, "inedef", 6) == 0)
+						return UDMFK_LINEDEF;
+					break;
+				case 'O':
+				case 'o':
+					if (strnicmp(text + 1, "ffsetx", 6) == 0)
+						return UDMFK_OFFSETX;
+					if (strnicmp(text + 1, "ffsety", 6) == 0)
+						return UDMFK_OFFSETY;
+					break;
+				case 'P':
+				case 'p':
+					if (strnicmp(text + 1, "assuse", 6) == 0)
+						return UDMFK_PASSUSE;
+					break;
+				case 'S':
+				case 's':
+					if (strnicmp(text + 1, "idedef", 6) == 0)
+						return UDMFK_SIDEDEF;
+					if (strnicmp(text + 1, "pecial", 6) == 0)
+						return UDMFK_SPECIAL;
+					break;
+			}
+			break;
+		case 8:
+			switch ((unsigned char)text[0])
+			{
+				case 'B':
+				case 'b':
+					if (strnicmp(text + 1, "locking", 7) == 0)
+						return UDMFK_BLOCKING;
+					break;
+				case 'D':
+				case 'd':
+					if (strnicmp(text + 1, "ontdraw", 7) == 0)
+						return UDMFK_DONTDRAW;
+					break;
+				case 'S':
+				case 's':
+					if (strnicmp(text + 1, "ideback", 7) == 0)
+						return UDMFK_SIDEBACK;
+					break;
+				case 'T':
+				case 't':
+					if (strnicmp(text + 1, "wosided", 7) == 0)
+						return UDMFK_TWOSIDED;
+					break;
+			}
+			break;
+		case 9:
+			switch ((unsigned char)text[0])
+			{
+				case 'N':
+				case 'n':
+					if (strnicmp(text + 1, "amespace", 8) == 0)
+						return UDMFK_NAMESPACE;
+					break;
+				case 'P':
+				case 'p':
+					if (strnicmp(text + 1, "layeruse", 8) == 0)
+						return UDMFK_PLAYERUSE;
+					break;
+				case 'S':
+				case 's':
+					if (strnicmp(text + 1, "idefront", 8) == 0)
+						return UDMFK_SIDEFRONT;
+					break;
+			}
+			break;
+		case 10:
+			switch ((unsigned char)text[0])
+			{
+				case 'B':
+				case 'b':
+					if (strnicmp(text + 1, "locksound", 9) == 0)
+						return UDMFK_BLOCKSOUND;
+					break;
+				case 'D':
+				case 'd':
+					if (strnicmp(text + 1, "ontpegtop", 9) == 0)
+						return UDMFK_DONTPEGTOP;
+					break;
+				case 'L':
+				case 'l':
+					if (strnicmp(text + 1, "ightlevel", 9) == 0)
+						return UDMFK_LIGHTLEVEL;
+					break;
+				case 'P':
+				case 'p':
+					if (strnicmp(text + 1, "layerpush", 9) == 0)
+						return UDMFK_PLAYERPUSH;
+					break;
+				case 'T':
+				case 't':
+					if (strnicmp(text + 1, "exturetop", 9) == 0)
+						return UDMFK_TEXTURETOP;
+					break;
+			}
+			break;
+		case 11:
+			switch ((unsigned char)text[0])
+			{
+				case 'H':
+				case 'h':
+					if (strnicmp(text + 1, "eightfloor", 10) == 0)
+						return UDMFK_HEIGHTFLOOR;
+					break;
+				case 'P':
+				case 'p':
+					if (strnicmp(text + 1, "layercross", 10) == 0)
+						return UDMFK_PLAYERCROSS;
+					break;
+			}
+			break;
+		case 12:
+			switch ((unsigned char)text[0])
+			{
+				case 'M':
+				case 'm':
+					if (strnicmp(text + 1, "issilecross", 11) == 0)
+						return UDMFK_MISSILECROSS;
+					if (strnicmp(text + 1, "onstercross", 11) == 0)
+						return UDMFK_MONSTERCROSS;
+					break;
+				case 'T':
+				case 't':
+					if (strnicmp(text + 1, "exturefloor", 11) == 0)
+						return UDMFK_TEXTUREFLOOR;
+					break;
+			}
+			break;
+		case 13:
+			switch ((unsigned char)text[0])
+			{
+				case 'B':
+				case 'b':
+					if (strnicmp(text + 1, "lockmonsters", 12) == 0)
+						return UDMFK_BLOCKMONSTERS;
+					break;
+				case 'D':
+				case 'd':
+					if (strnicmp(text + 1, "ontpegbottom", 12) == 0)
+						return UDMFK_DONTPEGBOTTOM;
+					break;
+				case 'H':
+				case 'h':
+					if (strnicmp(text + 1, "eightceiling", 12) == 0)
+						return UDMFK_HEIGHTCEILING;
+					break;
+				case 'R':
+				case 'r':
+					if (strnicmp(text + 1, "epeatspecial", 12) == 0)
+						return UDMFK_REPEATSPECIAL;
+					break;
+				case 'T':
+				case 't':
+					if (strnicmp(text + 1, "exturebottom", 12) == 0)
+						return UDMFK_TEXTUREBOTTOM;
+					if (strnicmp(text + 1, "exturemiddle", 12) == 0)
+						return UDMFK_TEXTUREMIDDLE;
+					break;
+			}
+			break;
+		case 14:
+			switch ((unsigned char)text[0])
+			{
+				case 'T':
+				case 't':
+					if (strnicmp(text + 1, "extureceiling", 13) == 0)
+						return UDMFK_TEXTURECEILING;
+					break;
+			}
+			break;
+	}
+	return -1;
+}
+
+// Gets the next delimiter trie node from a node and a character.
+static int trie_next(int node, int c)
+{
+	switch (node)
+	{
+		case 0:
+			switch (c)
+			{
+				case '+': return 1;
+				case '-': return 2;
+				case '/': return 7;
+				case ';': return 3;
+				case '=': return 4;
+				case '{': return 5;
+				case '}': return 6;
+			}
+			break;
+		case 7:
+			switch (c)
+			{
+				case '*': return 8;
+				case '/': return 9;
+			}
+			break;
+	}
+	return LXRK_TRIE_NONE;
+}
+
+// Delimiter type of each trie node.
+static const int delimiter_type[10] =
+{
+	-1,
+	UDMFD_PLUS,
+	UDMFD_MINUS,
+	UDMFD_SEMICOLON,
+	UDMFD_EQUALS,
+	UDMFD_LBRACE,
+	UDMFD_RBRACE,
+	-1,
+	-1,
+	-1,
+};
+
+// Comment end of each trie node.
+static char* const comment_end[10] =
+{
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	"*/",
+	NULL,
+};
+
+// Line comment flag of each trie node.
+static const char line_comment[10] =
+{
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 1,
+};
+
+static const lexer_kernel_generated_t generated =
+{
+	char_class,
+	string_end,
+	'.',
+	'\\',
+	keyword_type,
+	trie_next,
+	delimiter_type,
+	comment_end,
+	line_comment,
+	10,
+};
+
+lexer_kernel_t* UDMF_CreateKernel()
+{
+	return LXRK_CreateGenerated(&generated);
+}
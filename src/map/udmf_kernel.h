@@ -0,0 +1,106 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#ifndef __UDMF_KERNEL_H__
+#define __UDMF_KERNEL_H__
+
+#include "parser/lexer_kernel.h"
+
+// Delimiter types.
+#define UDMFD_LBRACE		0
+#define UDMFD_RBRACE		1
+#define UDMFD_EQUALS		2
+#define UDMFD_SEMICOLON		3
+#define UDMFD_MINUS			4
+#define UDMFD_PLUS			5
+
+/**
+ * Keyword types - every known key, block name, and literal.
+ */
+typedef enum {
+
+	UDMFK_NAMESPACE,
+	UDMFK_THING,
+	UDMFK_LINEDEF,
+	UDMFK_SIDEDEF,
+	UDMFK_VERTEX,
+	UDMFK_SECTOR,
+	UDMFK_TRUE,
+	UDMFK_FALSE,
+
+	UDMFK_X,
+	UDMFK_Y,
+	UDMFK_HEIGHT,
+	UDMFK_ANGLE,
+	UDMFK_TYPE,
+	UDMFK_ID,
+	UDMFK_SPECIAL,
+	UDMFK_ARG0,
+	UDMFK_ARG1,
+	UDMFK_ARG2,
+	UDMFK_ARG3,
+	UDMFK_ARG4,
+	UDMFK_V1,
+	UDMFK_V2,
+	UDMFK_SIDEFRONT,
+	UDMFK_SIDEBACK,
+	UDMFK_OFFSETX,
+	UDMFK_OFFSETY,
+	UDMFK_TEXTURETOP,
+	UDMFK_TEXTUREBOTTOM,
+	UDMFK_TEXTUREMIDDLE,
+	UDMFK_HEIGHTFLOOR,
+	UDMFK_HEIGHTCEILING,
+	UDMFK_TEXTUREFLOOR,
+	UDMFK_TEXTURECEILING,
+	UDMFK_LIGHTLEVEL,
+
+	UDMFK_SKILL1,
+	UDMFK_SKILL2,
+	UDMFK_SKILL3,
+	UDMFK_SKILL4,
+	UDMFK_SKILL5,
+	UDMFK_AMBUSH,
+	UDMFK_SINGLE,
+	UDMFK_DM,
+	UDMFK_COOP,
+	UDMFK_FRIEND,
+	UDMFK_DORMANT,
+	UDMFK_CLASS1,
+	UDMFK_CLASS2,
+	UDMFK_CLASS3,
+
+	UDMFK_BLOCKING,
+	UDMFK_BLOCKMONSTERS,
+	UDMFK_TWOSIDED,
+	UDMFK_DONTPEGTOP,
+	UDMFK_DONTPEGBOTTOM,
+	UDMFK_SECRET,
+	UDMFK_BLOCKSOUND,
+	UDMFK_DONTDRAW,
+	UDMFK_MAPPED,
+	UDMFK_PASSUSE,
+	UDMFK_REPEATSPECIAL,
+	UDMFK_PLAYERCROSS,
+	UDMFK_PLAYERUSE,
+	UDMFK_MONSTERCROSS,
+	UDMFK_IMPACT,
+	UDMFK_PLAYERPUSH,
+	UDMFK_MISSILECROSS,
+
+	UDMFK_COUNT
+
+} udmfkey_t;
+
+/**
+ * Creates a new UDMF lexer kernel (generated from udmf.lxk - see the "kernels" target).
+ * @return a new, compiled lexer kernel or NULL if it couldn't be allocated.
+ */
+lexer_kernel_t* UDMF_CreateKernel();
+
+#endif
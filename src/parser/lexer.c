@@ -13,9 +13,23 @@
 #include "lexer.h"
 #include "../io/stream.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define LXRC_END_OF_LEXER	-1
 #define LXRC_END_OF_STREAM	-2
 
+// Arguments for LXR_AddRun(): the classes that continue a state, and the classes tested before them that end it.
+#define LXR_RUN_IDENTIFIER		(LXRK_CC_UNDERSCORE | LXRK_CC_ALPHABETICAL | LXRK_CC_DECIMAL), (LXRK_CC_WHITESPACE | LXRK_CC_STRING_START | LXRK_CC_DELIMITER_START)
+#define LXR_RUN_NUMBER			LXRK_CC_DECIMAL, (LXRK_CC_WHITESPACE | LXRK_CC_DECIMAL_SEPARATOR | LXRK_CC_EXPONENT | LXRK_CC_STRING_START | LXRK_CC_DELIMITER_START | LXRK_CC_ALPHABETICAL)
+#define LXR_RUN_FLOAT			LXRK_CC_DECIMAL, (LXRK_CC_WHITESPACE | LXRK_CC_EXPONENT | LXRK_CC_STRING_START)
+#define LXR_RUN_HEX			LXRK_CC_HEXADECIMAL, (LXRK_CC_WHITESPACE | LXRK_CC_STRING_START | LXRK_CC_DELIMITER_START)
+#define LXR_RUN_EXPONENT_POWER	LXRK_CC_DECIMAL, (LXRK_CC_WHITESPACE | LXRK_CC_STRING_START)
+
+// If a character after a token is read back as itself once stored (not skipped like CR, taken as nothing like NUL, or a negative char).
+#define LXR_STORES_AS_IS(c)		((c) != 0x0D && (c) != 0x00 && (c) < 0x80)
+
 
 // ===========================================================================
 // Common Private Functions
@@ -28,7 +42,13 @@ static void LXR_ResetToken(lexer_token_t *token)
 	token->type = LXRT_UNKNOWN;
 	token->subtype = -1;
 	token->lexeme[0] = '\0';
+	token->text = token->lexeme;
+	token->offset = 0;
 	token->length = 0;
+	token->escaped = 0;
+	token->string_end = '\0';
+	token->integer = 0;
+	token->decimal = 0.0;
 	token->line_number = 0;
 }
 
@@ -39,6 +59,7 @@ static void LXR_ResetOptions(lexer_options_t *options)
 	options->include_tabs = 0;
 	options->include_newlines = 0;
 	options->include_stream_break = 0;
+	options->zero_copy = 0;
 }
 
 // Creates a lexer stream.
@@ -49,6 +70,10 @@ static lexer_stream_t* LXR_CreateStream(char *name, stream_t *stream)
 		return NULL;
 	out->name = name;
 	out->stream = stream;
+	out->memory = STREAM_GetMemory(stream);
+	out->span_start = NULL;
+	out->span_pos = NULL;
+	out->span_end = NULL;
 	out->line_number = 1;
 	out->character_number = 0;
 	return out;
@@ -93,6 +118,28 @@ static stream_t* LXR_PopStreamNode(lexer_t *lexer)
 	return out;
 }
 
+// Advances the source stream past the read part of the current span and gets the next span.
+// Returns nonzero if there is a new span, 0 if not (end of stream, or a stream without spans).
+static int LXR_FillSpan(lexer_stream_t *lexerstream)
+{
+	const unsigned char *ptr;
+	int n;
+	
+	STREAM_Advance(lexerstream->stream, lexerstream->span_pos - lexerstream->span_start);
+	if ((n = STREAM_Peek(lexerstream->stream, &ptr)) > 0)
+	{
+		lexerstream->span_start = ptr;
+		lexerstream->span_pos = ptr;
+		lexerstream->span_end = ptr + n;
+		return 1;
+	}
+	
+	lexerstream->span_start = NULL;
+	lexerstream->span_pos = NULL;
+	lexerstream->span_end = NULL;
+	return 0;
+}
+
 // Get a single character from a lexer.
 // Ignores CR.
 // Return LXRC_END_OF_LEXER if no more streams.
@@ -107,7 +154,10 @@ static int LXR_GetChar(lexer_t *lexer)
 	
 	// skip CR
 	do {
-		out = STREAM_GetChar(lexerstream->stream);
+		if (lexerstream->span_pos < lexerstream->span_end || LXR_FillSpan(lexerstream))
+			out = *(lexerstream->span_pos++);
+		else
+			out = STREAM_GetChar(lexerstream->stream);
 		if (out == 0x0A) // line feed
 		{
 			lexerstream->line_number++;
@@ -125,9 +175,53 @@ static int LXR_GetChar(lexer_t *lexer)
 	return out;
 }
 
+// Sets if tokens from the current stream can be zero-copy slices.
+static void LXR_UpdateSlicing(lexer_t *lexer)
+{
+	lexer->slicing = lexer->options.zero_copy 
+		&& lexer->kernel->compiled 
+		&& lexer->stream_stack 
+		&& lexer->stream_stack->stream->memory;
+}
+
+// Copies a zero-copy token's text to its lexeme (as much as fits).
+static void LXR_CopySlice(lexer_t *lexer)
+{
+	int len = lexer->token.length < LEXEME_LENGTH_MAX - 1 ? lexer->token.length : LEXEME_LENGTH_MAX - 1;
+	memcpy(lexer->token.lexeme, lexer->token.text, len);
+	lexer->token.lexeme[len] = 0x00;
+	lexer->token.text = lexer->token.lexeme;
+	lexer->token.length = len;
+}
+
 // Adds to the current token.
 static void LXR_AddToToken(lexer_t *lexer, int c)
 {
+	if (lexer->slicing)
+	{
+		lexer_stream_t *lexerstream = lexer->stream_stack->stream;
+		// the last character read is always the one added.
+		const char *src = (const char*)lexerstream->span_pos - 1;
+		if (!lexer->token.length)
+		{
+			lexer->token.text = src;
+			lexer->token.length = 1;
+			lexer->token.line_number = lexerstream->line_number;
+			return;
+		}
+		else if (lexer->token.text != lexer->token.lexeme)
+		{
+			if (src == lexer->token.text + lexer->token.length)
+			{
+				lexer->token.length++;
+				lexer->token.line_number = lexerstream->line_number;
+				return;
+			}
+			// not contiguous (skipped CR) - copy from here on.
+			LXR_CopySlice(lexer);
+		}
+	}
+
 	if (lexer->token.length >= LEXEME_LENGTH_MAX - 1)
 		return;
 	
@@ -149,10 +243,338 @@ static void LXR_AddToTokenTemp(lexer_t *lexer, int c)
 	lexer->token.lexeme[lexer->token.length+1] = 0x00; // null-terminate
 }
 
+// Gets the unread part of the current stream's span, filling it if needed.
+// Returns its length, or 0 if there is none.
+static int LXR_Peek(lexer_t *lexer, const unsigned char **ptr)
+{
+	if (!lexer->stream_stack)
+		return 0;
+	lexer_stream_t *lexerstream = lexer->stream_stack->stream;
+	if (lexerstream->span_pos >= lexerstream->span_end && !LXR_FillSpan(lexerstream))
+		return 0;
+	*ptr = lexerstream->span_pos;
+	return lexerstream->span_end - lexerstream->span_pos;
+}
+
+// Skips peeked bytes that are not part of a token (comments, whitespace).
+static void LXR_Skip(lexer_t *lexer, const unsigned char *ptr, int n)
+{
+	lexer_stream_t *lexerstream = lexer->stream_stack->stream;
+	int i;
+	for (i = 0; i < n; i++)
+	{
+		if (ptr[i] == 0x0A) // line feed
+		{
+			lexerstream->line_number++;
+			lexerstream->character_number = 0;
+		}
+		else if (ptr[i] != 0x0D) // CR (ignored)
+		{
+			lexerstream->character_number++;
+		}
+	}
+	lexerstream->span_pos += n;
+}
+
+// Adds peeked bytes to the current token and skips them. The bytes cannot contain CR or LF.
+static void LXR_AddSpanToToken(lexer_t *lexer, const unsigned char *ptr, int n)
+{
+	lexer_stream_t *lexerstream = lexer->stream_stack->stream;
+	const char *src = (const char*)ptr;
+
+	if (lexer->slicing && !lexer->token.length)
+	{
+		lexer->token.text = src;
+		lexer->token.length = n;
+		lexer->token.line_number = lexerstream->line_number;
+	}
+	else if (lexer->slicing && lexer->token.text != lexer->token.lexeme && src == lexer->token.text + lexer->token.length)
+	{
+		lexer->token.length += n;
+	}
+	else
+	{
+		if (lexer->token.text != lexer->token.lexeme)
+			LXR_CopySlice(lexer);
+		int amount = LEXEME_LENGTH_MAX - 1 - lexer->token.length;
+		amount = n < amount ? n : amount;
+		if (amount > 0)
+		{
+			memcpy(lexer->token.lexeme + lexer->token.length, src, amount);
+			lexer->token.length += amount;
+			lexer->token.lexeme[lexer->token.length] = 0x00;
+		}
+		lexer->token.line_number = lexerstream->line_number;
+	}
+
+	lexerstream->character_number += n;
+	lexerstream->span_pos += n;
+}
+
+// Scans peeked bytes from "i" while they have a class in "want" and none in "stop". Returns where it stopped.
+static int LXR_ScanRun(const uint16_t *cc, const unsigned char *p, int i, int n, uint16_t want, uint16_t stop)
+{
+	for (; i < n && (cc[p[i]] & want) && !(cc[p[i]] & stop); i++) ;
+	return i;
+}
+
+// Adds the run of upcoming characters that have a class in "want" and none in "stop" to the current token.
+// This is the same as adding them one at a time from a state that only continues on those characters.
+static void LXR_AddRun(lexer_t *lexer, uint16_t want, uint16_t stop)
+{
+	const uint16_t *cc = lexer->kernel->char_class;
+	const unsigned char *p;
+	int i, n;
+	do {
+		n = LXR_Peek(lexer, &p);
+		i = LXR_ScanRun(cc, p, 0, n, want, stop);
+		if (i)
+			LXR_AddSpanToToken(lexer, p, i);
+	} while (i && i == n);
+}
+
+// Adds the run of upcoming plain string characters (not the string end, an escape, or a newline) to the current token.
+static void LXR_AddStringRun(lexer_t *lexer)
+{
+	unsigned char end = (unsigned char)lexer->string_end;
+	unsigned char escape = (unsigned char)lexer->kernel->escape_char;
+	const uint16_t *cc = lexer->kernel->char_class;
+	const unsigned char *p;
+	int i, n;
+	do {
+		n = LXR_Peek(lexer, &p);
+		i = 0;
+#ifdef __SSE2__
+		__m128i vend = _mm_set1_epi8((char)end);
+		__m128i vescape = _mm_set1_epi8((char)escape);
+		__m128i vlf = _mm_set1_epi8(0x0A);
+		__m128i vcr = _mm_set1_epi8(0x0D);
+		for (; i + 16 <= n; i += 16)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+			__m128i m = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, vend), _mm_cmpeq_epi8(v, vescape)),
+				_mm_or_si128(_mm_cmpeq_epi8(v, vlf), _mm_cmpeq_epi8(v, vcr))
+			);
+			if (_mm_movemask_epi8(m))
+				break;
+		}
+#endif
+		for (; i < n && p[i] != end && p[i] != 0x0D && !(cc[p[i]] & (LXRK_CC_NEWLINE | LXRK_CC_ESCAPE)); i++) ;
+		if (i)
+			LXR_AddSpanToToken(lexer, p, i);
+	} while (i && i == n);
+}
+
+// Skips the run of upcoming whitespace that does not make tokens.
+static void LXR_SkipWhitespace(lexer_t *lexer)
+{
+	const uint16_t *cc = lexer->kernel->char_class;
+	uint16_t stop = 
+		(lexer->options.include_newlines ? LXRK_CC_NEWLINE : 0)
+		| (lexer->options.include_spaces ? LXRK_CC_SPACE : 0)
+		| (lexer->options.include_tabs ? LXRK_CC_TAB : 0);
+	const unsigned char *p;
+	int i, n;
+	do {
+		n = LXR_Peek(lexer, &p);
+		for (i = 0; i < n && (cc[p[i]] & LXRK_CC_WHITESPACE) && !(cc[p[i]] & stop); i++) ;
+		if (i)
+			LXR_Skip(lexer, p, i);
+	} while (i && i == n);
+}
+
+// Skips upcoming characters up to (not including) the next "c".
+static void LXR_SkipTo(lexer_t *lexer, unsigned char c)
+{
+	const unsigned char *p, *found;
+	int n;
+	do {
+		if (!(n = LXR_Peek(lexer, &p)))
+			return;
+		found = (const unsigned char*)memchr(p, c, n);
+		LXR_Skip(lexer, p, found ? found - p : n);
+	} while (!found);
+}
+
+// Clears the current token.
+static void LXR_ClearToken(lexer_t *lexer)
+{
+	lexer->token.lexeme[0] = '\0';
+	lexer->token.text = lexer->token.lexeme;
+	lexer->token.length = 0;
+}
+
+// Checks if the last character read in a comment plus this one ends it.
+static int LXR_IsCommentEnd(lexer_t *lexer, int c)
+{
+	const char *end = lexer->comment_end;
+	return end[0] == lexer->comment_char && end[1] != '\0' && end[1] == c && end[2] == '\0';
+}
+
 // Flatten token back to current length.
 static void LXR_FlattenToken(lexer_t *lexer)
 {
-	lexer->token.lexeme[lexer->token.length] = '\0';
+	if (lexer->token.text == lexer->token.lexeme)
+		lexer->token.lexeme[lexer->token.length] = '\0';
+}
+
+// Starts a delimiter walk at its first character (compiled kernels only).
+static void LXR_StartDelimiter(lexer_t *lexer, int c)
+{
+	if (lexer->kernel->compiled)
+		lexer->delimiter_node = LXRK_TrieNext(lexer->kernel, LXRK_TRIE_ROOT, c);
+}
+
+// Looks up the current token plus the next character as a delimiter or comment start.
+// Sets the next trie node in "node" (compiled kernels), the comment end in "comment_end",
+// and if it is a line comment in "line_comment". Returns the delimiter type, or -1 if not a delimiter.
+static int LXR_NextDelimiter(lexer_t *lexer, int c, int *node, char **comment_end, int *line_comment)
+{
+	if (lexer->kernel->compiled)
+	{
+		*node = LXRK_TrieNext(lexer->kernel, lexer->delimiter_node, c);
+		*comment_end = LXRK_TrieCommentEnd(lexer->kernel, *node);
+		*line_comment = LXRK_TrieLineComment(lexer->kernel, *node);
+		return LXRK_TrieDelimiterType(lexer->kernel, *node);
+	}
+	else
+	{
+		LXR_AddToTokenTemp(lexer, c);
+		*node = LXRK_TRIE_NONE;
+		*comment_end = LXRK_GetCommentEnd(lexer->kernel, lexer->token.lexeme);
+		*line_comment = LXRK_IsLineComment(lexer->kernel, lexer->token.lexeme);
+		return LXRK_GetDelimiterType(lexer->kernel, lexer->token.lexeme);
+	}
+}
+
+// Exact powers of ten for the float fast path.
+static const double LXR_POW10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Parses integer digits in a radix, stopping at the first non-digit.
+// Saturates at INT64_MAX, like strtoll().
+static int64_t LXR_ParseInteger(const char *t, int len, int radix)
+{
+	uint64_t out = 0;
+	int i, d;
+	for (i = 0; i < len; i++)
+	{
+		char c = t[i];
+		if (c >= '0' && c <= '9')
+			d = c - '0';
+		else if (c >= 'a' && c <= 'f')
+			d = c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			d = c - 'A' + 10;
+		else
+			break;
+		if (d >= radix)
+			break;
+		if (out > ((uint64_t)INT64_MAX - d) / radix)
+			return INT64_MAX;
+		out = out * radix + d;
+	}
+	return (int64_t)out;
+}
+
+// Decodes a number token's subtype and value from its text in one pass.
+static void LXR_DecodeNumber(lexer_t *lexer)
+{
+	lexer_token_t *token = &(lexer->token);
+	const char *t = token->text;
+	int len = token->length;
+	char decimal = lexer->kernel->decimal_char;
+
+	uint64_t mantissa = 0;
+	int i, digits = 0, exp10 = 0, truncated = 0, point = 0, exponent = 0;
+
+	token->integer = 0;
+	token->decimal = 0.0;
+
+	if (len > 1 && t[0] == '0' && (t[1] == 'x' || t[1] == 'X'))
+	{
+		token->subtype = LXRTN_HEX;
+		token->integer = LXR_ParseInteger(t + 2, len - 2, 16);
+		token->decimal = (double)token->integer;
+		return;
+	}
+
+	// mantissa (first 19 significant digits), decimal point, and exponent.
+	for (i = 0; i < len; i++)
+	{
+		char c = t[i];
+		if (c >= '0' && c <= '9')
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (c - '0');
+				if (mantissa)
+					digits++;
+				if (point)
+					exp10--;
+			}
+			else
+			{
+				truncated = 1;
+				if (!point)
+					exp10++;
+			}
+		}
+		else if (c == decimal)
+		{
+			point = 1;
+		}
+		else if (c == 'e' || c == 'E')
+		{
+			int e = 0, negative = 0;
+			exponent = 1;
+			if (++i < len && (t[i] == '-' || t[i] == '+'))
+				negative = t[i++] == '-';
+			for (; i < len && t[i] >= '0' && t[i] <= '9'; i++)
+				if (e < 100000)
+					e = e * 10 + (t[i] - '0');
+			exp10 += negative ? -e : e;
+			break;
+		}
+		else
+			break;
+	}
+
+	if (!point && len > 0 && t[0] == '0')
+	{
+		token->subtype = LXRTN_OCTAL;
+		token->integer = LXR_ParseInteger(t, len, 8);
+		token->decimal = (double)token->integer;
+	}
+	else if (!point && !exponent)
+	{
+		token->subtype = LXRTN_INTEGER;
+		token->integer = truncated || mantissa > INT64_MAX ? INT64_MAX : (int64_t)mantissa;
+		token->decimal = (double)token->integer;
+	}
+	else
+	{
+		token->subtype = LXRTN_FLOAT;
+		// both the mantissa and the power of ten are exact doubles, so one operation rounds correctly.
+		if (!truncated && mantissa <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22)
+		{
+			token->decimal = exp10 < 0 ? (double)mantissa / LXR_POW10[-exp10] : (double)mantissa * LXR_POW10[exp10];
+		}
+		else
+		{
+			char number[LEXEME_LENGTH_MAX];
+			int n = len < LEXEME_LENGTH_MAX - 1 ? len : LEXEME_LENGTH_MAX - 1;
+			memcpy(number, t, n);
+			number[n] = '\0';
+			if (decimal != '.' && (t = memchr(number, decimal, n)))
+				number[t - number] = '.';
+			token->decimal = strtod(number, NULL);
+		}
+		token->integer = token->decimal < 9.2e18 ? (int64_t)token->decimal : INT64_MAX;
+	}
 }
 
 // Finishes the current token.
@@ -160,39 +582,178 @@ static void LXR_FinishToken(lexer_t *lexer, lexeme_type_t state)
 {
 	LXR_FlattenToken(lexer);
 	lexer->token.stream_name = lexer->stream_stack->stream->name;
+	// a token that never had a character added still has a line: the one it ends on.
+	if (!lexer->token.line_number)
+		lexer->token.line_number = lexer->stream_stack->stream->line_number;
 	
 	lexer->token.type = state;
 	lexer->token.subtype = -1;
 
 	if (lexer->token.type == LXRT_NUMBER)
 	{
-		char *t;
-		if (strchr(lexer->token.lexeme, '.'))
-			lexer->token.subtype = LXRTN_FLOAT;
-		else if ((t = strstr(lexer->token.lexeme, "0x")) && t == lexer->token.lexeme)
-			lexer->token.subtype = LXRTN_HEX;
-		else if ((t = strstr(lexer->token.lexeme, "0X")) && t == lexer->token.lexeme)
-			lexer->token.subtype = LXRTN_HEX;
-		else if ((t = strstr(lexer->token.lexeme, "0")) && t == lexer->token.lexeme)
-			lexer->token.subtype = LXRTN_OCTAL;
-		else if (strchr(lexer->token.lexeme, 'e'))
-			lexer->token.subtype = LXRTN_FLOAT;
-		else if (strchr(lexer->token.lexeme, 'E'))
-			lexer->token.subtype = LXRTN_FLOAT;
-		else
-			lexer->token.subtype = LXRTN_INTEGER;
+		LXR_DecodeNumber(lexer);
 	}
 	else if (lexer->token.type == LXRT_IDENTIFIER)
 	{
-		lexer->token.subtype = LXRK_GetKeywordType(lexer->kernel, lexer->token.lexeme);
+		if (lexer->kernel->compiled)
+			lexer->token.subtype = LXRK_GetKeywordSliceType(lexer->kernel, lexer->token.text, lexer->token.length);
+		else
+			lexer->token.subtype = LXRK_GetKeywordType(lexer->kernel, lexer->token.lexeme);
 		if (lexer->token.subtype >= 0)
 			lexer->token.type = LXRT_KEYWORD;
 	}
 	else if (lexer->token.type == LXRT_DELIMITER)
-		lexer->token.subtype = LXRK_GetDelimiterType(lexer->kernel, lexer->token.lexeme);
+	{
+		if (lexer->kernel->compiled)
+			lexer->token.subtype = LXRK_TrieDelimiterType(lexer->kernel, lexer->delimiter_node);
+		else
+			lexer->token.subtype = LXRK_GetDelimiterType(lexer->kernel, lexer->token.lexeme);
+	}
 	
 }
 
+// Sets the current token's text to peeked bytes (a slice, or a copy of as much as fits).
+static void LXR_SetTokenSpan(lexer_t *lexer, const unsigned char *ptr, int n)
+{
+	if (lexer->slicing)
+	{
+		lexer->token.text = (const char*)ptr;
+		lexer->token.length = n;
+	}
+	else
+	{
+		n = n < LEXEME_LENGTH_MAX - 1 ? n : LEXEME_LENGTH_MAX - 1;
+		memcpy(lexer->token.lexeme, ptr, n);
+		lexer->token.lexeme[n] = 0x00;
+		lexer->token.length = n;
+	}
+}
+
+// Takes back the character stored after the last token: whitespace is dropped (it would only be skipped),
+// anything else is put back in the span it was read from. Returns nonzero if it was taken back.
+static int LXR_Unstore(lexer_t *lexer)
+{
+	lexer_stream_t *lexerstream;
+	int c = lexer->stored;
+	if (c < 0 || !lexer->stream_stack)
+		return 0;
+	if (!(LXRK_CharClass(lexer->kernel, c) & LXRK_CC_WHITESPACE))
+	{
+		lexerstream = lexer->stream_stack->stream;
+		if (!lexerstream->span_pos || lexerstream->span_pos == lexerstream->span_start || lexerstream->span_pos[-1] != c)
+			return 0;
+		lexerstream->span_pos--;
+		lexerstream->character_number--;
+	}
+	lexer->stored = 0;
+	return 1;
+}
+
+// Scans a whole token straight from the current span, skipping whitespace first: an identifier, a decimal number,
+// a one-character delimiter, or a string without escapes, that ends (with the character that ends it) inside the span.
+// This makes the same token as the state machine in LXR_NextToken(), without going through it a character at a time.
+// Returns the finished token, or NULL if the state machine has to make it (nothing but whitespace is read then).
+static lexer_token_t* LXR_QuickToken(lexer_t *lexer)
+{
+	const uint16_t *cc = lexer->kernel->char_class;
+	lexer_stream_t *lexerstream;
+	lexeme_type_t state;
+	const unsigned char *p;
+	int i, n, node = LXRK_TRIE_NONE, next;
+	uint16_t cls, end_cls;
+
+	if (lexer->options.include_newlines || lexer->options.include_spaces || lexer->options.include_tabs)
+		return NULL;
+	if (lexer->stored && !LXR_Unstore(lexer))
+		return NULL;
+
+	LXR_SkipWhitespace(lexer);
+	if ((n = LXR_Peek(lexer, &p)) < 2)
+		return NULL;
+
+	// the character after the token is left in the span for the next one. The state machine stores it instead,
+	// so tokens that end at a character it doesn't store as is are left to it.
+	cls = cc[p[0]];
+	i = 1;
+	if (cls & (LXRK_CC_WHITESPACE | LXRK_CC_DECIMAL_SEPARATOR))
+	{
+		return NULL;
+	}
+	else if (cls & LXRK_CC_STRING_START)
+	{
+		unsigned char string_end = (unsigned char)LXRK_GetStringEnd(lexer->kernel, p[0]);
+		for (; i < n && p[i] != string_end && p[i] != 0x0D && !(cc[p[i]] & (LXRK_CC_NEWLINE | LXRK_CC_ESCAPE)); i++) ;
+		if (i == n || p[i] != string_end || (cc[p[i]] & LXRK_CC_NEWLINE))
+			return NULL;
+		if (i > 1)
+			LXR_SetTokenSpan(lexer, p + 1, i - 1);
+		lexer->string_end = string_end;
+		lexer->token.string_end = string_end;
+		// the end is part of the string.
+		i++;
+		state = LXRT_STRING;
+	}
+	else if (cls & LXRK_CC_DELIMITER_START)
+	{
+		if (!lexer->kernel->compiled)
+			return NULL;
+		node = LXRK_TrieNext(lexer->kernel, LXRK_TRIE_ROOT, p[0]);
+		if (LXRK_TrieDelimiterType(lexer->kernel, node) < 0 || LXRK_TrieCommentEnd(lexer->kernel, node) || LXRK_TrieLineComment(lexer->kernel, node))
+			return NULL;
+		end_cls = cc[p[1]];
+		if (!LXR_STORES_AS_IS(p[1]))
+			return NULL;
+		else if (!(end_cls & (LXRK_CC_WHITESPACE | LXRK_CC_STRING_START)))
+		{
+			// ends if no longer delimiter or comment starts with this.
+			next = LXRK_TrieNext(lexer->kernel, node, p[1]);
+			if (LXRK_TrieDelimiterType(lexer->kernel, next) >= 0 || LXRK_TrieCommentEnd(lexer->kernel, next) || LXRK_TrieLineComment(lexer->kernel, next))
+				return NULL;
+		}
+		LXR_SetTokenSpan(lexer, p, 1);
+		state = LXRT_DELIMITER;
+	}
+	else if (cls & (LXRK_CC_UNDERSCORE | LXRK_CC_ALPHABETICAL))
+	{
+		i = LXR_ScanRun(cc, p, i, n, LXR_RUN_IDENTIFIER);
+		if (i == n || !LXR_STORES_AS_IS(p[i]) || !(cc[p[i]] & (LXRK_CC_WHITESPACE | LXRK_CC_STRING_START | LXRK_CC_DELIMITER_START)))
+			return NULL;
+		LXR_SetTokenSpan(lexer, p, i);
+		state = LXRT_IDENTIFIER;
+	}
+	else if (cls & LXRK_CC_DECIMAL)
+	{
+		// a leading zero only differs from other digits when a hex prefix follows, which isn't taken here.
+		i = LXR_ScanRun(cc, p, i, n, LXR_RUN_NUMBER);
+		if (i < n && (cc[p[i]] & LXRK_CC_DECIMAL_SEPARATOR))
+		{
+			i = LXR_ScanRun(cc, p, i + 1, n, LXR_RUN_FLOAT);
+			if (i == n || !LXR_STORES_AS_IS(p[i]) || (cc[p[i]] & (LXRK_CC_EXPONENT | LXRK_CC_DECIMAL)))
+				return NULL;
+		}
+		else if (i == n || !LXR_STORES_AS_IS(p[i]) || (cc[p[i]] & LXRK_CC_EXPONENT))
+			return NULL;
+		if (!(cc[p[i]] & (LXRK_CC_WHITESPACE | LXRK_CC_STRING_START | LXRK_CC_DELIMITER_START)))
+			return NULL;
+		LXR_SetTokenSpan(lexer, p, i);
+		state = LXRT_NUMBER;
+	}
+	else
+	{
+		return NULL;
+	}
+
+	lexerstream = lexer->stream_stack->stream;
+	if (lexer->slicing)
+		lexer->token.offset = p - lexerstream->memory;
+	lexer->token.line_number = lexerstream->line_number;
+	lexer->delimiter_node = node;
+	lexerstream->character_number += i;
+	lexerstream->span_pos += i;
+	LXR_FinishToken(lexer, state);
+	return &(lexer->token);
+}
+
 // ===========================================================================
 // Public Functions
 // ===========================================================================
@@ -265,9 +826,13 @@ lexer_t* LXR_Create(lexer_kernel_t *kernel)
 		
 	out->kernel = kernel;
 	out->stream_stack = NULL;
+	out->retired = NULL;
 	out->state = LXRT_UNKNOWN;
 	out->string_end = '\0';
 	out->comment_end = NULL;
+	out->comment_char = '\0';
+	out->slicing = 0;
+	out->delimiter_node = LXRK_TRIE_ROOT;
 	out->stored = '\0';
 	
 	LXR_ResetOptions(&(out->options));
@@ -287,6 +852,15 @@ int LXR_Destroy(lexer_t *lexer)
 	
 	while (lexer->stream_stack)
 		LXR_PopStream(lexer);
+
+	while (lexer->retired)
+	{
+		lexer_stream_stack_t *node = lexer->retired;
+		lexer->retired = node->previous;
+		STREAM_Close(node->stream->stream);
+		LXR_FREE(node->stream);
+		LXR_FREE(node);
+	}
 	
 	LXR_FREE(lexer);
 	return 0;
@@ -298,9 +872,15 @@ int LXR_Destroy(lexer_t *lexer)
 // ---------------------------------------------------------------
 int LXR_PushStream(lexer_t *lexer, char *filename)
 {
-	stream_t *stream = STREAM_OpenBuffered(filename, LEXER_STREAM_BUFFER_SIZE);
+	// regular files are mapped, so tokens can be sliced straight out of them.
+	stream_t *stream = STREAM_OpenMapped(filename);
 	if (!stream)
-		return 1;
+	{
+		if (!(stream = STREAM_OpenBuffered(filename, LEXER_STREAM_BUFFER_SIZE)))
+			return 1;
+		// otherwise, read the next buffer while lexing this one.
+		STREAM_SetReadAhead(stream);
+	}
 	
 	return LXR_PushStreamNode(lexer, filename, stream);
 }
@@ -314,6 +894,7 @@ int LXR_PushStreamFile(lexer_t *lexer, char *name, FILE *file)
 	stream_t *stream = STREAM_OpenBufferedFile(file, LEXER_STREAM_BUFFER_SIZE);
 	if (!stream)
 		return 1;
+	STREAM_SetReadAhead(stream);
 	
 	return LXR_PushStreamNode(lexer, name, stream);	
 }
@@ -331,12 +912,34 @@ int LXR_PushStreamBuffer(lexer_t *lexer, char *name, unsigned char *buffer, size
 	return LXR_PushStreamNode(lexer, name, stream);	
 }
 
+// ---------------------------------------------------------------
+// int LXR_PushStreamHandle(lexer_t *lexer, char *name, stream_t *stream)
+// See lexer.h
+// ---------------------------------------------------------------
+int LXR_PushStreamHandle(lexer_t *lexer, char *name, stream_t *stream)
+{
+	if (!stream)
+		return 1;
+	
+	return LXR_PushStreamNode(lexer, name, stream);	
+}
+
 // ---------------------------------------------------------------
 // int LXR_PopStream(lexer_t *lexer)
 // See lexer.h
 // ---------------------------------------------------------------
 int LXR_PopStream(lexer_t *lexer)
 {
+	// a mapping goes away when its stream closes, so keep it while slices may point into it.
+	if (lexer->stream_stack && lexer->options.zero_copy && lexer->stream_stack->stream->stream->type == STREAMI_MMAP)
+	{
+		lexer_stream_stack_t *node = lexer->stream_stack;
+		lexer->stream_stack = node->previous;
+		node->previous = lexer->retired;
+		lexer->retired = node;
+		return 0;
+	}
+
 	stream_t *stream = LXR_PopStreamNode(lexer);
 	if (!stream)
 		return 1;
@@ -352,9 +955,17 @@ int LXR_PopStream(lexer_t *lexer)
 lexer_token_t* LXR_NextToken(lexer_t *lexer)
 {
 	LXR_ResetToken(&(lexer->token));
+	LXR_UpdateSlicing(lexer);
 	lexeme_type_t state = LXRT_UNKNOWN;
+
+	lexer_token_t *quick;
+	if ((quick = LXR_QuickToken(lexer)))
+		return quick;
 	
 	int c, i, h;
+	uint16_t cls;
+	int node, line_comment, delimiter_type;
+	char *comment_end;
 	int breakloop = 0;
 	while (!breakloop)
 	{
@@ -368,6 +979,7 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 		{
 			c = LXR_GetChar(lexer);
 		}
+		cls = LXRK_CharClass(lexer->kernel, c);
 		
 		switch (state)
 		{
@@ -379,6 +991,10 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 
 			case LXRT_UNKNOWN:
 			{
+				// the token starts at the last character read.
+				if (lexer->slicing && c >= 0)
+					lexer->token.offset = lexer->stream_stack->stream->span_pos - 1 - lexer->stream_stack->stream->memory;
+
 				if (c == LXRC_END_OF_LEXER) // Lexer End
 				{
 					state = LXRT_END_OF_LEXER;
@@ -392,74 +1008,83 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 						breakloop = 1;
 					}
 					LXR_PopStream(lexer);
+					LXR_UpdateSlicing(lexer);
 				}
-				else if (LXRK_IsNewlineChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_NEWLINE)
 				{
 					if (lexer->options.include_newlines)
 					{
 						state = LXRT_NEWLINE;
 						breakloop = 1;
 					}
+					else
+						LXR_SkipWhitespace(lexer);
 				}
-				else if (LXRK_IsSpaceChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_SPACE)
 				{
 					if (lexer->options.include_spaces)
 					{
 						state = LXRT_SPACE;
 						breakloop = 1;
 					}
+					else
+						LXR_SkipWhitespace(lexer);
 				}
-				else if (LXRK_IsTabChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_TAB)
 				{
 					if (lexer->options.include_tabs)
 					{
 						state = LXRT_TAB;
 						breakloop = 1;
 					}
+					else
+						LXR_SkipWhitespace(lexer);
 				}
-				else if (LXRK_IsWhitespaceChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_WHITESPACE)
 				{
-					// Do nothing.
+					LXR_SkipWhitespace(lexer);
 				}
-				else if (LXRK_IsDecimalSeparatorChar(lexer->kernel, c) && LXRK_IsDelimiterStartChar(lexer->kernel, c))
+				else if ((cls & LXRK_CC_DECIMAL_SEPARATOR) && (cls & LXRK_CC_DELIMITER_START))
 				{
 					state = LXRT_STATE_POINT;
 					LXR_AddToToken(lexer, c);
+					LXR_StartDelimiter(lexer, c);
 				}
-				else if (LXRK_IsDecimalSeparatorChar(lexer->kernel, c) && !LXRK_IsDelimiterStartChar(lexer->kernel, c))
+				else if ((cls & LXRK_CC_DECIMAL_SEPARATOR) && !(cls & LXRK_CC_DELIMITER_START))
 				{
 					state = LXRT_STATE_FLOAT;
 					LXR_AddToToken(lexer, c);
 				}
-				else if (LXRK_IsStringStartChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_STRING_START)
 				{
 					state = LXRT_STRING;
 					lexer->string_end = LXRK_GetStringEnd(lexer->kernel, c);
+					lexer->token.string_end = lexer->string_end;
+					// empty strings still have a line.
+					lexer->token.line_number = lexer->stream_stack->stream->line_number;
 				}
-				else if (LXRK_IsDelimiterStartChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_DELIMITER_START)
 				{
 					state = LXRT_DELIMITER;
 					LXR_AddToToken(lexer, c);
+					LXR_StartDelimiter(lexer, c);
 				}
-				else if (LXRK_IsUnderscoreChar(lexer->kernel, c))
-				{
-					state = LXRT_IDENTIFIER;
-					LXR_AddToToken(lexer, c);
-				}
-				else if (LXRK_IsAlphabeticalChar(lexer->kernel, c))
+				else if (cls & (LXRK_CC_UNDERSCORE | LXRK_CC_ALPHABETICAL))
 				{
 					state = LXRT_IDENTIFIER;
 					LXR_AddToToken(lexer, c);
+					LXR_AddRun(lexer, LXR_RUN_IDENTIFIER);
 				}
 				else if (c == '0')
 				{
 					state = LXRT_STATE_HEX_INTEGER0;
 					LXR_AddToToken(lexer, c);
 				}
-				else if (LXRK_IsDecimalChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_DECIMAL)
 				{
 					state = LXRT_NUMBER;
 					LXR_AddToToken(lexer, c);
+					LXR_AddRun(lexer, LXR_RUN_NUMBER);
 				}
 				else
 				{
@@ -476,44 +1101,11 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsNewlineChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsSpaceChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsTabChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsWhitespaceChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsStringStartChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsDelimiterStartChar(lexer->kernel, c))
+				else if (cls & (LXRK_CC_WHITESPACE | LXRK_CC_STRING_START | LXRK_CC_DELIMITER_START))
 				{
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsAlphabeticalChar(lexer->kernel, c))
-				{
-					LXR_AddToToken(lexer, c);
-				}
-				else if (LXRK_IsDecimalChar(lexer->kernel, c))
-				{
-					LXR_AddToToken(lexer, c);
-				}
 				else
 				{
 					LXR_AddToToken(lexer, c);
@@ -529,37 +1121,13 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsNewlineChar(lexer->kernel, c))
-				{
-					state = LXRT_DELIMITER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsSpaceChar(lexer->kernel, c))
-				{
-					state = LXRT_DELIMITER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsTabChar(lexer->kernel, c))
-				{
-					state = LXRT_DELIMITER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsWhitespaceChar(lexer->kernel, c))
+				else if (cls & (LXRK_CC_WHITESPACE | LXRK_CC_STRING_START))
 				{
 					state = LXRT_DELIMITER;
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsStringStartChar(lexer->kernel, c))
-				{
-					state = LXRT_DELIMITER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsDecimalChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_DECIMAL)
 				{
 					state = LXRT_STATE_FLOAT;
 					LXR_AddToToken(lexer, c);
@@ -567,9 +1135,11 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 				else
 				{
 					state = LXRT_DELIMITER;
-					LXR_AddToTokenTemp(lexer, c);
-					if (LXRK_GetDelimiterType(lexer->kernel, lexer->token.lexeme) >= 0)
+					if (LXR_NextDelimiter(lexer, c, &node, &comment_end, &line_comment) >= 0)
+					{
 						LXR_AddToToken(lexer, c);
+						lexer->delimiter_node = node;
+					}
 					else
 					{
 						lexer->stored = c;
@@ -580,53 +1150,36 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 			break; // LXRT_STATE_POINT
 
 			case LXRT_STATE_FLOAT:
-			{
-				if (c == LXRC_END_OF_STREAM) // Stream End
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsNewlineChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsSpaceChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsTabChar(lexer->kernel, c))
+			{
+				if (c == LXRC_END_OF_STREAM) // Stream End
 				{
 					state = LXRT_NUMBER;
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsWhitespaceChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_WHITESPACE)
 				{
 					state = LXRT_NUMBER;
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (c == 'E' || c == 'e')
+				else if (cls & LXRK_CC_EXPONENT)
 				{
 					state = LXRT_STATE_EXPONENT;
 					LXR_AddToToken(lexer, c);
 				}
-				else if (LXRK_IsStringStartChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_STRING_START)
 				{
 					state = LXRT_NUMBER;
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsDecimalChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_DECIMAL)
 				{
 					LXR_AddToToken(lexer, c);
+					LXR_AddRun(lexer, LXR_RUN_FLOAT);
 				}
-				else if (LXRK_IsDelimiterStartChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_DELIMITER_START)
 				{
 					state = LXRT_NUMBER;
 					lexer->stored = c;
@@ -647,47 +1200,15 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsNewlineChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsSpaceChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsTabChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsWhitespaceChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsStringStartChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsDelimiterStartChar(lexer->kernel, c))
+				else if (cls & (LXRK_CC_WHITESPACE | LXRK_CC_STRING_START | LXRK_CC_DELIMITER_START))
 				{
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsUnderscoreChar(lexer->kernel, c))
-				{
-					LXR_AddToToken(lexer, c);
-				}
-				else if (LXRK_IsAlphabeticalChar(lexer->kernel, c))
-				{
-					LXR_AddToToken(lexer, c);
-				}
-				else if (LXRK_IsDecimalChar(lexer->kernel, c))
+				else if (cls & (LXRK_CC_UNDERSCORE | LXRK_CC_ALPHABETICAL | LXRK_CC_DECIMAL))
 				{
 					LXR_AddToToken(lexer, c);
+					LXR_AddRun(lexer, LXR_RUN_IDENTIFIER);
 				}
 				else
 				{
@@ -705,53 +1226,29 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsNewlineChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsSpaceChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsTabChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsWhitespaceChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_WHITESPACE)
 				{
 					state = LXRT_NUMBER;
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsDecimalSeparatorChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_DECIMAL_SEPARATOR)
 				{
 					state = LXRT_STATE_FLOAT;
 					LXR_AddToToken(lexer, c);
 				}
-				else if (LXRK_IsStringStartChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsDelimiterStartChar(lexer->kernel, c))
+				else if (cls & (LXRK_CC_STRING_START | LXRK_CC_DELIMITER_START))
 				{
 					state = LXRT_NUMBER;
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (c == 'x' || c == 'X')
+				else if (cls & LXRK_CC_HEX_PREFIX)
 				{
 					state = LXRT_STATE_HEX_INTEGER1;
 					LXR_AddToToken(lexer, c);
 				}
-				else if (LXRK_IsDecimalChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_DECIMAL)
 				{
 					state = LXRT_NUMBER;
 					LXR_AddToToken(lexer, c);
@@ -772,54 +1269,18 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsNewlineChar(lexer->kernel, c))
-				{
-					state = LXRT_ILLEGAL;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsSpaceChar(lexer->kernel, c))
-				{
-					state = LXRT_ILLEGAL;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsTabChar(lexer->kernel, c))
-				{
-					state = LXRT_ILLEGAL;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsWhitespaceChar(lexer->kernel, c))
-				{
-					state = LXRT_ILLEGAL;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsDecimalSeparatorChar(lexer->kernel, c))
-				{
-					state = LXRT_ILLEGAL;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsStringStartChar(lexer->kernel, c))
-				{
-					state = LXRT_ILLEGAL;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsDelimiterStartChar(lexer->kernel, c))
+				else if (cls & (LXRK_CC_WHITESPACE | LXRK_CC_DECIMAL_SEPARATOR | LXRK_CC_STRING_START | LXRK_CC_DELIMITER_START))
 				{
 					state = LXRT_ILLEGAL;
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsHexadecimalChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_HEXADECIMAL)
 				{
 					state = LXRT_STATE_HEX_INTEGER;
 					LXR_AddToToken(lexer, c);
 				}
-				else if (LXRK_IsAlphabeticalChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_ALPHABETICAL)
 				{
 					state = LXRT_ILLEGAL;
 					LXR_AddToToken(lexer, c);
@@ -840,47 +1301,18 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsNewlineChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsSpaceChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsTabChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsWhitespaceChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsStringStartChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsDelimiterStartChar(lexer->kernel, c))
+				else if (cls & (LXRK_CC_WHITESPACE | LXRK_CC_STRING_START | LXRK_CC_DELIMITER_START))
 				{
 					state = LXRT_NUMBER;
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsHexadecimalChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_HEXADECIMAL)
 				{
 					LXR_AddToToken(lexer, c);
+					LXR_AddRun(lexer, LXR_RUN_HEX);
 				}
-				else if (LXRK_IsAlphabeticalChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_ALPHABETICAL)
 				{
 					state = LXRT_ILLEGAL;
 					LXR_AddToToken(lexer, c);
@@ -900,54 +1332,35 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsNewlineChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsSpaceChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsTabChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsWhitespaceChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_WHITESPACE)
 				{
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsDecimalSeparatorChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_DECIMAL_SEPARATOR)
 				{
 					state = LXRT_STATE_FLOAT;
 					LXR_AddToToken(lexer, c);
 				}
-				else if (c == 'E' || c == 'e')
+				else if (cls & LXRK_CC_EXPONENT)
 				{
 					state = LXRT_STATE_EXPONENT;
 					LXR_AddToToken(lexer, c);
 				}
-				else if (LXRK_IsStringStartChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsDelimiterStartChar(lexer->kernel, c))
+				else if (cls & (LXRK_CC_STRING_START | LXRK_CC_DELIMITER_START))
 				{
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsAlphabeticalChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_ALPHABETICAL)
 				{
 					state = LXRT_ILLEGAL;
 					LXR_AddToToken(lexer, c);
 				}
-				else if (LXRK_IsDecimalChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_DECIMAL)
 				{
 					LXR_AddToToken(lexer, c);
+					LXR_AddRun(lexer, LXR_RUN_NUMBER);
 				}
 				else
 				{
@@ -965,53 +1378,29 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsNewlineChar(lexer->kernel, c))
-				{
-					state = LXRT_ILLEGAL;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsSpaceChar(lexer->kernel, c))
-				{
-					state = LXRT_ILLEGAL;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsTabChar(lexer->kernel, c))
-				{
-					state = LXRT_ILLEGAL;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsWhitespaceChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_WHITESPACE)
 				{
 					state = LXRT_ILLEGAL;
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsExponentSignChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_EXPONENT_SIGN)
 				{
 					state = LXRT_STATE_EXPONENT_POWER;
 					LXR_AddToToken(lexer, c);
 				}
-				else if (LXRK_IsStringStartChar(lexer->kernel, c))
-				{
-					state = LXRT_ILLEGAL;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsDelimiterStartChar(lexer->kernel, c))
+				else if (cls & (LXRK_CC_STRING_START | LXRK_CC_DELIMITER_START))
 				{
 					state = LXRT_ILLEGAL;
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsAlphabeticalChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_ALPHABETICAL)
 				{
 					state = LXRT_ILLEGAL;
 					LXR_AddToToken(lexer, c);
 				}
-				else if (LXRK_IsDecimalChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_DECIMAL)
 				{
 					state = LXRT_STATE_EXPONENT_POWER;
 					LXR_AddToToken(lexer, c);
@@ -1032,41 +1421,18 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsNewlineChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsSpaceChar(lexer->kernel, c))
+				else if (cls & (LXRK_CC_WHITESPACE | LXRK_CC_STRING_START))
 				{
 					state = LXRT_NUMBER;
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsTabChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsWhitespaceChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsStringStartChar(lexer->kernel, c))
-				{
-					state = LXRT_NUMBER;
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsDecimalChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_DECIMAL)
 				{
 					LXR_AddToToken(lexer, c);
+					LXR_AddRun(lexer, LXR_RUN_EXPONENT_POWER);
 				}
-				else if (LXRK_IsDelimiterStartChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_DELIMITER_START)
 				{
 					state = LXRT_NUMBER;
 					lexer->stored = c;
@@ -1088,7 +1454,7 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsNewlineChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_NEWLINE)
 				{
 					state = LXRT_ILLEGAL;
 					lexer->stored = c;
@@ -1098,12 +1464,35 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 				{
 					breakloop = 1;
 				}
-				else if (LXRK_IsEscapeChar(lexer->kernel, c))
+				else if ((cls & LXRK_CC_ESCAPE) && lexer->slicing)
+				{
+					// leave escapes in place - LXR_GetTokenText() processes them.
+					int line = lexer->token.line_number;
+					LXR_AddToToken(lexer, c);
+					c = LXR_GetChar(lexer);
+					// unknown escapes (like an escaped newline) add nothing when copying, so they keep the token's line, too.
+					if (c < 0)
+					{
+						lexer->token.line_number = line;
+						state = LXRT_ILLEGAL;
+						lexer->stored = c;
+						breakloop = 1;
+					}
+					else
+					{
+						LXR_AddToToken(lexer, c);
+						lexer->token.escaped = 1;
+						if (c != lexer->string_end && !(LXRK_CharClass(lexer->kernel, c) & LXRK_CC_ESCAPE) && (!c || !strchr("0btnfr/ux", c)))
+							lexer->token.line_number = line;
+					}
+				}
+				else if (cls & LXRK_CC_ESCAPE)
 				{
 					c = LXR_GetChar(lexer);
+					cls = LXRK_CharClass(lexer->kernel, c);
 					if (c == lexer->string_end)
 						LXR_AddToToken(lexer, c);
-					else if (LXRK_IsEscapeChar(lexer->kernel, c))
+					else if (cls & LXRK_CC_ESCAPE)
 						LXR_AddToToken(lexer, c);
 					else switch (c)
 					{
@@ -1135,11 +1524,13 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 							for (i = 0; i < 4; i++)
 							{
 								c = LXR_GetChar(lexer);
-								if (!LXRK_IsHexadecimalChar(lexer->kernel, c))
+								cls = LXRK_CharClass(lexer->kernel, c);
+								if (!(cls & LXRK_CC_HEXADECIMAL))
 								{
 									state = LXRT_ILLEGAL;
 									lexer->stored = c;
 									breakloop = 1;
+									break;
 								}
 								else
 								{
@@ -1153,7 +1544,8 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 									h |= n << (i * 4);
 								}
 							}
-							LXR_AddToToken(lexer, h);
+							if (!breakloop)
+								LXR_AddToToken(lexer, h);
 						}
 						break;
 							
@@ -1163,11 +1555,13 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 							for (i = 0; i < 2; i++)
 							{
 								c = LXR_GetChar(lexer);
-								if (!LXRK_IsHexadecimalChar(lexer->kernel, c))
+								cls = LXRK_CharClass(lexer->kernel, c);
+								if (!(cls & LXRK_CC_HEXADECIMAL))
 								{
 									state = LXRT_ILLEGAL;
 									lexer->stored = c;
 									breakloop = 1;
+									break;
 								}
 								else
 								{
@@ -1181,7 +1575,8 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 									h |= n << (i * 4);
 								}
 							}
-							LXR_AddToToken(lexer, h);
+							if (!breakloop)
+								LXR_AddToToken(lexer, h);
 						}
 						break;
 					}
@@ -1189,6 +1584,7 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 				else
 				{
 					LXR_AddToToken(lexer, c);
+					LXR_AddStringRun(lexer);
 				}
 			}
 			break; // LXRT_STRING
@@ -1200,52 +1596,31 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 					lexer->stored = c;
 					breakloop = 1;
 				}
-				else if (LXRK_IsNewlineChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsSpaceChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsTabChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsWhitespaceChar(lexer->kernel, c))
-				{
-					lexer->stored = c;
-					breakloop = 1;
-				}
-				else if (LXRK_IsStringStartChar(lexer->kernel, c))
+				else if (cls & (LXRK_CC_WHITESPACE | LXRK_CC_STRING_START))
 				{
 					lexer->stored = c;
 					breakloop = 1;
 				}
 				else
 				{
-					LXR_AddToTokenTemp(lexer, c);
+					delimiter_type = LXR_NextDelimiter(lexer, c, &node, &comment_end, &line_comment);
 					// Could be a special delimiter
-					if ((lexer->comment_end = LXRK_GetCommentEnd(lexer->kernel, lexer->token.lexeme)) != NULL)
+					if ((lexer->comment_end = comment_end) != NULL)
 					{
-						lexer->token.lexeme[0] = '\0';
-						lexer->token.length = 0;
+						LXR_ClearToken(lexer);
 						state = LXRT_STATE_COMMENT;
 					}
 					// Could be a special delimiter
-					else if (LXRK_IsLineComment(lexer->kernel, lexer->token.lexeme))
+					else if (line_comment)
 					{
-						lexer->token.lexeme[0] = '\0';
-						lexer->token.length = 0;
+						LXR_ClearToken(lexer);
 						state = LXRT_STATE_LINE_COMMENT;
 					}
 					// Possibly still a delimiter
-					else if (LXRK_GetDelimiterType(lexer->kernel, lexer->token.lexeme) >= 0)
+					else if (delimiter_type >= 0)
 					{
 						LXR_AddToToken(lexer, c);
+						lexer->delimiter_node = node;
 					}
 					// Not a delimiter anymore
 					else
@@ -1262,23 +1637,17 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 			{
 				if (c == LXRC_END_OF_STREAM) // Stream End
 				{
-					lexer->token.lexeme[0] = '\0';
-					lexer->token.length = 0;
 					state = LXRT_UNKNOWN;
 				}
+				else if (cls & LXRK_CC_END_COMMENT_START)
+				{
+					lexer->comment_char = c;
+					state = LXRT_STATE_END_COMMENT;
+				}
 				else
 				{
-					if (strcmp(lexer->token.lexeme, lexer->comment_end) == 0)
-					{
-						lexer->token.lexeme[0] = '\0';
-						lexer->token.length = 0;
-						state = LXRT_UNKNOWN;
-					}
-					else if (LXRK_IsEndCommentStartChar(lexer->kernel, c))
-					{
-						state = LXRT_STATE_END_COMMENT;
-						LXR_AddToToken(lexer, c);
-					}
+					// nothing before the first character of the comment end matters.
+					LXR_SkipTo(lexer, lexer->comment_end[0]);
 				}
 			}
 			break; // LXRT_STATE_COMMENT
@@ -1287,31 +1656,19 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 			{
 				if (c == LXRC_END_OF_STREAM) // Stream End
 				{
-					lexer->token.lexeme[0] = '\0';
-					lexer->token.length = 0;
 					state = LXRT_STATE_COMMENT;
 				}
-				else if (LXRK_IsWhitespaceChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_WHITESPACE)
 				{
-					lexer->token.lexeme[0] = '\0';
-					lexer->token.length = 0;
 					state = LXRT_STATE_COMMENT;
 				}
+				else if (LXR_IsCommentEnd(lexer, c))
+				{
+					state = LXRT_UNKNOWN;
+				}
 				else
 				{
-					LXR_AddToTokenTemp(lexer, c);
-					if (strcmp(lexer->token.lexeme, lexer->comment_end) == 0)
-					{
-						lexer->token.lexeme[0] = '\0';
-						lexer->token.length = 0;
-						state = LXRT_UNKNOWN;
-					}
-					else
-					{
-						lexer->token.lexeme[0] = '\0';
-						lexer->token.length = 0;
-						LXR_AddToToken(lexer, c);
-					}
+					lexer->comment_char = c;
 				}
 			}
 			break; // LXRT_STATE_END_COMMENT
@@ -1320,16 +1677,16 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 			{
 				if (c == LXRC_END_OF_STREAM) // Stream End
 				{
-					lexer->token.lexeme[0] = '\0';
-					lexer->token.length = 0;
 					state = LXRT_UNKNOWN;
 				}
-				else if (LXRK_IsNewlineChar(lexer->kernel, c))
+				else if (cls & LXRK_CC_NEWLINE)
 				{
-					lexer->token.lexeme[0] = '\0';
-					lexer->token.length = 0;
 					state = LXRT_UNKNOWN;
 				}
+				else
+				{
+					LXR_SkipTo(lexer, 0x0A);
+				}
 			}
 			break; // LXRT_STATE_LINE_COMMENT
 		
@@ -1358,6 +1715,7 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 		{
 			lexer->token.lexeme[0] = ' ';
 			lexer->token.lexeme[1] = '\0';
+			lexer->token.text = lexer->token.lexeme;
 			lexer->token.length = 1;
 		}
 		break;
@@ -1366,14 +1724,14 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 		{
 			lexer->token.lexeme[0] = '\t';
 			lexer->token.lexeme[1] = '\0';
+			lexer->token.text = lexer->token.lexeme;
 			lexer->token.length = 1;
 		}
 		break;
 		
 		case LXRT_NEWLINE:
 		{
-			lexer->token.lexeme[0] = '\0';
-			lexer->token.length = 0;
+			LXR_ClearToken(lexer);
 		}
 		break;
 
@@ -1388,3 +1746,116 @@ lexer_token_t* LXR_NextToken(lexer_t *lexer)
 
 	return outtoken;
 }
+
+// ---------------------------------------------------------------
+// int LXR_GetTokenText(lexer_t *lexer, lexer_token_t *token, char *out, int max)
+// See lexer.h
+// ---------------------------------------------------------------
+int LXR_GetTokenText(lexer_t *lexer, lexer_token_t *token, char *out, int max)
+{
+	return LXR_DecodeText(lexer->kernel, token->text, token->length, token->escaped, token->string_end, out, max);
+}
+
+// ---------------------------------------------------------------
+// char* LXR_CopyTokenText(lexer_t *lexer, lexer_token_t *token, mt_arena_t *arena)
+// See lexer.h
+// ---------------------------------------------------------------
+char* LXR_CopyTokenText(lexer_t *lexer, lexer_token_t *token, mt_arena_t *arena)
+{
+	// processing escapes never makes text longer.
+	char *out = (char*)MT_ArenaAlloc(arena, token->length + 1);
+	if (out)
+		LXR_GetTokenText(lexer, token, out, token->length + 1);
+	return out;
+}
+
+// ---------------------------------------------------------------
+// const char* LXR_InternTokenText(lexer_t *lexer, lexer_token_t *token, mt_intern_t *intern)
+// See lexer.h
+// ---------------------------------------------------------------
+const char* LXR_InternTokenText(lexer_t *lexer, lexer_token_t *token, mt_intern_t *intern)
+{
+	char buffer[LEXEME_LENGTH_MAX];
+	char *text = buffer;
+	const char *out;
+	int length;
+
+	if (!token->escaped)
+		return MT_Intern(intern, token->text, token->length);
+
+	if (token->length >= LEXEME_LENGTH_MAX && !(text = (char*)LXR_MALLOC(token->length + 1)))
+		return NULL;
+	length = LXR_GetTokenText(lexer, token, text, token->length + 1);
+	out = MT_Intern(intern, text, length);
+	if (text != buffer)
+		LXR_FREE(text);
+	return out;
+}
+
+// ---------------------------------------------------------------
+// int LXR_DecodeText(lexer_kernel_t *kernel, const char *text, int length, int escaped, char string_end, char *out, int max)
+// See lexer.h
+// ---------------------------------------------------------------
+int LXR_DecodeText(lexer_kernel_t *kernel, const char *text, int length, int escaped, char string_end, char *out, int max)
+{
+	const char *t = text;
+	int i = 0, len = 0;
+
+	#define LXR_PUTTEXT(ch) { if (len < max - 1) out[len] = (ch); len++; }
+
+	while (i < length)
+	{
+		int c = t[i++] & 0x0FF;
+		if (!escaped || !(LXRK_CharClass(kernel, c) & LXRK_CC_ESCAPE) || i >= length)
+		{
+			LXR_PUTTEXT(c);
+			continue;
+		}
+
+		c = t[i++] & 0x0FF;
+		if (c == string_end || (LXRK_CharClass(kernel, c) & LXRK_CC_ESCAPE))
+		{
+			LXR_PUTTEXT(c);
+		}
+		else switch (c)
+		{
+			case '0': LXR_PUTTEXT('\0'); break;
+			case 'b': LXR_PUTTEXT('\b'); break;
+			case 't': LXR_PUTTEXT('\t'); break;
+			case 'n': LXR_PUTTEXT('\n'); break;
+			case 'f': LXR_PUTTEXT('\f'); break;
+			case 'r': LXR_PUTTEXT('\r'); break;
+			case '/': LXR_PUTTEXT('/'); break;
+
+			case 'u':
+			case 'x':
+			{
+				int n, d, h = 0, digits = c == 'u' ? 4 : 2;
+				for (d = 0; d < digits && i < length; d++, i++)
+				{
+					c = t[i];
+					if (c >= '0' && c <= '9')
+						n = c - '0';
+					else if (c >= 'A' && c <= 'F')
+						n = c - 'A' + 10;
+					else if (c >= 'a' && c <= 'f')
+						n = c - 'a' + 10;
+					else
+						break;
+					h |= n << (d * 4);
+				}
+				LXR_PUTTEXT(h & 0x0FF);
+			}
+			break;
+
+			default:
+				break;
+		}
+	}
+
+	#undef LXR_PUTTEXT
+
+	if (max > 0)
+		out[len < max - 1 ? len : max - 1] = '\0';
+	return len;
+}
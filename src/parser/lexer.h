@@ -13,6 +13,8 @@
 #include "lexer_config.h"
 #include "lexer_kernel.h"
 #include "io/stream.h"
+#include "struct/mt_arena.h"
+#include "struct/mt_intern.h"
 
 /**
  * Lexeme type.
@@ -97,6 +99,12 @@ typedef struct {
 	int include_newlines;
 	/** Include stream break (end of stream)? */
 	int include_stream_break;
+	/** 
+	 * Make tokens zero-copy slices of the source text where possible (streams that read from memory, compiled kernels)? 
+	 * Token text is then only in lexer_token_t.text/length (not null-terminated, no length limit), and string escapes 
+	 * are left in place until LXR_GetTokenText() is called. Other tokens are copied to lexeme as usual.
+	 */
+	int zero_copy;
 
 } lexer_options_t;
 
@@ -109,6 +117,12 @@ typedef struct {
 	char *name;
 	/** Source stream. */
 	stream_t *stream;
+	/** Source stream memory, if it reads from memory (else NULL). */
+	const unsigned char *memory;
+	/** Span of the source stream being read (see STREAM_Peek()): its start, next byte, and end. */
+	const unsigned char *span_start;
+	const unsigned char *span_pos;
+	const unsigned char *span_end;
 	/** Current line number. */
 	int line_number;
 	/** Current character number (on the line). */
@@ -127,10 +141,22 @@ typedef struct {
 	lexeme_type_t type;
 	/** Token subtype. */
 	int subtype;
-	/** Token lexeme. */
+	/** Numeric value (number tokens only): exact for LXRTN_INTEGER, LXRTN_OCTAL and LXRTN_HEX, truncated from decimal for LXRTN_FLOAT. Saturates at INT64_MAX. */
+	int64_t integer;
+	/** Numeric value (number tokens only): correctly rounded for LXRTN_FLOAT, converted from integer for the others. */
+	double decimal;
+	/** Token lexeme (null-terminated, truncated to LEXEME_LENGTH_MAX - 1 characters). Empty for zero-copy tokens. */
 	char lexeme[LEXEME_LENGTH_MAX];
-	/** Token lexeme length. */
+	/** Token text: either lexeme, or a zero-copy slice of the source text (NOT null-terminated). */
+	const char *text;
+	/** Offset of the token's first character in its stream, such as a string's opening delimiter (zero-copy tokens only, else 0). */
+	size_t offset;
+	/** Token text length. */
 	int length;
+	/** If nonzero, this is a string token with unprocessed escapes in its text (zero-copy only - see LXR_GetTokenText()). */
+	int escaped;
+	/** String end character (string tokens only). */
+	char string_end;
 	/** Current line number. */
 	int line_number;
 	
@@ -162,12 +188,20 @@ typedef struct {
 
 	/** Stream stack. */
 	lexer_stream_stack_t *stream_stack;
+	/** Popped memory-mapped streams, kept open until the lexer is destroyed (token slices may point into them). */
+	lexer_stream_stack_t *retired;
 	/** Current lexer state. */
 	lexeme_type_t state;
 	/** Current string terminal. */
 	char string_end;
 	/** Current comment terminal. */
 	char *comment_end;
+	/** Last character seen while matching the comment terminal. */
+	char comment_char;
+	/** If nonzero, tokens from the current stream are zero-copy slices. */
+	int slicing;
+	/** Current delimiter trie node (compiled kernels only). */
+	int delimiter_node;
 	/** Stored character on token break. */
 	char stored;
 
@@ -202,6 +236,7 @@ int LXR_PushStream(lexer_t *lexer, char *filename);
 
 /**
  * Pushes a new character stream onto the lexer using an already-opened file.
+ * The file is read ahead on another thread (see STREAM_SetReadAhead()), so it must not be read elsewhere until the stream is popped.
  * NOTE: Be careful - this does not affect the current state!
  * @param lexer the lexer to use.
  * @param name the name of the stream.
@@ -221,6 +256,17 @@ int LXR_PushStreamFile(lexer_t *lexer, char *name, FILE *file);
  */
 int LXR_PushStreamBuffer(lexer_t *lexer, char *name, unsigned char *buffer, size_t length);
 
+/**
+ * Pushes an already-open stream onto the lexer.
+ * The lexer takes ownership of the stream and closes it when it is popped.
+ * NOTE: Be careful - this does not affect the current state!
+ * @param lexer the lexer to use.
+ * @param name the name of the stream.
+ * @param stream the open stream.
+ * @return 0 if successful or nonzero if not.
+ */
+int LXR_PushStreamHandle(lexer_t *lexer, char *name, stream_t *stream);
+
 /**
  * Pops a character stream off of lexer.
  * NOTE: Be careful - this does not affect the current state!
@@ -237,6 +283,53 @@ int LXR_PopStream(lexer_t *lexer);
  */
 lexer_token_t* LXR_NextToken(lexer_t *lexer);
 
+/**
+ * Gets a token's text, null-terminated, with any string escapes processed.
+ * This is how to read the full text of zero-copy tokens (copied tokens are truncated to the lexeme buffer).
+ * Malformed escapes in zero-copy strings are not reported: a short hex escape ends at the first non-hex digit.
+ * @param lexer the lexer that scanned the token.
+ * @param token the token.
+ * @param out the output buffer.
+ * @param max the size of the output buffer, including the null terminator. Text that does not fit is truncated.
+ * @return the full length of the processed text (not including the terminator), even if truncated.
+ */
+int LXR_GetTokenText(lexer_t *lexer, lexer_token_t *token, char *out, int max);
+
+/**
+ * Gets token text, null-terminated, with any string escapes processed.
+ * This is LXR_GetTokenText() for token text kept outside of a lexer_token_t.
+ * @param kernel the kernel that scanned the text.
+ * @param text the token text.
+ * @param length the token text length.
+ * @param escaped if nonzero, the text has unprocessed escapes.
+ * @param string_end the string end character of the token (string tokens only).
+ * @param out the output buffer.
+ * @param max the size of the output buffer, including the null terminator. Text that does not fit is truncated.
+ * @return the full length of the processed text (not including the terminator), even if truncated.
+ */
+int LXR_DecodeText(lexer_kernel_t *kernel, const char *text, int length, int escaped, char string_end, char *out, int max);
+
+/**
+ * Copies a token's text into an arena, null-terminated, with any string escapes processed.
+ * Unlike LXR_GetTokenText(), the text is never truncated (zero-copy tokens can be any length).
+ * @param lexer the lexer that scanned the token.
+ * @param token the token.
+ * @param arena the arena to allocate from.
+ * @return the copied text, or NULL if out of memory.
+ */
+char* LXR_CopyTokenText(lexer_t *lexer, lexer_token_t *token, mt_arena_t *arena);
+
+/**
+ * Interns a token's text, with any string escapes processed (see MT_Intern()).
+ * Text without escapes is looked up straight from the token, so text that was interned 
+ * before is never copied.
+ * @param lexer the lexer that scanned the token.
+ * @param token the token.
+ * @param intern the interning table.
+ * @return the interned text, or NULL if out of memory.
+ */
+const char* LXR_InternTokenText(lexer_t *lexer, lexer_token_t *token, mt_intern_t *intern);
+
 /**
  * Returns the type name for a token type.
  * @param type the lexeme type.
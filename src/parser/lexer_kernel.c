@@ -23,11 +23,6 @@ typedef struct {
 	
 } LXRK_SETPAIR;
 
-static int LXRK_CompareChar(void *a, void *b)
-{
-	return (int)a - (int)b;
-}
-
 static int LXRK_CompareCharPtr(void *a, void *b)
 {
 	char *ka = (char*)(a);
@@ -35,13 +30,6 @@ static int LXRK_CompareCharPtr(void *a, void *b)
 	return strcmp(ka, kb);
 }
 
-static int LXRK_ComparePairChar(void *a, void *b)
-{
-	LXRK_SETPAIR *pa = (LXRK_SETPAIR*)a;
-	LXRK_SETPAIR *pb = (LXRK_SETPAIR*)b;
-	return ((char)(int)(pa->key)) - ((char)(int)(pb->key));
-}
-
 static int LXRK_ComparePairCharPtr(void *a, void *b)
 {
 	LXRK_SETPAIR *pa = (LXRK_SETPAIR*)a;
@@ -51,15 +39,6 @@ static int LXRK_ComparePairCharPtr(void *a, void *b)
 	return strcmp(ka, kb);
 }
 
-static int LXRK_ComparePairCICharPtr(void *a, void *b)
-{
-	LXRK_SETPAIR *pa = (LXRK_SETPAIR*)a;
-	LXRK_SETPAIR *pb = (LXRK_SETPAIR*)b;
-	char *ka = (char*)(pa->key);
-	char *kb = (char*)(pb->key);
-	return stricmp(ka, kb);
-}
-
 // Creates a new set pair.
 static LXRK_SETPAIR* LXRK_CreatePair()
 {
@@ -109,19 +88,14 @@ static void LXRK_DestroyCharPtrIntPair(LXRK_SETPAIR *pair)
 	LXR_FREE(pair);
 }
 
-// Creates a new set pair.
-static LXRK_SETPAIR* LXRK_CreateCharCharPair(int key, int value)
-{
-	LXRK_SETPAIR* pair = LXRK_CreatePair();
-	pair->key = (void*)key;
-	pair->value = (void*)value;
-	return pair;
-}
-
-// Destroys a new set pair.
-static void LXRK_DestroyCharCharPair(LXRK_SETPAIR *pair)
+// Frees a keyword map and its keys.
+static void LXRK_FreeKeywordMap(mt_hashmap_t *map)
 {
-	LXR_FREE(pair);
+	int position = 0;
+	void *key;
+	while (MT_HashMapNext(map, &position, &key, NULL))
+		LXR_FREE(key);
+	MT_HashMapDestroy(map);
 }
 
 static void LXRK_FreeSets(lexer_kernel_t *kernel)
@@ -145,32 +119,256 @@ static void LXRK_FreeSets(lexer_kernel_t *kernel)
 			LXRK_DestroyCharPtrIntPair(kernel->delimiter_map->items[i]);
 		LXR_FREE(kernel->delimiter_map);
 	}
-	if (kernel->delimiter_starts) 
+	if (kernel->keyword_map)
 	{
-		LXR_FREE(kernel->delimiter_starts);
+		LXRK_FreeKeywordMap(kernel->keyword_map);
 	}
-	if (kernel->end_comment_starts) 
+	if (kernel->cikeyword_map) 
 	{
-		LXR_FREE(kernel->end_comment_starts);
+		LXRK_FreeKeywordMap(kernel->cikeyword_map);
 	}
-	if (kernel->keyword_map)
+}
+
+// Sets the fixed character classes and the default separator/escape classes.
+static void LXRK_InitCharClasses(lexer_kernel_t *kernel)
+{
+	int c;
+	uint16_t cc;
+	for (c = 0; c < 256; c++)
 	{
-		for (i = 0; i < kernel->keyword_map->size; i++)
-			LXRK_DestroyCharPtrIntPair(kernel->keyword_map->items[i]);
-		LXR_FREE(kernel->keyword_map);
+		cc = 0;
+		if (isalpha(c))
+			cc |= LXRK_CC_ALPHABETICAL;
+		if (isdigit(c))
+			cc |= LXRK_CC_DECIMAL;
+		if (isxdigit(c))
+			cc |= LXRK_CC_HEXADECIMAL;
+		if (isspace(c))
+			cc |= LXRK_CC_WHITESPACE;
+		kernel->char_class[c] = cc;
+		kernel->string_end[c] = 0;
 	}
-	if (kernel->cikeyword_map) 
+	kernel->char_class['_'] |= LXRK_CC_UNDERSCORE;
+	kernel->char_class['\n'] |= LXRK_CC_NEWLINE;
+	kernel->char_class[' '] |= LXRK_CC_SPACE;
+	kernel->char_class['\t'] |= LXRK_CC_TAB;
+	kernel->char_class['e'] |= LXRK_CC_EXPONENT;
+	kernel->char_class['E'] |= LXRK_CC_EXPONENT;
+	kernel->char_class['-'] |= LXRK_CC_EXPONENT_SIGN;
+	kernel->char_class['+'] |= LXRK_CC_EXPONENT_SIGN;
+	kernel->char_class['x'] |= LXRK_CC_HEX_PREFIX;
+	kernel->char_class['X'] |= LXRK_CC_HEX_PREFIX;
+	kernel->char_class[(unsigned char)kernel->decimal_char] |= LXRK_CC_DECIMAL_SEPARATOR;
+	kernel->char_class[(unsigned char)kernel->escape_char] |= LXRK_CC_ESCAPE;
+}
+
+// Moves a single-character class bit from one character to another.
+static void LXRK_MoveCharClass(lexer_kernel_t *kernel, uint16_t bit, char from, char to)
+{
+	kernel->char_class[(unsigned char)from] &= ~bit;
+	kernel->char_class[(unsigned char)to] |= bit;
+}
+
+// ===========================================================================
+// Compile Private Functions
+// ===========================================================================
+
+// Keyword table size will be at least this many times the amount of keywords.
+#define LXRK_KEYWORD_LOAD		2
+// Amount of seeds tried per table size.
+#define LXRK_KEYWORD_SEEDS		64
+
+// Case-folded FNV-1a hash.
+static uint32_t LXRK_KeywordHash(uint32_t seed, const char *s, int length)
+{
+	uint32_t h = 2166136261u ^ seed;
+	while (length--)
 	{
-		for (i = 0; i < kernel->cikeyword_map->size; i++)
-			LXRK_DestroyCharPtrIntPair(kernel->cikeyword_map->items[i]);
-		LXR_FREE(kernel->cikeyword_map);
+		h ^= (uint32_t)tolower((unsigned char)*s++);
+		h *= 16777619u;
 	}
-	if (kernel->string_map)
+	return h;
+}
+
+// Sorts keyword entries by case-folded keyword, case-sensitive ones first.
+static int LXRK_CompareKeywordEntry(const void *a, const void *b)
+{
+	const lexer_kernel_keyword_t *ka = (const lexer_kernel_keyword_t*)a;
+	const lexer_kernel_keyword_t *kb = (const lexer_kernel_keyword_t*)b;
+	int c = stricmp(ka->keyword, kb->keyword);
+	return c ? c : ka->case_insensitive - kb->case_insensitive;
+}
+
+// Frees compiled data.
+static void LXRK_FreeCompiled(lexer_kernel_t *kernel)
+{
+	if (kernel->keywords.slot_first)
+		LXR_FREE(kernel->keywords.slot_first);
+	if (kernel->keywords.slot_count)
+		LXR_FREE(kernel->keywords.slot_count);
+	if (kernel->keywords.entries)
+		LXR_FREE(kernel->keywords.entries);
+	if (kernel->trie)
+		LXR_FREE(kernel->trie);
+	memset(&(kernel->keywords), 0, sizeof(lexer_kernel_keywords_t));
+	kernel->trie = NULL;
+	kernel->trie_count = 0;
+	kernel->compiled = 0;
+}
+
+// Compiles the keywords. Returns nonzero if out of memory.
+static int LXRK_CompileKeywords(lexer_kernel_t *kernel)
+{
+	lexer_kernel_keywords_t *kw = &(kernel->keywords);
+	int i, n, groups, size, seed, found, position;
+	uint32_t slot;
+	void *key, *value;
+
+	n = kernel->keyword_map->size + kernel->cikeyword_map->size;
+	if (!(kw->entries = (lexer_kernel_keyword_t*)LXR_MALLOC(sizeof(lexer_kernel_keyword_t) * (n ? n : 1))))
+		return 1;
+	kw->entry_count = n;
+
+	i = 0;
+	position = 0;
+	while (MT_HashMapNext(kernel->keyword_map, &position, &key, &value))
+	{
+		kw->entries[i].keyword = (char*)key;
+		kw->entries[i].length = strlen((char*)key);
+		kw->entries[i].type = (int)(intptr_t)value;
+		kw->entries[i].case_insensitive = 0;
+		i++;
+	}
+	position = 0;
+	while (MT_HashMapNext(kernel->cikeyword_map, &position, &key, &value))
 	{
-		for (i = 0; i < kernel->string_map->size; i++)
-			LXRK_DestroyCharCharPair(kernel->string_map->items[i]);
-		LXR_FREE(kernel->string_map);
+		kw->entries[i].keyword = (char*)key;
+		kw->entries[i].length = strlen((char*)key);
+		kw->entries[i].type = (int)(intptr_t)value;
+		kw->entries[i].case_insensitive = 1;
+		i++;
 	}
+	qsort(kw->entries, n, sizeof(lexer_kernel_keyword_t), &LXRK_CompareKeywordEntry);
+
+	// entries with the same folded keyword share a slot.
+	groups = 0;
+	for (i = 0; i < n; i++)
+		if (i == 0 || stricmp(kw->entries[i - 1].keyword, kw->entries[i].keyword))
+			groups++;
+
+	size = 8;
+	while (size < groups * LXRK_KEYWORD_LOAD)
+		size <<= 1;
+
+	found = 0;
+	while (!found)
+	{
+		if (!(kw->slot_first = (int*)LXR_MALLOC(sizeof(int) * size)))
+			return 1;
+		if (!(kw->slot_count = (int*)LXR_MALLOC(sizeof(int) * size)))
+			return 1;
+
+		for (seed = 0; !found && seed < LXRK_KEYWORD_SEEDS; seed++)
+		{
+			memset(kw->slot_count, 0, sizeof(int) * size);
+			found = 1;
+			for (i = 0; found && i < n; i++)
+			{
+				slot = LXRK_KeywordHash(seed, kw->entries[i].keyword, kw->entries[i].length) & (size - 1);
+				if (kw->slot_count[slot] && stricmp(kw->entries[kw->slot_first[slot]].keyword, kw->entries[i].keyword))
+					found = 0;
+				else if (!kw->slot_count[slot]++)
+					kw->slot_first[slot] = i;
+			}
+			if (found)
+			{
+				kw->seed = seed;
+				kw->mask = size - 1;
+			}
+		}
+
+		if (!found)
+		{
+			LXR_FREE(kw->slot_first);
+			LXR_FREE(kw->slot_count);
+			kw->slot_first = NULL;
+			kw->slot_count = NULL;
+			size <<= 1;
+		}
+	}
+	return 0;
+}
+
+// Adds a path to the trie, returning its end node, or -1 if out of memory.
+static int LXRK_TrieAdd(lexer_kernel_t *kernel, int *capacity, const char *s)
+{
+	int node = LXRK_TRIE_ROOT;
+	unsigned char c;
+	while ((c = (unsigned char)*s++))
+	{
+		if (kernel->trie[node].next[c] == LXRK_TRIE_NONE)
+		{
+			if (kernel->trie_count == *capacity)
+			{
+				if (*capacity >= 65536)
+					return -1;
+				lexer_kernel_trie_t *newtrie = (lexer_kernel_trie_t*)LXR_REALLOC(kernel->trie, sizeof(lexer_kernel_trie_t) * (*capacity * 2));
+				if (!newtrie)
+					return -1;
+				kernel->trie = newtrie;
+				*capacity *= 2;
+			}
+			memset(&(kernel->trie[kernel->trie_count]), 0, sizeof(lexer_kernel_trie_t));
+			kernel->trie[kernel->trie_count].delimiter_type = -1;
+			kernel->trie[node].next[c] = (uint16_t)kernel->trie_count;
+			kernel->trie_count++;
+		}
+		node = kernel->trie[node].next[c];
+	}
+	return node;
+}
+
+// Compiles the delimiter/comment trie. Returns nonzero if out of memory.
+static int LXRK_CompileTrie(lexer_kernel_t *kernel)
+{
+	int i, node, capacity = 16;
+
+	if (!(kernel->trie = (lexer_kernel_trie_t*)LXR_MALLOC(sizeof(lexer_kernel_trie_t) * capacity)))
+		return 1;
+	memset(kernel->trie, 0, sizeof(lexer_kernel_trie_t));
+	kernel->trie[LXRK_TRIE_ROOT].delimiter_type = -1;
+	kernel->trie_count = 1;
+
+	for (i = 0; i < kernel->delimiter_map->size; i++)
+	{
+		LXRK_SETPAIR *pair = MT_SetGet(kernel->delimiter_map, LXRK_SETPAIR*, i);
+		if ((node = LXRK_TrieAdd(kernel, &capacity, (char*)pair->key)) < 0)
+			return 1;
+		kernel->trie[node].delimiter_type = (int)(intptr_t)pair->value;
+	}
+	for (i = 0; i < kernel->comment_map->size; i++)
+	{
+		LXRK_SETPAIR *pair = MT_SetGet(kernel->comment_map, LXRK_SETPAIR*, i);
+		if ((node = LXRK_TrieAdd(kernel, &capacity, (char*)pair->key)) < 0)
+			return 1;
+		kernel->trie[node].comment_end = (char*)pair->value;
+	}
+	for (i = 0; i < kernel->comment_line_map->size; i++)
+	{
+		if ((node = LXRK_TrieAdd(kernel, &capacity, MT_SetGet(kernel->comment_line_map, char*, i))) < 0)
+			return 1;
+		kernel->trie[node].line_comment = 1;
+	}
+	return 0;
+}
+
+// Walks the trie along a string. Returns the end node or LXRK_TRIE_NONE.
+static int LXRK_TrieFind(lexer_kernel_t *kernel, const char *s)
+{
+	int node = LXRK_TRIE_ROOT;
+	while (*s && node != LXRK_TRIE_NONE)
+		node = LXRK_TrieNext(kernel, node, (unsigned char)*s++);
+	return node;
 }
 
 static lexer_kernel_t* LXRK_Init()
@@ -186,23 +384,20 @@ static lexer_kernel_t* LXRK_Init()
 	out->delimiter_map = MT_SetCreate(16, &LXRK_ComparePairCharPtr);
 	if (!out->delimiter_map)
 		return NULL;
-	out->delimiter_starts = MT_SetCreate(16, &LXRK_CompareChar);
-	if (!out->delimiter_starts)
-		return NULL;
-	out->end_comment_starts = MT_SetCreate(16, &LXRK_CompareChar);
-	if (!out->end_comment_starts)
-		return NULL;
-	out->keyword_map = MT_SetCreate(16, &LXRK_ComparePairCharPtr);
+	out->keyword_map = MT_HashMapCreate(16, &MT_HashString, &MT_EqualString);
 	if (!out->keyword_map)
 		return NULL;
-	out->cikeyword_map = MT_SetCreate(16, &LXRK_ComparePairCICharPtr);
+	out->cikeyword_map = MT_HashMapCreate(16, &MT_HashStringCI, &MT_EqualStringCI);
 	if (!out->cikeyword_map)
 		return NULL;
-	out->string_map = MT_SetCreate(16, &LXRK_ComparePairChar);
-	if (!out->string_map)
-		return NULL;
 	out->decimal_char = '.';
 	out->escape_char = '\\';
+	LXRK_InitCharClasses(out);
+	out->compiled = 0;
+	memset(&(out->keywords), 0, sizeof(lexer_kernel_keywords_t));
+	out->trie = NULL;
+	out->trie_count = 0;
+	out->generated = NULL;
 	
 	return out;
 }
@@ -220,6 +415,25 @@ lexer_kernel_t* LXRK_Create()
 	return LXRK_Init();
 }
 
+// ---------------------------------------------------------------
+// lexer_kernel_t* LXRK_CreateGenerated(const lexer_kernel_generated_t *generated)
+// See lexer_kernel.h
+// ---------------------------------------------------------------
+lexer_kernel_t* LXRK_CreateGenerated(const lexer_kernel_generated_t *generated)
+{
+	lexer_kernel_t *out = LXRK_Init();
+	if (!out)
+		return NULL;
+	memcpy(out->char_class, generated->char_class, sizeof(uint16_t) * 256);
+	memcpy(out->string_end, generated->string_end, sizeof(char) * 256);
+	out->decimal_char = generated->decimal_char;
+	out->escape_char = generated->escape_char;
+	out->trie_count = generated->trie_count;
+	out->generated = generated;
+	out->compiled = 1;
+	return out;
+}
+
 // ---------------------------------------------------------------
 // int LXRK_Destroy(lexer_kernel_t *kernel)
 // See lexer_kernel.h
@@ -228,22 +442,41 @@ int LXRK_Destroy(lexer_kernel_t *kernel)
 {
 	if (kernel == NULL)
 		return 1;
+	LXRK_FreeCompiled(kernel);
 	LXRK_FreeSets(kernel);
 	LXR_FREE(kernel);
 	return 0;
 }
 
+// ---------------------------------------------------------------
+// int LXRK_Compile(lexer_kernel_t *kernel)
+// See lexer_kernel.h
+// ---------------------------------------------------------------
+int LXRK_Compile(lexer_kernel_t *kernel)
+{
+	if (kernel->compiled)
+		return 0;
+	
+	if (LXRK_CompileKeywords(kernel) || LXRK_CompileTrie(kernel))
+	{
+		LXRK_FreeCompiled(kernel);
+		return 1;
+	}
+	kernel->compiled = 1;
+	return 0;
+}
+
 // ---------------------------------------------------------------
 // void LXRK_AddCommentDelimiter(lexer_kernel_t *kernel, char *comment_start, char *comment_end)
 // See lexer_kernel.h
 // ---------------------------------------------------------------
 void LXRK_AddCommentDelimiter(lexer_kernel_t *kernel, char *comment_start, char *comment_end)
 {
-	if (!comment_start || !strlen(comment_start) || !comment_end || !strlen(comment_end))
+	if (kernel->compiled || !comment_start || !strlen(comment_start) || !comment_end || !strlen(comment_end))
 		return;
 	MT_SetAdd(kernel->comment_map, LXRK_CreateCharPtrCharPtrPair(comment_start, comment_end));
-	MT_SetAdd(kernel->delimiter_starts, (void*)(int)comment_start[0]);
-	MT_SetAdd(kernel->end_comment_starts, (void*)(int)comment_end[0]);
+	kernel->char_class[(unsigned char)comment_start[0]] |= LXRK_CC_DELIMITER_START;
+	kernel->char_class[(unsigned char)comment_end[0]] |= LXRK_CC_END_COMMENT_START;
 }
 
 // ---------------------------------------------------------------
@@ -252,10 +485,10 @@ void LXRK_AddCommentDelimiter(lexer_kernel_t *kernel, char *comment_start, char
 // ---------------------------------------------------------------
 void LXRK_AddLineCommentDelimiter(lexer_kernel_t *kernel, char *delimiter)
 {
-	if (!delimiter || !strlen(delimiter))
+	if (kernel->compiled || !delimiter || !strlen(delimiter))
 		return;
 	MT_SetAdd(kernel->comment_line_map, LXRK_CreateString(delimiter));
-	MT_SetAdd(kernel->delimiter_starts, (void*)(int)delimiter[0]);
+	kernel->char_class[(unsigned char)delimiter[0]] |= LXRK_CC_DELIMITER_START;
 }
 
 // ---------------------------------------------------------------
@@ -264,10 +497,10 @@ void LXRK_AddLineCommentDelimiter(lexer_kernel_t *kernel, char *delimiter)
 // ---------------------------------------------------------------
 void LXRK_AddDelimiter(lexer_kernel_t *kernel, char *delimiter, int delimiter_type)
 {
-	if (!delimiter || !strlen(delimiter))
+	if (kernel->compiled || !delimiter || !strlen(delimiter))
 		return;
 	MT_SetAdd(kernel->delimiter_map, LXRK_CreateCharPtrIntPair(delimiter, delimiter_type));
-	MT_SetAdd(kernel->delimiter_starts, (void*)(int)delimiter[0]);
+	kernel->char_class[(unsigned char)delimiter[0]] |= LXRK_CC_DELIMITER_START;
 }
 
 // ---------------------------------------------------------------
@@ -276,9 +509,9 @@ void LXRK_AddDelimiter(lexer_kernel_t *kernel, char *delimiter, int delimiter_ty
 // ---------------------------------------------------------------
 void LXRK_AddKeyword(lexer_kernel_t *kernel, char *keyword, int keyword_type)
 {
-	if (!keyword || !strlen(keyword))
+	if (kernel->compiled || !keyword || !strlen(keyword) || MT_HashMapContainsKey(kernel->keyword_map, keyword))
 		return;
-	MT_SetAdd(kernel->keyword_map, LXRK_CreateCharPtrIntPair(keyword, keyword_type));
+	MT_HashMapPut(kernel->keyword_map, LXRK_CreateString(keyword), (void*)(intptr_t)keyword_type);
 }
 
 // ---------------------------------------------------------------
@@ -287,9 +520,9 @@ void LXRK_AddKeyword(lexer_kernel_t *kernel, char *keyword, int keyword_type)
 // ---------------------------------------------------------------
 void LXRK_AddCaseInsensitiveKeyword(lexer_kernel_t *kernel, char *keyword, int keyword_type)
 {
-	if (!keyword || !strlen(keyword))
+	if (kernel->compiled || !keyword || !strlen(keyword) || MT_HashMapContainsKey(kernel->cikeyword_map, keyword))
 		return;
-	MT_SetAdd(kernel->cikeyword_map, LXRK_CreateCharPtrIntPair(keyword, keyword_type));
+	MT_HashMapPut(kernel->cikeyword_map, LXRK_CreateString(keyword), (void*)(intptr_t)keyword_type);
 }
 
 // ---------------------------------------------------------------
@@ -298,7 +531,8 @@ void LXRK_AddCaseInsensitiveKeyword(lexer_kernel_t *kernel, char *keyword, int k
 // ---------------------------------------------------------------
 inline void LXRK_AddStringDelimiters(lexer_kernel_t *kernel, char start, char end)
 {
-	MT_SetAdd(kernel->string_map, LXRK_CreateCharCharPair(start, end));
+	kernel->char_class[(unsigned char)start] |= LXRK_CC_STRING_START;
+	kernel->string_end[(unsigned char)start] = end;
 }
 
 // ---------------------------------------------------------------
@@ -307,6 +541,7 @@ inline void LXRK_AddStringDelimiters(lexer_kernel_t *kernel, char start, char en
 // ---------------------------------------------------------------
 inline void LXRK_SetDecimalSeparator(lexer_kernel_t *kernel, char separator)
 {
+	LXRK_MoveCharClass(kernel, LXRK_CC_DECIMAL_SEPARATOR, kernel->decimal_char, separator);
 	kernel->decimal_char = separator;
 }
 
@@ -316,6 +551,7 @@ inline void LXRK_SetDecimalSeparator(lexer_kernel_t *kernel, char separator)
 // ---------------------------------------------------------------
 inline void LXRK_SetStringEscapeChar(lexer_kernel_t *kernel, char escape)
 {
+	LXRK_MoveCharClass(kernel, LXRK_CC_ESCAPE, kernel->escape_char, escape);
 	kernel->escape_char = escape;
 }
 
@@ -325,6 +561,9 @@ inline void LXRK_SetStringEscapeChar(lexer_kernel_t *kernel, char escape)
 // ---------------------------------------------------------------
 char* LXRK_GetCommentEnd(lexer_kernel_t *kernel, char *comment_start)
 {
+	if (kernel->compiled)
+		return LXRK_TrieCommentEnd(kernel, LXRK_TrieFind(kernel, comment_start));
+
 	LXRK_SETPAIR pair;
 	pair.key = (void*)comment_start;
 	int idx;
@@ -339,6 +578,8 @@ char* LXRK_GetCommentEnd(lexer_kernel_t *kernel, char *comment_start)
 // ---------------------------------------------------------------
 int LXRK_IsLineComment(lexer_kernel_t *kernel, char *line_comment)
 {
+	if (kernel->compiled)
+		return LXRK_TrieLineComment(kernel, LXRK_TrieFind(kernel, line_comment));
 	return MT_SetContains(kernel->comment_line_map, line_comment);
 }
 
@@ -348,12 +589,7 @@ int LXRK_IsLineComment(lexer_kernel_t *kernel, char *line_comment)
 // ---------------------------------------------------------------
 char LXRK_GetStringEnd(lexer_kernel_t *kernel, char string_start)
 {
-	LXRK_SETPAIR pair;
-	pair.key = (void*)(int)string_start;
-	int idx;
-	if ((idx = MT_SetSearch(kernel->string_map, &pair)) >= 0)
-		return (char)(int)(MT_SetGet(kernel->string_map, LXRK_SETPAIR*, idx)->value);
-	return 0;
+	return kernel->string_end[(unsigned char)string_start];
 }
 
 // ---------------------------------------------------------------
@@ -362,13 +598,35 @@ char LXRK_GetStringEnd(lexer_kernel_t *kernel, char string_start)
 // ---------------------------------------------------------------
 int LXRK_GetKeywordType(lexer_kernel_t *kernel, char* keyword)
 {
-	LXRK_SETPAIR pair;
-	pair.key = (void*)keyword;
-	int idx;
-	if ((idx = MT_SetSearch(kernel->keyword_map, &pair)) >= 0)
-		return (int)(MT_SetGet(kernel->keyword_map, LXRK_SETPAIR*, idx)->value);
-	else if ((idx = MT_SetSearch(kernel->cikeyword_map, &pair)) >= 0)
-		return (int)(MT_SetGet(kernel->cikeyword_map, LXRK_SETPAIR*, idx)->value);
+	if (kernel->compiled)
+		return LXRK_GetKeywordSliceType(kernel, keyword, strlen(keyword));
+
+	void *value;
+	if (MT_HashMapFind(kernel->keyword_map, keyword, &value) || MT_HashMapFind(kernel->cikeyword_map, keyword, &value))
+		return (int)(intptr_t)value;
+	return -1;
+}
+
+// ---------------------------------------------------------------
+// int LXRK_GetKeywordSliceType(lexer_kernel_t *kernel, const char *text, int length)
+// See lexer_kernel.h
+// ---------------------------------------------------------------
+int LXRK_GetKeywordSliceType(lexer_kernel_t *kernel, const char *text, int length)
+{
+	if (kernel->generated)
+		return kernel->generated->keyword_type(text, length);
+
+	lexer_kernel_keywords_t *kw = &(kernel->keywords);
+	uint32_t slot = LXRK_KeywordHash(kw->seed, text, length) & kw->mask;
+	int i, end = kw->slot_first[slot] + kw->slot_count[slot];
+	for (i = kw->slot_first[slot]; i < end; i++)
+	{
+		lexer_kernel_keyword_t *entry = &(kw->entries[i]);
+		if (entry->length != length)
+			continue;
+		if ((entry->case_insensitive ? strnicmp(entry->keyword, text, length) : memcmp(entry->keyword, text, length)) == 0)
+			return entry->type;
+	}
 	return -1;
 }
 
@@ -378,6 +636,9 @@ int LXRK_GetKeywordType(lexer_kernel_t *kernel, char* keyword)
 // ---------------------------------------------------------------
 int LXRK_GetDelimiterType(lexer_kernel_t *kernel, char* delimiter)
 {
+	if (kernel->compiled)
+		return LXRK_TrieDelimiterType(kernel, LXRK_TrieFind(kernel, delimiter));
+
 	LXRK_SETPAIR pair;
 	pair.key = (void*)delimiter;
 	int idx;
@@ -390,99 +651,99 @@ int LXRK_GetDelimiterType(lexer_kernel_t *kernel, char* delimiter)
 // int LXRK_IsAlphabeticalChar(lexer_kernel_t *kernel, int c)
 // See lexer_kernel.h
 // ---------------------------------------------------------------
-inline int LXRK_IsAlphabeticalChar(lexer_kernel_t *kernel, int c)
+int LXRK_IsAlphabeticalChar(lexer_kernel_t *kernel, int c)
 {
-	return isalpha(c);
+	return (LXRK_CharClass(kernel, c) & LXRK_CC_ALPHABETICAL) ? 1 : 0;
 }
 
 // ---------------------------------------------------------------
 // int LXRK_IsHexadecimalChar(lexer_kernel_t *kernel, int c)
 // See lexer_kernel.h
 // ---------------------------------------------------------------
-inline int LXRK_IsHexadecimalChar(lexer_kernel_t *kernel, int c)
+int LXRK_IsHexadecimalChar(lexer_kernel_t *kernel, int c)
 {
-	return isxdigit(c);
+	return (LXRK_CharClass(kernel, c) & LXRK_CC_HEXADECIMAL) ? 1 : 0;
 }
 
 // ---------------------------------------------------------------
 // int LXRK_IsDecimalChar(lexer_kernel_t *kernel, int c)
 // See lexer_kernel.h
 // ---------------------------------------------------------------
-inline int LXRK_IsDecimalChar(lexer_kernel_t *kernel, int c)
+int LXRK_IsDecimalChar(lexer_kernel_t *kernel, int c)
 {
-	return isdigit(c);
+	return (LXRK_CharClass(kernel, c) & LXRK_CC_DECIMAL) ? 1 : 0;
 }
 
 // ---------------------------------------------------------------
 // int LXRK_IsUnderscoreChar(lexer_kernel_t *kernel, int c)
 // See lexer_kernel.h
 // ---------------------------------------------------------------
-inline int LXRK_IsUnderscoreChar(lexer_kernel_t *kernel, int c)
+int LXRK_IsUnderscoreChar(lexer_kernel_t *kernel, int c)
 {
-	return c == '_' ? 1 : 0;
+	return (LXRK_CharClass(kernel, c) & LXRK_CC_UNDERSCORE) ? 1 : 0;
 }
 
 // ---------------------------------------------------------------
 // int LXRK_IsNewlineChar(lexer_kernel_t *kernel, int c)
 // See lexer_kernel.h
 // ---------------------------------------------------------------
-inline int LXRK_IsNewlineChar(lexer_kernel_t *kernel, int c)
+int LXRK_IsNewlineChar(lexer_kernel_t *kernel, int c)
 {
-	return c == '\n' ? 1 : 0;
+	return (LXRK_CharClass(kernel, c) & LXRK_CC_NEWLINE) ? 1 : 0;
 }
 
 // ---------------------------------------------------------------
 // int LXRK_IsSpaceChar(lexer_kernel_t *kernel, int c)
 // See lexer_kernel.h
 // ---------------------------------------------------------------
-inline int LXRK_IsSpaceChar(lexer_kernel_t *kernel, int c)
+int LXRK_IsSpaceChar(lexer_kernel_t *kernel, int c)
 {
-	return c == ' ' ? 1 : 0;
+	return (LXRK_CharClass(kernel, c) & LXRK_CC_SPACE) ? 1 : 0;
 }
 
 // ---------------------------------------------------------------
 // int LXRK_IsTabChar(lexer_kernel_t *kernel, int c)
 // See lexer_kernel.h
 // ---------------------------------------------------------------
-inline int LXRK_IsTabChar(lexer_kernel_t *kernel, int c)
+int LXRK_IsTabChar(lexer_kernel_t *kernel, int c)
 {
-	return c == '\t' ? 1 : 0;
+	return (LXRK_CharClass(kernel, c) & LXRK_CC_TAB) ? 1 : 0;
 }
 
 // ---------------------------------------------------------------
 // int LXRK_IsWhitespaceChar(lexer_kernel_t *kernel, int c)
 // See lexer_kernel.h
 // ---------------------------------------------------------------
-inline int LXRK_IsWhitespaceChar(lexer_kernel_t *kernel, int c)
+int LXRK_IsWhitespaceChar(lexer_kernel_t *kernel, int c)
 {
-	return isspace(c);
+	return (LXRK_CharClass(kernel, c) & LXRK_CC_WHITESPACE) ? 1 : 0;
 }
 
 // ---------------------------------------------------------------
 // int LXRK_IsExponentSignChar(lexer_kernel_t *kernel, int c)
 // See lexer_kernel.h
 // ---------------------------------------------------------------
-inline int LXRK_IsExponentSignChar(lexer_kernel_t *kernel, int c)
+int LXRK_IsExponentSignChar(lexer_kernel_t *kernel, int c)
 {
-	return (c == '-' || c == '+') ? 1 : 0;
+	return (LXRK_CharClass(kernel, c) & LXRK_CC_EXPONENT_SIGN) ? 1 : 0;
 }
 
 // ---------------------------------------------------------------
-// int LXRK_IsDelimiterChar(lexer_kernel_t *kernel, int c)
+// int LXRK_IsDelimiterStartChar(lexer_kernel_t *kernel, int c)
 // See lexer_kernel.h
 // ---------------------------------------------------------------
-inline int LXRK_IsDelimiterStartChar(lexer_kernel_t *kernel, int c)
+int LXRK_IsDelimiterStartChar(lexer_kernel_t *kernel, int c)
 {
-	return MT_SetContains(kernel->delimiter_starts, (void*)c);
+	return (LXRK_CharClass(kernel, c) & LXRK_CC_DELIMITER_START) ? 1 : 0;
 }
 
 // ---------------------------------------------------------------
 // int LXRK_IsEndCommentStartChar(lexer_kernel_t *kernel, int c)
 // See lexer_kernel.h
 // ---------------------------------------------------------------
-inline int LXRK_IsEndCommentStartChar(lexer_kernel_t *kernel, int c)
+int LXRK_IsEndCommentStartChar(lexer_kernel_t *kernel, int c)
 {
-	return MT_SetContains(kernel->end_comment_starts, (void*)c);
+	return (LXRK_CharClass(kernel, c) & LXRK_CC_END_COMMENT_START) ? 1 : 0;
 }
 
 // ---------------------------------------------------------------
@@ -491,25 +752,23 @@ inline int LXRK_IsEndCommentStartChar(lexer_kernel_t *kernel, int c)
 // ---------------------------------------------------------------
 int LXRK_IsStringStartChar(lexer_kernel_t *kernel, int c)
 {
-	LXRK_SETPAIR pair;
-	pair.key = (void*)c;
-	return MT_SetContains(kernel->string_map, &pair);
+	return (LXRK_CharClass(kernel, c) & LXRK_CC_STRING_START) ? 1 : 0;
 }
 
 // ---------------------------------------------------------------
 // int LXRK_IsDecimalSeparatorChar(lexer_kernel_t *kernel, int c)
 // See lexer_kernel.h
 // ---------------------------------------------------------------
-inline int LXRK_IsDecimalSeparatorChar(lexer_kernel_t *kernel, int c)
+int LXRK_IsDecimalSeparatorChar(lexer_kernel_t *kernel, int c)
 {
-	return c == kernel->decimal_char ? 1 : 0;
+	return (LXRK_CharClass(kernel, c) & LXRK_CC_DECIMAL_SEPARATOR) ? 1 : 0;
 }
 
 // ---------------------------------------------------------------
 // int LXRK_IsEscapeChar(lexer_kernel_t *kernel, int c)
 // See lexer_kernel.h
 // ---------------------------------------------------------------
-inline int LXRK_IsEscapeChar(lexer_kernel_t *kernel, int c)
+int LXRK_IsEscapeChar(lexer_kernel_t *kernel, int c)
 {
-	return c == kernel->escape_char ? 1 : 0;
+	return (LXRK_CharClass(kernel, c) & LXRK_CC_ESCAPE) ? 1 : 0;
 }
@@ -13,10 +13,125 @@
 #include <stdint.h>
 #include "lexer_config.h"
 #include "struct/mt_set.h"
+#include "struct/mt_hashmap.h"
 
 #define LXR_KERNEL_SET_SIZE		32
 #define LXR_KERNEL_HTABLE_SIZE	8
 
+// Character class bits (see lexer_kernel_t.char_class).
+#define LXRK_CC_ALPHABETICAL		0x0001
+#define LXRK_CC_DECIMAL				0x0002
+#define LXRK_CC_HEXADECIMAL			0x0004
+#define LXRK_CC_UNDERSCORE			0x0008
+#define LXRK_CC_NEWLINE				0x0010
+#define LXRK_CC_SPACE				0x0020
+#define LXRK_CC_TAB					0x0040
+#define LXRK_CC_WHITESPACE			0x0080
+#define LXRK_CC_EXPONENT			0x0100
+#define LXRK_CC_EXPONENT_SIGN		0x0200
+#define LXRK_CC_HEX_PREFIX			0x0400
+#define LXRK_CC_DELIMITER_START		0x0800
+#define LXRK_CC_END_COMMENT_START	0x1000
+#define LXRK_CC_STRING_START		0x2000
+#define LXRK_CC_DECIMAL_SEPARATOR	0x4000
+#define LXRK_CC_ESCAPE				0x8000
+
+/**
+ * Gets the class bits of a character (LXRK_CC_*) - a single table load.
+ * Negative values (end of stream/lexer) have no class bits.
+ */
+#define LXRK_CharClass(kernel, c) ((c) < 0 ? 0 : (kernel)->char_class[(c) & 0x0FF])
+
+// No trie node.
+#define LXRK_TRIE_NONE			0
+// Root trie node.
+#define LXRK_TRIE_ROOT			0
+
+/**
+ * A compiled keyword entry.
+ */
+typedef struct {
+
+	/** The keyword (owned by the keyword sets). */
+	char *keyword;
+	/** Keyword length. */
+	int length;
+	/** Keyword type. */
+	int type;
+	/** If nonzero, matched case-insensitively. */
+	int case_insensitive;
+
+} lexer_kernel_keyword_t;
+
+/**
+ * Compiled keywords: a perfect hash of case-folded keywords.
+ * Every distinct case-folded keyword has its own slot, so a lookup is one hash and (usually) one compare.
+ */
+typedef struct {
+
+	/** Hash seed. */
+	uint32_t seed;
+	/** Slot mask (slot count - 1, power of two). */
+	uint32_t mask;
+	/** Index of each slot's first entry. */
+	int *slot_first;
+	/** Amount of entries in each slot (case-sensitive entries are first). */
+	int *slot_count;
+	/** Entries, grouped by slot. */
+	lexer_kernel_keyword_t *entries;
+	/** Amount of entries. */
+	int entry_count;
+
+} lexer_kernel_keywords_t;
+
+/**
+ * Compiled delimiter trie node.
+ * The children are indexed by byte, so walking a delimiter is one load per character.
+ */
+typedef struct {
+
+	/** Child node per next character (LXRK_TRIE_NONE for none - the root is never a child). */
+	uint16_t next[256];
+	/** Delimiter type if the path to this node is a delimiter, else -1. */
+	int delimiter_type;
+	/** Comment end if the path to this node starts a multi-line comment, else NULL (owned by the comment set). */
+	char *comment_end;
+	/** Nonzero if the path to this node starts a line comment. */
+	int line_comment;
+
+} lexer_kernel_trie_t;
+
+/**
+ * Generated kernel data - a kernel specialized at compile time (see LXRK_CreateGenerated()).
+ * Source files that define these are written by the "lxrgen" tool from a kernel description,
+ * so that keyword and delimiter lookups are switch-based code instead of compiled tables.
+ */
+typedef struct {
+
+	/** Class bits (LXRK_CC_*) for each byte value. */
+	const uint16_t *char_class;
+	/** String end character for each string start character (0 if not a string start). */
+	const char *string_end;
+	/** Decimal character. */
+	char decimal_char;
+	/** String escape character. */
+	char escape_char;
+
+	/** Gets a keyword type from a slice of text, or -1 if not a keyword. */
+	int (*keyword_type)(const char *text, int length);
+	/** Gets the next delimiter trie node from a node and a character (0 to 255), or LXRK_TRIE_NONE. */
+	int (*trie_next)(int node, int c);
+	/** Delimiter type of each trie node, or -1. */
+	const int *delimiter_type;
+	/** Comment end of each trie node, or NULL. */
+	char * const *comment_end;
+	/** Nonzero for each trie node that starts a line comment. */
+	const char *line_comment;
+	/** Amount of trie nodes. */
+	int trie_count;
+
+} lexer_kernel_generated_t;
+
 /**
  * Lexer kernel - defines subtypes for tokens.
  */
@@ -30,24 +145,36 @@ typedef struct {
 	/** Set of pairs: char* to int: delimiters to delimiter type. */
 	mt_set_t *delimiter_map;
 	
-	/** Set of characters that start delimiters. Delimiters immediately break the current token if encountered. */
-	mt_set_t *delimiter_starts;
-	/** Set of characters that start end-comment delimiters. Delimiters immediately break the current token if encountered. */
-	mt_set_t *end_comment_starts;
-	
-	/** Set of pairs: char* to int: identifier to keyword type. */
-	mt_set_t *keyword_map;
-	/** Set of pairs: char* to int: identifier to keyword type. Case-insensitive matching. */
-	mt_set_t *cikeyword_map;
-
-	/** Set of pairs: char to char: string start char to string end char. */
-	mt_set_t *string_map;
+	/** Map of char* to int: identifier to keyword type. */
+	mt_hashmap_t *keyword_map;
+	/** Map of char* to int: identifier to keyword type. Case-insensitive matching. */
+	mt_hashmap_t *cikeyword_map;
 
 	/** Decimal character. */
 	char decimal_char;
 	/** String escape character. */
 	char escape_char;
 
+	/** 
+	 * Class bits (LXRK_CC_*) for each byte value.
+	 * Kept up to date as the kernel is built, so the lexer classifies a character with one load.
+	 * Delimiter starts and end-comment starts break the current token if encountered.
+	 */
+	uint16_t char_class[256];
+	/** String end character for each string start character (0 if not a string start). */
+	char string_end[256];
+
+	/** If nonzero, this kernel was compiled (see LXRK_Compile()) and can no longer be changed. */
+	int compiled;
+	/** Compiled keywords. */
+	lexer_kernel_keywords_t keywords;
+	/** Compiled delimiter/comment trie. Node LXRK_TRIE_ROOT is the root. */
+	lexer_kernel_trie_t *trie;
+	/** Amount of trie nodes. */
+	int trie_count;
+	/** Generated lookups, used instead of the compiled keywords and trie (generated kernels only, else NULL). */
+	const lexer_kernel_generated_t *generated;
+
 } lexer_kernel_t;
 
 //............................................................................
@@ -58,6 +185,15 @@ typedef struct {
  */
 lexer_kernel_t* LXRK_Create();
 
+/**
+ * Creates a new lexer kernel from generated data.
+ * The kernel is already compiled, and its keywords, delimiters and comments are looked up by the 
+ * generated code, so its sets stay empty and there is nothing to build at runtime.
+ * @param generated the generated data. Must remain valid while the kernel is used (it is usually static).
+ * @return a new lexer kernel or NULL if it couldn't be allocated.
+ */
+lexer_kernel_t* LXRK_CreateGenerated(const lexer_kernel_generated_t *generated);
+
 /**
  * Destroys an allocated lexer kernel.
  * @param kernel the kernel to destroy.
@@ -65,6 +201,19 @@ lexer_kernel_t* LXRK_Create();
  */
 int LXRK_Destroy(lexer_kernel_t *kernel);
 
+/**
+ * Compiles (and freezes) a kernel.
+ * Keywords are built into a perfect hash of case-folded keywords, and delimiters and
+ * comment starts into a byte-indexed trie, so that identifier and delimiter classification 
+ * cost O(length) with no set searches. After this, the kernel's delimiters, comments and keywords 
+ * cannot be changed (the LXRK_Add* functions do nothing), and the kernel can be safely shared by
+ * lexers on separate threads. Compiling a compiled kernel does nothing.
+ * Lexers work with uncompiled kernels as well, just slower.
+ * @param kernel the kernel to compile.
+ * @return 0 if successful, nonzero if not (out of memory - the kernel is left uncompiled).
+ */
+int LXRK_Compile(lexer_kernel_t *kernel);
+
 //............................................................................
 
 /**
@@ -165,6 +314,16 @@ char LXRK_GetStringEnd(lexer_kernel_t *kernel, char string_start);
  */
 int LXRK_GetKeywordType(lexer_kernel_t *kernel, char* keyword);
 
+/**
+ * Gets a keyword type from a slice of text.
+ * The kernel must be compiled.
+ * @param kernel the kernel to use.
+ * @param text the start of the text (need not be null-terminated).
+ * @param length the length of the text.
+ * @return the type id or -1 for no associated type.
+ */
+int LXRK_GetKeywordSliceType(lexer_kernel_t *kernel, const char *text, int length);
+
 /**
  * Gets the associated string ending character.
  * @param kernel the kernel to add to.
@@ -173,6 +332,38 @@ int LXRK_GetKeywordType(lexer_kernel_t *kernel, char* keyword);
  */
 int LXRK_GetDelimiterType(lexer_kernel_t *kernel, char* delimiter);
 
+/**
+ * Gets the next delimiter trie node from a node and a character.
+ * The kernel must be compiled.
+ * @param kernel the kernel to use.
+ * @param node the current node (LXRK_TRIE_ROOT to start).
+ * @param c the next character.
+ * @return the next node, or LXRK_TRIE_NONE if no delimiter or comment start continues with this character.
+ */
+#define LXRK_TrieNext(kernel, node, c) ((c) < 0 ? LXRK_TRIE_NONE : (kernel)->generated \
+	? (kernel)->generated->trie_next((node), (c) & 0x0FF) : (kernel)->trie[(node)].next[(c) & 0x0FF])
+
+/**
+ * Gets the delimiter type of a trie node (-1 if none).
+ * The kernel must be compiled.
+ */
+#define LXRK_TrieDelimiterType(kernel, node) ((kernel)->generated \
+	? (kernel)->generated->delimiter_type[(node)] : (kernel)->trie[(node)].delimiter_type)
+
+/**
+ * Gets the comment end of a trie node (NULL if none).
+ * The kernel must be compiled.
+ */
+#define LXRK_TrieCommentEnd(kernel, node) ((kernel)->generated \
+	? (kernel)->generated->comment_end[(node)] : (kernel)->trie[(node)].comment_end)
+
+/**
+ * Gets if a trie node starts a line comment.
+ * The kernel must be compiled.
+ */
+#define LXRK_TrieLineComment(kernel, node) ((kernel)->generated \
+	? (kernel)->generated->line_comment[(node)] : (kernel)->trie[(node)].line_comment)
+
 //............................................................................
 
 /**
@@ -0,0 +1,459 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "lexer_config.h"
+#include "lexer_parallel.h"
+
+#define LXR_TOKEN_ARRAY_INITSIZE	256
+
+/**
+ * A part of a buffer to lex.
+ */
+typedef struct {
+
+	/** The kernel to use. */
+	lexer_kernel_t *kernel;
+	/** The whole buffer. */
+	const unsigned char *buffer;
+	/** Offset to start lexing at. */
+	size_t start;
+	/** Tokens that start at or after this offset are not added. */
+	size_t stop;
+	/** Offset of the end of the buffer. */
+	size_t end;
+	/** Output tokens. */
+	lexer_token_array_t *array;
+	/** Offset of the first token at or after stop (end if none). */
+	size_t next_start;
+	/** Line number of that token, counted from the start. */
+	int next_line;
+	/** If nonzero, this could not be lexed. */
+	int error;
+
+} lexer_range_t;
+
+/**
+ * A set of ranges lexed by a set of threads.
+ */
+typedef struct {
+
+	/** The ranges. */
+	lexer_range_t *ranges;
+	/** Amount of ranges. */
+	int count;
+	/** Next range to lex. */
+	int next;
+	/** Guards next. */
+	pthread_mutex_t mutex;
+
+} lexer_jobs_t;
+
+// ===========================================================================
+// Private Functions
+// ===========================================================================
+
+// Creates a new, empty token array.
+static lexer_token_array_t* LXR_TokenArrayCreate(const unsigned char *source, size_t length)
+{
+	lexer_token_array_t *out = (lexer_token_array_t*)LXR_MALLOC(sizeof(lexer_token_array_t));
+	if (!out)
+		return NULL;
+	out->tokens = (lexer_array_token_t*)LXR_MALLOC(sizeof(lexer_array_token_t) * LXR_TOKEN_ARRAY_INITSIZE);
+	if (!out->tokens)
+	{
+		LXR_FREE(out);
+		return NULL;
+	}
+	out->source = source;
+	out->source_length = length;
+	out->count = 0;
+	out->capacity = LXR_TOKEN_ARRAY_INITSIZE;
+	return out;
+}
+
+// Checks if a token's text is a copy owned by the array.
+static int LXR_TokenArrayOwnsText(lexer_token_array_t *array, lexer_array_token_t *token)
+{
+	const unsigned char *t = (const unsigned char*)token->text;
+	return t && (t < array->source || t >= array->source + array->source_length);
+}
+
+// Frees the text copies of a span of tokens (and clears them, so they aren't freed again).
+static void LXR_TokenArrayFreeText(lexer_token_array_t *array, int start, int end)
+{
+	int i;
+	for (i = start; i < end; i++)
+		if (LXR_TokenArrayOwnsText(array, &(array->tokens[i])))
+		{
+			LXR_FREE((char*)array->tokens[i].text);
+			array->tokens[i].text = NULL;
+		}
+}
+
+// Ensures room for one more token. Returns nonzero if not.
+static int LXR_TokenArrayExpand(lexer_token_array_t *array)
+{
+	if (array->count < array->capacity)
+		return 0;
+	lexer_array_token_t *tokens = (lexer_array_token_t*)LXR_REALLOC(array->tokens, sizeof(lexer_array_token_t) * array->capacity * 2);
+	if (!tokens)
+		return 1;
+	array->tokens = tokens;
+	array->capacity *= 2;
+	return 0;
+}
+
+// Adds a scanned token at a source offset. Returns nonzero if it couldn't be added.
+static int LXR_TokenArrayAdd(lexer_token_array_t *array, lexer_token_t *token, size_t offset)
+{
+	if (LXR_TokenArrayExpand(array))
+		return 1;
+
+	lexer_array_token_t *out = &(array->tokens[array->count]);
+	if (token->text == token->lexeme)
+	{
+		// not a slice (the text skipped a CR) - keep a copy.
+		char *text = (char*)LXR_MALLOC(token->length + 1);
+		if (!text)
+			return 1;
+		memcpy(text, token->lexeme, token->length + 1);
+		out->text = text;
+	}
+	else
+	{
+		out->text = token->text;
+	}
+	out->offset = offset;
+	out->integer = token->integer;
+	out->decimal = token->decimal;
+	out->length = token->length;
+	out->subtype = token->subtype;
+	out->line_number = token->line_number;
+	out->type = token->type;
+	out->escaped = (char)token->escaped;
+	out->string_end = token->string_end;
+	array->count++;
+	return 0;
+}
+
+// Lexes a range.
+static void LXR_LexRange(lexer_range_t *range)
+{
+	lexer_t *lexer;
+	lexer_token_t *token;
+
+	range->next_start = range->end;
+	range->next_line = 0;
+
+	if (range->error)
+		return;
+	if (!(lexer = LXR_Create(range->kernel)))
+	{
+		range->error = 1;
+		return;
+	}
+	lexer->options.zero_copy = 1;
+	if (LXR_PushStreamBuffer(lexer, "", (unsigned char*)range->buffer + range->start, range->end - range->start))
+	{
+		LXR_Destroy(lexer);
+		range->error = 1;
+		return;
+	}
+
+	while ((token = LXR_NextToken(lexer)))
+	{
+		size_t offset = range->start + token->offset;
+		if (offset >= range->stop)
+		{
+			range->next_start = offset;
+			range->next_line = token->line_number;
+			break;
+		}
+		if (LXR_TokenArrayAdd(range->array, token, offset))
+		{
+			range->error = 1;
+			break;
+		}
+	}
+
+	LXR_Destroy(lexer);
+}
+
+// Lexes jobs until there are none left.
+static void* LXR_JobThread(void *arg)
+{
+	lexer_jobs_t *jobs = (lexer_jobs_t*)arg;
+	int i;
+	while (1)
+	{
+		pthread_mutex_lock(&(jobs->mutex));
+		i = jobs->next++;
+		pthread_mutex_unlock(&(jobs->mutex));
+		if (i >= jobs->count)
+			break;
+		LXR_LexRange(&(jobs->ranges[i]));
+	}
+	return NULL;
+}
+
+// Lexes a set of ranges on up to "threads" threads (including this one).
+static void LXR_RunJobs(lexer_range_t *ranges, int count, int threads)
+{
+	lexer_jobs_t jobs;
+	pthread_t *workers;
+	int i, started = 0;
+
+	jobs.ranges = ranges;
+	jobs.count = count;
+	jobs.next = 0;
+	pthread_mutex_init(&(jobs.mutex), NULL);
+
+	threads = threads < count ? threads : count;
+	workers = threads > 1 ? (pthread_t*)LXR_MALLOC(sizeof(pthread_t) * (threads - 1)) : NULL;
+	// if threads can't be started, this thread does more of the work.
+	if (workers)
+		for (i = 0; i < threads - 1; i++)
+			if (!pthread_create(&workers[started], NULL, LXR_JobThread, &jobs))
+				started++;
+
+	LXR_JobThread(&jobs);
+
+	for (i = 0; i < started; i++)
+		pthread_join(workers[i], NULL);
+	if (workers)
+		LXR_FREE(workers);
+	pthread_mutex_destroy(&(jobs.mutex));
+}
+
+// Finds the token that starts at an offset. Returns its index, or -1 if none.
+static int LXR_TokenArrayFind(lexer_token_array_t *array, size_t offset)
+{
+	int lo = 0, hi = array->count - 1;
+	while (lo <= hi)
+	{
+		int mid = lo + (hi - lo) / 2;
+		if (array->tokens[mid].offset < offset)
+			lo = mid + 1;
+		else if (array->tokens[mid].offset > offset)
+			hi = mid - 1;
+		else
+			return mid;
+	}
+	return -1;
+}
+
+// Appends tokens from one array to another, adding a line delta. Returns nonzero if out of memory.
+static int LXR_TokenArrayAppend(lexer_token_array_t *array, lexer_token_array_t *from, int start, int line_delta)
+{
+	int i;
+	for (i = start; i < from->count; i++)
+	{
+		if (LXR_TokenArrayExpand(array))
+		{
+			// the rest stay where they are.
+			memmove(from->tokens + start, from->tokens + i, sizeof(lexer_array_token_t) * (from->count - i));
+			from->count = start + from->count - i;
+			return 1;
+		}
+		array->tokens[array->count] = from->tokens[i];
+		// line 0 is "no line", not the first line of the range.
+		if (array->tokens[array->count].line_number > 0)
+			array->tokens[array->count].line_number += line_delta;
+		array->count++;
+	}
+	// text copies moved over.
+	from->count = start;
+	return 0;
+}
+
+// Makes sure the kernel can be shared.
+static int LXR_PrepareKernel(lexer_kernel_t *kernel)
+{
+	return kernel->compiled ? 0 : LXRK_Compile(kernel);
+}
+
+// ===========================================================================
+// Public Functions
+// ===========================================================================
+
+// ---------------------------------------------------------------
+// lexer_token_array_t* LXR_LexParallel(lexer_kernel_t *kernel, const unsigned char *buffer, size_t length, int threads)
+// See lexer_parallel.h
+// ---------------------------------------------------------------
+lexer_token_array_t* LXR_LexParallel(lexer_kernel_t *kernel, const unsigned char *buffer, size_t length, int threads)
+{
+	lexer_range_t *ranges;
+	lexer_token_array_t *out = NULL;
+	int i, j, chunks, error = 0;
+	size_t next;
+	int next_line, delta;
+
+	if (LXR_PrepareKernel(kernel))
+		return NULL;
+
+	threads = threads < 1 ? 1 : threads;
+	for (chunks = threads; chunks > 1 && length / chunks < LEXER_PARALLEL_CHUNK_MIN; chunks--) ;
+
+	if (!(ranges = (lexer_range_t*)LXR_CALLOC(chunks, sizeof(lexer_range_t))))
+		return NULL;
+
+	// split after line breaks.
+	for (i = 0; i < chunks; i++)
+	{
+		ranges[i].kernel = kernel;
+		ranges[i].buffer = buffer;
+		ranges[i].end = length;
+		if (i == 0)
+			ranges[i].start = 0;
+		else
+		{
+			size_t from = length / chunks * i;
+			const unsigned char *nl;
+			from = from > ranges[i - 1].start ? from : ranges[i - 1].start;
+			nl = (const unsigned char*)memchr(buffer + from, '\n', length - from);
+			ranges[i].start = nl ? (size_t)(nl - buffer) + 1 : length;
+			ranges[i - 1].stop = ranges[i].start;
+		}
+		if (!(ranges[i].array = LXR_TokenArrayCreate(buffer, length)))
+			error = 1;
+	}
+	ranges[chunks - 1].stop = length;
+
+	if (!error)
+		LXR_RunJobs(ranges, chunks, threads);
+
+	// stitch: each range is used from the first token that the previous range also ends at.
+	if (!error && !ranges[0].error)
+	{
+		out = ranges[0].array;
+		ranges[0].array = NULL;
+		next = ranges[0].next_start;
+		next_line = ranges[0].next_line;
+
+		for (i = 1; i < chunks && !error; i++)
+		{
+			lexer_range_t *range = &ranges[i];
+
+			// the previous range's last token covers this one.
+			if (next >= range->stop)
+				continue;
+
+			j = range->error ? -1 : LXR_TokenArrayFind(range->array, next);
+			if (j < 0)
+			{
+				// never lined up (it started inside a comment or string) - lex again from the right place.
+				LXR_TokenArrayFreeText(range->array, 0, range->array->count);
+				range->array->count = 0;
+				range->start = next;
+				range->error = 0;
+				LXR_LexRange(range);
+				if (range->error || !range->array->count)
+				{
+					error = 1;
+					break;
+				}
+				j = 0;
+			}
+
+			delta = next_line - range->array->tokens[j].line_number;
+			LXR_TokenArrayFreeText(range->array, 0, j);
+			if (LXR_TokenArrayAppend(out, range->array, j, delta))
+				error = 1;
+			next = range->next_start;
+			next_line = range->next_line + delta;
+		}
+	}
+	else
+		error = 1;
+
+	for (i = 0; i < chunks; i++)
+		if (ranges[i].array)
+			LXR_TokenArrayDestroy(ranges[i].array);
+	LXR_FREE(ranges);
+
+	if (error && out)
+	{
+		LXR_TokenArrayDestroy(out);
+		out = NULL;
+	}
+	return out;
+}
+
+// ---------------------------------------------------------------
+// int LXR_LexBuffers(lexer_kernel_t *kernel, const unsigned char **buffers, size_t *lengths, int count, lexer_token_array_t **out, int threads)
+// See lexer_parallel.h
+// ---------------------------------------------------------------
+int LXR_LexBuffers(lexer_kernel_t *kernel, const unsigned char **buffers, size_t *lengths, int count, lexer_token_array_t **out, int threads)
+{
+	lexer_range_t *ranges;
+	int i, error = 0;
+
+	for (i = 0; i < count; i++)
+		out[i] = NULL;
+
+	if (count <= 0)
+		return 0;
+	if (LXR_PrepareKernel(kernel))
+		return 1;
+	if (!(ranges = (lexer_range_t*)LXR_CALLOC(count, sizeof(lexer_range_t))))
+		return 1;
+
+	for (i = 0; i < count; i++)
+	{
+		ranges[i].kernel = kernel;
+		ranges[i].buffer = buffers[i];
+		ranges[i].start = 0;
+		ranges[i].stop = lengths[i];
+		ranges[i].end = lengths[i];
+		if (!(ranges[i].array = LXR_TokenArrayCreate(buffers[i], lengths[i])))
+			ranges[i].error = 1;
+	}
+
+	LXR_RunJobs(ranges, count, threads < 1 ? 1 : threads);
+
+	for (i = 0; i < count; i++)
+	{
+		if (ranges[i].error)
+		{
+			if (ranges[i].array)
+				LXR_TokenArrayDestroy(ranges[i].array);
+			error = 1;
+		}
+		else
+			out[i] = ranges[i].array;
+	}
+
+	LXR_FREE(ranges);
+	return error;
+}
+
+// ---------------------------------------------------------------
+// int LXR_GetArrayTokenText(lexer_kernel_t *kernel, lexer_array_token_t *token, char *out, int max)
+// See lexer_parallel.h
+// ---------------------------------------------------------------
+int LXR_GetArrayTokenText(lexer_kernel_t *kernel, lexer_array_token_t *token, char *out, int max)
+{
+	return LXR_DecodeText(kernel, token->text, token->length, token->escaped, token->string_end, out, max);
+}
+
+// ---------------------------------------------------------------
+// int LXR_TokenArrayDestroy(lexer_token_array_t *array)
+// See lexer_parallel.h
+// ---------------------------------------------------------------
+int LXR_TokenArrayDestroy(lexer_token_array_t *array)
+{
+	if (!array)
+		return 1;
+	LXR_TokenArrayFreeText(array, 0, array->count);
+	LXR_FREE(array->tokens);
+	LXR_FREE(array);
+	return 0;
+}
@@ -0,0 +1,117 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#ifndef __LEXER_PARALLEL_H__
+#define __LEXER_PARALLEL_H__
+
+#include <stdint.h>
+#include "lexer.h"
+
+/**
+ * Smallest input chunk lexed on its own thread by LXR_LexParallel().
+ */
+#ifndef LEXER_PARALLEL_CHUNK_MIN
+#define LEXER_PARALLEL_CHUNK_MIN	65536
+#endif
+
+/**
+ * A scanned token, kept in a token array.
+ */
+typedef struct {
+
+	/** Token text: a slice of the source buffer (or a copy owned by the array). NOT null-terminated. */
+	const char *text;
+	/** Offset of the token's first character in the source buffer. */
+	size_t offset;
+	/** Numeric value (number tokens only - see lexer_token_t). */
+	int64_t integer;
+	/** Numeric value (number tokens only - see lexer_token_t). */
+	double decimal;
+	/** Token text length. */
+	int length;
+	/** Token subtype. */
+	int subtype;
+	/** Line number. */
+	int line_number;
+	/** Lexeme type. */
+	lexeme_type_t type;
+	/** If nonzero, this is a string token with unprocessed escapes in its text (see LXR_DecodeText()). */
+	char escaped;
+	/** String end character (string tokens only). */
+	char string_end;
+
+} lexer_array_token_t;
+
+/**
+ * A scanned token array.
+ */
+typedef struct {
+
+	/** The source buffer (not owned by the array). */
+	const unsigned char *source;
+	/** Source buffer length. */
+	size_t source_length;
+	/** Tokens in source order. */
+	lexer_array_token_t *tokens;
+	/** Amount of tokens. */
+	int count;
+	/** Token capacity. */
+	int capacity;
+
+} lexer_token_array_t;
+
+/**
+ * Lexes a whole buffer into a token array, splitting it into chunks that are lexed on separate threads.
+ * Chunks are split at line breaks and stitched back together in order, with line numbers fixed up, so the
+ * result is the same as lexing the buffer with one lexer. If a chunk starts inside a comment or string,
+ * its tokens up to the point where it meets the previous chunk's tokens are dropped.
+ * Tokens are zero-copy slices of the buffer, so it must stay valid while the array is used.
+ * Whitespace, newline and stream break tokens are never included.
+ * The kernel is compiled first if it isn't (see LXRK_Compile()), and is only read while lexing.
+ * @param kernel the kernel to use.
+ * @param buffer the buffer to lex.
+ * @param length the buffer length in bytes.
+ * @param threads the maximum amount of threads to use. Values less than 1 are set to 1.
+ * @return a new token array, or NULL if it couldn't be allocated.
+ */
+lexer_token_array_t* LXR_LexParallel(lexer_kernel_t *kernel, const unsigned char *buffer, size_t length, int threads);
+
+/**
+ * Lexes many separate buffers into token arrays at the same time, with one shared kernel.
+ * Each buffer is lexed as if by LXR_LexParallel() with one thread.
+ * The kernel is compiled first if it isn't (see LXRK_Compile()), and is only read while lexing.
+ * @param kernel the kernel to use.
+ * @param buffers the buffers to lex.
+ * @param lengths the buffer lengths in bytes.
+ * @param count the amount of buffers.
+ * @param out the output array of token arrays, one per buffer. Entries are NULL for buffers that couldn't be lexed.
+ * @param threads the maximum amount of threads to use. Values less than 1 are set to 1.
+ * @return 0 if all buffers were lexed, nonzero if not.
+ */
+int LXR_LexBuffers(lexer_kernel_t *kernel, const unsigned char **buffers, size_t *lengths, int count, lexer_token_array_t **out, int threads);
+
+/**
+ * Gets an array token's text, null-terminated, with any string escapes processed.
+ * @param kernel the kernel that scanned the token.
+ * @param token the token.
+ * @param out the output buffer.
+ * @param max the size of the output buffer, including the null terminator. Text that does not fit is truncated.
+ * @return the full length of the processed text (not including the terminator), even if truncated.
+ */
+int LXR_GetArrayTokenText(lexer_kernel_t *kernel, lexer_array_token_t *token, char *out, int max);
+
+/**
+ * Destroys a token array.
+ * The source buffer is NOT FREED.
+ * If successful, the pointer is invalidated.
+ * @param array the token array.
+ * @return 0 if successful and the pointer was invalidated, nonzero if not.
+ */
+int LXR_TokenArrayDestroy(lexer_token_array_t *array);
+
+#endif
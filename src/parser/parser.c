@@ -8,8 +8,145 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "parser.h"
 
+// ===========================================================================
+// Private Functions
+// ===========================================================================
+
+// Gets a token's slot in the token ring buffer.
+#define PARSER_SLOT(p, i) (&((p)->chunks[((i) / PARSER_CHUNK_SIZE) & ((p)->chunk_count - 1)][(i) & (PARSER_CHUNK_SIZE - 1)]))
+
+// Copies a token. Lexeme text is copied; zero-copy slices are not.
+static void PARSER_CopyToken(lexer_token_t *dest, lexer_token_t *src)
+{
+	dest->stream_name = src->stream_name;
+	dest->type = src->type;
+	dest->subtype = src->subtype;
+	dest->integer = src->integer;
+	dest->decimal = src->decimal;
+	dest->offset = src->offset;
+	dest->length = src->length;
+	dest->escaped = src->escaped;
+	dest->string_end = src->string_end;
+	dest->line_number = src->line_number;
+	if (src->text == src->lexeme)
+	{
+		int len = src->length < LEXEME_LENGTH_MAX - 1 ? src->length : LEXEME_LENGTH_MAX - 1;
+		memcpy(dest->lexeme, src->lexeme, len);
+		dest->lexeme[len] = '\0';
+		dest->text = dest->lexeme;
+	}
+	else
+	{
+		dest->lexeme[0] = '\0';
+		dest->text = src->text;
+	}
+}
+
+// Gets the index of the oldest token that must stay in the ring buffer.
+static long PARSER_Oldest(parser_t *parser)
+{
+	long out = parser->position;
+	if (parser->mark_count > 0 && parser->marks[0] < out)
+		out = parser->marks[0];
+	return out < 0 ? 0 : out;
+}
+
+// Resizes the token ring buffer to an amount of chunks, keeping the tokens from the oldest one needed. 
+// Chunks are never moved or copied, only placed in a bigger table, so that tokens stay where they are. 
+// Returns nonzero if out of memory.
+static int PARSER_Resize(parser_t *parser, int chunk_count)
+{
+	lexer_token_t **chunks = (lexer_token_t**)LXR_MALLOC(sizeof(lexer_token_t*) * chunk_count);
+	if (!chunks)
+		return 1;
+	lexer_token_t **pool = (lexer_token_t**)LXR_MALLOC(sizeof(lexer_token_t*) * chunk_count);
+	if (!pool)
+	{
+		LXR_FREE(chunks);
+		return 1;
+	}
+	
+	int i, pooled = 0;
+	for (i = 0; i < chunk_count - parser->chunk_count; i++)
+	{
+		if (!(pool[pooled] = (lexer_token_t*)LXR_MALLOC(sizeof(lexer_token_t) * PARSER_CHUNK_SIZE)))
+		{
+			while (pooled--)
+				LXR_FREE(pool[pooled]);
+			LXR_FREE(pool);
+			LXR_FREE(chunks);
+			return 1;
+		}
+		pooled++;
+	}
+	
+	for (i = 0; i < chunk_count; i++)
+		chunks[i] = NULL;
+
+	// Chunks in use keep their ring order in the new table.
+	long c;
+	long end = (parser->filled + PARSER_CHUNK_SIZE - 1) / PARSER_CHUNK_SIZE;
+	for (c = PARSER_Oldest(parser) / PARSER_CHUNK_SIZE; c < end && parser->chunk_count > 0; c++)
+	{
+		chunks[c & (chunk_count - 1)] = parser->chunks[c & (parser->chunk_count - 1)];
+		parser->chunks[c & (parser->chunk_count - 1)] = NULL;
+	}
+	for (i = 0; i < parser->chunk_count; i++)
+		if (parser->chunks[i])
+			pool[pooled++] = parser->chunks[i];
+	for (i = 0; i < chunk_count; i++)
+		if (!chunks[i])
+			chunks[i] = pool[--pooled];
+	
+	LXR_FREE(pool);
+	if (parser->chunks)
+		LXR_FREE(parser->chunks);
+	parser->chunks = chunks;
+	parser->chunk_count = chunk_count;
+	return 0;
+}
+
+// Fetches tokens from the lexer until the token at an index is fetched or there are no more tokens.
+// Tokens are fetched at least one batch at a time. Returns nonzero if the index can't be reached.
+static int PARSER_Fill(parser_t *parser, long index)
+{
+	if (index < parser->filled)
+		return 0;
+	if (parser->end)
+		return 1;
+
+	int batch = parser->batch > 0 ? parser->batch : 1;
+	long stop = parser->filled + batch;
+	if (stop <= index)
+		stop = index + 1;
+
+	lexer_token_t *token;
+	while (parser->filled < stop)
+	{
+		if (parser->filled / PARSER_CHUNK_SIZE - PARSER_Oldest(parser) / PARSER_CHUNK_SIZE >= parser->chunk_count)
+		{
+			int chunk_count = parser->chunk_count > 0 ? parser->chunk_count * 2 : 2;
+			while (chunk_count * PARSER_CHUNK_SIZE < batch * 2)
+				chunk_count *= 2;
+			if (PARSER_Resize(parser, chunk_count))
+				break;
+		}
+		
+		if (!(token = LXR_NextToken(parser->lexer)))
+		{
+			parser->end = 1;
+			break;
+		}
+		PARSER_CopyToken(PARSER_SLOT(parser, parser->filled), token);
+		parser->filled++;
+	}
+	
+	return index >= parser->filled;
+}
+
 // ===========================================================================
 // Public Functions
 // ===========================================================================
@@ -24,6 +161,13 @@ parser_t* PARSER_Create(lexer_t *lexer)
 	if (!out)
 		return NULL;
 	out->lexer = lexer;
+	out->chunks = NULL;
+	out->chunk_count = 0;
+	out->batch = PARSER_BATCH_SIZE;
+	out->position = -1;
+	out->filled = 0;
+	out->end = 0;
+	out->mark_count = 0;
 	return out;
 }
 
@@ -36,6 +180,13 @@ int PARSER_Destroy(parser_t *parser)
 	if (!parser)
 		return 1;
 	
+	if (parser->chunks)
+	{
+		int i;
+		for (i = 0; i < parser->chunk_count; i++)
+			LXR_FREE(parser->chunks[i]);
+		LXR_FREE(parser->chunks);
+	}
 	LXR_FREE(parser);
 	return 0;
 }
@@ -44,20 +195,77 @@ int PARSER_Destroy(parser_t *parser)
 // lexer_token_t* PARSER_Next(parser_t *parser)
 // See parser.h
 // ---------------------------------------------------------------
-inline lexer_token_t* PARSER_Next(parser_t *parser)
+lexer_token_t* PARSER_Next(parser_t *parser)
 {
-	return LXR_NextToken(parser->lexer);
+	if (PARSER_Fill(parser, parser->position + 1))
+	{
+		parser->position = parser->filled;
+		return NULL;
+	}
+	parser->position++;
+	return PARSER_SLOT(parser, parser->position);
 } 
 
 // ---------------------------------------------------------------
 // lexer_token_t* PARSER_Current(parser_t *parser)
 // See parser.h
 // ---------------------------------------------------------------
-inline lexer_token_t* PARSER_Current(parser_t *parser)
+lexer_token_t* PARSER_Current(parser_t *parser)
 {
-	return &(parser->lexer->token);
+	if (parser->position < 0 || parser->position >= parser->filled)
+		return &(parser->lexer->token);
+	return PARSER_SLOT(parser, parser->position);
 } 
 
+// ---------------------------------------------------------------
+// lexer_token_t* PARSER_Peek(parser_t *parser, int k)
+// See parser.h
+// ---------------------------------------------------------------
+lexer_token_t* PARSER_Peek(parser_t *parser, int k)
+{
+	long index = parser->position + k;
+	if (k < 0 || index < 0 || PARSER_Fill(parser, index))
+		return NULL;
+	return PARSER_SLOT(parser, index);
+}
+
+// ---------------------------------------------------------------
+// int PARSER_Mark(parser_t *parser)
+// See parser.h
+// ---------------------------------------------------------------
+int PARSER_Mark(parser_t *parser)
+{
+	if (parser->mark_count >= PARSER_MARKS_MAX)
+		return -1;
+	parser->marks[parser->mark_count] = parser->position;
+	return parser->mark_count++;
+}
+
+// ---------------------------------------------------------------
+// int PARSER_Rewind(parser_t *parser, int mark)
+// See parser.h
+// ---------------------------------------------------------------
+int PARSER_Rewind(parser_t *parser, int mark)
+{
+	if (mark < 0 || mark >= parser->mark_count)
+		return 1;
+	parser->position = parser->marks[mark];
+	parser->mark_count = mark;
+	return 0;
+}
+
+// ---------------------------------------------------------------
+// int PARSER_Release(parser_t *parser, int mark)
+// See parser.h
+// ---------------------------------------------------------------
+int PARSER_Release(parser_t *parser, int mark)
+{
+	if (mark < 0 || mark >= parser->mark_count)
+		return 1;
+	parser->mark_count = mark;
+	return 0;
+}
+
 // ---------------------------------------------------------------
 // int PARSER_IsType(parser_t *parser, lexeme_type_t type)
 // See parser.h
@@ -12,14 +12,63 @@
 #include <stdio.h>
 #include "lexer.h"
 
+/**
+ * Default amount of tokens fetched from the lexer at a time.
+ */
+#ifndef PARSER_BATCH_SIZE
+#define PARSER_BATCH_SIZE	32
+#endif
+
+/**
+ * Amount of tokens in each chunk of the token ring buffer (must be a power of two).
+ */
+#ifndef PARSER_CHUNK_SIZE
+#define PARSER_CHUNK_SIZE	32
+#endif
+
+/**
+ * Maximum amount of marks that can be active at once (see PARSER_Mark()).
+ */
+#ifndef PARSER_MARKS_MAX
+#define PARSER_MARKS_MAX	16
+#endif
+
 /**
  * A parser that encloses one lexer.
+ * Tokens are fetched from the lexer in batches and kept in a ring buffer, so that the parser
+ * can look ahead (see PARSER_Peek()) and back up (see PARSER_Mark() and PARSER_Rewind()).
  */
 typedef struct {
 
 	/** Current lexer. */
 	lexer_t *lexer;
 
+	/** 
+	 * Token ring buffer (copies of lexer tokens), in chunks of PARSER_CHUNK_SIZE tokens. 
+	 * It grows if marked or peeked tokens would be overwritten, but chunks are never moved,
+	 * so growing does not invalidate tokens already returned.
+	 */
+	lexer_token_t **chunks;
+	/** Amount of chunks in the token ring buffer (always a power of two). */
+	int chunk_count;
+	/** 
+	 * Amount of tokens fetched from the lexer at a time (at least 1). 
+	 * Streams pushed onto the lexer while parsing are only read after the tokens already fetched,
+	 * so set this to 1 if the parser pushes streams (for includes and the like).
+	 */
+	int batch;
+	/** Index of the current token (-1 before the first call to PARSER_Next()). */
+	long position;
+	/** Index one past the last fetched token. */
+	long filled;
+	/** If nonzero, the lexer has no more tokens. */
+	int end;
+
+	/** Marked token indices, oldest first. */
+	long marks[PARSER_MARKS_MAX];
+	/** Amount of active marks. */
+	int mark_count;
+
 } parser_t;
 
 /**
@@ -33,28 +82,65 @@ parser_t* PARSER_Create(lexer_t *lexer);
 /**
  * Closes a parser.
  * If successful, the pointer is invalidated.
- * The underlying lexer is NOT FREED NOR ALTERED.
+ * The underlying lexer is NOT FREED, but tokens that were fetched from it and not yet parsed are lost.
  * @param parser the parser to destroy.
  * @return 0 if successful and the pointer was invalidated, nonzero if not.
  */
 int PARSER_Destroy(parser_t *parser);
 
 /**
- * Gets the next token from the underlying lexer.
+ * Advances to the next token, fetching more tokens from the underlying lexer if needed.
+ * The returned token stays valid until its place in the token buffer is reused, which is
+ * never before it is behind the current token and every active mark. Looking ahead or fetching
+ * more tokens does not move tokens already returned.
+ * Zero-copy token slices point into the lexer's stream memory, which must remain valid while they are used.
  * @param parser the parser to use.
- * @return the pointer to the next token.
+ * @return the pointer to the next token, or NULL if there are no more tokens.
  * @see lexer.h/LXR_NextToken(lexer_token_t*)
  */
 lexer_token_t* PARSER_Next(parser_t *parser);
 
 /**
- * Gets the current token from the underlying lexer.
+ * Gets the current token.
+ * Before the first call to PARSER_Next(), or after the last token, this is the lexer's own token.
  * @param parser the parser to use.
  * @return the pointer to the current token.
  * @see lexer.h/LXR_NextToken(lexer_token_t*)
  */
 lexer_token_t* PARSER_Current(parser_t *parser);
 
+/**
+ * Looks ahead at an upcoming token without advancing, fetching more tokens from the underlying lexer if needed.
+ * @param parser the parser to use.
+ * @param k how many tokens to look ahead: 0 is the current token, 1 is the next one, and so on.
+ * @return the pointer to the token, or NULL if there is no such token (past the end, before the first token, or out of memory).
+ */
+lexer_token_t* PARSER_Peek(parser_t *parser, int k);
+
+/**
+ * Marks the current position, so that the parser can return to it later with PARSER_Rewind().
+ * Tokens after an active mark are kept in the token buffer until the mark is released.
+ * @param parser the parser to use.
+ * @return the mark, or -1 if there are already PARSER_MARKS_MAX active marks.
+ */
+int PARSER_Mark(parser_t *parser);
+
+/**
+ * Returns to a marked position. The mark and all marks made after it are released.
+ * @param parser the parser to use.
+ * @param mark the mark from PARSER_Mark().
+ * @return 0 if successful, nonzero if the mark is not active.
+ */
+int PARSER_Rewind(parser_t *parser, int mark);
+
+/**
+ * Releases a mark without returning to it. All marks made after it are released as well.
+ * @param parser the parser to use.
+ * @param mark the mark from PARSER_Mark().
+ * @return 0 if successful, nonzero if the mark is not active.
+ */
+int PARSER_Release(parser_t *parser, int mark);
+
 /**
  * Checks if the current lexeme type on the current token is the provided type.
  * @param type the type to check.
@@ -0,0 +1,166 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mt_config.h"
+#include "mt_arena.h"
+
+// ===========================================================================
+// Common Private Functions
+// ===========================================================================
+
+// Rounds a size up to the arena alignment.
+#define MT_ARENA_ROUND(s) (((s) + (MT_ARENA_ALIGN - 1)) & ~((size_t)MT_ARENA_ALIGN - 1))
+
+// Size of a chunk header, with padding so that chunk memory is aligned.
+#define MT_ARENA_HEADER MT_ARENA_ROUND(sizeof(mt_arena_chunk_t))
+
+// Gets a chunk's memory.
+#define MT_ARENA_DATA(c) ((unsigned char*)(c) + MT_ARENA_HEADER)
+
+static mt_arena_chunk_t* _newchunk(size_t size)
+{
+	mt_arena_chunk_t *out = (mt_arena_chunk_t*)MTS_MALLOC(MT_ARENA_HEADER + size);
+	if (!out)
+		return NULL;
+	out->next = NULL;
+	out->size = size;
+	return out;
+}
+
+// Allocates when the current chunk is full.
+static void* _allocslow(mt_arena_t *arena, size_t size)
+{
+	mt_arena_chunk_t *chunk;
+
+	// big allocations get their own chunk behind the current one, so it can still be filled.
+	if (size > arena->chunk_size / 4)
+	{
+		if (!(chunk = _newchunk(size)))
+			return NULL;
+		if (arena->chunks)
+		{
+			chunk->next = arena->chunks->next;
+			arena->chunks->next = chunk;
+		}
+		else
+		{
+			arena->chunks = chunk;
+			arena->next = arena->end = MT_ARENA_DATA(chunk) + size;
+		}
+		arena->used += size;
+		return MT_ARENA_DATA(chunk);
+	}
+
+	if (!(chunk = _newchunk(arena->chunk_size)))
+		return NULL;
+	chunk->next = arena->chunks;
+	arena->chunks = chunk;
+	arena->next = MT_ARENA_DATA(chunk) + size;
+	arena->end = MT_ARENA_DATA(chunk) + chunk->size;
+	arena->used += size;
+	return MT_ARENA_DATA(chunk);
+}
+
+// ===========================================================================
+// Public Functions
+// ===========================================================================
+
+// See mt_arena.h
+mt_arena_t* MT_ArenaCreate(size_t chunk_size)
+{
+	mt_arena_t *out = (mt_arena_t*)MTS_MALLOC(sizeof(mt_arena_t));
+	if (!out)
+		return NULL;
+
+	out->chunks = NULL;
+	out->next = NULL;
+	out->end = NULL;
+	out->chunk_size = MT_ARENA_ROUND(chunk_size ? chunk_size : MT_ARENA_CHUNK_SIZE);
+	out->used = 0;
+	return out;
+}
+
+// See mt_arena.h
+void MT_ArenaDestroy(mt_arena_t *arena)
+{
+	mt_arena_chunk_t *chunk, *next;
+	for (chunk = arena->chunks; chunk; chunk = next)
+	{
+		next = chunk->next;
+		MTS_FREE(chunk);
+	}
+	MTS_FREE(arena);
+}
+
+// See mt_arena.h
+void MT_ArenaReset(mt_arena_t *arena)
+{
+	mt_arena_chunk_t *chunk, *next, *keep = NULL;
+	for (chunk = arena->chunks; chunk; chunk = next)
+	{
+		next = chunk->next;
+		if (!keep && chunk->size == arena->chunk_size)
+			keep = chunk;
+		else
+			MTS_FREE(chunk);
+	}
+
+	arena->chunks = keep;
+	if (keep)
+	{
+		keep->next = NULL;
+		arena->next = MT_ARENA_DATA(keep);
+		arena->end = MT_ARENA_DATA(keep) + keep->size;
+	}
+	else
+	{
+		arena->next = NULL;
+		arena->end = NULL;
+	}
+	arena->used = 0;
+}
+
+// See mt_arena.h
+void* MT_ArenaAlloc(mt_arena_t *arena, size_t size)
+{
+	void *out;
+	size = MT_ARENA_ROUND(size ? size : 1);
+	if ((size_t)(arena->end - arena->next) < size)
+		return _allocslow(arena, size);
+
+	out = arena->next;
+	arena->next += size;
+	arena->used += size;
+	return out;
+}
+
+// See mt_arena.h
+void* MT_ArenaCalloc(mt_arena_t *arena, size_t n, size_t size)
+{
+	void *out;
+	if (size && n > ((size_t)-1) / size)
+		return NULL;
+	if ((out = MT_ArenaAlloc(arena, n * size)))
+		memset(out, 0, n * size);
+	return out;
+}
+
+// See mt_arena.h
+char* MT_ArenaStrndup(mt_arena_t *arena, const char *s, size_t length)
+{
+	char *out = (char*)MT_ArenaAlloc(arena, length + 1);
+	if (!out)
+		return NULL;
+	memcpy(out, s, length);
+	out[length] = '\0';
+	return out;
+}
@@ -0,0 +1,112 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#ifndef __MT_ARENA_H__
+#define __MT_ARENA_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Alignment of every arena allocation, in bytes. */
+#ifndef MT_ARENA_ALIGN
+#define MT_ARENA_ALIGN			16
+#endif
+
+/** Default arena chunk size, in bytes. */
+#ifndef MT_ARENA_CHUNK_SIZE
+#define MT_ARENA_CHUNK_SIZE		65536
+#endif
+
+/** Arena chunk. The chunk's memory follows this header. */
+typedef struct mt_arena_chunk_s
+{
+	/** Next (older) chunk. */
+	struct mt_arena_chunk_s *next;
+	/** Usable size in bytes. */
+	size_t size;
+
+} mt_arena_chunk_t;
+
+/**
+ * Arena object type.
+ * Memory is allocated by bumping a pointer through large chunks, and is only freed all at once.
+ */
+typedef struct
+{
+	/** Chunks, current first. */
+	mt_arena_chunk_t *chunks;
+	/** Next free byte in the current chunk. */
+	unsigned char *next;
+	/** End of the current chunk. */
+	unsigned char *end;
+	/** Size of new chunks. */
+	size_t chunk_size;
+	/** Bytes allocated from the arena since it was created or reset (including alignment padding). */
+	size_t used;
+
+} mt_arena_t;
+
+/**
+ * Creates an arena.
+ * No chunks are allocated until the first allocation.
+ * @param chunk_size the size of each chunk in bytes (0 for MT_ARENA_CHUNK_SIZE).
+ *		Allocations larger than a quarter of this get a chunk of their own.
+ * @return a pointer to the new arena, or NULL if not allocated.
+ */
+mt_arena_t* MT_ArenaCreate(size_t chunk_size);
+
+/**
+ * Frees an arena and everything allocated from it.
+ * @param arena the pointer to the arena object.
+ */
+void MT_ArenaDestroy(mt_arena_t *arena);
+
+/**
+ * Frees everything allocated from an arena, keeping one chunk for reuse.
+ * All pointers allocated from the arena are invalidated.
+ * @param arena the pointer to the arena object.
+ */
+void MT_ArenaReset(mt_arena_t *arena);
+
+/**
+ * Allocates memory from an arena, aligned to MT_ARENA_ALIGN bytes.
+ * The memory is NOT cleared.
+ * @param arena the pointer to the arena object.
+ * @param size the amount of bytes to allocate.
+ * @return a pointer to the memory, or NULL if out of memory.
+ */
+void* MT_ArenaAlloc(mt_arena_t *arena, size_t size);
+
+/**
+ * Allocates cleared memory from an arena, aligned to MT_ARENA_ALIGN bytes.
+ * @param arena the pointer to the arena object.
+ * @param n the amount of elements.
+ * @param size the size of each element in bytes.
+ * @return a pointer to the memory, or NULL if out of memory.
+ */
+void* MT_ArenaCalloc(mt_arena_t *arena, size_t n, size_t size);
+
+/**
+ * Copies a string into an arena.
+ * @param arena the pointer to the arena object.
+ * @param s the string to copy (need not be null-terminated).
+ * @param length the length of the string in bytes.
+ * @return a pointer to the null-terminated copy, or NULL if out of memory.
+ */
+char* MT_ArenaStrndup(mt_arena_t *arena, const char *s, size_t length);
+
+/**
+ * Copies a null-terminated string into an arena.
+ * @param arena the pointer to the arena object.
+ * @param s the string to copy.
+ * @return a pointer to the copy, or NULL if out of memory.
+ */
+#define MT_ArenaStrdup(a,s) MT_ArenaStrndup((a),(s),strlen((s)))
+
+#endif
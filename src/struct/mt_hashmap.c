@@ -0,0 +1,263 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mt_config.h"
+#include "mt_hashmap.h"
+
+// ===========================================================================
+// Common Private Functions
+// ===========================================================================
+
+// Marks slots of removed keys, so that probing continues past them.
+static char _removedslot;
+#define MT_HASHMAP_REMOVED ((void*)&_removedslot)
+
+// Slot count for an amount of mappings, keeping the table at most 3/4 full.
+static int _slotsfor(int count)
+{
+	int slots = 16;
+	while (slots / 4 * 3 < count)
+		slots <<= 1;
+	return slots;
+}
+
+// Gets the first slot for a hash.
+static int _home(uint32_t hash, int capacity)
+{
+	return (int)((hash ^ (hash >> 16)) & (uint32_t)(capacity - 1));
+}
+
+// Finds the slot of a key, or -1 if none.
+static int _find(mt_hashmap_t *map, void *key)
+{
+	int mask = map->capacity - 1;
+	int i = _home((*map->hashfunc)(key), map->capacity);
+	void *k;
+	while ((k = map->keys[i]))
+	{
+		if (k != MT_HASHMAP_REMOVED && (*map->equalfunc)(k, key))
+			return i;
+		i = (i + 1) & mask;
+	}
+	return -1;
+}
+
+// Puts a mapping into the first free slot of its probe sequence. Assumes the key is not in the map.
+static void _put(mt_hashmap_t *map, void *key, void *value, uint32_t hash)
+{
+	int mask = map->capacity - 1;
+	int i = _home(hash, map->capacity);
+	while (map->keys[i] && map->keys[i] != MT_HASHMAP_REMOVED)
+		i = (i + 1) & mask;
+	if (map->keys[i] == MT_HASHMAP_REMOVED)
+		map->removed--;
+	map->keys[i] = key;
+	map->values[i] = value;
+	map->size++;
+}
+
+// Rebuilds the table with a new slot count, dropping removed slots. Returns 0 if out of memory.
+static int _rehash(mt_hashmap_t *map, int capacity)
+{
+	int i, oldcapacity = map->capacity;
+	void **oldkeys = map->keys;
+	void **oldvalues = map->values;
+	void **newkeys, **newvalues;
+
+	if (!(newkeys = (void**)MTS_CALLOC(capacity, sizeof(void*))))
+		return 0;
+	if (!(newvalues = (void**)MTS_MALLOC(capacity * sizeof(void*))))
+	{
+		MTS_FREE(newkeys);
+		return 0;
+	}
+
+	map->keys = newkeys;
+	map->values = newvalues;
+	map->capacity = capacity;
+	map->size = 0;
+	map->removed = 0;
+	for (i = 0; i < oldcapacity; i++)
+		if (oldkeys[i] && oldkeys[i] != MT_HASHMAP_REMOVED)
+			_put(map, oldkeys[i], oldvalues[i], (*map->hashfunc)(oldkeys[i]));
+
+	MTS_FREE(oldkeys);
+	MTS_FREE(oldvalues);
+	return 1;
+}
+
+// Makes room for one more mapping. Returns 0 if out of memory.
+static int _canadd(mt_hashmap_t *map)
+{
+	if (map->size + map->removed + 1 <= map->capacity / 4 * 3)
+		return 1;
+	// just drop removed slots if that makes enough room.
+	return _rehash(map, map->size + 1 <= map->capacity / 4 * 3 ? map->capacity : map->capacity * 2);
+}
+
+// ===========================================================================
+// Public Functions
+// ===========================================================================
+
+// See mt_hashmap.h
+mt_hashmap_t* MT_HashMapCreate(int capacity, uint32_t (*hashfunc)(void*), int (*equalfunc)(void*, void*))
+{
+	mt_hashmap_t *out = (mt_hashmap_t*)MTS_MALLOC(sizeof(mt_hashmap_t));
+	if (!out)
+		return NULL;
+
+	out->capacity = _slotsfor(capacity);
+	out->keys = (void**)MTS_CALLOC(out->capacity, sizeof(void*));
+	out->values = (void**)MTS_MALLOC(out->capacity * sizeof(void*));
+	if (!out->keys || !out->values)
+	{
+		MTS_FREE(out->keys);
+		MTS_FREE(out->values);
+		MTS_FREE(out);
+		return NULL;
+	}
+	out->hashfunc = hashfunc;
+	out->equalfunc = equalfunc;
+	out->size = 0;
+	out->removed = 0;
+	return out;
+}
+
+// See mt_hashmap.h
+void MT_HashMapDestroy(mt_hashmap_t *map)
+{
+	MTS_FREE(map->keys);
+	MTS_FREE(map->values);
+	MTS_FREE(map);
+}
+
+// See mt_hashmap.h
+void MT_HashMapClear(mt_hashmap_t *map)
+{
+	memset(map->keys, 0, sizeof(void*) * map->capacity);
+	map->size = 0;
+	map->removed = 0;
+}
+
+// See mt_hashmap.h
+inline int MT_HashMapLength(mt_hashmap_t *map)
+{
+	return map->size;
+}
+
+// See mt_hashmap.h
+int MT_HashMapReserve(mt_hashmap_t *map, int count)
+{
+	if (count + map->removed <= map->capacity / 4 * 3)
+		return 1;
+	return _rehash(map, _slotsfor(count > map->size ? count : map->size));
+}
+
+// See mt_hashmap.h
+int MT_HashMapPut(mt_hashmap_t *map, void *key, void *value)
+{
+	int i;
+	if (!key)
+		return -1;
+	if ((i = _find(map, key)) >= 0)
+	{
+		map->values[i] = value;
+		return 0;
+	}
+	if (!_canadd(map))
+		return -1;
+	_put(map, key, value, (*map->hashfunc)(key));
+	return 1;
+}
+
+// See mt_hashmap.h
+int MT_HashMapPutAll(mt_hashmap_t *map, void **keys, void **values, int count)
+{
+	int i, r, added = 0;
+	if (!MT_HashMapReserve(map, map->size + count))
+		return -1;
+	for (i = 0; i < count; i++)
+	{
+		if ((r = MT_HashMapPut(map, keys[i], values[i])) < 0)
+			return -1;
+		added += r;
+	}
+	return added;
+}
+
+// See mt_hashmap.h
+void* MT_HashMapRemove(mt_hashmap_t *map, void *key)
+{
+	int i;
+	void *out;
+	if ((i = _find(map, key)) < 0)
+		return NULL;
+
+	out = map->values[i];
+	// a slot followed by an empty one ends every probe sequence through it, so it can be emptied.
+	if (!map->keys[(i + 1) & (map->capacity - 1)])
+		map->keys[i] = NULL;
+	else
+	{
+		map->keys[i] = MT_HASHMAP_REMOVED;
+		map->removed++;
+	}
+	map->size--;
+	return out;
+}
+
+// See mt_hashmap.h
+void* MT_HashMapGet(mt_hashmap_t *map, void *key)
+{
+	int i = _find(map, key);
+	return i >= 0 ? map->values[i] : NULL;
+}
+
+// See mt_hashmap.h
+int MT_HashMapFind(mt_hashmap_t *map, void *key, void **value)
+{
+	int i = _find(map, key);
+	if (i < 0)
+		return 0;
+	*value = map->values[i];
+	return 1;
+}
+
+// See mt_hashmap.h
+void* MT_HashMapGetKey(mt_hashmap_t *map, void *key)
+{
+	int i = _find(map, key);
+	return i >= 0 ? map->keys[i] : NULL;
+}
+
+// See mt_hashmap.h
+inline int MT_HashMapContainsKey(mt_hashmap_t *map, void *key)
+{
+	return _find(map, key) >= 0 ? 1 : 0;
+}
+
+// See mt_hashmap.h
+int MT_HashMapNext(mt_hashmap_t *map, int *position, void **key, void **value)
+{
+	while (*position < map->capacity)
+	{
+		int i = (*position)++;
+		if (map->keys[i] && map->keys[i] != MT_HASHMAP_REMOVED)
+		{
+			*key = map->keys[i];
+			if (value)
+				*value = map->values[i];
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,148 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#ifndef __MT_HASHMAP_H__
+#define __MT_HASHMAP_H__
+
+#include <stdint.h>
+#include "mt_hashset.h"
+
+/** Hash map object type. */
+typedef struct
+{
+	/** Pointer to key hashing function. */
+	uint32_t (*hashfunc)(void*);
+	/** Pointer to key equality function (nonzero if equal). */
+	int (*equalfunc)(void*, void*);
+	/** Key slots (open addressing): NULL if empty. */
+	void **keys;
+	/** Values, parallel to the key slots. */
+	void **values;
+	/** Slot count (power of two). */
+	int capacity;
+	/** Amount of mappings. */
+	int size;
+	/** Amount of slots holding removed keys. */
+	int removed;
+
+} mt_hashmap_t;
+
+/**
+ * Creates a hash map object.
+ * This can dynamically grow in size if need be, and memory is avaliable to do so.
+ * NULL keys cannot be added. Values may be anything (including NULL).
+ * The hashing and equality functions in mt_hashset.h can be used here.
+ * @param capacity the expected amount of mappings.
+ * @param hashfunc the key hashing function.
+ * @param equalfunc the key equality function - returns nonzero if both keys are equal.
+ * @return a pointer to the new map, or NULL if not allocated.
+ */
+mt_hashmap_t* MT_HashMapCreate(int capacity, uint32_t (*hashfunc)(void*), int (*equalfunc)(void*, void*));
+
+/**
+ * Frees the contents of a hash map object.
+ * DOES NOT FREE THE CONTAINED KEYS OR VALUES.
+ * @param map the pointer to the map object.
+ */
+void MT_HashMapDestroy(mt_hashmap_t *map);
+
+/**
+ * Clears the contents of a hash map object.
+ * This removes all mappings.
+ * @param map the pointer to the map object.
+ */
+void MT_HashMapClear(mt_hashmap_t *map);
+
+/**
+ * Returns amount of mappings in the map.
+ * @param map the pointer to the map object.
+ * @return the amount of mappings in the map.
+ */
+int MT_HashMapLength(mt_hashmap_t *map);
+
+/**
+ * Makes room for an amount of mappings, so that adding up to that many does not rehash the map.
+ * @param map the pointer to the map object.
+ * @param count the total amount of mappings to make room for.
+ * @return 1 if successful, 0 if out of memory.
+ */
+int MT_HashMapReserve(mt_hashmap_t *map, int count);
+
+/**
+ * Maps a key to a value, replacing the value of an equal key if there is one.
+ * The map keeps the key instance that was added first.
+ * @param map the pointer to the map object.
+ * @param key the key.
+ * @param value the value.
+ * @return 1 if the key was added, 0 if its value was replaced, or -1 if out of memory.
+ */
+int MT_HashMapPut(mt_hashmap_t *map, void *key, void *value);
+
+/**
+ * Maps many keys to values, reserving room for all of them first.
+ * @param map the pointer to the map object.
+ * @param keys the keys.
+ * @param values the values, parallel to the keys.
+ * @param count the amount of keys.
+ * @return the amount of keys added, or -1 if out of memory.
+ */
+int MT_HashMapPutAll(mt_hashmap_t *map, void **keys, void **values, int count);
+
+/**
+ * Removes a mapping (if exist).
+ * @param map the map object.
+ * @param key the key to remove.
+ * @return the value that was mapped to the key, or NULL if no match.
+ */
+void* MT_HashMapRemove(mt_hashmap_t *map, void *key);
+
+/**
+ * Gets the value mapped to a key.
+ * @param map the map object.
+ * @param key the key to look for.
+ * @return the value, or NULL if no match (use MT_HashMapFind if NULL values are mapped).
+ */
+void* MT_HashMapGet(mt_hashmap_t *map, void *key);
+
+/**
+ * Gets the value mapped to a key, telling a NULL value apart from a missing key.
+ * @param map the map object.
+ * @param key the key to look for.
+ * @param value output for the value (not changed if no match).
+ * @return 1 if found, 0 if not.
+ */
+int MT_HashMapFind(mt_hashmap_t *map, void *key, void **value);
+
+/**
+ * Gets the key instance in the map equal to a key.
+ * @param map the map object.
+ * @param key the key to look for.
+ * @return the key in the map, or NULL if no match.
+ */
+void* MT_HashMapGetKey(mt_hashmap_t *map, void *key);
+
+/**
+ * Checks if a key is in the map.
+ * @param map the map object.
+ * @param key the key to check for.
+ * @return 1 if so, 0 if not.
+ */
+int MT_HashMapContainsKey(mt_hashmap_t *map, void *key);
+
+/**
+ * Iterates through the mappings in the map, in no particular order.
+ * The map must not be changed while iterating.
+ * @param map the map object.
+ * @param position the iteration position - set to 0 before the first call.
+ * @param key output for the next key.
+ * @param value output for the next value (can be NULL).
+ * @return 1 if a mapping was returned, 0 if no more mappings.
+ */
+int MT_HashMapNext(mt_hashmap_t *map, int *position, void **key, void **value);
+
+#endif
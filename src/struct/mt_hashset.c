@@ -0,0 +1,278 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "mt_config.h"
+#include "mt_hashset.h"
+
+// ===========================================================================
+// Common Private Functions
+// ===========================================================================
+
+// Marks slots of removed refs, so that probing continues past them.
+static char _removedslot;
+#define MT_HASHSET_REMOVED ((void*)&_removedslot)
+
+// Slot count for an amount of refs, keeping the table at most 3/4 full.
+static int _slotsfor(int count)
+{
+	int slots = 16;
+	while (slots / 4 * 3 < count)
+		slots <<= 1;
+	return slots;
+}
+
+// Gets the first slot for a hash.
+static int _home(uint32_t hash, int capacity)
+{
+	return (int)((hash ^ (hash >> 16)) & (uint32_t)(capacity - 1));
+}
+
+// Finds the slot of a ref equal to a value, or -1 if none.
+static int _find(mt_hashset_t *set, void *value)
+{
+	int mask = set->capacity - 1;
+	int i = _home((*set->hashfunc)(value), set->capacity);
+	void *item;
+	while ((item = set->items[i]))
+	{
+		if (item != MT_HASHSET_REMOVED && (*set->equalfunc)(item, value))
+			return i;
+		i = (i + 1) & mask;
+	}
+	return -1;
+}
+
+// Puts a ref into the first free slot of its probe sequence. Assumes the ref is not in the set.
+static void _put(mt_hashset_t *set, void *value, uint32_t hash)
+{
+	int mask = set->capacity - 1;
+	int i = _home(hash, set->capacity);
+	while (set->items[i] && set->items[i] != MT_HASHSET_REMOVED)
+		i = (i + 1) & mask;
+	if (set->items[i] == MT_HASHSET_REMOVED)
+		set->removed--;
+	set->items[i] = value;
+	set->size++;
+}
+
+// Rebuilds the table with a new slot count, dropping removed slots. Returns 0 if out of memory.
+static int _rehash(mt_hashset_t *set, int capacity)
+{
+	int i, oldcapacity = set->capacity;
+	void **old = set->items;
+	void **newitems = (void**)MTS_CALLOC(capacity, sizeof(void*));
+	if (!newitems)
+		return 0;
+
+	set->items = newitems;
+	set->capacity = capacity;
+	set->size = 0;
+	set->removed = 0;
+	for (i = 0; i < oldcapacity; i++)
+		if (old[i] && old[i] != MT_HASHSET_REMOVED)
+			_put(set, old[i], (*set->hashfunc)(old[i]));
+
+	MTS_FREE(old);
+	return 1;
+}
+
+// Makes room for one more ref. Returns 0 if out of memory.
+static int _canadd(mt_hashset_t *set)
+{
+	if (set->size + set->removed + 1 <= set->capacity / 4 * 3)
+		return 1;
+	// just drop removed slots if that makes enough room.
+	return _rehash(set, set->size + 1 <= set->capacity / 4 * 3 ? set->capacity : set->capacity * 2);
+}
+
+// ===========================================================================
+// Public Functions
+// ===========================================================================
+
+// See mt_hashset.h
+mt_hashset_t* MT_HashSetCreate(int capacity, uint32_t (*hashfunc)(void*), int (*equalfunc)(void*, void*))
+{
+	mt_hashset_t *out = (mt_hashset_t*)MTS_MALLOC(sizeof(mt_hashset_t));
+	if (!out)
+		return NULL;
+
+	out->capacity = _slotsfor(capacity);
+	out->items = (void**)MTS_CALLOC(out->capacity, sizeof(void*));
+	if (!out->items)
+	{
+		MTS_FREE(out);
+		return NULL;
+	}
+	out->hashfunc = hashfunc;
+	out->equalfunc = equalfunc;
+	out->size = 0;
+	out->removed = 0;
+	return out;
+}
+
+// See mt_hashset.h
+void MT_HashSetDestroy(mt_hashset_t *set)
+{
+	MTS_FREE(set->items);
+	MTS_FREE(set);
+}
+
+// See mt_hashset.h
+void MT_HashSetClear(mt_hashset_t *set)
+{
+	memset(set->items, 0, sizeof(void*) * set->capacity);
+	set->size = 0;
+	set->removed = 0;
+}
+
+// See mt_hashset.h
+inline int MT_HashSetLength(mt_hashset_t *set)
+{
+	return set->size;
+}
+
+// See mt_hashset.h
+int MT_HashSetReserve(mt_hashset_t *set, int count)
+{
+	if (count + set->removed <= set->capacity / 4 * 3)
+		return 1;
+	return _rehash(set, _slotsfor(count > set->size ? count : set->size));
+}
+
+// See mt_hashset.h
+int MT_HashSetAdd(mt_hashset_t *set, void *value)
+{
+	if (!value || _find(set, value) >= 0)
+		return 0;
+	if (!_canadd(set))
+		return 0;
+	_put(set, value, (*set->hashfunc)(value));
+	return 1;
+}
+
+// See mt_hashset.h
+int MT_HashSetAddAll(mt_hashset_t *set, void **values, int count)
+{
+	int i, added = 0;
+	MT_HashSetReserve(set, set->size + count);
+	for (i = 0; i < count; i++)
+		added += MT_HashSetAdd(set, values[i]);
+	return added;
+}
+
+// See mt_hashset.h
+void* MT_HashSetRemove(mt_hashset_t *set, void *value)
+{
+	int i;
+	void *out;
+	if ((i = _find(set, value)) < 0)
+		return NULL;
+
+	out = set->items[i];
+	// a slot followed by an empty one ends every probe sequence through it, so it can be emptied.
+	if (!set->items[(i + 1) & (set->capacity - 1)])
+		set->items[i] = NULL;
+	else
+	{
+		set->items[i] = MT_HASHSET_REMOVED;
+		set->removed++;
+	}
+	set->size--;
+	return out;
+}
+
+// See mt_hashset.h
+void* MT_HashSetGet(mt_hashset_t *set, void *value)
+{
+	int i = _find(set, value);
+	return i >= 0 ? set->items[i] : NULL;
+}
+
+// See mt_hashset.h
+inline int MT_HashSetContains(mt_hashset_t *set, void *value)
+{
+	return _find(set, value) >= 0 ? 1 : 0;
+}
+
+// See mt_hashset.h
+void* MT_HashSetNext(mt_hashset_t *set, int *position)
+{
+	while (*position < set->capacity)
+	{
+		void *item = set->items[(*position)++];
+		if (item && item != MT_HASHSET_REMOVED)
+			return item;
+	}
+	return NULL;
+}
+
+// See mt_hashset.h
+uint32_t MT_HashString(void *value)
+{
+	const unsigned char *s = (const unsigned char*)value;
+	uint32_t h = 2166136261u;
+	while (*s)
+	{
+		h ^= *s++;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+// See mt_hashset.h
+uint32_t MT_HashStringCI(void *value)
+{
+	const unsigned char *s = (const unsigned char*)value;
+	uint32_t h = 2166136261u;
+	while (*s)
+	{
+		h ^= (unsigned char)tolower(*s++);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+// See mt_hashset.h
+int MT_EqualString(void *a, void *b)
+{
+	return strcmp((const char*)a, (const char*)b) == 0;
+}
+
+// See mt_hashset.h
+int MT_EqualStringCI(void *a, void *b)
+{
+	const unsigned char *sa = (const unsigned char*)a;
+	const unsigned char *sb = (const unsigned char*)b;
+	while (*sa && tolower(*sa) == tolower(*sb))
+	{
+		sa++;
+		sb++;
+	}
+	return tolower(*sa) == tolower(*sb);
+}
+
+// See mt_hashset.h
+uint32_t MT_HashPointer(void *value)
+{
+	uint64_t h = (uint64_t)(uintptr_t)value;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	return (uint32_t)h;
+}
+
+// See mt_hashset.h
+int MT_EqualPointer(void *a, void *b)
+{
+	return a == b;
+}
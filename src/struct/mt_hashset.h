@@ -0,0 +1,170 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#ifndef __MT_HASHSET_H__
+#define __MT_HASHSET_H__
+
+#include <stdint.h>
+
+/** Hash set object type. */
+typedef struct
+{
+	/** Pointer to hashing function. */
+	uint32_t (*hashfunc)(void*);
+	/** Pointer to equality function (nonzero if equal). */
+	int (*equalfunc)(void*, void*);
+	/** Slots (open addressing): NULL if empty. */
+	void **items;
+	/** Slot count (power of two). */
+	int capacity;
+	/** Set length. */
+	int size;
+	/** Amount of slots holding removed refs. */
+	int removed;
+
+} mt_hashset_t;
+
+/**
+ * Creates a hash set object.
+ * This can dynamically grow in size if need be, and memory is avaliable to do so.
+ * NULL refs cannot be added.
+ * @param capacity the expected amount of refs.
+ * @param hashfunc the hashing function.
+ * @param equalfunc the equality function - returns nonzero if both refs are equal.
+ * @return a pointer to the new set, or NULL if not allocated.
+ */
+mt_hashset_t* MT_HashSetCreate(int capacity, uint32_t (*hashfunc)(void*), int (*equalfunc)(void*, void*));
+
+/**
+ * Frees the contents of a hash set object.
+ * DOES NOT FREE THE CONTAINED OBJECTS.
+ * @param set the pointer to the set object.
+ */
+void MT_HashSetDestroy(mt_hashset_t *set);
+
+/**
+ * Clears the contents of a hash set object.
+ * This removes all refs.
+ * @param set the pointer to the set object.
+ */
+void MT_HashSetClear(mt_hashset_t *set);
+
+/**
+ * Returns amount of refs in the set.
+ * @param set the pointer to the set object.
+ * @return the amount of refs in the set.
+ */
+int MT_HashSetLength(mt_hashset_t *set);
+
+/**
+ * Makes room for an amount of refs, so that adding up to that many does not rehash the set.
+ * @param set the pointer to the set object.
+ * @param count the total amount of refs to make room for.
+ * @return 1 if successful, 0 if out of memory.
+ */
+int MT_HashSetReserve(mt_hashset_t *set, int count);
+
+/**
+ * Adds a ref (if not exist).
+ * @param set the pointer to the set object.
+ * @param value the reference to add.
+ * @return 1 if added, 0 if not.
+ */
+int MT_HashSetAdd(mt_hashset_t *set, void *value);
+
+/**
+ * Adds many refs (those that do not exist), reserving room for all of them first.
+ * @param set the pointer to the set object.
+ * @param values the references to add.
+ * @param count the amount of references.
+ * @return the amount of refs added.
+ */
+int MT_HashSetAddAll(mt_hashset_t *set, void **values, int count);
+
+/**
+ * Removes a ref (if exist).
+ * @param set the set object.
+ * @param value the reference to remove.
+ * @return a pointer to the instance actually removed, or NULL if no match.
+ */
+void* MT_HashSetRemove(mt_hashset_t *set, void *value);
+
+/**
+ * Finds the ref in the set equal to a value.
+ * @param set the set object.
+ * @param value the value to look for.
+ * @return a pointer to the instance in the set, or NULL if no match.
+ */
+void* MT_HashSetGet(mt_hashset_t *set, void *value);
+
+/**
+ * Checks if a ref is in the set.
+ * @param set the set object.
+ * @param value the value to check for.
+ * @return 1 if so, 0 if not.
+ */
+int MT_HashSetContains(mt_hashset_t *set, void *value);
+
+/**
+ * Iterates through the refs in the set, in no particular order.
+ * The set must not be changed while iterating.
+ * @param set the set object.
+ * @param position the iteration position - set to 0 before the first call.
+ * @return the next ref, or NULL if no more refs.
+ */
+void* MT_HashSetNext(mt_hashset_t *set, int *position);
+
+/**
+ * Hashes a null-terminated string (FNV-1a).
+ * Suitable as a hashing function for sets of char*.
+ * @param value the string.
+ * @return the hash.
+ */
+uint32_t MT_HashString(void *value);
+
+/**
+ * Hashes a null-terminated string, ignoring ASCII case (FNV-1a).
+ * Suitable as a hashing function for sets of char*, with MT_EqualStringCI.
+ * @param value the string.
+ * @return the hash.
+ */
+uint32_t MT_HashStringCI(void *value);
+
+/**
+ * Compares two null-terminated strings for equality.
+ * @param a the first string.
+ * @param b the second string.
+ * @return 1 if equal, 0 if not.
+ */
+int MT_EqualString(void *a, void *b);
+
+/**
+ * Compares two null-terminated strings for equality, ignoring ASCII case.
+ * @param a the first string.
+ * @param b the second string.
+ * @return 1 if equal, 0 if not.
+ */
+int MT_EqualStringCI(void *a, void *b);
+
+/**
+ * Hashes a pointer by its address.
+ * Suitable as a hashing function for sets of refs compared by identity, with MT_EqualPointer.
+ * @param value the pointer.
+ * @return the hash.
+ */
+uint32_t MT_HashPointer(void *value);
+
+/**
+ * Compares two pointers by address.
+ * @param a the first pointer.
+ * @param b the second pointer.
+ * @return 1 if equal, 0 if not.
+ */
+int MT_EqualPointer(void *a, void *b);
+
+#endif
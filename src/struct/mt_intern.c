@@ -0,0 +1,135 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mt_config.h"
+#include "mt_intern.h"
+
+// ===========================================================================
+// Common Private Functions
+// ===========================================================================
+
+// FNV-1a hash.
+static uint32_t _hash(const char *s, int length)
+{
+	uint32_t h = 2166136261u;
+	while (length--)
+	{
+		h ^= (unsigned char)*s++;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+// Finds the slot for a string: its entry, or the empty slot where it goes.
+static mt_intern_entry_t* _slot(mt_intern_t *intern, const char *s, int length, uint32_t hash)
+{
+	int mask = intern->capacity - 1;
+	int i = hash & mask;
+	mt_intern_entry_t *entry;
+	while ((entry = &(intern->entries[i]))->string)
+	{
+		if (entry->hash == hash && entry->length == length && memcmp(entry->string, s, length) == 0)
+			return entry;
+		i = (i + 1) & mask;
+	}
+	return entry;
+}
+
+// Doubles the slot count. Returns 0 if out of memory.
+static int _expand(mt_intern_t *intern)
+{
+	int i, oldcapacity = intern->capacity;
+	mt_intern_entry_t *old = intern->entries;
+	mt_intern_entry_t *newentries = (mt_intern_entry_t*)MTS_CALLOC(oldcapacity * 2, sizeof(mt_intern_entry_t));
+	if (!newentries)
+		return 0;
+
+	intern->entries = newentries;
+	intern->capacity = oldcapacity * 2;
+	for (i = 0; i < oldcapacity; i++)
+		if (old[i].string)
+			*_slot(intern, old[i].string, old[i].length, old[i].hash) = old[i];
+
+	MTS_FREE(old);
+	return 1;
+}
+
+// ===========================================================================
+// Public Functions
+// ===========================================================================
+
+// See mt_intern.h
+mt_intern_t* MT_InternCreate(mt_arena_t *arena, int capacity)
+{
+	int slots = 16;
+	mt_intern_t *out = (mt_intern_t*)MTS_MALLOC(sizeof(mt_intern_t));
+	if (!out)
+		return NULL;
+
+	// keep the table at most half full.
+	while (slots < capacity * 2)
+		slots <<= 1;
+
+	out->entries = (mt_intern_entry_t*)MTS_CALLOC(slots, sizeof(mt_intern_entry_t));
+	if (!out->entries)
+	{
+		MTS_FREE(out);
+		return NULL;
+	}
+	out->arena = arena;
+	out->capacity = slots;
+	out->size = 0;
+	return out;
+}
+
+// See mt_intern.h
+void MT_InternDestroy(mt_intern_t *intern)
+{
+	MTS_FREE(intern->entries);
+	MTS_FREE(intern);
+}
+
+// See mt_intern.h
+void MT_InternClear(mt_intern_t *intern)
+{
+	memset(intern->entries, 0, sizeof(mt_intern_entry_t) * intern->capacity);
+	intern->size = 0;
+}
+
+// See mt_intern.h
+const char* MT_Intern(mt_intern_t *intern, const char *s, int length)
+{
+	uint32_t hash = _hash(s, length);
+	mt_intern_entry_t *entry = _slot(intern, s, length, hash);
+	if (entry->string)
+		return entry->string;
+
+	if ((intern->size + 1) * 2 > intern->capacity)
+	{
+		if (!_expand(intern))
+			return NULL;
+		entry = _slot(intern, s, length, hash);
+	}
+
+	if (!(entry->string = MT_ArenaStrndup(intern->arena, s, length)))
+		return NULL;
+	entry->length = length;
+	entry->hash = hash;
+	intern->size++;
+	return entry->string;
+}
+
+// See mt_intern.h
+const char* MT_InternFind(mt_intern_t *intern, const char *s, int length)
+{
+	return _slot(intern, s, length, _hash(s, length))->string;
+}
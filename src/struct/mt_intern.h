@@ -0,0 +1,93 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#ifndef __MT_INTERN_H__
+#define __MT_INTERN_H__
+
+#include <stdint.h>
+#include "mt_arena.h"
+
+/** Interned string entry. */
+typedef struct
+{
+	/** The interned string (in the arena, null-terminated), or NULL for an empty slot. */
+	const char *string;
+	/** String length. */
+	int length;
+	/** String hash. */
+	uint32_t hash;
+
+} mt_intern_entry_t;
+
+/**
+ * String interning table type.
+ * Each distinct string is copied into an arena once, so equal strings share one pointer
+ * and can be compared by pointer.
+ */
+typedef struct
+{
+	/** Arena that holds the strings (not owned by the table). */
+	mt_arena_t *arena;
+	/** Hash slots (open addressing). */
+	mt_intern_entry_t *entries;
+	/** Slot count (power of two). */
+	int capacity;
+	/** Amount of interned strings. */
+	int size;
+
+} mt_intern_t;
+
+/**
+ * Creates a string interning table.
+ * @param arena the arena to copy strings into. It must outlive the table.
+ * @param capacity the expected amount of distinct strings.
+ * @return a pointer to the new table, or NULL if not allocated.
+ */
+mt_intern_t* MT_InternCreate(mt_arena_t *arena, int capacity);
+
+/**
+ * Frees an interning table.
+ * DOES NOT FREE THE INTERNED STRINGS - they belong to the arena.
+ * @param intern the pointer to the table.
+ */
+void MT_InternDestroy(mt_intern_t *intern);
+
+/**
+ * Removes all strings from an interning table.
+ * Call this when resetting the table's arena.
+ * @param intern the pointer to the table.
+ */
+void MT_InternClear(mt_intern_t *intern);
+
+/**
+ * Interns a string.
+ * @param intern the pointer to the table.
+ * @param s the string (need not be null-terminated).
+ * @param length the length of the string in bytes.
+ * @return the interned, null-terminated string (the same pointer for every equal string), or NULL if out of memory.
+ */
+const char* MT_Intern(mt_intern_t *intern, const char *s, int length);
+
+/**
+ * Finds an interned string without adding it.
+ * @param intern the pointer to the table.
+ * @param s the string (need not be null-terminated).
+ * @param length the length of the string in bytes.
+ * @return the interned string, or NULL if it was never interned.
+ */
+const char* MT_InternFind(mt_intern_t *intern, const char *s, int length);
+
+/**
+ * Interns a null-terminated string.
+ * @param i the pointer to the table.
+ * @param s the string.
+ * @return the interned string, or NULL if out of memory.
+ */
+#define MT_InternString(i,s) MT_Intern((i),(s),strlen((s)))
+
+#endif
@@ -77,6 +77,37 @@ static int MT_SetCanExpand(mt_set_t *set)
 	return set->size == set->capacity ? 1 : 0;
 }
 
+// stable merge sort of arr, using temp (same length) as scratch space.
+static void MT_SetSort(void **arr, void **temp, int count, int (*comparefunc)(void*, void*))
+{
+	int width, lo, a, b, mid, hi, k;
+	void **src = arr, **dest = temp, **swap;
+
+	for (width = 1; width < count; width *= 2)
+	{
+		for (lo = 0; lo < count; lo += width * 2)
+		{
+			mid = lo + width < count ? lo + width : count;
+			hi = lo + width * 2 < count ? lo + width * 2 : count;
+			a = lo;
+			b = mid;
+			k = lo;
+			while (a < mid && b < hi)
+				dest[k++] = (*comparefunc)(src[b], src[a]) < 0 ? src[b++] : src[a++];
+			while (a < mid)
+				dest[k++] = src[a++];
+			while (b < hi)
+				dest[k++] = src[b++];
+		}
+		swap = src;
+		src = dest;
+		dest = swap;
+	}
+
+	if (src != arr)
+		memcpy(arr, src, sizeof(void*) * count);
+}
+
 // ===========================================================================
 // Public Functions
 // ===========================================================================
@@ -152,6 +183,65 @@ int MT_SetAdd(mt_set_t *set, void *value)
 	return 0;
 }
 
+int MT_SetAddAll(mt_set_t *set, void **values, int count)
+{
+	void **sorted, **merged;
+	int i, n, a, b, k, c, newsize;
+
+	if (count <= 0)
+		return 0;
+
+	// sort a copy of the values (second half is scratch space), and drop duplicates.
+	sorted = (void**)MTS_MALLOC(sizeof(void*) * count * 2);
+	if (!sorted)
+		return -1;
+	memcpy(sorted, values, sizeof(void*) * count);
+	MT_SetSort(sorted, sorted + count, count, set->comparefunc);
+	for (i = 1, n = 1; i < count; i++)
+		if ((*set->comparefunc)(sorted[n - 1], sorted[i]) != 0)
+			sorted[n++] = sorted[i];
+
+	newsize = set->capacity > 0 ? set->capacity : 1;
+	while (newsize < set->size + n)
+		newsize *= 2;
+	merged = (void**)MTS_MALLOC(sizeof(void*) * newsize);
+	if (!merged)
+	{
+		MTS_FREE(sorted);
+		return -1;
+	}
+
+	// merge, keeping refs already in the set.
+	a = 0;
+	b = 0;
+	k = 0;
+	while (a < set->size && b < n)
+	{
+		c = (*set->comparefunc)(set->items[a], sorted[b]);
+		if (c < 0)
+			merged[k++] = set->items[a++];
+		else if (c > 0)
+			merged[k++] = sorted[b++];
+		else
+		{
+			merged[k++] = set->items[a++];
+			b++;
+		}
+	}
+	while (a < set->size)
+		merged[k++] = set->items[a++];
+	while (b < n)
+		merged[k++] = sorted[b++];
+
+	MTS_FREE(sorted);
+	MTS_FREE(set->items);
+	set->items = merged;
+	set->capacity = newsize;
+	n = k - set->size;
+	set->size = k;
+	return n;
+}
+
 void* MT_SetRemove(mt_set_t *set, void *value)
 {
 	int i;
@@ -182,11 +272,11 @@ int MT_SetUnion(mt_set_t *out, mt_set_t *first, mt_set_t *second)
 
 	MT_SetClear(out);
 	
+	// first is already sorted, so each add appends.
 	for (i = 0; i < cf; i++)
 		MT_SetAdd(out, first->items[i]);
 	
-	for (i = 0; i < cs; i++)
-		MT_SetAdd(out, second->items[i]);
+	MT_SetAddAll(out, second->items, cs);
 
 	return out->size;
 }
@@ -68,6 +68,17 @@ int MT_SetCapacity(mt_set_t *set);
  */
 int MT_SetAdd(mt_set_t *set, void *value);
 
+/**
+ * Adds many refs (those that do not exist).
+ * The refs are sorted and merged in, which is much faster than adding them one by one.
+ * Of refs that compare equal, the one already in the set (or else the first one in values) is kept.
+ * @param set the pointer to the set object.
+ * @param values the references to add (not changed).
+ * @param count the amount of references.
+ * @return the amount of refs added, or -1 if out of memory.
+ */
+int MT_SetAddAll(mt_set_t *set, void **values, int count);
+
 /**
  * Removes a ref (if exist).
  * @param set the set object.
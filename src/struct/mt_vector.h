@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "mt_config.h"
 
 /** Vector object type. */
 typedef struct
@@ -119,6 +120,123 @@ void* MT_VectorRemoveAt(mt_vector_t *vector, int index);
  */
 void MT_VectorDump(mt_vector_t *vector, void (*dumpfunc)(void*));
 
-
+/**
+ * Declares a typed vector that stores its elements inline (no allocation per element).
+ * Declares type name_t {items, capacity, size}, and these functions:
+ *
+ * void name_Init(name_t *v) - sets up an empty vector (nothing is allocated until needed).
+ * void name_Free(name_t *v) - frees the element array (not anything the elements point to).
+ * void name_Clear(name_t *v) - removes all elements.
+ * int name_Reserve(name_t *v, int capacity) - makes room for elements. Returns 1 if successful, 0 if out of memory.
+ * type* name_Push(name_t *v, type value) - adds an element to the end. Returns a pointer to it, or NULL if out of memory.
+ * type* name_Insert(name_t *v, int index, type value) - adds an element at an index, shifting the rest. Returns a pointer to it, or NULL if out of memory or bad index.
+ * int name_Remove(name_t *v, int index) - removes an element, shifting the rest. Returns 1 if removed, 0 if bad index.
+ * int name_Append(name_t *v, const type *values, int count) - adds many elements to the end. Returns 1 if successful, 0 if out of memory.
+ * void name_Sort(name_t *v, int (*comparefunc)(const void*, const void*)) - sorts the elements (see qsort(...)).
+ * int name_Search(name_t *v, const type *key, int (*comparefunc)(const void*, const void*)) - binary searches a sorted vector (see bsearch(...)). Returns the index, or -1 if not found.
+ *
+ * @param name the vector type and function prefix.
+ * @param type the element type.
+ */
+#define MT_VECTOR_DECLARE(name, type) \
+typedef struct \
+{ \
+	type *items; \
+	int capacity; \
+	int size; \
+} name##_t; \
+\
+static inline void name##_Init(name##_t *v) \
+{ \
+	v->items = NULL; \
+	v->capacity = 0; \
+	v->size = 0; \
+} \
+\
+static inline void name##_Free(name##_t *v) \
+{ \
+	MTS_FREE(v->items); \
+	name##_Init(v); \
+} \
+\
+static inline void name##_Clear(name##_t *v) \
+{ \
+	v->size = 0; \
+} \
+\
+static inline int name##_Reserve(name##_t *v, int capacity) \
+{ \
+	type *items; \
+	if (capacity <= v->capacity) \
+		return 1; \
+	if (!(items = (type*)MTS_REALLOC(v->items, sizeof(type) * capacity))) \
+		return 0; \
+	v->items = items; \
+	v->capacity = capacity; \
+	return 1; \
+} \
+\
+static inline int name##_Grow(name##_t *v, int count) \
+{ \
+	int capacity = v->capacity ? v->capacity : 8; \
+	if (v->size + count <= v->capacity) \
+		return 1; \
+	while (capacity < v->size + count) \
+		capacity *= 2; \
+	return name##_Reserve(v, capacity); \
+} \
+\
+static inline type* name##_Push(name##_t *v, type value) \
+{ \
+	if (!name##_Grow(v, 1)) \
+		return NULL; \
+	v->items[v->size] = value; \
+	return &(v->items[v->size++]); \
+} \
+\
+static inline type* name##_Insert(name##_t *v, int index, type value) \
+{ \
+	if (index < 0 || index > v->size || !name##_Grow(v, 1)) \
+		return NULL; \
+	memmove(&(v->items[index + 1]), &(v->items[index]), sizeof(type) * (v->size - index)); \
+	v->items[index] = value; \
+	v->size++; \
+	return &(v->items[index]); \
+} \
+\
+static inline int name##_Remove(name##_t *v, int index) \
+{ \
+	if (index < 0 || index >= v->size) \
+		return 0; \
+	memmove(&(v->items[index]), &(v->items[index + 1]), sizeof(type) * (v->size - index - 1)); \
+	v->size--; \
+	return 1; \
+} \
+\
+static inline int name##_Append(name##_t *v, const type *values, int count) \
+{ \
+	if (count <= 0) \
+		return 1; \
+	if (!name##_Grow(v, count)) \
+		return 0; \
+	memcpy(&(v->items[v->size]), values, sizeof(type) * count); \
+	v->size += count; \
+	return 1; \
+} \
+\
+static inline void name##_Sort(name##_t *v, int (*comparefunc)(const void*, const void*)) \
+{ \
+	if (v->size > 1) \
+		qsort(v->items, v->size, sizeof(type), comparefunc); \
+} \
+\
+static inline int name##_Search(name##_t *v, const type *key, int (*comparefunc)(const void*, const void*)) \
+{ \
+	type *found; \
+	if (!v->size) \
+		return -1; \
+	found = (type*)bsearch(key, v->items, v->size, sizeof(type), comparefunc); \
+	return found ? (int)(found - v->items) : -1; \
+}
 
 #endif
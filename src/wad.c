@@ -28,19 +28,25 @@
 #include "wadtool/remove.h"
 #include "wadtool/marker.h"
 #include "wadtool/clean.h"
+#include "wadtool/map.h"
+#include "wadtool/batch.h"
+#include "wadtool/serve.h"
 
-#define WADTOOL_COUNT 12
+#define WADTOOL_COUNT 15
 wadtool_t* WADTOOLS_ALL[WADTOOL_COUNT] = {
 	&WADTOOL_Add,
+	&WADTOOL_Batch,
 	&WADTOOL_Clean,
 	&WADTOOL_Create,
 	&WADTOOL_Dump,
 	&WADTOOL_Info,
 	&WADTOOL_List,
+	&WADTOOL_Map,
 	&WADTOOL_Marker,
 	&WADTOOL_Rename,
 	&WADTOOL_Remove,
 	&WADTOOL_Search,
+	&WADTOOL_Serve,
 	&WADTOOL_Shift,
 	&WADTOOL_Swap,
 };
@@ -51,15 +57,18 @@ wadtool_t* WADTOOLS_ALL[WADTOOL_COUNT] = {
 #define COMMAND_ALL 	"all"
 
 #define COMMAND_ADD 	"add"
+#define COMMAND_BATCH	"batch"
 #define COMMAND_CLEAN	"clean"
 #define COMMAND_CREATE	"create"
 #define COMMAND_DUMP 	"dump"
 #define COMMAND_INFO 	"info"
 #define COMMAND_LIST 	"list"
+#define COMMAND_MAP 	"map"
 #define COMMAND_MARKER 	"marker"
 #define COMMAND_REMOVE 	"remove"
 #define COMMAND_RENAME 	"rename"
 #define COMMAND_SEARCH 	"search"
+#define COMMAND_SERVE	"serve"
 #define COMMAND_SHIFT 	"shift"
 #define COMMAND_SWAP 	"swap"
 
@@ -105,6 +114,8 @@ static wadtool_t* parse_tool(arg_parser_t *argparser)
 		return &DEFAULT_TOOL;
 	else if (matcharg(argparser, COMMAND_ADD))
 		return &WADTOOL_Add;
+	else if (matcharg(argparser, COMMAND_BATCH))
+		return &WADTOOL_Batch;
 	else if (matcharg(argparser, COMMAND_CLEAN))
 		return &WADTOOL_Clean;
 	else if (matcharg(argparser, COMMAND_CREATE))
@@ -113,10 +124,14 @@ static wadtool_t* parse_tool(arg_parser_t *argparser)
 		return &WADTOOL_Info;
 	else if (matcharg(argparser, COMMAND_LIST))
 		return &WADTOOL_List;
+	else if (matcharg(argparser, COMMAND_MAP))
+		return &WADTOOL_Map;
 	else if (matcharg(argparser, COMMAND_MARKER))
 		return &WADTOOL_Marker;
 	else if (matcharg(argparser, COMMAND_SEARCH))
 		return &WADTOOL_Search;
+	else if (matcharg(argparser, COMMAND_SERVE))
+		return &WADTOOL_Serve;
 	else if (matcharg(argparser, COMMAND_DUMP))
 		return &WADTOOL_Dump;
 	else if (matcharg(argparser, COMMAND_SHIFT))
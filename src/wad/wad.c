@@ -14,6 +14,7 @@
 #include "wad_config.h"
 #include "wad.h"
 #include "waderrno.h"
+#include "io/stream.h"
 
 #ifndef min
 #define min(x,y) ((x) < (y) ? (x) : (y))
@@ -23,6 +24,14 @@
 #define max(x,y) ((x) > (y) ? (x) : (y))
 #endif
 
+// Zip records.
+#define WADZIP_FILE_SIGNATURE		"PK\x03\x04"
+#define WADZIP_DIRECTORY_SIGNATURE	"PK\x01\x02"
+#define WADZIP_END_SIGNATURE		"PK\x05\x06"
+#define WADZIP_FILE_LENGTH			30
+#define WADZIP_DIRECTORY_LENGTH		46
+#define WADZIP_END_LENGTH			22
+
 // Character buffer.
 #define CBUF_LEN 16384
 static unsigned char cbuf[CBUF_LEN];
@@ -56,6 +65,14 @@ static wad_t* WAD_Init()
 	out->entries = NULL;
 	out->entries_capacity = 0;
 
+	// Not a zip.
+	out->zip_entries = NULL;
+	out->zip_paths = NULL;
+
+	// Commits are not deferred.
+	out->deferred = 0;
+	out->deferred_offset = 0;
+
 	return out;
 }
 
@@ -249,6 +266,172 @@ static int WAD_EntryNameCopy(const char *src, char *dest)
 	return i;
 }
 
+// Reads a little-endian 16-bit value from a zip record.
+static uint16_t WAD_ZipShort(const unsigned char *p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// Reads a little-endian 32-bit value from a zip record.
+static uint32_t WAD_ZipLong(const unsigned char *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Checks if a file starts like a zip archive (a file header, or the end record of an empty one).
+static int WAD_IsZipFile(char *filename)
+{
+	unsigned char magic[4];
+	int out = 0;
+	FILE *fp = fopen(filename, "rb");
+	if (!fp)
+		return 0;
+	if (fread(magic, 1, 4, fp) == 4)
+		out = !memcmp(magic, WADZIP_FILE_SIGNATURE, 4) || !memcmp(magic, WADZIP_END_SIGNATURE, 4);
+	fclose(fp);
+	return out;
+}
+
+// Makes an entry name from a zip path: the file name without its extension.
+static void WAD_ZipEntryName(const char *path, char *dest)
+{
+	char name[9];
+	const char *base = strrchr(path, '/');
+	int i;
+
+	base = base ? base + 1 : path;
+	for (i = 0; i < 8 && base[i] && base[i] != '.'; i++)
+		name[i] = base[i];
+	name[i] = '\0';
+
+	memset(dest, 0, 8);
+	WAD_EntryNameCopy(name, dest);
+}
+
+// Zip directory entry, for sorting into data order.
+typedef struct {
+	wadentry_t entry;
+	wadzipentry_t zip;
+} wadzipsort_t;
+
+static int WAD_ZipSortCompare(const void *a, const void *b)
+{
+	uint32_t x = ((const wadzipsort_t*)a)->entry.offset;
+	uint32_t y = ((const wadzipsort_t*)b)->entry.offset;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Builds the entry list of a zip from its central directory. The paths are moved to the front of the directory.
+static int WAD_SetupZipEntrylist(wad_t *wad, unsigned char *directory, uint32_t length, int count)
+{
+	unsigned char *p = directory, *end = directory + length, *next;
+	char *path = (char*)directory;
+	wadzipsort_t *files;
+	int i, kept = 0;
+
+	if (!(files = (wadzipsort_t*)WAD_MALLOC(sizeof(wadzipsort_t) * max(count, 1))))
+	{
+		waderrno = WADERROR_OUT_OF_MEMORY;
+		return 1;
+	}
+
+	for (i = 0; i < count; i++, p = next)
+	{
+		if (end - p < WADZIP_DIRECTORY_LENGTH || memcmp(p, WADZIP_DIRECTORY_SIGNATURE, 4))
+			break;
+
+		uint16_t flags = WAD_ZipShort(p + 8);
+		uint16_t method = WAD_ZipShort(p + 10);
+		uint32_t crc = WAD_ZipLong(p + 16);
+		uint32_t compressed_length = WAD_ZipLong(p + 20);
+		uint32_t file_length = WAD_ZipLong(p + 24);
+		uint16_t name_length = WAD_ZipShort(p + 28);
+		uint32_t offset = WAD_ZipLong(p + 42);
+		char *name = (char*)p + WADZIP_DIRECTORY_LENGTH;
+
+		next = p + WADZIP_DIRECTORY_LENGTH + name_length + WAD_ZipShort(p + 30) + WAD_ZipShort(p + 32);
+		if (next > end)
+			break;
+
+		// folders are not entries.
+		if (!name_length || name[name_length - 1] == '/')
+			continue;
+
+		// too big for an entry (or Zip64, which marks these).
+		if (file_length > INT32_MAX || compressed_length == 0xFFFFFFFF || offset == 0xFFFFFFFF)
+			break;
+
+		// this header is read, so the path can go over it.
+		memmove(path, name, name_length);
+		path[name_length] = '\0';
+
+		wadzipsort_t *file = &files[kept++];
+		file->zip.path = path;
+		file->zip.compressed_length = compressed_length;
+		file->zip.method = (flags & 0x01) ? 0xFFFF : method;
+		file->zip.crc = crc;
+		file->entry.offset = offset;
+		file->entry.length = file_length;
+		WAD_ZipEntryName(path, file->entry.name);
+
+		path += name_length + 1;
+	}
+
+	if (i < count)
+	{
+		WAD_FREE(files);
+		waderrno = WADERROR_FILE_NOT_A_WAD;
+		return 1;
+	}
+
+	qsort(files, kept, sizeof(wadzipsort_t), WAD_ZipSortCompare);
+
+	if (WAD_ExpandEntrylist(wad, kept) || !(wad->zip_entries = (wadzipentry_t*)WAD_MALLOC(sizeof(wadzipentry_t) * max(kept, 1))))
+	{
+		WAD_FREE(files);
+		waderrno = WADERROR_OUT_OF_MEMORY;
+		return 1;
+	}
+
+	for (i = 0; i < kept; i++)
+	{
+		*(wad->entries[i]) = files[i].entry;
+		wad->zip_entries[i] = files[i].zip;
+	}
+	wad->header.entry_count = kept;
+
+	WAD_FREE(files);
+	return 0;
+}
+
+// Gets the index of an entry in a zip, or -1 if not a zip or not found. Entries are in offset order.
+static int WAD_ZipEntryIndex(wad_t *wad, wadentry_t *entry)
+{
+	int lo = 0, hi = wad->header.entry_count - 1, i;
+
+	if (wad->type != WI_ZIP || !entry)
+		return -1;
+
+	while (lo <= hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (wad->entries[mid]->offset < entry->offset)
+			lo = mid + 1;
+		else if (wad->entries[mid]->offset > entry->offset)
+			hi = mid - 1;
+		else if (wad->entries[mid] == entry)
+			return mid;
+		else
+			break;
+	}
+
+	// files that share an offset (a bad archive) - look for it.
+	for (i = 0; i < wad->header.entry_count; i++)
+		if (wad->entries[i] == entry)
+			return i;
+	return -1;
+}
+
 // Adds an entry.
 static wadentry_t* WAD_AddEntryCommon(wad_t *wad, const char *name, int32_t length, int32_t offset, int index)
 {
@@ -310,6 +493,9 @@ static int WAD_RemoveEntriesCommon(wad_t *wad, int *indices, const int count)
 		else
 			newentrylist[j++] = wad->entries[i];
 	}
+	// keep the unused entries past the end, too
+	for (; i < wad->entries_capacity; i++)
+		newentrylist[i] = wad->entries[i];
 
 	WAD_FREE(wad->entries); // free old list of pointers
 
@@ -591,22 +777,35 @@ static int wi_file_commit_header(wad_t *wad)
 	return 0;
 }
 
-static int wi_file_commit_entry(wad_t *wad, int index)
+// Writes the whole entry list in one go.
+static int wi_file_commit_entry_list(wad_t *wad)
 {
 	errno = 0;
 	FILE *file = wad->handle.file;
-	if (fseek(file, wad->header.entry_list_offset + (sizeof(wadentry_t) * index), SEEK_SET))
+	if (fseek(file, wad->header.entry_list_offset, SEEK_SET))
 		return 1;
-	if (!fwrite(wad->entries[index], sizeof(wadentry_t), 1, file))
+
+	stream_t *out = STREAM_OpenWriteFile(file, min(sizeof(wadentry_t) * wad->header.entry_count, STREAM_WRITE_BUFFER_SIZE));
+	if (!out)
 		return 1;
-	
-	return 0;
+
+	int i, err = 0;
+	for (i = 0; !err && i < wad->header.entry_count; i++)
+		err = STREAM_Write(out, wad->entries[i], sizeof(wadentry_t));
+	if (!err)
+		err = STREAM_Flush(out);
+	STREAM_Close(out);
+	return err;
 }
 
 // Implementation of wadfuncs_t.commit_entries(wad_t*)
 static int wi_file_commit_entries(wad_t *wad)
 {
-	if (wi_file_commit_header(wad))
+	if (wad->deferred)
+		return 0;
+
+	// Entry list first, so that the header never points at a list that isn't there yet.
+	if (wi_file_commit_entry_list(wad) || fflush(wad->handle.file))
 	{
 		if (errno)
 			waderrno = WADERROR_FILE_ERROR;
@@ -614,23 +813,34 @@ static int wi_file_commit_entries(wad_t *wad)
 			waderrno = WADERROR_CANNOT_COMMIT;
 		return 1;
 	}
-	
-	int i = 0;
-	while (i < wad->header.entry_count)
+
+	if (wi_file_commit_header(wad))
 	{
-		if (wi_file_commit_entry(wad, i++))
-		{
-			if (errno)
-				waderrno = WADERROR_FILE_ERROR;
-			else
-				waderrno = WADERROR_CANNOT_COMMIT;
-			return 1;
-		}
+		if (errno)
+			waderrno = WADERROR_FILE_ERROR;
+		else
+			waderrno = WADERROR_CANNOT_COMMIT;
+		return 1;
 	}
 
 	return 0;
 }
 
+// Gets where to write added content: over the entry list (it is rewritten after it),
+// or past the end of the file if commits are deferred.
+static int wi_file_content_offset(wad_t *wad)
+{
+	return wad->deferred ? wad->deferred_offset : wad->header.entry_list_offset;
+}
+
+// Marks added content as written: the entry list goes after it.
+static void wi_file_content_written(wad_t *wad, int end)
+{
+	wad->header.entry_list_offset = end;
+	if (wad->deferred)
+		wad->deferred_offset = end;
+}
+
 // Implementation of wadfuncs_t.create_entry_at(wad_t*, const char*, int)
 static wadentry_t* wi_file_create_entry_at(wad_t *wad, const char *name, int index)
 {
@@ -648,9 +858,8 @@ static wadentry_t* wi_file_create_entry_at(wad_t *wad, const char *name, int ind
 // Implementation of wadfuncs_t.add_entry_at(wad_t*, const char*, int, unsigned char*, size_t)
 static wadentry_t* wi_file_add_entry_at(wad_t *wad, const char *name, int index, unsigned char *buffer, size_t size)
 {
-	int count;
 	wadentry_t* entry;
-	int pos = wad->header.entry_list_offset;
+	int pos = wi_file_content_offset(wad);
 	if (!(entry = WAD_AddEntryCommon(wad, name, size, pos, index)))
 	{
 		waderrno = WADERROR_OUT_OF_MEMORY;
@@ -661,21 +870,14 @@ static wadentry_t* wi_file_add_entry_at(wad_t *wad, const char *name, int index,
 	if (fseek(fp, pos, SEEK_SET))
 		return NULL;
 	
-	size_t remain = size;
-	
-	while (remain)
+	// one write - there's nothing to gather.
+	if (size && fwrite(buffer, 1, size, fp) < size)
 	{
-		count = min(CBUF_LEN, remain);
-		if (fwrite(buffer, 1, count, fp) < count)
-		{
-			waderrno = WADERROR_FILE_ERROR;
-			return NULL;
-		}
-		remain -= count;
-		buffer += count;
+		waderrno = WADERROR_FILE_ERROR;
+		return NULL;
 	}
 	
-	wad->header.entry_list_offset = pos + size;
+	wi_file_content_written(wad, pos + size);
 	
 	if (wi_file_commit_entries(wad))
 		return NULL;
@@ -687,7 +889,7 @@ static wadentry_t* wi_file_add_entry_at(wad_t *wad, const char *name, int index,
 static wadentry_t* wi_file_add_entry_data_at(wad_t *wad, const char *name, int index, FILE *stream)
 {
 	wadentry_t* entry;
-	int pos = wad->header.entry_list_offset;
+	int pos = wi_file_content_offset(wad);
 	FILE *fp = wad->handle.file;
 	if (fseek(fp, pos, SEEK_SET))
 	{
@@ -695,20 +897,34 @@ static wadentry_t* wi_file_add_entry_data_at(wad_t *wad, const char *name, int i
 		return NULL;
 	}
 	
+	stream_t *out = STREAM_OpenWriteFile(fp, STREAM_WRITE_BUFFER_SIZE);
+	if (!out)
+	{
+		waderrno = WADERROR_OUT_OF_MEMORY;
+		return NULL;
+	}
+
 	int buf = 0;
 	int count = 0;
 	while ((buf = fread(cbuf, 1, CBUF_LEN, stream)))
 	{
-		if (fwrite(cbuf, 1, buf, fp) < buf)
+		if (STREAM_Write(out, cbuf, buf))
 		{
+			STREAM_Close(out);
 			waderrno = WADERROR_FILE_ERROR;
 			return NULL;
 		}
-		fflush(stream);
 		count += buf;
 	}
+	if (STREAM_Flush(out))
+	{
+		STREAM_Close(out);
+		waderrno = WADERROR_FILE_ERROR;
+		return NULL;
+	}
+	STREAM_Close(out);
 	
-	wad->header.entry_list_offset = pos + count;
+	wi_file_content_written(wad, pos + count);
 
 	if (!(entry = WAD_AddEntryCommon(wad, name, count, pos, index)))
 	{
@@ -1026,6 +1242,113 @@ static wadfuncs_t WI_BUFFER_WADFUNCS = {
 	wi_buffer_read_data,
 };
 
+// ===========================================================================
+// WI_ZIP
+// ===========================================================================
+
+// Buffer size for reading zip entries.
+#define WI_ZIP_BUFFER_SIZE 16384
+
+// Implementation of wadfuncs_t.destroy(wad_t*)
+static int wi_zip_destroy(wad_t *wad)
+{
+	// Close file handle, free the zip details.
+	fclose(wad->handle.file);
+	WAD_FREE(wad->zip_entries);
+	WAD_FREE(wad->zip_paths);
+	return 0;
+}
+
+// Opens a stream on the (decompressed) content of an entry.
+static stream_t* wi_zip_open_stream(wad_t *wad, wadentry_t *entry)
+{
+	wadzipentry_t *zipentry;
+	stream_t *out, *inflated;
+	size_t offset;
+
+	if (!(zipentry = WAD_GetZipEntry(wad, entry)))
+	{
+		waderrno = WADERROR_INDEX_OUT_OF_RANGE;
+		return NULL;
+	}
+	if (zipentry->method != WADZIP_STORED && zipentry->method != WADZIP_DEFLATED)
+	{
+		waderrno = WADERROR_NOT_SUPPORTED;
+		return NULL;
+	}
+	if (WAD_GetZipEntryDataOffset(wad, entry, &offset))
+		return NULL;
+
+	if (!(out = STREAM_OpenFileSectionAt(wad->handle.file, offset, zipentry->compressed_length, WI_ZIP_BUFFER_SIZE)))
+	{
+		waderrno = WADERROR_OUT_OF_MEMORY;
+		return NULL;
+	}
+	if (zipentry->method == WADZIP_DEFLATED)
+	{
+		if (!(inflated = STREAM_OpenInflate(out, entry->length)))
+		{
+			STREAM_Close(out);
+			waderrno = WADERROR_OUT_OF_MEMORY;
+			return NULL;
+		}
+		out = inflated;
+	}
+	STREAM_SetCRC32(out, zipentry->crc);
+	return out;
+}
+
+// Implementation of wadfuncs_t.get_data(wad_t*, wadentry_t*, unsigned char*)
+static int wi_zip_get_data(wad_t *wad, wadentry_t *entry, unsigned char *destination)
+{
+	int out;
+	stream_t *stream = wi_zip_open_stream(wad, entry);
+	if (!stream)
+		return -1;
+	out = STREAM_Read(stream, destination, 1, entry->length);
+	// a short read or a CRC mismatch means the archive is damaged.
+	if (out != entry->length || STREAM_Error(stream))
+	{
+		waderrno = WADERROR_BAD_DATA;
+		out = -1;
+	}
+	STREAM_Close(stream);
+	return out;
+}
+
+// Implementation of wadfuncs_t.read_data(wad_t*, wadentry_t*, void*, size_t, size_t)
+static int wi_zip_read_data(wad_t *wad, wadentry_t *entry, void *destination, size_t size, size_t count)
+{
+	int out;
+	stream_t *stream = wi_zip_open_stream(wad, entry);
+	if (!stream)
+		return -1;
+	out = STREAM_Read(stream, destination, size, count);
+	if (STREAM_Error(stream))
+	{
+		waderrno = WADERROR_BAD_DATA;
+		out = -1;
+	}
+	STREAM_Close(stream);
+	return out;
+}
+
+// Read-only: changes are not supported, same as WI_MAP.
+static wadfuncs_t WI_ZIP_WADFUNCS = {
+	wi_zip_destroy,
+	wi_map_commit_entries,
+	wi_map_create_entry_at,
+	wi_map_add_entry_at,
+	wi_map_add_entry_data_at,
+	wi_map_add_entry_explicit_at,
+	wi_map_remove_entries_at,
+	wi_map_remove_entry_range,
+	wi_map_swap_entries,
+	wi_map_shift_entries,
+	wi_zip_get_data,
+	wi_zip_read_data,
+};
+
 // ...........................................................................
 
 static wadfuncs_t* WAD_funcs(wadimpl_t impl)
@@ -1035,6 +1358,7 @@ static wadfuncs_t* WAD_funcs(wadimpl_t impl)
 		case WI_MAP: return &WI_MAP_WADFUNCS;
 		case WI_FILE: return &WI_FILE_WADFUNCS;
 		case WI_BUFFER: return &WI_BUFFER_WADFUNCS;
+		case WI_ZIP: return &WI_ZIP_WADFUNCS;
 		case WI_UNKNOWN: return NULL;
 		default: return NULL;
 	}
@@ -1057,7 +1381,11 @@ wad_t* WAD_Open(char *filename)
 
 	// Reset error state.
 	waderrno = WADERROR_NO_ERROR;
-	
+
+	// Zip archives (PK3s) are read-only.
+	if (WAD_IsZipFile(filename))
+		return WAD_OpenZip(filename);
+
 	fp = fopen(filename, "r+b");
 	if (!fp)
 	{
@@ -1152,6 +1480,10 @@ wad_t* WAD_OpenMap(char *filename)
 	// Reset error state.
 	waderrno = WADERROR_NO_ERROR;
 
+	// Zip archives (PK3s) are read-only.
+	if (WAD_IsZipFile(filename))
+		return WAD_OpenZip(filename);
+
 	fp = fopen(filename, "rb");
 	if (!fp)
 	{
@@ -1182,6 +1514,114 @@ wad_t* WAD_OpenMap(char *filename)
 	return out;
 }
 
+// ---------------------------------------------------------------
+// wad_t* WAD_OpenZip(char *filename)
+// See wad.h
+// ---------------------------------------------------------------
+wad_t* WAD_OpenZip(char *filename)
+{
+	wad_t *out;
+	FILE *fp;
+	unsigned char *tail, *end, *directory;
+	long size, tail_offset;
+	size_t tail_length;
+	uint32_t directory_length, directory_offset;
+
+	// Reset error state.
+	waderrno = WADERROR_NO_ERROR;
+
+	fp = fopen(filename, "rb");
+	if (!fp)
+	{
+		waderrno = WADERROR_FILE_ERROR;
+		return NULL;
+	}
+
+	// The end record is last, but for a comment of up to 65535 bytes.
+	if (fseek(fp, 0, SEEK_END) || (size = ftell(fp)) < WADZIP_END_LENGTH)
+	{
+		fclose(fp);
+		waderrno = WADERROR_FILE_NOT_A_WAD;
+		return NULL;
+	}
+	tail_length = min(size, WADZIP_END_LENGTH + 65535);
+	tail_offset = size - tail_length;
+	if (!(tail = (unsigned char*)WAD_MALLOC(tail_length)))
+	{
+		fclose(fp);
+		waderrno = WADERROR_OUT_OF_MEMORY;
+		return NULL;
+	}
+	if (fseek(fp, tail_offset, SEEK_SET) || fread(tail, 1, tail_length, fp) != tail_length)
+	{
+		WAD_FREE(tail);
+		fclose(fp);
+		waderrno = WADERROR_FILE_ERROR;
+		return NULL;
+	}
+
+	for (end = tail + tail_length - WADZIP_END_LENGTH; end >= tail && memcmp(end, WADZIP_END_SIGNATURE, 4); end--) ;
+	directory_length = end >= tail ? WAD_ZipLong(end + 12) : 0;
+	directory_offset = end >= tail ? WAD_ZipLong(end + 16) : 0;
+	// The directory is right before the end record (Zip64 archives don't fit here, and are too big anyway).
+	if (end < tail || (size_t)directory_offset + directory_length > tail_offset + (end - tail))
+	{
+		WAD_FREE(tail);
+		fclose(fp);
+		waderrno = WADERROR_FILE_NOT_A_WAD;
+		return NULL;
+	}
+
+	int count = WAD_ZipShort(end + 10);
+
+	// The whole directory in one read, unless it was read with the end record.
+	if (directory_offset >= tail_offset)
+		directory = tail + (directory_offset - tail_offset);
+	else
+	{
+		WAD_FREE(tail);
+		if (!(tail = (unsigned char*)WAD_MALLOC(max(directory_length, 1))))
+		{
+			fclose(fp);
+			waderrno = WADERROR_OUT_OF_MEMORY;
+			return NULL;
+		}
+		if (fseek(fp, directory_offset, SEEK_SET) || fread(tail, 1, directory_length, fp) != directory_length)
+		{
+			WAD_FREE(tail);
+			fclose(fp);
+			waderrno = WADERROR_FILE_ERROR;
+			return NULL;
+		}
+		directory = tail;
+	}
+
+	out = WAD_Init();
+	if (!out)
+	{
+		WAD_FREE(tail);
+		fclose(fp);
+		waderrno = WADERROR_OUT_OF_MEMORY;
+		return NULL;
+	}
+	if (WAD_SetupZipEntrylist(out, directory, directory_length, count))
+	{
+		// waderrno set in call.
+		WAD_FREE(out->zip_entries);
+		WAD_FreeAllocated(out);
+		WAD_FREE(tail);
+		fclose(fp);
+		return NULL;
+	}
+
+	out->type = WI_ZIP;
+	out->handle.file = fp;
+	out->header.entry_list_offset = directory_offset;
+	out->zip_paths = (char*)tail;
+
+	return out;
+}
+
 // ---------------------------------------------------------------
 // wad_t* WAD_OpenBuffer(char *filename)
 // See wad.h
@@ -1312,6 +1752,36 @@ int WAD_CommitEntries(wad_t *wad)
 	return 0;
 }
 
+// ---------------------------------------------------------------
+// int WAD_SetDeferredCommit(wad_t *wad, int defer)
+// See wad.h
+// ---------------------------------------------------------------
+int WAD_SetDeferredCommit(wad_t *wad, int defer)
+{
+	// Reset error state.
+	waderrno = WADERROR_NO_ERROR;
+
+	if (wad == NULL)
+	{
+		waderrno = WADERROR_WAD_INVALID;
+		return 1;
+	}
+
+	if (defer && !wad->deferred && wad->type == WI_FILE)
+	{
+		long end;
+		if (fseek(wad->handle.file, 0, SEEK_END) || (end = ftell(wad->handle.file)) < 0)
+		{
+			waderrno = WADERROR_FILE_ERROR;
+			return 1;
+		}
+		wad->deferred_offset = (int)end;
+	}
+
+	wad->deferred = defer;
+	return 0;
+}
+
 // ---------------------------------------------------------------
 // wadentry_t* WAD_GetEntry(wad_t *wad, int index)
 // See wad.h
@@ -1336,6 +1806,71 @@ wadentry_t* WAD_GetEntry(wad_t *wad, int index)
 	return wad->entries[index];
 }
 
+// ---------------------------------------------------------------
+// const char* WAD_GetEntryPath(wad_t *wad, wadentry_t *entry)
+// See wad.h
+// ---------------------------------------------------------------
+const char* WAD_GetEntryPath(wad_t *wad, wadentry_t *entry)
+{
+	wadzipentry_t *zipentry = WAD_GetZipEntry(wad, entry);
+	return zipentry ? zipentry->path : NULL;
+}
+
+// ---------------------------------------------------------------
+// wadzipentry_t* WAD_GetZipEntry(wad_t *wad, wadentry_t *entry)
+// See wad.h
+// ---------------------------------------------------------------
+wadzipentry_t* WAD_GetZipEntry(wad_t *wad, wadentry_t *entry)
+{
+	int index;
+
+	if (wad == NULL)
+	{
+		waderrno = WADERROR_WAD_INVALID;
+		return NULL;
+	}
+
+	if ((index = WAD_ZipEntryIndex(wad, entry)) < 0)
+		return NULL;
+	return &(wad->zip_entries[index]);
+}
+
+// ---------------------------------------------------------------
+// int WAD_GetZipEntryDataOffset(wad_t *wad, wadentry_t *entry, size_t *offset)
+// See wad.h
+// ---------------------------------------------------------------
+int WAD_GetZipEntryDataOffset(wad_t *wad, wadentry_t *entry, size_t *offset)
+{
+	unsigned char header[WADZIP_FILE_LENGTH];
+	stream_t *stream;
+	int got;
+
+	if (!WAD_GetZipEntry(wad, entry))
+	{
+		waderrno = WADERROR_INDEX_OUT_OF_RANGE;
+		return 1;
+	}
+
+	// Positional, so that readers don't share the file's position.
+	if (!(stream = STREAM_OpenFileSectionAt(wad->handle.file, entry->offset, WADZIP_FILE_LENGTH, WADZIP_FILE_LENGTH)))
+	{
+		waderrno = WADERROR_OUT_OF_MEMORY;
+		return 1;
+	}
+	got = STREAM_Read(stream, header, WADZIP_FILE_LENGTH, 1);
+	STREAM_Close(stream);
+
+	if (got != 1 || memcmp(header, WADZIP_FILE_SIGNATURE, 4))
+	{
+		waderrno = WADERROR_FILE_ERROR;
+		return 1;
+	}
+
+	// The file's header has its own name and extra field lengths.
+	*offset = entry->offset + WADZIP_FILE_LENGTH + WAD_ZipShort(header + 26) + WAD_ZipShort(header + 28);
+	return 0;
+}
+
 // ---------------------------------------------------------------
 // wadentry_t* WAD_GetEntryByName(wad_t *wad, char *name)
 // See wad.h
@@ -1515,6 +2050,40 @@ int WAD_GetEntryIndexOffset(wad_t *wad, const char *name, int start)
 	return -1;
 }
 
+// ---------------------------------------------------------------
+// int WAD_GetEntryIndexByPath(wad_t *wad, const char *path, int start)
+// See wad.h
+// ---------------------------------------------------------------
+int WAD_GetEntryIndexByPath(wad_t *wad, const char *path, int start)
+{
+	// Reset error state.
+	waderrno = WADERROR_NO_ERROR;
+
+	if (wad == NULL)
+	{
+		waderrno = WADERROR_WAD_INVALID;
+		return -1;
+	}
+	
+	if (start < 0)
+	{
+		waderrno = WADERROR_INDEX_OUT_OF_RANGE;
+		return -1;
+	}
+
+	if (wad->type != WI_ZIP)
+		return -1;
+
+	while (start < wad->header.entry_count)
+	{
+		if (!stricmp(path, wad->zip_entries[start].path))
+			return start;
+		start++;
+	}
+
+	return -1;
+}
+
 // ---------------------------------------------------------------
 // WAD_GetEntryIndices(wad_t *wad, const char *name, int *out, int offset, int max)
 // See wad.h
@@ -17,6 +17,10 @@
 #define WADTYPE_IWAD 0x44415749
 #define WADTYPE_PWAD 0x44415750
 
+// Zip (PK3) compression methods.
+#define WADZIP_STORED 0
+#define WADZIP_DEFLATED 8
+
 #define WADBUFFER_INITSIZE (1024 * 32)
 #define WADENTRIES_INITSIZE 16
 
@@ -48,6 +52,22 @@ typedef struct {
 	
 } wadentry_t;
 
+/**
+ * Zip archive details of a WAD entry (see WAD_OpenZip()).
+ */
+typedef struct {
+	
+	/** Full path of the file in the archive. */
+	char *path;
+	/** Length of the file's data in the archive (compressed, if compressed). */
+	uint32_t compressed_length;
+	/** Compression method: WADZIP_STORED or WADZIP_DEFLATED can be read, others (or encrypted files) cannot. */
+	uint16_t method;
+	/** CRC-32 of the file's (decompressed) content, checked when a stream reads all of it. */
+	uint32_t crc;
+	
+} wadzipentry_t;
+
 /**
  * WAD implementation type.
  * This determines how data is loaded and manipulated and what functions to call.
@@ -62,6 +82,8 @@ typedef enum {
 	WI_BUFFER,
 	/** Content and entries read from open file (random access). */
 	WI_FILE,
+	/** Files in a zip archive (PK3) read from open file (random access, no write). */
+	WI_ZIP,
 	
 } wadimpl_t;
 
@@ -76,7 +98,7 @@ typedef struct {
 	/** Handle union. */
 	union {
 		
-		/** If WI_FILE. */
+		/** If WI_FILE or WI_ZIP. */
 		FILE *file;
 		/** If WI_BUFFER. */
 		unsigned char *buffer;
@@ -94,6 +116,16 @@ typedef struct {
 	int buffer_size;
 	/** WAD buffer capacity (if buffer implementation). */
 	int buffer_capacity;
+
+	/** If WI_ZIP, the archive details of each entry (in entry order). */
+	wadzipentry_t *zip_entries;
+	/** If WI_ZIP, the memory that the paths are in. */
+	char *zip_paths;
+
+	/** If nonzero, entry list changes are kept in memory until WAD_SetDeferredCommit() clears this. */
+	int deferred;
+	/** If WI_FILE and deferred, where added content is written (past the end of the file as it was). */
+	int deferred_offset;
 	
 } wad_t;
 
@@ -130,6 +162,19 @@ wad_t* WAD_Open(char *filename);
  */
 wad_t* WAD_Create(char *filename);
 
+/**
+ * Opens an existing zip archive (PK3) for random access, read-only.
+ * Each file in the archive is an entry, named after its file name minus the extension (like a lump in a PK3),
+ * and the full paths are kept on the side (see WAD_GetEntryPath()). Folders are not entries.
+ * Entries are in the order that their data is in the archive, and their offsets are of their zip headers.
+ * The central directory is read in one go - file data is read when entries are read.
+ * Functions that change entries are not supported.
+ * WAD_Open() and WAD_OpenMap() call this for zip archives.
+ * @param filename the file name to open.
+ * @return a newly-allocated wad_t (zip implementation), or NULL on error.
+ */
+wad_t* WAD_OpenZip(char *filename);
+
 /**
  * Opens an existing WAD file, but only skims for entry data.
  * The file is not left open - no handle is kept.
@@ -184,6 +229,19 @@ int WAD_EntryCount(wad_t *wad);
  */
 int WAD_CommitEntries(wad_t *wad);
 
+/**
+ * Sets whether changes to the entry list are written as they are made.
+ * While deferred, entries are only changed in memory, and WAD_CommitEntries() writes nothing.
+ * Content added to a file is still written as it is added, but past the end of the file as it was,
+ * so the entry list on disk is left alone and the file still reads as it did until the commit.
+ * Clear this and call WAD_CommitEntries() to write everything in one go, or close the WAD without
+ * doing so to throw the entry list changes away.
+ * @param wad the pointer to the open WAD.
+ * @param defer if nonzero, defer commits, else stop deferring.
+ * @return 0 if successful, nonzero on error.
+ */
+int WAD_SetDeferredCommit(wad_t *wad, int defer);
+
 /**
  * Gets a WAD entry at a particular index.
  * @param wad the pointer to the open WAD.
@@ -192,6 +250,32 @@ int WAD_CommitEntries(wad_t *wad);
  */
 wadentry_t* WAD_GetEntry(wad_t *wad, int index);
 
+/**
+ * Gets the full path of an entry in a zip archive.
+ * @param wad the pointer to the open WAD.
+ * @param entry the entry.
+ * @return the path, or NULL if the WAD is not a zip archive (or the entry is not in it).
+ */
+const char* WAD_GetEntryPath(wad_t *wad, wadentry_t *entry);
+
+/**
+ * Gets the zip archive details of an entry.
+ * @param wad the pointer to the open WAD.
+ * @param entry the entry.
+ * @return the details, or NULL if the WAD is not a zip archive (or the entry is not in it).
+ */
+wadzipentry_t* WAD_GetZipEntry(wad_t *wad, wadentry_t *entry);
+
+/**
+ * Gets where the data of an entry in a zip archive is (from its zip header).
+ * This reads the file positionally - it does not change the file's position.
+ * @param wad the pointer to the open WAD.
+ * @param entry the entry.
+ * @param offset the output for the byte offset of the data.
+ * @return 0 if found, nonzero on error.
+ */
+int WAD_GetZipEntryDataOffset(wad_t *wad, wadentry_t *entry, size_t *offset);
+
 /**
  * Gets the first WAD entry by a particular name.
  * Names are case-sensitive, and only the first 8 characters are compared.
@@ -269,6 +353,16 @@ int WAD_GetEntryIndex(wad_t *wad, const char *name);
  */
 int WAD_GetEntryIndexOffset(wad_t *wad, const char *name, int start);
 
+/**
+ * Gets the index of an entry by its full path in a zip archive, from a starting index.
+ * Paths are not case-sensitive (like lump lookups in PK3s).
+ * @param wad the pointer to the open WAD.
+ * @param path the full path.
+ * @param start the index to start from.
+ * @return the matching index or -1 if not found (or the WAD is not a zip archive).
+ */
+int WAD_GetEntryIndexByPath(wad_t *wad, const char *path, int start);
+
 /**
  * Gets the indices of all matching lumps by name.
  * Names are case-sensitive, and only the first 8 characters are compared.
@@ -485,7 +579,7 @@ int WAD_ShiftEntries(wad_t *wad, int start, int count, int destination);
  * @param wad the pointer to the open WAD.
  * @param entry the entry to use for length and offset.
  * @param destination the destination buffer.
- * @return the amount of bytes read, or -1 on a read error.
+ * @return the amount of bytes read, or -1 on a read error (waderrno is WADERROR_BAD_DATA if zip file data is damaged or short).
  */
 int WAD_GetEntryData(wad_t *wad, wadentry_t *entry, unsigned char *destination);
 
@@ -497,7 +591,7 @@ int WAD_GetEntryData(wad_t *wad, wadentry_t *entry, unsigned char *destination);
  * @param destination the destination buffer.
  * @param size the size of a single element in bytes.
  * @param count the amount of elements to read.
- * @return the amount of elements read, or -1 on a read error.
+ * @return the amount of elements read, or -1 on a read error (waderrno is WADERROR_BAD_DATA if zip file data is damaged or short).
  */
 int WAD_ReadEntryData(wad_t *wad, wadentry_t *entry, void *destination, size_t size, size_t count);
 
@@ -19,6 +19,7 @@ static char *waderr[WADERROR_COUNT] = {
 	"Cannot commit WAD entry list.",
 	"Operation not supported in this implementation.",
 	"Index out of range.",
+	"Entry data is corrupt or incomplete.",
 };
 
 char* strwaderror(int n)
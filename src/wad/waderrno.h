@@ -23,7 +23,8 @@
 #define WADERROR_CANNOT_COMMIT			6
 #define WADERROR_NOT_SUPPORTED			7
 #define WADERROR_INDEX_OUT_OF_RANGE		8
-#define WADERROR_COUNT					9
+#define WADERROR_BAD_DATA				9
+#define WADERROR_COUNT					10
 
 /**
  * WAD error number.
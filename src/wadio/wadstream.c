@@ -9,6 +9,26 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "wadstream.h"
+#include "wad/wad_config.h"
+
+// Buffer size for reading entries from files.
+#define WADSTREAM_BUFFER_SIZE 16384
+// Buffer size for reading several entries from files.
+#define WADSTREAM_MULTI_BUFFER_SIZE 65536
+
+// Opens a stream on a section of a WAD's file: mapped if possible, else read positionally with read-ahead.
+static stream_t* wadstream_open_section(FILE *fp, size_t offset, size_t length)
+{
+	stream_t *out;
+	// pending writes must reach the file first.
+	fflush(fp);
+	if ((out = STREAM_OpenMappedSection(fileno(fp), offset, length)))
+		return out;
+	// otherwise read it positionally, so the WAD's file position is shared by no one.
+	if ((out = STREAM_OpenFileSectionAt(fp, offset, length, WADSTREAM_BUFFER_SIZE)))
+		STREAM_SetReadAhead(out);
+	return out;
+}
 
 // ---------------------------------------------------------------
 // stream_t* STREAM_OpenWADStream(wad_t *wad, wadentry_t *entry)
@@ -25,10 +45,32 @@ stream_t* STREAM_OpenWADStream(wad_t *wad, wadentry_t *entry)
 		case WI_MAP:
 			return NULL;
 		case WI_FILE:
+			return wadstream_open_section(wad->handle.file, entry->offset, entry->length);
+		case WI_ZIP:
 		{
-			FILE *fp = wad->handle.file;
-			fseek(fp, entry->offset, SEEK_SET);
-			return STREAM_OpenBufferedFileSection(fp, entry->length, 16384);
+			wadzipentry_t *zipentry = WAD_GetZipEntry(wad, entry);
+			stream_t *out, *inflated;
+			size_t offset;
+
+			if (!zipentry || WAD_GetZipEntryDataOffset(wad, entry, &offset))
+				return NULL;
+			if (zipentry->method != WADZIP_STORED && zipentry->method != WADZIP_DEFLATED)
+				return NULL;
+			// stored files are read in place, compressed ones are decompressed from there.
+			if (!(out = wadstream_open_section(wad->handle.file, offset, zipentry->compressed_length)))
+				return NULL;
+			if (zipentry->method == WADZIP_DEFLATED)
+			{
+				if (!(inflated = STREAM_OpenInflate(out, entry->length)))
+				{
+					STREAM_Close(out);
+					return NULL;
+				}
+				out = inflated;
+			}
+			// the content is checked against the archive's CRC-32 as it is read.
+			STREAM_SetCRC32(out, zipentry->crc);
+			return out;
 		}
 		case WI_BUFFER:
 		{
@@ -37,3 +79,46 @@ stream_t* STREAM_OpenWADStream(wad_t *wad, wadentry_t *entry)
 		}
 	}
 }
+
+// ---------------------------------------------------------------
+// stream_t* STREAM_OpenWADMultiStream(wad_t *wad, wadentry_t **entries, int count)
+// See wadstream.h
+// ---------------------------------------------------------------
+stream_t* STREAM_OpenWADMultiStream(wad_t *wad, wadentry_t **entries, int count)
+{
+	int i;
+	stream_t *out = NULL;
+	stream_extent_t *extents;
+
+	if (!wad || count < 0 || wad->type == WI_MAP || wad->type == WI_ZIP)
+		return NULL;
+
+	if (!(extents = (stream_extent_t*)WAD_MALLOC(sizeof(stream_extent_t) * (count > 0 ? count : 1))))
+		return NULL;
+
+	// entry offsets include the header, which is not in a WAD buffer (empty entries are skipped, so they don't matter).
+	size_t base = wad->type == WI_BUFFER ? sizeof(wadheader_t) : 0;
+	for (i = 0; i < count; i++)
+	{
+		extents[i].offset = entries[i]->offset - base;
+		extents[i].length = entries[i]->length;
+	}
+
+	switch (wad->type)
+	{
+		default:
+		case WI_MAP:
+			break;
+		case WI_FILE:
+			// pending writes must reach the file first.
+			fflush(wad->handle.file);
+			out = STREAM_OpenFileExtents(wad->handle.file, extents, count, WADSTREAM_MULTI_BUFFER_SIZE);
+			break;
+		case WI_BUFFER:
+			out = STREAM_OpenBufferExtents(wad->handle.buffer, extents, count);
+			break;
+	}
+
+	WAD_FREE(extents);
+	return out;
+}
@@ -15,6 +15,10 @@
 /**
  * Opens a stream for reading from a WAD file's contents.
  * Stream is either buffer-based or file-based depending on the type of WAD implementation.
+ * Entries of file-based WADs are memory-mapped where possible, and otherwise read with positional reads
+ * and read-ahead, so streams on entries of one WAD are independent of each other and of the WAD's file position.
+ * Stored files in zip archives are read the same way, and compressed ones are decompressed from there.
+ * Zip files are checked against their CRC-32 as they are read: see io/stream.h/STREAM_Error().
  * See io/stream.h for more info.
  * @param wad the open WAD file.
  * @param entry the WAD entry to use.
@@ -22,4 +26,17 @@
  */
 stream_t* STREAM_OpenWADStream(wad_t *wad, wadentry_t *entry);
 
+/**
+ * Opens a stream for reading the contents of several WAD entries in order, as though they were one entry.
+ * Entries that are adjacent in the WAD are read together, and entries of file-based WADs are read with positional reads
+ * (so the stream is independent of other streams and the WAD's file position).
+ * Zip archives are not supported: each file's CRC-32 is checked on its own stream (see STREAM_OpenWADStream()).
+ * See io/stream.h for more info.
+ * @param wad the open WAD file.
+ * @param entries the WAD entries to use, in the order to read them.
+ * @param count the amount of entries.
+ * @return a pointer to a stream (that must be closed with STREAM_Close), or NULL if wad is invalid or other errors.
+ */
+stream_t* STREAM_OpenWADMultiStream(wad_t *wad, wadentry_t **entries, int count);
+
 #endif
@@ -21,6 +21,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include "wadtool.h"
+#include "common.h"
 #include "wad/wad.h"
 #include "wad/waderrno.h"
 #include "io/stream.h"
@@ -163,7 +164,7 @@ static int exec(wadtool_options_add_t *options)
 
 		if (strcmp(sourceFile, STREAMNAME_STDIN) == 0)
 		{
-			listin = STREAM_OpenFile(stdin);
+			listin = STREAM_OpenBufferedFile(stdin, 16384);
 			if (!listin)
 			{
 				fprintf(stderr, "ERROR: Couldn't read from STDIN!\n");
@@ -180,10 +181,16 @@ static int exec(wadtool_options_add_t *options)
 			}
 		}
 
-		int ret = 0;
+		int ret = 0, len;
+		const char *line;
+		char scratch[MAX_FILENAME_SIZE];
 		char filenameLine[MAX_FILENAME_SIZE];
-		while (!ret && STREAM_ReadLine(listin, filenameLine, MAX_FILENAME_SIZE) >= 0)
+		while (!ret && (len = STREAM_ReadLineView(listin, &line, scratch, MAX_FILENAME_SIZE)) >= 0)
 		{
+			len = len < MAX_FILENAME_SIZE ? len : MAX_FILENAME_SIZE - 1;
+			memcpy(filenameLine, line, len);
+			filenameLine[len] = '\0';
+
 			if (options->entryName)
 				ret = add(wad, filenameLine, options->entryName, addIndex++);
 			else
@@ -226,7 +233,7 @@ static int parse_file(arg_parser_t *argparser, wadtool_options_add_t *options)
 	}
 
 	// Open a file.
-	options->wad = WAD_Open(options->filename);
+	options->wad = WADTools_OpenWAD(options->filename);
 
 	if (!options->wad)
 	{
@@ -320,12 +327,12 @@ static int call(arg_parser_t *argparser)
 	}
 	if ((err = parse_switches(argparser, &options)))
 	{
-		WAD_Close(options.wad);
+		WADTools_CloseWAD(options.wad);
 		return err;
 	}
 	
 	int ret = exec(&options);
-	WAD_Close(options.wad);
+	WADTools_CloseWAD(options.wad);
 	return ret;
 }
 
@@ -0,0 +1,317 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "wadtool.h"
+#include "common.h"
+#include "batch.h"
+#include "add.h"
+#include "marker.h"
+#include "remove.h"
+#include "rename.h"
+#include "shift.h"
+#include "swap.h"
+#include "wad/wad.h"
+#include "wad/waderrno.h"
+#include "io/stream.h"
+
+extern int errno;
+extern int waderrno;
+
+#define ERRORBATCH_NONE                 0
+#define ERRORBATCH_NO_FILENAME          1
+#define ERRORBATCH_BAD_SWITCH           2
+#define ERRORBATCH_BAD_COMMAND          3
+#define ERRORBATCH_COMMAND_FAILED       4
+#define ERRORBATCH_WAD_ERROR            10
+#define ERRORBATCH_IO_ERROR             20
+
+#define SWITCH_ATOMIC                   "-a"
+#define SWITCH_ATOMIC2                  "--atomic"
+#define STREAMNAME_STDIN                "-"
+
+#define BATCH_LINE_MAX                  4096
+#define BATCH_ARGS_MAX                  64
+
+// The tools that can be run in a batch (the ones that change the WAD).
+static wadtool_t* BATCH_TOOLS[] = {
+	&WADTOOL_Add,
+	&WADTOOL_Marker,
+	&WADTOOL_Remove,
+	&WADTOOL_Rename,
+	&WADTOOL_Shift,
+	&WADTOOL_Swap,
+	NULL
+};
+
+typedef struct
+{
+	/** WAD filename. */
+	char *filename;
+	/** The WAD to use. */
+	wad_t *wad;
+	/** The script filename, or stream indicator. */
+	char *script;
+	/** If nonzero, only change the WAD if every command succeeds. */
+	int atomic;
+
+} wadtool_options_batch_t;
+
+static wadtool_t* find_tool(const char *name)
+{
+	int i;
+	for (i = 0; BATCH_TOOLS[i]; i++)
+		if (stricmp(BATCH_TOOLS[i]->name, name) == 0)
+			return BATCH_TOOLS[i];
+	return NULL;
+}
+
+// Runs each line of the script against the open WAD. Returns the line number that failed, or 0 if none did.
+static int run_script(wadtool_options_batch_t *options, stream_t *script, int *count, int *err)
+{
+	int len, lineNumber = 0;
+	const char *view;
+	char scratch[BATCH_LINE_MAX];
+	char line[BATCH_LINE_MAX + 1];
+	char *argv[BATCH_ARGS_MAX + 1];
+
+	while ((len = STREAM_ReadLineView(script, &view, scratch, BATCH_LINE_MAX)) >= 0)
+	{
+		lineNumber++;
+		if (len >= BATCH_LINE_MAX)
+		{
+			fprintf(stderr, "ERROR: Line %d: Line is too long.\n", lineNumber);
+			*err = ERRORBATCH_BAD_COMMAND;
+			return lineNumber;
+		}
+		memcpy(line, view, len);
+		line[len] = '\0';
+
+		// Command first, then the WAD file, then the rest - the same as the command line.
+		int argc = WADTools_SplitArgs(line, argv + 1, BATCH_ARGS_MAX);
+		if (argc == 0)
+			continue;
+		if (argc < 0)
+		{
+			fprintf(stderr, "ERROR: Line %d: Too many arguments.\n", lineNumber);
+			*err = ERRORBATCH_BAD_COMMAND;
+			return lineNumber;
+		}
+		argv[0] = argv[1];
+		argv[1] = options->filename;
+
+		wadtool_t *tool = find_tool(argv[0]);
+		if (!tool)
+		{
+			fprintf(stderr, "ERROR: Line %d: Not a batch command: %s\n", lineNumber, argv[0]);
+			*err = ERRORBATCH_BAD_COMMAND;
+			return lineNumber;
+		}
+
+		arg_parser_t parser = {argc + 1, argv, 0, NULL};
+		nextarg(&parser);
+		nextarg(&parser);
+		if ((tool->call)(&parser))
+		{
+			fprintf(stderr, "ERROR: Line %d: Command failed.\n", lineNumber);
+			*err = ERRORBATCH_COMMAND_FAILED;
+			return lineNumber;
+		}
+		(*count)++;
+	}
+
+	return 0;
+}
+
+static int exec(wadtool_options_batch_t *options)
+{
+	stream_t *script;
+	if (strcmp(options->script, STREAMNAME_STDIN) == 0)
+	{
+		script = STREAM_OpenBufferedFile(stdin, 16384);
+		if (!script)
+		{
+			fprintf(stderr, "ERROR: Couldn't read from STDIN!\n");
+			return ERRORBATCH_IO_ERROR;
+		}
+	}
+	else
+	{
+		script = STREAM_Open(options->script);
+		if (!script)
+		{
+			fprintf(stderr, "ERROR: Couldn't read from %s: %s\n", options->script, strerror(errno));
+			return ERRORBATCH_IO_ERROR + errno;
+		}
+	}
+
+	if (WAD_SetDeferredCommit(options->wad, 1))
+	{
+		STREAM_Close(script);
+		fprintf(stderr, "ERROR: %s %s\n", strwaderror(waderrno), strerror(errno));
+		return ERRORBATCH_IO_ERROR + errno;
+	}
+
+	int count = 0, err = 0;
+	WADTools_SetBatchWAD(options->wad);
+	int failed = run_script(options, script, &count, &err);
+	WADTools_SetBatchWAD(NULL);
+	STREAM_Close(script);
+
+	if (failed && options->atomic)
+	{
+		// Never committed: the file still has its old entry list.
+		fprintf(stderr, "No changes made to %s.\n", options->filename);
+		return err;
+	}
+
+	WAD_SetDeferredCommit(options->wad, 0);
+	if (WAD_CommitEntries(options->wad))
+	{
+		if (errno)
+		{
+			fprintf(stderr, "ERROR: %s %s\n", strwaderror(waderrno), strerror(errno));
+			return ERRORBATCH_IO_ERROR + errno;
+		}
+		else
+		{
+			fprintf(stderr, "ERROR: %s\n", strwaderror(waderrno));
+			return ERRORBATCH_WAD_ERROR + waderrno;
+		}
+	}
+
+	if (failed)
+		fprintf(stderr, "Committed %d commands to %s (stopped at line %d).\n", count, options->filename, failed);
+	else
+		printf("Committed %d commands to %s.\n", count, options->filename);
+
+	return err;
+}
+
+// If nonzero, bad parse.
+static int parse_file(arg_parser_t *argparser, wadtool_options_batch_t *options)
+{
+	options->filename = currarg(argparser);
+	if (!options->filename)
+	{
+		fprintf(stderr, "ERROR: No WAD file.\n");
+		return ERRORBATCH_NO_FILENAME;
+	}
+
+	// Open a file.
+	options->wad = WAD_Open(options->filename);
+
+	if (!options->wad)
+	{
+		if (waderrno == WADERROR_FILE_ERROR)
+		{
+			fprintf(stderr, "ERROR: %s %s\n", strwaderror(waderrno), strerror(errno));
+			return ERRORBATCH_IO_ERROR + errno;
+		}
+		else
+		{
+			fprintf(stderr, "ERROR: %s\n", strwaderror(waderrno));
+			return ERRORBATCH_WAD_ERROR + waderrno;
+		}
+	}
+	nextarg(argparser);
+	return 0;
+}
+
+// If nonzero, bad parse.
+static int parse_switches(arg_parser_t *argparser, wadtool_options_batch_t *options)
+{
+	if (currarg(argparser) && !currargis(argparser, SWITCH_ATOMIC) && !currargis(argparser, SWITCH_ATOMIC2))
+		options->script = takearg(argparser);
+
+	while (currarg(argparser))
+	{
+		if (matcharg(argparser, SWITCH_ATOMIC) || matcharg(argparser, SWITCH_ATOMIC2))
+			options->atomic = 1;
+		else
+		{
+			fprintf(stderr, "ERROR: Bad switch: %s\n", currarg(argparser));
+			return ERRORBATCH_BAD_SWITCH;
+		}
+	}
+
+	return 0;
+}
+
+static int call(arg_parser_t *argparser)
+{
+	wadtool_options_batch_t options = {NULL, NULL, STREAMNAME_STDIN, 0};
+
+	int err;
+	if ((err = parse_file(argparser, &options)))
+	{
+		return err;
+	}
+	if ((err = parse_switches(argparser, &options)))
+	{
+		WAD_Close(options.wad);
+		return err;
+	}
+	
+	int ret = exec(&options);
+	WAD_Close(options.wad);
+	return ret;
+}
+
+static void usage()
+{
+	printf("Usage: wad batch [wadfile] <script> [switches]\n");
+}
+
+static void help()
+{
+	printf("[wadfile]: \n");
+	printf("    The name of the WAD file to change.\n");
+	printf("\n");
+	printf("<script>: Optional, default is STDIN.\n");
+	printf("    The file to read commands from, one per line, or `-` for STDIN (commands\n");
+	printf("    cannot read STDIN as well, then).\n");
+	printf("    Each line is one of these commands, with the same arguments as on the\n");
+	printf("    command line, minus the WAD file:\n");
+	printf("\n");
+	printf("        add, marker, remove, rename, shift, swap\n");
+	printf("\n");
+	printf("    For example:\n");
+	printf("\n");
+	printf("        rename MAP01 MAP02\n");
+	printf("        add \"my file.lmp\" -n FOO\n");
+	printf("\n");
+	printf("    Arguments with spaces go in double quotes. Blank lines are skipped, and\n");
+	printf("    an argument that starts with `#` starts a comment. The WAD's entry list\n");
+	printf("    is changed in memory and written once, after the last command. Added\n");
+	printf("    content is written past the end of the file, so the file reads as it did\n");
+	printf("    before until then.\n");
+	printf("\n");
+	printf("    If a command fails, the rest are not run, and the changes made by the\n");
+	printf("    commands before it are written.\n");
+	printf("\n");
+	printf("[switches]: \n");
+	printf("\n");
+	printf("    Batch options: \n");
+	printf("\n");
+	printf("        --atomic                  If a command fails, write no changes at\n");
+	printf("        -a                        all. Content that was already added is\n");
+	printf("                                  left unused at the end of the file (see\n");
+	printf("                                  `wad clean`).\n");
+}
+
+wadtool_t WADTOOL_Batch = {
+	"batch",
+	"Runs many commands against a WAD file, committing once.",
+	&call,
+	&usage,
+	&help,
+};
@@ -0,0 +1,16 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#ifndef __WADTOOL_BATCH_H__
+#define __WADTOOL_BATCH_H__
+
+#include "wadtool.h"
+
+wadtool_t WADTOOL_Batch;
+
+#endif
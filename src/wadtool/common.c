@@ -8,119 +8,160 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <ctype.h>
 
 #include "common.h"
 #include "common_list.h"
 #include "wad/wad.h"
 #include "wad/wad_config.h"
+#include "io/stream.h"
 
 // to avoid the overflow in an arithmetic method
 #define COMPARE_INT(x,y)	((x) == (y) ? 0 : ((x) < (y) ? -1 : 1))
 
+#define ARGS_COMMENT		'#'
+#define ARGS_QUOTE			'"'
+
+// The WAD that a running batch has open (see batch.c).
+static wad_t *batch_wad = NULL;
+
+void WADTools_SetBatchWAD(wad_t *wad)
+{
+	batch_wad = wad;
+}
+
+wad_t* WADTools_OpenWAD(char *filename)
+{
+	if (batch_wad)
+		return batch_wad;
+	return WAD_Open(filename);
+}
+
+int WADTools_CloseWAD(wad_t *wad)
+{
+	if (wad == batch_wad)
+		return 0;
+	return WAD_Close(wad);
+}
+
 int WADTools_ListEntrySortIndex(const void *a, const void *b)
 {
-	listentry_t *x = *(listentry_t**)a;
-	listentry_t *y = *(listentry_t**)b;
+	listentry_t *x = (listentry_t*)a;
+	listentry_t *y = (listentry_t*)b;
 	return COMPARE_INT(x->index, y->index);
 }
 
 int WADTools_ListEntrySortName(const void *a, const void *b)
 {
-	listentry_t *x = *(listentry_t**)a;
-	listentry_t *y = *(listentry_t**)b;
+	listentry_t *x = (listentry_t*)a;
+	listentry_t *y = (listentry_t*)b;
 	return strncmp(x->entry->name, y->entry->name, 8);
 }
 
 int WADTools_ListEntrySortLength(const void *a, const void *b)
 {
-	listentry_t *x = *(listentry_t**)a;
-	listentry_t *y = *(listentry_t**)b;
+	listentry_t *x = (listentry_t*)a;
+	listentry_t *y = (listentry_t*)b;
 	return COMPARE_INT(x->entry->length, y->entry->length);
 }
 
 int WADTools_ListEntrySortOffset(const void *a, const void *b)
 {
-	listentry_t *x = *(listentry_t**)a;
-	listentry_t *y = *(listentry_t**)b;
+	listentry_t *x = (listentry_t*)a;
+	listentry_t *y = (listentry_t*)b;
 	return COMPARE_INT(x->entry->offset, y->entry->offset);
 }
 
 // Print a single list entry.
-static void listentry_print(listentry_t *listentry, int listflags, int no_header, int inline_header)
+static void listentry_print(stream_t *out, listentry_t *listentry, int listflags, int no_header, int inline_header)
 {
 	if (!listflags || (listflags & LISTFLAG_INDICES))
 	{
 		if (!no_header && inline_header)
-			printf("Index ");
-		printf("%-10d ", listentry->index);
+			STREAM_Printf(out, "Index ");
+		STREAM_Printf(out, "%-10d ", listentry->index);
 	}
 	if (!listflags || (listflags & LISTFLAG_NAMES))
 	{
 		if (!no_header && inline_header)
-			printf("Name ");
-		printf("%-8.8s ", listentry->entry->name);
+			STREAM_Printf(out, "Name ");
+		STREAM_Printf(out, "%-8.8s ", listentry->entry->name);
 	}
 	if (!listflags || (listflags & LISTFLAG_LENGTHS))
 	{
 		if (!no_header && inline_header)
-			printf("Length ");
-		printf("%-10d ", listentry->entry->length);
+			STREAM_Printf(out, "Length ");
+		STREAM_Printf(out, "%-10d ", listentry->entry->length);
 	}
 	if (!listflags || (listflags & LISTFLAG_OFFSETS))
 	{
 		if (!no_header && inline_header)
-			printf("Offset ");
-		printf("%-10d ", listentry->entry->offset);
+			STREAM_Printf(out, "Offset ");
+		STREAM_Printf(out, "%-10d ", listentry->entry->offset);
+	}
+	if (listentry->path && (!listflags || (listflags & LISTFLAG_NAMES)))
+	{
+		if (!no_header && inline_header)
+			STREAM_Printf(out, "Path ");
+		STREAM_Printf(out, "%s", listentry->path);
 	}
-	printf("\n");
+	STREAM_Printf(out, "\n");
+}
+
+void WADTools_ListEntriesPrint(listentry_t *entries, size_t count, size_t limit, int listflags, int no_header, int inline_header, int reverse)
+{
+	stream_t *out = STREAM_OpenWriteFile(stdout, STREAM_WRITE_BUFFER_SIZE);
+	if (!out)
+		return;
+	WADTools_ListEntriesWrite(out, entries, count, limit, listflags, no_header, inline_header, reverse);
+	STREAM_Close(out);
 }
 
-void WADTools_ListEntriesPrint(listentry_t **entries, size_t count, size_t limit, int listflags, int no_header, int inline_header, int reverse)
+void WADTools_ListEntriesWrite(stream_t *out, listentry_t *entries, size_t count, size_t limit, int listflags, int no_header, int inline_header, int reverse)
 {
+	int i, x = 0, paths = 0;
+	for (i = 0; i < count && !paths; i++)
+		paths = entries[i].path != NULL;
+	paths = paths && (!listflags || (listflags & LISTFLAG_NAMES));
+
 	if (!no_header && !inline_header)
 	{
 		if (!listflags || (listflags & LISTFLAG_INDICES))
-			printf("Index      ");
+			STREAM_Printf(out, "Index      ");
 		if (!listflags || (listflags & LISTFLAG_NAMES))
-			printf("Name     ");
+			STREAM_Printf(out, "Name     ");
 		if (!listflags || (listflags & LISTFLAG_LENGTHS))
-			printf("Length     ");
+			STREAM_Printf(out, "Length     ");
 		if (!listflags || (listflags & LISTFLAG_OFFSETS))
-			printf("Offset");
-		printf("\n");
+			STREAM_Printf(out, paths ? "Offset     " : "Offset");
+		if (paths)
+			STREAM_Printf(out, "Path");
+		STREAM_Printf(out, "\n");
 
 		if (!listflags || (listflags & LISTFLAG_INDICES))
-			printf("-----------");
+			STREAM_Printf(out, "-----------");
 		if (!listflags || (listflags & LISTFLAG_NAMES))
-			printf("---------");
+			STREAM_Printf(out, "---------");
 		if (!listflags || (listflags & LISTFLAG_LENGTHS))
-			printf("-----------");
+			STREAM_Printf(out, "-----------");
 		if (!listflags || (listflags & LISTFLAG_OFFSETS))
-			printf("-----------");
-		printf("\n");
+			STREAM_Printf(out, "-----------");
+		if (paths)
+			STREAM_Printf(out, "----");
+		STREAM_Printf(out, "\n");
 	}
 
-	int i, x = 0;
 	if (reverse) for (i = count - 1; i >= 0 && x < limit; i--, x++)
-		listentry_print(entries[i], listflags, no_header, inline_header);
+		listentry_print(out, &entries[i], listflags, no_header, inline_header);
 	else for (i = 0; i < count && x < limit; i++, x++)
-		listentry_print(entries[i], listflags, no_header, inline_header);
+		listentry_print(out, &entries[i], listflags, no_header, inline_header);
 
 	if (!no_header && !inline_header)
 	{
-		printf("Count %d\n", x);
+		STREAM_Printf(out, "Count %d\n", x);
 	}
-}
 
-listentry_t** WADTools_ListEntryShadow(listentry_t *v, size_t n)
-{
-	int i = 0;
-	listentry_t **out = (listentry_t**)WAD_MALLOC(sizeof(listentry_t*) * n);
-	if (!out)
-		return NULL;
-	for (i = 0; i < n; i++)
-		out[i] = &v[i];
-	return out;
+	STREAM_Flush(out);
 }
 
 int WADTools_FindEntryIndex(wad_t *wad, entry_search_type_t entrytype, const char *entry, int start)
@@ -131,7 +172,8 @@ int WADTools_FindEntryIndex(wad_t *wad, entry_search_type_t entrytype, const cha
 		default:
 		case ET_DETECT:
 		{
-			if (!(result = atoi(entry)) && strcmp(entry, "0") != 0 && (result = WAD_GetEntryIndexOffset(wad, entry, start)) < 0)
+			if (!(result = atoi(entry)) && strcmp(entry, "0") != 0 && (result = WAD_GetEntryIndexOffset(wad, entry, start)) < 0
+				&& (result = WAD_GetEntryIndexByPath(wad, entry, start)) < 0)
 				result = -1;
 		}
 		break;
@@ -146,10 +188,41 @@ int WADTools_FindEntryIndex(wad_t *wad, entry_search_type_t entrytype, const cha
 
 		case ET_NAME:
 		{
-			if ((result = WAD_GetEntryIndexOffset(wad, entry, start)) < 0)
+			if ((result = WAD_GetEntryIndexOffset(wad, entry, start)) < 0 && (result = WAD_GetEntryIndexByPath(wad, entry, start)) < 0)
 				result = -1;
 		}
 		break;
 	}
 	return result;
 }
+
+int WADTools_SplitArgs(char *line, char **argv, int max)
+{
+	int argc = 0;
+	while (*line)
+	{
+		while (*line && isspace(*line))
+			line++;
+		if (!*line || *line == ARGS_COMMENT)
+			break;
+		if (argc == max)
+			return -1;
+
+		if (*line == ARGS_QUOTE)
+		{
+			argv[argc++] = ++line;
+			while (*line && *line != ARGS_QUOTE)
+				line++;
+		}
+		else
+		{
+			argv[argc++] = line;
+			while (*line && !isspace(*line))
+				line++;
+		}
+
+		if (*line)
+			*(line++) = '\0';
+	}
+	return argc;
+}
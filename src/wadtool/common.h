@@ -10,6 +10,8 @@
 #define __WADTOOL_COMMON_H__
 
 #include "wad/wad.h"
+#include "io/stream.h"
+#include "struct/mt_vector.h"
 
 #define LISTFLAG_INDICES    	(1 << 0)
 #define LISTFLAG_NAMES     		(1 << 1)
@@ -37,12 +39,41 @@ typedef struct
 	int index;
 	// Pointer to entry.
 	wadentry_t *entry;
+	// Full path, if in a zip archive (else NULL).
+	const char *path;
 
 } listentry_t;
 
+/**
+ * Vector of list entries (stored inline).
+ */
+MT_VECTOR_DECLARE(listentry_vector, listentry_t)
+
+/**
+ * Sets the WAD that a batch has open, for tools to use instead of opening their own.
+ * @param wad the open WAD, or NULL once the batch is done.
+ */
+void WADTools_SetBatchWAD(wad_t *wad);
+
+/**
+ * Opens a WAD file for a tool that changes it.
+ * While a batch is running, this is the batch's WAD instead (the filename is not opened again).
+ * @param filename the WAD filename.
+ * @return the open WAD, or NULL on error (see waderrno).
+ */
+wad_t* WADTools_OpenWAD(char *filename);
+
+/**
+ * Closes a WAD opened with WADTools_OpenWAD(). A batch's WAD is left open.
+ * @param wad the WAD to close.
+ * @return 0 if closed, nonzero on error.
+ */
+int WADTools_CloseWAD(wad_t *wad);
+
 /**
  * Searches for an entry index using a string input,
  * interpreted as either numeric or string depending on entrytype.
+ * In zip archives, names that match no entry are tried as full paths.
  * @param wad the wad to search in.
  * @param entrytype the entry search type.
  * @param entry the input name/index as a string.
@@ -52,45 +83,64 @@ typedef struct
 int WADTools_FindEntryIndex(wad_t *wad, entry_search_type_t entrytype, const char *entry, int start);
 
 /**
- * Sort function for an array of listentry_t*.
+ * Splits a line into arguments, in place (the line is cut up with null characters).
+ * Arguments are separated by whitespace, and double quotes group arguments with spaces in them.
+ * An argument that starts with '#' starts a comment that runs to the end of the line.
+ * @param line the null-terminated line.
+ * @param argv the output argument pointers (into line).
+ * @param max the capacity of argv.
+ * @return the amount of arguments, or -1 if there are more than max.
+ */
+int WADTools_SplitArgs(char *line, char **argv, int max);
+
+/**
+ * Sort function for an array of listentry_t.
  * See qsort(...).
  */
 int WADTools_ListEntrySortIndex(const void *a, const void *b);
 
 /**
- * Sort function for an array of listentry_t*.
+ * Sort function for an array of listentry_t.
  * See qsort(...).
  */
 int WADTools_ListEntrySortName(const void *a, const void *b);
 
 /**
- * Sort function for an array of listentry_t*.
+ * Sort function for an array of listentry_t.
  * See qsort(...).
  */
 int WADTools_ListEntrySortLength(const void *a, const void *b);
 
 /**
- * Sort function for an array of listentry_t*.
+ * Sort function for an array of listentry_t.
  * See qsort(...).
  */
 int WADTools_ListEntrySortOffset(const void *a, const void *b);
 
 /**
  * Prints a list of list entries to STDOUT.
- * @param entries the list of pointers to pointers to entries.
- * @param count the amount of pointers in the list.
+ * @param entries the list of entries.
+ * @param count the amount of entries in the list.
  * @param limit the amount of entries to print.
  * @param listflags the LISTFLAG_* bits that describe what to print.
  * @param no_header if nonzero, do not print headers.
  * @param inline_header if nonzero, print headers inline (nothing printed if no_headers).
  * @param reverse if nonzero, print in reverse order.
  */
-void WADTools_ListEntriesPrint(listentry_t **entries, size_t count, size_t limit, int listflags, int no_header, int inline_header, int reverse);
+void WADTools_ListEntriesPrint(listentry_t *entries, size_t count, size_t limit, int listflags, int no_header, int inline_header, int reverse);
 
 /**
- * Sort function for an array of listentry_t*.
- * See qsort(...).
+ * Writes a list of list entries to an output stream, the same as WADTools_ListEntriesPrint().
+ * The stream is flushed, but not closed.
+ * @param out the output stream.
+ * @param entries the list of entries.
+ * @param count the amount of entries in the list.
+ * @param limit the amount of entries to print.
+ * @param listflags the LISTFLAG_* bits that describe what to print.
+ * @param no_header if nonzero, do not print headers.
+ * @param inline_header if nonzero, print headers inline (nothing printed if no_headers).
+ * @param reverse if nonzero, print in reverse order.
  */
-listentry_t** WADTools_ListEntryShadow(listentry_t *v, size_t n);
+void WADTools_ListEntriesWrite(stream_t *out, listentry_t *entries, size_t count, size_t limit, int listflags, int no_header, int inline_header, int reverse);
 
 #endif
@@ -44,6 +44,8 @@ extern int waderrno;
 #define SWITCH_STARTFROMINDEX2		"--start-index"
 #define SWITCH_STARTFROMNAME		"-sn"
 #define SWITCH_STARTFROMNAME2		"--start-name"
+#define SWITCH_COUNT				"-c"
+#define SWITCH_COUNT2				"--count"
 
 typedef struct
 {
@@ -60,6 +62,8 @@ typedef struct
 	char *startfrom;
 	/** Entry type. */
 	entry_search_type_t startfrom_entrytype;
+	/** Amount of entries to dump. */
+	int count;
 
 } wadtool_options_dump_t;
 
@@ -72,6 +76,27 @@ static void strupper(char* str)
 	}
 }
 
+// Writes a stream to the output. Returns 0 if successful, 1 on a write error, or -1 on bad or short entry data.
+static int dump_stream(stream_t *stream, stream_t *out)
+{
+	int b;
+	size_t written = 0;
+	const unsigned char *span;
+	unsigned char buf[8192];
+	// write straight from the stream's memory or buffer where possible.
+	while ((b = STREAM_Peek(stream, &span)) > 0 || (!b && (b = STREAM_Read(stream, buf, 1, 8192)) > 0))
+	{
+		if (STREAM_Write(out, span ? span : buf, b))
+			break;
+		if (span)
+			STREAM_Advance(stream, b);
+		written += b;
+	}
+	if (b > 0)
+		return 1;
+	return STREAM_Error(stream) || written != STREAM_Length(stream) ? -1 : 0;
+}
+
 static int exec(wadtool_options_dump_t *options)
 {
 	int start, index;
@@ -107,9 +132,29 @@ static int exec(wadtool_options_dump_t *options)
 		return ERRORDUMP_MISSING_PARAMETER;
 	}
 
-	stream_t *stream = STREAM_OpenWADStream(options->wad, entry);
-	if (!stream)
+	// the following entries too, back to back.
+	int i, count = WAD_EntryCount(options->wad) - index;
+	if (count > options->count)
+		count = options->count;
+	wadentry_t **entries = (wadentry_t**)malloc(sizeof(wadentry_t*) * count);
+	if (!entries)
 	{
+		fprintf(stderr, "ERROR: Out of memory.\n");
+		return ERRORDUMP_STREAM_ERROR;
+	}
+	for (i = 0; i < count; i++)
+		entries[i] = WAD_GetEntry(options->wad, index + i);
+
+	stream_t *stream;
+	if (count > 1)
+		stream = STREAM_OpenWADMultiStream(options->wad, entries, count);
+	else
+		stream = STREAM_OpenWADStream(options->wad, entry);
+
+	// zip entries are read one at a time, each checked against its CRC-32.
+	if (!stream && !(count > 1 && WAD_GetImplementation(options->wad) == WI_ZIP))
+	{
+		free(entries);
 		fprintf(stderr, "ERROR: Could not read from WAD.\n");
 		return ERRORDUMP_STREAM_ERROR;
 	}
@@ -118,18 +163,50 @@ static int exec(wadtool_options_dump_t *options)
 	_setmode(_fileno(stdout), _O_BINARY);
 #endif
 
-	int b;
-	unsigned char buf[8192];
-	while ((b = STREAM_Read(stream, buf, 1, 8192)) > 0)
+	stream_t *out = STREAM_OpenWriteFile(stdout, STREAM_WRITE_BUFFER_SIZE);
+	if (!out)
 	{
-		if (fwrite(buf, 1, b, stdout) != b)
-		{
+		if (stream)
 			STREAM_Close(stream);
-			fprintf(stderr, "ERROR: Could not write to STDOUT.\n");
+		free(entries);
+		fprintf(stderr, "ERROR: Could not write to STDOUT.\n");
+		return ERRORDUMP_STREAM_ERROR;
+	}
+
+	int err = 0;
+	if (stream)
+	{
+		err = dump_stream(stream, out);
+		STREAM_Close(stream);
+	}
+	else for (i = 0; i < count && !err; i++)
+	{
+		if (!(stream = STREAM_OpenWADStream(options->wad, entries[i])))
+		{
+			STREAM_Close(out);
+			free(entries);
+			fprintf(stderr, "ERROR: Could not read from WAD.\n");
 			return ERRORDUMP_STREAM_ERROR;
 		}
-		fflush(stdout);
+		err = dump_stream(stream, out);
+		STREAM_Close(stream);
 	}
+	free(entries);
+
+	if (err < 0)
+	{
+		STREAM_Flush(out);
+		STREAM_Close(out);
+		fprintf(stderr, "ERROR: Entry data is corrupt or incomplete.\n");
+		return ERRORDUMP_STREAM_ERROR;
+	}
+	if (err || STREAM_Flush(out))
+	{
+		STREAM_Close(out);
+		fprintf(stderr, "ERROR: Could not write to STDOUT.\n");
+		return ERRORDUMP_STREAM_ERROR;
+	}
+	STREAM_Close(out);
 
 #ifdef _WIN32
 	_setmode(_fileno(stdout), _O_TEXT);
@@ -140,6 +217,7 @@ static int exec(wadtool_options_dump_t *options)
 
 #define SWITCHSTATE_INIT		0
 #define SWITCHSTATE_STARTFROM	1
+#define SWITCHSTATE_COUNT		2
 
 // If nonzero, bad parse.
 static int parse_switches(arg_parser_t *argparser, wadtool_options_dump_t *options)
@@ -168,6 +246,20 @@ static int parse_switches(arg_parser_t *argparser, wadtool_options_dump_t *optio
 				options->startfrom_entrytype = ET_NAME;
 				state = SWITCHSTATE_STARTFROM;
 			}
+			else if (matcharg(argparser, SWITCH_COUNT) || matcharg(argparser, SWITCH_COUNT2))
+				state = SWITCHSTATE_COUNT;
+		}
+		break;
+
+		case SWITCHSTATE_COUNT:
+		{
+			char *arg = takearg(argparser);
+			if ((options->count = atoi(arg)) < 1)
+			{
+				fprintf(stderr, "ERROR: Bad count: %s\n", arg);
+				return ERRORDUMP_BAD_SWITCH;
+			}
+			state = SWITCHSTATE_INIT;
 		}
 		break;
 
@@ -185,6 +277,11 @@ static int parse_switches(arg_parser_t *argparser, wadtool_options_dump_t *optio
 		fprintf(stderr, "ERROR: Expected entry or index.\n");
 		return ERRORDUMP_MISSING_PARAMETER;
 	}
+	if (state == SWITCHSTATE_COUNT)
+	{
+		fprintf(stderr, "ERROR: Expected amount after count switch.\n");
+		return ERRORDUMP_MISSING_PARAMETER;
+	}
 
 	return 0;
 }
@@ -221,7 +318,7 @@ static int parse_file(arg_parser_t *argparser, wadtool_options_dump_t *options)
 
 static int call(arg_parser_t *argparser)
 {
-	wadtool_options_dump_t options = {NULL, NULL, NULL, ET_DETECT, NULL, ET_DETECT};
+	wadtool_options_dump_t options = {NULL, NULL, NULL, ET_DETECT, NULL, ET_DETECT, 1};
 
 	int err;
 	if ((err = parse_file(argparser, &options)))
@@ -260,10 +357,10 @@ static void usage()
 static void help()
 {
 	printf("[wadfile]:\n");
-	printf("    The name of the WAD file to open.\n");
+	printf("    The name of the WAD file (or zip/PK3 archive) to open.\n");
 	printf("\n");
 	printf("[entry]:\n");
-	printf("    The entry to dump (name or index).\n");
+	printf("    The entry to dump (name or index, or full path in a zip/PK3 archive).\n");
 	printf("\n");
 	printf("[switches]:\n");
 	printf("\n");
@@ -285,11 +382,16 @@ static void help()
 	printf("\n");
 	printf("        --start-name x      Starts the lookup from the first entry called `x`.\n");
 	printf("        -sn x\n");
+	printf("\n");
+	printf("    Output:\n");
+	printf("\n");
+	printf("        --count x           Dumps `x` entries, starting from [entry], back to back.\n");
+	printf("        -c x\n");
 }
 
 wadtool_t WADTOOL_Dump = {
 	"dump",
-	"Dumps the contents of a WAD entry to STDOUT.",
+	"Dumps the contents of a WAD entry (or entries) to STDOUT.",
 	&call,
 	&usage,
 	&help,
@@ -71,24 +71,22 @@ static int exec(wadtool_options_list_t *options)
 	}
 
 	int i;
-	int count = 0;
-	listentry_t *entrydata = (listentry_t*)WAD_MALLOC(sizeof(listentry_t) * len);
+	listentry_vector_t entries;
+	listentry_vector_Init(&entries);
+	listentry_vector_Reserve(&entries, len);
 	for (i = start; i < start + len; i++)
 	{
-		entrydata[count].index = i;
-		entrydata[count].entry = wad->entries[i];
-		count++;
+		listentry_t e = {i, wad->entries[i], WAD_GetEntryPath(wad, wad->entries[i])};
+		listentry_vector_Push(&entries, e);
 	}
-	listentry_t **entries = WADTools_ListEntryShadow(entrydata, len);
-	qsort(entries, len, sizeof(listentry_t*), options->sortfunc);
+	listentry_vector_Sort(&entries, options->sortfunc);
 
 	if (!options->no_header && !options->inline_header)
 		printf("Entries in %s, %d to %d\n", options->filename, start, start + len - 1);
 
-	WADTools_ListEntriesPrint(entries, count, count, options->listflags, options->no_header, options->inline_header, options->reverse);
+	WADTools_ListEntriesPrint(entries.items, entries.size, entries.size, options->listflags, options->no_header, options->inline_header, options->reverse);
 
-	WAD_FREE(entries);
-	WAD_FREE(entrydata);
+	listentry_vector_Free(&entries);
 	return ERRORLIST_NONE;
 }
 
@@ -272,7 +270,8 @@ static void usage()
 static void help()
 {
 	printf("[wadfile]: \n");
-	printf("    The name of the WAD file to list the entries of.\n");
+	printf("    The name of the WAD file (or zip/PK3 archive) to list the entries of.\n");
+	printf("    Entries in zip/PK3 archives are also listed with their full paths.\n");
 	printf("\n");
 	printf("[switches]: \n");
 	printf("\n");
@@ -0,0 +1,662 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include "wadtool.h"
+#include "common_list.h"
+#include "wad/wad.h"
+#include "wad/waderrno.h"
+#include "map/map_config.h"
+#include "map/mapindex.h"
+#include "map/mapdata.h"
+#include "map/mapfilter.h"
+#include "map/maperrno.h"
+
+extern int errno;
+extern int waderrno;
+
+#define ERRORMAP_NONE					0
+#define ERRORMAP_NO_FILENAME			1
+#define ERRORMAP_BAD_SWITCH				2
+#define ERRORMAP_BAD_MODE				3
+#define ERRORMAP_MISSING_PARAMETER		4
+#define ERRORMAP_BAD_PARAMETER			5
+#define ERRORMAP_WAD_ERROR				10
+#define ERRORMAP_IO_ERROR				20
+#define ERRORMAP_MAP_ERROR				30
+
+#define MODE_SEARCH						"search"
+#define TARGET_THINGS					"things"
+
+#define SWITCH_TYPE						"--type"
+#define SWITCH_TYPE2					"-t"
+#define SWITCH_FLAGS					"--flags"
+#define SWITCH_FLAGS2					"-f"
+#define SWITCH_ANYFLAGS					"--any-flags"
+#define SWITCH_ANYFLAGS2				"-af"
+#define SWITCH_NOTFLAGS					"--not-flags"
+#define SWITCH_NOTFLAGS2				"-nf"
+#define SWITCH_SKILL					"--skill"
+#define SWITCH_SKILL2					"-sk"
+#define SWITCH_BOX						"--box"
+#define SWITCH_BOX2						"-b"
+#define SWITCH_ANGLE					"--angle"
+#define SWITCH_ANGLE2					"-a"
+#define SWITCH_MAP						"--map"
+#define SWITCH_MAP2						"-m"
+#define SWITCH_MIN						"--min"
+#define SWITCH_MAX						"--max"
+#define SWITCH_LISTTHINGS				"--list-things"
+#define SWITCH_LISTTHINGS2				"-lt"
+
+#define TYPECLASS_MONSTERS				"monsters"
+
+// Doom / Doom II monster editor numbers (as ranges).
+#define DOOM_MONSTER_RANGES 8
+static int32_t doom_monster_ranges[DOOM_MONSTER_RANGES][2] =
+{
+	{7, 7},         // Spider Mastermind
+	{9, 9},         // Shotgun Guy
+	{16, 16},       // Cyberdemon
+	{58, 58},       // Spectre
+	{64, 69},       // Arch-vile, Chaingunner, Revenant, Mancubus, Arachnotron, Hell Knight
+	{71, 72},       // Pain Elemental, Commander Keen
+	{84, 84},       // Wolfenstein SS
+	{3001, 3006},   // Imp, Demon, Baron, Zombieman, Cacodemon, Lost Soul
+};
+
+/**
+ * Map tool modes.
+ */
+typedef enum
+{
+	MM_NONE,
+	MM_SEARCH_THINGS,
+
+} mapmode_t;
+
+typedef struct
+{
+	/** WAD filenames (points into the argument list). */
+	char **filenames;
+	/** Amount of WAD filenames. */
+	int filename_count;
+
+	/** Tool mode. */
+	mapmode_t mode;
+	/** If not NULL, only search this map. */
+	char *mapname;
+	/** Thing filter. */
+	mapthingfilter_t filter;
+
+	/** Minimum amount of matches for a map to be reported. */
+	int min;
+	/** Maximum amount of matches for a map to be reported (negative = no max). */
+	int max;
+	/** If nonzero, list every matching thing. */
+	int list_things;
+	/** If nonzero, don't print header. */
+	int no_header;
+
+} wadtool_options_map_t;
+
+static void strupper(char* str)
+{
+	while (*str)
+	{
+		*str = toupper(*str);
+		str++;
+	}
+}
+
+// Parses an integer. Returns nonzero if bad.
+static int parse_int(char *s, int32_t *out)
+{
+	char *end;
+	if (!s || !*s)
+		return 1;
+	*out = (int32_t)strtol(s, &end, 0);
+	return *end != '\0';
+}
+
+// Converts map units to fixed point for an edge of a box, clamped to what fixed point can hold.
+static int32_t box_fixed(int32_t units)
+{
+	int64_t out = (int64_t)units * MAP_FRACUNIT;
+	if (out > INT32_MAX)
+		return INT32_MAX;
+	if (out < INT32_MIN)
+		return INT32_MIN;
+	return (int32_t)out;
+}
+
+// Parses an integer or range of integers ("x" or "x-y"). Returns nonzero if bad.
+static int parse_range(char *s, int32_t *lo, int32_t *hi)
+{
+	char *end;
+	if (!s || !*s)
+		return 1;
+	*lo = (int32_t)strtol(s, &end, 0);
+	if (end == s)
+		return 1;
+	if (*end == '\0')
+	{
+		*hi = *lo;
+		return 0;
+	}
+	if (*end != '-')
+		return 1;
+	s = end + 1;
+	*hi = (int32_t)strtol(s, &end, 0);
+	return end == s || *end != '\0';
+}
+
+// Parses a list of types and type ranges separated by commas. Returns nonzero if bad.
+static int parse_types(char *s, mapthingfilter_t *filter)
+{
+	int i;
+	int32_t lo, hi;
+	char *token = strtok(s, ",");
+	while (token)
+	{
+		if (strcmp(token, TYPECLASS_MONSTERS) == 0)
+		{
+			for (i = 0; i < DOOM_MONSTER_RANGES; i++)
+				if (MAP_ThingFilterAddTypes(filter, doom_monster_ranges[i][0], doom_monster_ranges[i][1]))
+					return 1;
+		}
+		else if (parse_range(token, &lo, &hi) || MAP_ThingFilterAddTypes(filter, lo, hi))
+			return 1;
+		token = strtok(NULL, ",");
+	}
+	return 0;
+}
+
+// Prints a WAD error for a file.
+static int print_waderror(char *filename)
+{
+	if (waderrno == WADERROR_FILE_ERROR)
+	{
+		fprintf(stderr, "ERROR: %s: %s %s\n", filename, strwaderror(waderrno), strerror(errno));
+		return ERRORMAP_IO_ERROR + errno;
+	}
+	else
+	{
+		fprintf(stderr, "ERROR: %s: %s\n", filename, strwaderror(waderrno));
+		return ERRORMAP_WAD_ERROR + waderrno;
+	}
+}
+
+// Searches the things in all maps of one WAD.
+// Mask buffer is reused between maps and grown as needed.
+static int search_things(wadtool_options_map_t *options, char *filename, uint8_t **mask, int *mask_capacity, int *total_maps, int *total_things)
+{
+	wad_t *wad;
+	mapindex_t *index;
+	int m, i, count, err = ERRORMAP_NONE;
+
+	if (!(wad = WAD_Open(filename)))
+		return print_waderror(filename);
+
+	if (!(index = MAP_IndexCreate(wad)))
+	{
+		WAD_Close(wad);
+		fprintf(stderr, "ERROR: %s: Could not index maps.\n", filename);
+		return ERRORMAP_MAP_ERROR;
+	}
+
+	for (m = 0; m < MAP_IndexCount(index); m++)
+	{
+		mapindexentry_t *map = MAP_IndexGet(index, m);
+		wadentry_t *header = WAD_GetEntry(wad, map->header);
+		mapdata_t *data;
+
+		if (options->mapname && strncmp(header->name, options->mapname, 8) != 0)
+			continue;
+
+		if (!(data = MAP_DataRead(wad, map)))
+		{
+			fprintf(stderr, "ERROR: %s: %.8s: %s\n", filename, header->name, strmaperror(maperrno));
+			err = ERRORMAP_MAP_ERROR + maperrno;
+			continue;
+		}
+
+		if (data->things.count > *mask_capacity)
+		{
+			uint8_t *newmask = (uint8_t*)MAP_REALLOC(*mask, data->things.count);
+			if (!newmask)
+			{
+				MAP_DataDestroy(data);
+				err = ERRORMAP_MAP_ERROR + MAPERROR_OUT_OF_MEMORY;
+				break;
+			}
+			*mask = newmask;
+			*mask_capacity = data->things.count;
+		}
+
+		count = MAP_FilterThings(&(data->things), &(options->filter), *mask);
+		if (count >= options->min && (options->max < 0 || count <= options->max))
+		{
+			printf("%-24s %-8.8s %d\n", filename, header->name, count);
+			if (options->list_things) for (i = 0; i < data->things.count; i++)
+			{
+				if (!(*mask)[i])
+					continue;
+				printf("    %-10d %-6d %-8d %-8d %-5d 0x%04x\n", i,
+					data->things.type[i],
+					data->things.x[i] / MAP_FRACUNIT,
+					data->things.y[i] / MAP_FRACUNIT,
+					data->things.angle[i],
+					data->things.flags[i]
+				);
+			}
+			(*total_maps)++;
+			*total_things += count;
+		}
+
+		MAP_DataDestroy(data);
+	}
+
+	MAP_IndexDestroy(index);
+	WAD_Close(wad);
+	return err;
+}
+
+static int exec(wadtool_options_map_t *options)
+{
+	int i, err, ret = ERRORMAP_NONE;
+	int total_maps = 0, total_things = 0;
+	uint8_t *mask = NULL;
+	int mask_capacity = 0;
+
+	switch (options->mode)
+	{
+		default:
+		case MM_NONE:
+		{
+			fprintf(stderr, "ERROR: Expected mode.\n");
+			return ERRORMAP_MISSING_PARAMETER;
+		}
+
+		case MM_SEARCH_THINGS:
+		{
+			if (!options->no_header)
+			{
+				printf("%-24s %-8s %s\n", "WAD", "Map", "Things");
+				if (options->list_things)
+					printf("    %-10s %-6s %-8s %-8s %-5s %s\n", "Index", "Type", "X", "Y", "Angle", "Flags");
+				printf("------------------------------------------\n");
+			}
+
+			for (i = 0; i < options->filename_count; i++)
+			{
+				if ((err = search_things(options, options->filenames[i], &mask, &mask_capacity, &total_maps, &total_things)))
+					ret = err;
+			}
+
+			if (!options->no_header)
+				printf("Count %d maps, %d things\n", total_maps, total_things);
+		}
+		break;
+	}
+
+	if (mask)
+		MAP_FREE(mask);
+	return ret;
+}
+
+// If nonzero, bad parse.
+static int parse_mode(arg_parser_t *argparser, wadtool_options_map_t *options)
+{
+	if (matcharg(argparser, MODE_SEARCH))
+	{
+		if (matcharg(argparser, TARGET_THINGS))
+		{
+			options->mode = MM_SEARCH_THINGS;
+			return 0;
+		}
+		else if (!currarg(argparser))
+		{
+			fprintf(stderr, "ERROR: Expected search target.\n");
+			return ERRORMAP_MISSING_PARAMETER;
+		}
+		else
+		{
+			fprintf(stderr, "ERROR: Bad search target: %s\n", currarg(argparser));
+			return ERRORMAP_BAD_MODE;
+		}
+	}
+	else if (!currarg(argparser))
+	{
+		fprintf(stderr, "ERROR: Expected mode.\n");
+		return ERRORMAP_MISSING_PARAMETER;
+	}
+	else
+	{
+		fprintf(stderr, "ERROR: Bad mode: %s\n", currarg(argparser));
+		return ERRORMAP_BAD_MODE;
+	}
+}
+
+// If nonzero, bad parse.
+static int parse_files(arg_parser_t *argparser, wadtool_options_map_t *options)
+{
+	// current argument is the one before argparser->index.
+	options->filenames = argparser->argv + (argparser->index - 1);
+	options->filename_count = 0;
+	while (currarg(argparser) && !currargstart(argparser, SWITCH_PREFIX))
+	{
+		options->filename_count++;
+		nextarg(argparser);
+	}
+
+	if (!options->filename_count)
+	{
+		fprintf(stderr, "ERROR: No WAD file.\n");
+		return ERRORMAP_NO_FILENAME;
+	}
+	return 0;
+}
+
+#define SWITCHSTATE_INIT		0
+#define SWITCHSTATE_TYPE		1
+#define SWITCHSTATE_FLAGS		2
+#define SWITCHSTATE_ANYFLAGS	3
+#define SWITCHSTATE_NOTFLAGS	4
+#define SWITCHSTATE_SKILL		5
+#define SWITCHSTATE_BOX			6
+#define SWITCHSTATE_ANGLE		7
+#define SWITCHSTATE_MAP			8
+#define SWITCHSTATE_MIN			9
+#define SWITCHSTATE_MAX			10
+
+// If nonzero, bad parse.
+static int parse_switches(arg_parser_t *argparser, wadtool_options_map_t *options)
+{
+	int32_t value, lo, hi;
+	int32_t box[4];
+	int i;
+
+	int state = SWITCHSTATE_INIT;
+	while (currarg(argparser)) switch (state)
+	{
+		case SWITCHSTATE_INIT:
+		{
+			if (matcharg(argparser, SWITCH_TYPE) || matcharg(argparser, SWITCH_TYPE2))
+				state = SWITCHSTATE_TYPE;
+			else if (matcharg(argparser, SWITCH_FLAGS) || matcharg(argparser, SWITCH_FLAGS2))
+				state = SWITCHSTATE_FLAGS;
+			else if (matcharg(argparser, SWITCH_ANYFLAGS) || matcharg(argparser, SWITCH_ANYFLAGS2))
+				state = SWITCHSTATE_ANYFLAGS;
+			else if (matcharg(argparser, SWITCH_NOTFLAGS) || matcharg(argparser, SWITCH_NOTFLAGS2))
+				state = SWITCHSTATE_NOTFLAGS;
+			else if (matcharg(argparser, SWITCH_SKILL) || matcharg(argparser, SWITCH_SKILL2))
+				state = SWITCHSTATE_SKILL;
+			else if (matcharg(argparser, SWITCH_BOX) || matcharg(argparser, SWITCH_BOX2))
+				state = SWITCHSTATE_BOX;
+			else if (matcharg(argparser, SWITCH_ANGLE) || matcharg(argparser, SWITCH_ANGLE2))
+				state = SWITCHSTATE_ANGLE;
+			else if (matcharg(argparser, SWITCH_MAP) || matcharg(argparser, SWITCH_MAP2))
+				state = SWITCHSTATE_MAP;
+			else if (matcharg(argparser, SWITCH_MIN))
+				state = SWITCHSTATE_MIN;
+			else if (matcharg(argparser, SWITCH_MAX))
+				state = SWITCHSTATE_MAX;
+			else if (matcharg(argparser, SWITCH_LISTTHINGS) || matcharg(argparser, SWITCH_LISTTHINGS2))
+				options->list_things = 1;
+			else if (matcharg(argparser, SWITCH_NOHEADER) || matcharg(argparser, SWITCH_NOHEADER2))
+				options->no_header = 1;
+			else
+			{
+				fprintf(stderr, "ERROR: Bad switch: %s\n", currarg(argparser));
+				return ERRORMAP_BAD_SWITCH;
+			}
+		}
+		break;
+
+		case SWITCHSTATE_TYPE:
+		{
+			if (parse_types(currarg(argparser), &(options->filter)))
+			{
+				fprintf(stderr, "ERROR: Bad type list: %s\n", currarg(argparser));
+				return ERRORMAP_BAD_PARAMETER;
+			}
+			nextarg(argparser);
+			state = SWITCHSTATE_INIT;
+		}
+		break;
+
+		case SWITCHSTATE_FLAGS:
+		case SWITCHSTATE_ANYFLAGS:
+		case SWITCHSTATE_NOTFLAGS:
+		{
+			if (parse_int(currarg(argparser), &value))
+			{
+				fprintf(stderr, "ERROR: Bad flags: %s\n", currarg(argparser));
+				return ERRORMAP_BAD_PARAMETER;
+			}
+			if (state == SWITCHSTATE_FLAGS)
+				options->filter.flags_all |= value;
+			else if (state == SWITCHSTATE_ANYFLAGS)
+				options->filter.flags_any |= value;
+			else
+				options->filter.flags_none |= value;
+			nextarg(argparser);
+			state = SWITCHSTATE_INIT;
+		}
+		break;
+
+		case SWITCHSTATE_SKILL:
+		{
+			if (parse_int(currarg(argparser), &value) || value < 1 || value > 5)
+			{
+				fprintf(stderr, "ERROR: Bad skill (must be 1 to 5): %s\n", currarg(argparser));
+				return ERRORMAP_BAD_PARAMETER;
+			}
+			// Easy (1, 2), Medium (3), Hard (4, 5)
+			options->filter.flags_all |= value <= 2 ? 0x0001 : (value == 3 ? 0x0002 : 0x0004);
+			nextarg(argparser);
+			state = SWITCHSTATE_INIT;
+		}
+		break;
+
+		case SWITCHSTATE_BOX:
+		{
+			for (i = 0; i < 4; i++)
+			{
+				if (parse_int(currarg(argparser), &box[i]))
+				{
+					fprintf(stderr, "ERROR: Expected 4 coordinates after `box` switch.\n");
+					return ERRORMAP_BAD_PARAMETER;
+				}
+				nextarg(argparser);
+			}
+			options->filter.use_box = 1;
+			options->filter.box_x.lo = box_fixed(box[0] < box[2] ? box[0] : box[2]);
+			options->filter.box_x.hi = box_fixed(box[0] < box[2] ? box[2] : box[0]);
+			options->filter.box_y.lo = box_fixed(box[1] < box[3] ? box[1] : box[3]);
+			options->filter.box_y.hi = box_fixed(box[1] < box[3] ? box[3] : box[1]);
+			state = SWITCHSTATE_INIT;
+		}
+		break;
+
+		case SWITCHSTATE_ANGLE:
+		{
+			if (parse_range(currarg(argparser), &lo, &hi))
+			{
+				fprintf(stderr, "ERROR: Bad angle: %s\n", currarg(argparser));
+				return ERRORMAP_BAD_PARAMETER;
+			}
+			options->filter.use_angle = 1;
+			options->filter.angle.lo = lo;
+			options->filter.angle.hi = hi;
+			nextarg(argparser);
+			state = SWITCHSTATE_INIT;
+		}
+		break;
+
+		case SWITCHSTATE_MAP:
+		{
+			options->mapname = takearg(argparser);
+			strupper(options->mapname);
+			state = SWITCHSTATE_INIT;
+		}
+		break;
+
+		case SWITCHSTATE_MIN:
+		case SWITCHSTATE_MAX:
+		{
+			if (parse_int(currarg(argparser), &value))
+			{
+				fprintf(stderr, "ERROR: Bad amount: %s\n", currarg(argparser));
+				return ERRORMAP_BAD_PARAMETER;
+			}
+			if (state == SWITCHSTATE_MIN)
+				options->min = value;
+			else
+				options->max = value;
+			nextarg(argparser);
+			state = SWITCHSTATE_INIT;
+		}
+		break;
+	}
+
+	if (state == SWITCHSTATE_TYPE)
+	{
+		fprintf(stderr, "ERROR: Expected types after `type` switch.\n");
+		return ERRORMAP_MISSING_PARAMETER;
+	}
+	else if (state == SWITCHSTATE_FLAGS || state == SWITCHSTATE_ANYFLAGS || state == SWITCHSTATE_NOTFLAGS)
+	{
+		fprintf(stderr, "ERROR: Expected flags after flags switch.\n");
+		return ERRORMAP_MISSING_PARAMETER;
+	}
+	else if (state == SWITCHSTATE_SKILL)
+	{
+		fprintf(stderr, "ERROR: Expected skill after `skill` switch.\n");
+		return ERRORMAP_MISSING_PARAMETER;
+	}
+	else if (state == SWITCHSTATE_ANGLE)
+	{
+		fprintf(stderr, "ERROR: Expected angle after `angle` switch.\n");
+		return ERRORMAP_MISSING_PARAMETER;
+	}
+	else if (state == SWITCHSTATE_MAP)
+	{
+		fprintf(stderr, "ERROR: Expected map name after `map` switch.\n");
+		return ERRORMAP_MISSING_PARAMETER;
+	}
+	else if (state == SWITCHSTATE_MIN || state == SWITCHSTATE_MAX)
+	{
+		fprintf(stderr, "ERROR: Expected amount after `min`/`max` switch.\n");
+		return ERRORMAP_MISSING_PARAMETER;
+	}
+
+	return 0;
+}
+
+static int call(arg_parser_t *argparser)
+{
+	wadtool_options_map_t options;
+	memset(&options, 0, sizeof(wadtool_options_map_t));
+	MAP_ThingFilterInit(&(options.filter));
+	options.mode = MM_NONE;
+	options.min = 1;
+	options.max = -1;
+
+	int err;
+	if ((err = parse_mode(argparser, &options)))
+	{
+		return err;
+	}
+	if ((err = parse_files(argparser, &options)))
+	{
+		return err;
+	}
+	if ((err = parse_switches(argparser, &options)))
+	{
+		return err;
+	}
+
+	return exec(&options);
+}
+
+static void usage()
+{
+	printf("Usage: wad map [mode] ...\n");
+	printf("\n");
+	printf("       wad map search things [wadfiles] [switches]\n");
+}
+
+static void help()
+{
+	printf("[mode]: \n");
+	printf("    The map tool mode.\n");
+	printf("\n");
+	printf("        search things       Finds things in every map in a set of WADs, and\n");
+	printf("                            prints the amount of matching things per map.\n");
+	printf("\n");
+	printf("[wadfiles]: \n");
+	printf("    The names of one or more WAD files to search.\n");
+	printf("\n");
+	printf("[switches]: \n");
+	printf("\n");
+	printf("    Criteria (all must match):\n");
+	printf("\n");
+	printf("        --type [types]      Matches things of any of these types. [types] is a\n");
+	printf("        -t [types]          comma-separated list of editor numbers, ranges\n");
+	printf("                            (`3001-3006`), or `monsters` (Doom monsters).\n");
+	printf("\n");
+	printf("        --flags x           Matches things with all of the flags in `x` set.\n");
+	printf("        -f x\n");
+	printf("\n");
+	printf("        --any-flags x       Matches things with any of the flags in `x` set.\n");
+	printf("        -af x\n");
+	printf("\n");
+	printf("        --not-flags x       Matches things with none of the flags in `x` set.\n");
+	printf("        -nf x\n");
+	printf("\n");
+	printf("        --skill x           Matches things present on skill `x` (1 to 5).\n");
+	printf("        -sk x\n");
+	printf("\n");
+	printf("        --box x1 y1 x2 y2   Matches things inside a box (map units, inclusive).\n");
+	printf("        -b x1 y1 x2 y2\n");
+	printf("\n");
+	printf("        --angle x           Matches things facing angle `x` or in range `x-y`\n");
+	printf("        -a x                (degrees - ranges like `315-45` wrap around).\n");
+	printf("\n");
+	printf("        --map x             Only searches maps with the header name `x`.\n");
+	printf("        -m x\n");
+	printf("\n");
+	printf("    Output:\n");
+	printf("\n");
+	printf("        --min x             Only reports maps with at least `x` matches\n");
+	printf("                            (default 1).\n");
+	printf("\n");
+	printf("        --max x             Only reports maps with at most `x` matches.\n");
+	printf("\n");
+	printf("        --list-things       Also prints each matching thing.\n");
+	printf("        -lt\n");
+	printf("\n");
+	printf("        --no-header         Do not print the output header (and footer).\n");
+	printf("        -nh\n");
+	printf("\n");
+	printf("    Numbers can be decimal, hexadecimal (`0x`), or octal (leading `0`).\n");
+}
+
+wadtool_t WADTOOL_Map = {
+	"map",
+	"Searches the map data in WADs.",
+	&call,
+	&usage,
+	&help,
+};
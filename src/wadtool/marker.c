@@ -12,6 +12,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include "wadtool.h"
+#include "common.h"
 #include "wad/wad.h"
 #include "wad/waderrno.h"
 
@@ -89,7 +90,7 @@ static int parse_file(arg_parser_t *argparser, wadtool_options_marker_t *options
 	}
 
 	// Open a file.
-	options->wad = WAD_Open(options->filename);
+	options->wad = WADTools_OpenWAD(options->filename);
 
 	if (!options->wad)
 	{
@@ -139,12 +140,12 @@ static int call(arg_parser_t *argparser)
 	}
 	if ((err = parse_switches(argparser, &options)))
 	{
-		WAD_Close(options.wad);
+		WADTools_CloseWAD(options.wad);
 		return err;
 	}
 	
 	int ret = exec(&options);
-	WAD_Close(options.wad);
+	WADTools_CloseWAD(options.wad);
 	return ret;
 }
 
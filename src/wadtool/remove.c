@@ -12,6 +12,7 @@
 #include <errno.h>
 #include <ctype.h>
 #include "wadtool.h"
+#include "common.h"
 #include "wad/wad.h"
 #include "wad/waderrno.h"
 
@@ -84,7 +85,7 @@ static int parse_file(arg_parser_t *argparser, wadtool_options_remove_t *options
 	}
 
 	// Open a file.
-	options->wad = WAD_Open(options->filename);
+	options->wad = WADTools_OpenWAD(options->filename);
 
 	if (!options->wad)
 	{
@@ -148,12 +149,12 @@ static int call(arg_parser_t *argparser)
 	}
 	if ((err = parse_switches(argparser, &options)))
 	{
-		WAD_Close(options.wad);
+		WADTools_CloseWAD(options.wad);
 		return err;
 	}
 	
 	int ret = exec(&options);
-	WAD_Close(options.wad);
+	WADTools_CloseWAD(options.wad);
 	return ret;
 }
 
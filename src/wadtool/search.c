@@ -17,6 +17,7 @@
 #include "wad/wad_config.h"
 #include "wad/wad.h"
 #include "wad/waderrno.h"
+#include "map/mapindex.h"
 
 extern int errno;
 extern int waderrno;
@@ -38,49 +39,6 @@ extern int waderrno;
 #define MODE_NAME                       "name"
 #define MODE_NAMESPACE                  "namespace"
 
-#define MAPENTRY_SEARCHNAME             "THINGS"
-#define MAPENTRY_SEARCHNAME2            "TEXTMAP"
-
-// MUST BE ALPHABETICAL!
-#define MAP_ENTRY_NAMES_COUNT 22
-static char* map_entry_names[MAP_ENTRY_NAMES_COUNT] = 
-{
-	"BEHAVIOR",
-	"BLOCKMAP",
-	"DIALOGUE",
-	"ENDMAP",
-	"GL_NODES",
-	"GL_PVS",
-	"GL_SEGS",
-	"GL_SSECT",
-	"GL_VERT",
-	"LINEDEFS",
-	"NODES",
-	"PWADINFO",
-	"REJECT",	
-	"SCRIPTS",
-	"SECTORS",
-	"SEGS",
-	"SIDEDEFS",
-	"SSECTORS",
-	"TEXTMAP",
-	"THINGS",
-	"VERTEXES",
-	"ZNODES",
-};
-
-// Find a map entry by name, add to list if found.
-static int accum_map_entry(int* list, int index, wad_t *wad, char* name, int offset)
-{
-	int out = WAD_GetEntryIndexOffset(wad, name, offset);
-	if (out >= 0)
-	{
-		list[index] = out;
-		return out;
-	}
-	return -1;
-}
-
 /**
  * Search types.
  */
@@ -136,10 +94,11 @@ static int exec(wadtool_options_search_t *options)
 	wad_t *wad = options->wad;
 
 	int i, len = WAD_EntryCount(wad);
-	listentry_t **entries;
-	listentry_t *entrydata;
+	listentry_vector_t entries;
 	int count;
 
+	listentry_vector_Init(&entries);
+
 	switch (options->searchtype)
 	{
 		/***** Nothing *****/
@@ -153,83 +112,50 @@ static int exec(wadtool_options_search_t *options)
 		/***** Maps Search Mode *****/
 		case ST_MAPS:
 		{
-			count = 0;
-			for (i = 1; i < len; i++)
-			{
-				wadentry_t *entry = WAD_GetEntry(wad, i);
-				if (strncmp(entry->name, MAPENTRY_SEARCHNAME, 8) == 0)
-					count++;
-				else if (strncmp(entry->name, MAPENTRY_SEARCHNAME2, 8) == 0)
-					count++;
-			}
+			mapindex_t *index = MAP_IndexCreate(wad);
+			count = MAP_IndexCount(index);
 
 			if (!count)
 			{
+				MAP_IndexDestroy(index);
 				if (!options->no_header)
 					printf("No entries.\n");
 				return ERRORSEARCH_NONE;
 			}
 
-			entrydata = (listentry_t*)WAD_MALLOC(sizeof(listentry_t) * count);
-
-			count = 0;
-			for (i = 1; i < len; i++)
+			listentry_vector_Reserve(&entries, count);
+			for (i = 0; i < count; i++)
 			{
-				wadentry_t *entry = WAD_GetEntry(wad, i);
-				if (strncmp(entry->name, MAPENTRY_SEARCHNAME, 8) == 0 || strncmp(entry->name, MAPENTRY_SEARCHNAME2, 8) == 0)
-				{
-					entrydata[count].index = i - 1;
-					entrydata[count].entry = WAD_GetEntry(wad, i - 1);
-					count++;
-				}
+				int header = MAP_IndexGet(index, i)->header;
+				wadentry_t *entry = WAD_GetEntry(wad, header);
+				listentry_t e = {header, entry, WAD_GetEntryPath(wad, entry)};
+				listentry_vector_Push(&entries, e);
 			}
-			entries = WADTools_ListEntryShadow(entrydata, count);
-			qsort(entries, count, sizeof(listentry_t*), options->sortfunc);
+			MAP_IndexDestroy(index);
 		}
 		break;
 
 		case ST_MAP:
 		{
-			int offset = WAD_GetEntryIndex(wad, options->criterion0);
-			if (offset < 0)
+			mapindex_t *index = MAP_IndexCreate(wad);
+			mapindexentry_t *map = MAP_IndexFind(index, wad, options->criterion0);
+			if (!map)
 			{
+				MAP_IndexDestroy(index);
 				fprintf(stderr, "ERROR: Map name %s not found!\n", options->criterion0);
 				return ERRORSEARCH_MAP_NOT_FOUND;
 			}
 
-			// Output array of indices, filled with -1 (same when int-sized).
-			int indices[MAP_ENTRY_NAMES_COUNT];
-			memset(indices, 0xFF, sizeof(int) * (MAP_ENTRY_NAMES_COUNT));
-			count = 0;
-			for (i = 0; i < MAP_ENTRY_NAMES_COUNT; i++)
-			{
-				int index = accum_map_entry(indices, count, wad, map_entry_names[i], offset);
-				if (index >= offset)
-					indices[count++] = index;
-			}
-			
-			if (!count)
-			{
-				if (!options->no_header)
-					printf("No entries.\n");
-				return ERRORSEARCH_NONE;
-			}
-
-			wadentry_t *entry;
 			// add one to count to accommodate header entry
-			entrydata = (listentry_t*)WAD_MALLOC(sizeof(listentry_t) * (count + 1));
+			count = map->count + 1;
+			listentry_vector_Reserve(&entries, count);
 			for (i = 0; i < count; i++)
 			{
-				int index = indices[i];
-				entry = WAD_GetEntry(wad, index);
-				entrydata[i].index = index;
-				entrydata[i].entry = entry;
+				wadentry_t *entry = WAD_GetEntry(wad, map->header + i);
+				listentry_t e = {map->header + i, entry, WAD_GetEntryPath(wad, entry)};
+				listentry_vector_Push(&entries, e);
 			}
-			entrydata[count].index = offset;
-			entrydata[count].entry = WAD_GetEntry(wad, offset);
-			count++;
-			entries = WADTools_ListEntryShadow(entrydata, count);
-			qsort(entries, count, sizeof(listentry_t*), options->sortfunc);
+			MAP_IndexDestroy(index);
 		}
 		break;
 
@@ -238,44 +164,55 @@ static int exec(wadtool_options_search_t *options)
 			char ename[9];
 			ename[8] = '\0';
 
-			count = 0;
 			for (i = 0; i < len; i++)
 			{
 				wadentry_t *entry = WAD_GetEntry(wad, i);
 				memcpy(ename, entry->name, 8);
 				if (strstr(ename, options->criterion0) == ename) // starts with
-					count++;
+				{
+					listentry_t e = {i, entry, WAD_GetEntryPath(wad, entry)};
+					listentry_vector_Push(&entries, e);
+				}
 			}
 
-			if (!count)
+			if (!entries.size)
 			{
+				listentry_vector_Free(&entries);
 				if (!options->no_header)
 					printf("No entries.\n");
 				return ERRORSEARCH_NONE;
 			}
+		}
+		break;
 
-			entrydata = (listentry_t*)WAD_MALLOC(sizeof(listentry_t) * count);
+		case ST_NAMESPACE:
+		{
+			char sname[9], ename[9];
 
-			count = 0;
-			for (i = 0; i < len; i++)
+			// in zip archives, namespaces are folders.
+			if (WAD_GetImplementation(wad) == WI_ZIP)
 			{
-				wadentry_t *entry = WAD_GetEntry(wad, i);
-				memcpy(ename, entry->name, 8);
-				if (strstr(ename, options->criterion0) == ename) // starts with
+				size_t folderlen = strlen(options->criterion0);
+				for (i = 0; i < len; i++)
+				{
+					wadentry_t *entry = WAD_GetEntry(wad, i);
+					const char *path = WAD_GetEntryPath(wad, entry);
+					if (!strnicmp(path, options->criterion0, folderlen) && path[folderlen] == '/')
+					{
+						listentry_t e = {i, entry, path};
+						listentry_vector_Push(&entries, e);
+					}
+				}
+				if (!entries.size)
 				{
-					entrydata[count].index = i;
-					entrydata[count].entry = entry;
-					count++;
+					listentry_vector_Free(&entries);
+					if (!options->no_header)
+						printf("No entries.\n");
+					return ERRORSEARCH_NONE;
 				}
+				break;
 			}
-			entries = WADTools_ListEntryShadow(entrydata, count);
-			qsort(entries, count, sizeof(listentry_t*), options->sortfunc);
-		}
-		break;
 
-		case ST_NAMESPACE:
-		{
-			char sname[9], ename[9];
 			sprintf(sname, "%.2s_START", options->criterion0);
 			sprintf(ename, "%.2s_END", options->criterion0);
 
@@ -290,22 +227,21 @@ static int exec(wadtool_options_search_t *options)
 				return ERRORSEARCH_NONE;
 			}
 
-			entrydata = (listentry_t*)WAD_MALLOC(sizeof(listentry_t) * count);
-			count = 0;
+			listentry_vector_Reserve(&entries, count);
 			for (i = start_index + 1; i < end_index; i++)
 			{
 				wadentry_t *entry = WAD_GetEntry(wad, i);
-				entrydata[count].index = i;
-				entrydata[count].entry = entry;
-				count++;
+				listentry_t e = {i, entry, WAD_GetEntryPath(wad, entry)};
+				listentry_vector_Push(&entries, e);
 			}
-			entries = WADTools_ListEntryShadow(entrydata, count);
-			qsort(entries, count, sizeof(listentry_t*), options->sortfunc);
 		}
 		break;
 
 	}
 
+	listentry_vector_Sort(&entries, options->sortfunc);
+	count = entries.size;
+
 	if (!options->no_header && !options->inline_header)
 	{
 		printf("Entries in %s\n", options->filename);
@@ -325,7 +261,10 @@ static int exec(wadtool_options_search_t *options)
 				printf("Listing entries starting with `%s`.\n", options->criterion0); 
 				break;
 			case ST_NAMESPACE:
-				printf("Listing entries in namespace %.2s_START / %.2s_END.\n", options->criterion0, options->criterion0);
+				if (WAD_GetImplementation(wad) == WI_ZIP)
+					printf("Listing entries in folder %s.\n", options->criterion0);
+				else
+					printf("Listing entries in namespace %.2s_START / %.2s_END.\n", options->criterion0, options->criterion0);
 				break;
 		}
 	}
@@ -333,10 +272,9 @@ static int exec(wadtool_options_search_t *options)
 	// sanitize limit
 	options->limit = options->limit <= 0 ? count : options->limit;
 
-	WADTools_ListEntriesPrint(entries, count, options->limit, options->listflags, options->no_header, options->inline_header, options->reverse);
+	WADTools_ListEntriesPrint(entries.items, count, options->limit, options->listflags, options->no_header, options->inline_header, options->reverse);
 
-	if (entries) WAD_FREE(entries);
-	if (entrydata) WAD_FREE(entrydata);
+	listentry_vector_Free(&entries);
 	return ERRORSEARCH_NONE;
 }
 
@@ -608,8 +546,11 @@ static void help()
 	printf("                                The namespace characters (only up to two are\n");
 	printf("                                used).\n");
 	printf("\n");
+	printf("                            In zip/PK3 archives, finds all entries in the\n");
+	printf("                            folder [prefix] instead.\n");
+	printf("\n");
 	printf("[wadfile]: \n");
-	printf("    The name of the WAD file to search the entries of.\n");
+	printf("    The name of the WAD file (or zip/PK3 archive) to search the entries of.\n");
 	printf("\n");
 	printf("[switches]: \n");
 	printf("\n");
@@ -0,0 +1,1339 @@
+/*****************************************************************************
+ * Copyright (c) 2018 Matt Tropiano
+ * All rights reserved. This source and the accompanying materials
+ * are made available under the terms of the GNU Lesser Public License v2.1
+ * which accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include "wadtool.h"
+#include "common.h"
+#include "serve.h"
+#include "wad/wad.h"
+#include "wad/waderrno.h"
+#include "wadio/wadstream.h"
+#include "io/stream.h"
+#include "map/mapindex.h"
+#include "struct/mt_hashmap.h"
+
+#ifndef _WIN32
+#include <limits.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#endif
+
+extern int errno;
+extern int waderrno;
+
+#define ERRORSERVE_NONE                 0
+#define ERRORSERVE_NO_SOCKET            1
+#define ERRORSERVE_BAD_SWITCH           2
+#define ERRORSERVE_MISSING_PARAMETER    3
+#define ERRORSERVE_NOT_SUPPORTED        4
+#define ERRORSERVE_BAD_REQUEST          5
+#define ERRORSERVE_BAD_COMMAND          6
+#define ERRORSERVE_BAD_ENTRY            7
+#define ERRORSERVE_BAD_MODE             8
+#define ERRORSERVE_WAD_ERROR            10
+#define ERRORSERVE_IO_ERROR             20
+#define ERRORSERVE_MAP_NOT_FOUND        30
+
+#define SWITCH_SOCKET                   "-s"
+#define SWITCH_SOCKET2                  "--socket"
+#define SWITCH_THREADS                  "-t"
+#define SWITCH_THREADS2                 "--threads"
+#define SWITCH_CACHE                    "-c"
+#define SWITCH_CACHE2                   "--cache"
+
+#define COMMAND_INFO                    "info"
+#define COMMAND_LIST                    "list"
+#define COMMAND_SEARCH                  "search"
+#define COMMAND_DUMP                    "dump"
+
+#define MODE_MAP                        "map"
+#define MODE_MAPS                       "maps"
+#define MODE_NAME                       "name"
+#define MODE_NAMESPACE                  "namespace"
+
+/**
+ * Search types.
+ */
+typedef enum 
+{
+	ST_MAPS,
+	ST_MAP,
+	ST_NAME,
+	ST_NAMESPACE,
+
+} searchtype_t;
+
+#define SERVE_DEFAULT_THREADS           8
+#define SERVE_DEFAULT_CACHE             64
+#define SERVE_MAX_THREADS               256
+#define SERVE_QUEUE_SIZE                64
+#define SERVE_REQUEST_MAX               4096
+#define SERVE_ARGS_MAX                  16
+#define SERVE_COPY_BUFFER_SIZE          65536
+#define SERVE_CONNECTIONS_MAX           1024
+#define SERVE_IO_TIMEOUT                10
+
+typedef struct
+{
+	/** Path of the socket to listen on. */
+	char *socketPath;
+	/** Amount of worker threads. */
+	int threads;
+	/** Most WADs to keep open. */
+	int cache;
+
+} wadtool_options_serve_t;
+
+static void strupper(char* str)
+{
+	while (*str)
+	{
+		*str = toupper(*str);
+		str++;
+	}
+}
+
+#ifndef _WIN32
+
+/**
+ * A WAD kept open by the server.
+ */
+typedef struct
+{
+	/** Full path of the file (the key in the server's cache). */
+	char *path;
+	/** Guards everything below: queries hold it for reading, reloads for writing. */
+	pthread_rwlock_t lock;
+
+	/** The open WAD (an entry list only, or a zip archive), or NULL if not loaded. */
+	wad_t *wad;
+	/** The file, for reading content positionally. */
+	int fd;
+	/** Device of the file when it was loaded. */
+	dev_t dev;
+	/** Inode of the file when it was loaded. */
+	ino_t ino;
+	/** Size of the file when it was loaded. */
+	off_t size;
+	/** Modification time of the file when it was loaded. */
+	time_t mtime;
+
+	/** Every entry's name, null-terminated (9 characters each). */
+	char *names;
+	/** Entry name to the index of its first entry (as intptr_t). Keys are in names. */
+	mt_hashmap_t *name_index;
+	/** If a zip archive, full path to entry index (as intptr_t), ignoring case. */
+	mt_hashmap_t *path_index;
+	/** The maps in the WAD. */
+	mapindex_t *maps;
+	/** If a zip archive, a flag for each entry whose content matched its CRC-32 (see served_verify()). */
+	unsigned char *verified;
+	/** Guards verified, which queries set while holding the read lock. */
+	pthread_mutex_t verify_lock;
+
+	/** Amount of requests using this (guarded by the server's cache_lock). It is only evicted when unused. */
+	int refs;
+	/** When this was last used, in requests (guarded by the server's cache_lock). */
+	unsigned long used;
+
+} served_wad_t;
+
+/**
+ * Server state, shared by all threads.
+ */
+typedef struct
+{
+	/** Connections waiting for a worker (a ring). */
+	int queue[SERVE_QUEUE_SIZE];
+	/** Position of the first waiting connection. */
+	int queue_head;
+	/** Amount of waiting connections. */
+	int queue_count;
+	/** Guards the queue. */
+	pthread_mutex_t queue_lock;
+	/** Signaled when a connection is queued. */
+	pthread_cond_t queue_filled;
+	/** Signaled when a connection is taken off the queue. */
+	pthread_cond_t queue_drained;
+	/** Connections that workers answered a request on, to wait for the next one (guarded by queue_lock). */
+	int returned[SERVE_CONNECTIONS_MAX];
+	/** Amount of returned connections. */
+	int returned_count;
+	/** Amount of open connections (guarded by queue_lock). */
+	int connection_count;
+	/** Pipe that workers write to, to wake the listening thread for returned connections. */
+	int wake[2];
+
+	/** Full path to served_wad_t. */
+	mt_hashmap_t *cache;
+	/** Guards the cache (not the WADs in it). */
+	pthread_mutex_t cache_lock;
+	/** Most WADs to keep in the cache. Past that, the least recently used unused ones are closed. */
+	int cache_max;
+	/** Request counter, for when cached WADs were last used. */
+	unsigned long cache_clock;
+	/** Guards loading, since waderrno is shared by every thread. */
+	pthread_mutex_t load_lock;
+
+} server_t;
+
+// Set by the signal handler to stop accepting connections.
+static volatile sig_atomic_t serve_stop = 0;
+
+static void serve_signal(int sig)
+{
+	serve_stop = 1;
+}
+
+static void put_uint32(unsigned char *out, uint32_t value)
+{
+	out[0] = value & 0xff;
+	out[1] = (value >> 8) & 0xff;
+	out[2] = (value >> 16) & 0xff;
+	out[3] = (value >> 24) & 0xff;
+}
+
+static uint32_t get_uint32(const unsigned char *in)
+{
+	return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// Reads exactly length bytes. If nonzero, error or end of stream.
+static int recv_all(int fd, void *data, size_t length)
+{
+	unsigned char *ptr = (unsigned char*)data;
+	while (length)
+	{
+		ssize_t amount = read(fd, ptr, length);
+		if (amount < 0 && errno == EINTR)
+			continue;
+		if (amount <= 0)
+			return 1;
+		ptr += amount;
+		length -= amount;
+	}
+	return 0;
+}
+
+// Writes exactly length bytes. If nonzero, error.
+static int send_all(int fd, const void *data, size_t length)
+{
+	const unsigned char *ptr = (const unsigned char*)data;
+	while (length)
+	{
+		ssize_t amount = write(fd, ptr, length);
+		if (amount < 0 && errno == EINTR)
+			continue;
+		if (amount <= 0)
+			return 1;
+		ptr += amount;
+		length -= amount;
+	}
+	return 0;
+}
+
+// Writes a response header: status, then the payload length.
+static int send_header(int fd, int status, size_t length)
+{
+	unsigned char header[8];
+	put_uint32(header, (uint32_t)status);
+	put_uint32(header + 4, (uint32_t)length);
+	return send_all(fd, header, 8);
+}
+
+// Writes a section of a file without copying it through user space where possible. If nonzero, error.
+static int send_file(int fd, int source, off_t offset, size_t length)
+{
+#ifdef __linux__
+	while (length)
+	{
+		ssize_t amount = sendfile(fd, source, &offset, length);
+		if (amount < 0 && errno == EINTR)
+			continue;
+		if (amount < 0 && (errno == EINVAL || errno == ENOSYS))
+			break; // not supported for these descriptors - copy it instead.
+		if (amount <= 0)
+			return 1;
+		length -= amount;
+	}
+#endif
+
+	unsigned char buffer[SERVE_COPY_BUFFER_SIZE];
+	while (length)
+	{
+		ssize_t amount = pread(source, buffer, length < SERVE_COPY_BUFFER_SIZE ? length : SERVE_COPY_BUFFER_SIZE, offset);
+		if (amount < 0 && errno == EINTR)
+			continue;
+		if (amount <= 0 || send_all(fd, buffer, amount))
+			return 1;
+		offset += amount;
+		length -= amount;
+	}
+	return 0;
+}
+
+// Frees everything loaded for a WAD (hold the load lock).
+static void served_unload(served_wad_t *served)
+{
+	if (served->maps)
+		MAP_IndexDestroy(served->maps);
+	if (served->path_index)
+		MT_HashMapDestroy(served->path_index);
+	if (served->name_index)
+		MT_HashMapDestroy(served->name_index);
+	free(served->names);
+	free(served->verified);
+	if (served->fd >= 0)
+		close(served->fd);
+	if (served->wad)
+		WAD_Close(served->wad);
+
+	served->maps = NULL;
+	served->path_index = NULL;
+	served->name_index = NULL;
+	served->names = NULL;
+	served->verified = NULL;
+	served->fd = -1;
+	served->wad = NULL;
+}
+
+// Frees a WAD that was removed from the cache.
+static void served_free(server_t *server, served_wad_t *served)
+{
+	pthread_mutex_lock(&server->load_lock);
+	served_unload(served);
+	pthread_mutex_unlock(&server->load_lock);
+	pthread_rwlock_destroy(&served->lock);
+	pthread_mutex_destroy(&served->verify_lock);
+	free(served->path);
+	free(served);
+}
+
+// Removes the least recently used WAD that no request is using, if the cache is over its max (hold the cache lock).
+// Each new WAD calls this, so the cache only stays over while every WAD in it is in use.
+// Returns the WAD to free with served_free() (after unlocking), or NULL if none.
+static served_wad_t* served_evict(server_t *server)
+{
+	int position = 0;
+	void *key, *value;
+	served_wad_t *oldest = NULL;
+
+	if (MT_HashMapLength(server->cache) <= server->cache_max)
+		return NULL;
+	while (MT_HashMapNext(server->cache, &position, &key, &value))
+	{
+		served_wad_t *served = (served_wad_t*)value;
+		if (!served->refs && (!oldest || served->used < oldest->used))
+			oldest = served;
+	}
+	if (oldest)
+		MT_HashMapRemove(server->cache, oldest->path);
+	return oldest;
+}
+
+// Releases a WAD from served_get() (or its lock, on error).
+static void served_release(server_t *server, served_wad_t *served)
+{
+	pthread_rwlock_unlock(&served->lock);
+	pthread_mutex_lock(&server->cache_lock);
+	served->refs--;
+	pthread_mutex_unlock(&server->cache_lock);
+}
+
+// Loads a WAD and its indices (hold the load lock). If nonzero, error, and out has the message.
+static int served_load_wad(served_wad_t *served, struct stat *st, stream_t *out)
+{
+	int i, count, err = ERRORSERVE_NONE;
+
+	if (!(served->wad = WAD_OpenMap(served->path)))
+	{
+		if (waderrno == WADERROR_FILE_ERROR)
+		{
+			STREAM_Printf(out, "ERROR: %s %s\n", strwaderror(waderrno), strerror(errno));
+			err = ERRORSERVE_IO_ERROR + errno;
+		}
+		else
+		{
+			STREAM_Printf(out, "ERROR: %s\n", strwaderror(waderrno));
+			err = ERRORSERVE_WAD_ERROR + waderrno;
+		}
+		return err;
+	}
+
+	if ((served->fd = open(served->path, O_RDONLY)) < 0)
+	{
+		STREAM_Printf(out, "ERROR: %s\n", strerror(errno));
+		err = ERRORSERVE_IO_ERROR + errno;
+		served_unload(served);
+		return err;
+	}
+
+	wad_t *wad = served->wad;
+	count = WAD_EntryCount(wad);
+	served->names = (char*)malloc(sizeof(char) * 9 * (count > 0 ? count : 1));
+	served->name_index = MT_HashMapCreate(count, &MT_HashString, &MT_EqualString);
+	served->maps = MAP_IndexCreate(wad);
+	if (WAD_GetImplementation(wad) == WI_ZIP)
+	{
+		served->path_index = MT_HashMapCreate(count, &MT_HashStringCI, &MT_EqualStringCI);
+		served->verified = (unsigned char*)calloc(count > 0 ? count : 1, sizeof(unsigned char));
+	}
+
+	if (!served->names || !served->name_index || !served->maps || (WAD_GetImplementation(wad) == WI_ZIP && (!served->path_index || !served->verified)))
+	{
+		STREAM_Printf(out, "ERROR: %s\n", strwaderror(WADERROR_OUT_OF_MEMORY));
+		served_unload(served);
+		return ERRORSERVE_WAD_ERROR + WADERROR_OUT_OF_MEMORY;
+	}
+
+	// first of each name wins, the same as searching from the start.
+	for (i = 0; i < count; i++)
+	{
+		char *name = served->names + (i * 9);
+		sprintf(name, "%-.8s", wad->entries[i]->name);
+		if (!MT_HashMapContainsKey(served->name_index, name))
+			MT_HashMapPut(served->name_index, name, (void*)(intptr_t)i);
+		if (served->path_index)
+		{
+			char *path = (char*)WAD_GetEntryPath(wad, wad->entries[i]);
+			if (!MT_HashMapContainsKey(served->path_index, path))
+				MT_HashMapPut(served->path_index, path, (void*)(intptr_t)i);
+		}
+	}
+
+	served->dev = st->st_dev;
+	served->ino = st->st_ino;
+	served->size = st->st_size;
+	served->mtime = st->st_mtime;
+	return ERRORSERVE_NONE;
+}
+
+// (Re)loads a WAD and its indices (hold the write lock). If nonzero, error, and out has the message.
+// Loading and unloading hold the load lock, since waderrno is shared by every thread.
+static int served_load(server_t *server, served_wad_t *served, struct stat *st, stream_t *out)
+{
+	pthread_mutex_lock(&server->load_lock);
+	served_unload(served);
+	int err = served_load_wad(served, st, out);
+	pthread_mutex_unlock(&server->load_lock);
+	return err;
+}
+
+// Checks if a loaded WAD is still the one on disk.
+static int served_current(served_wad_t *served, struct stat *st)
+{
+	return served->wad
+		&& served->dev == st->st_dev
+		&& served->ino == st->st_ino
+		&& served->size == st->st_size
+		&& served->mtime == st->st_mtime;
+}
+
+// Gets a WAD from the cache, read-locked, (re)loading it if the file is new or changed.
+// Release it with served_release(). Returns NULL on error, and out has the message.
+static served_wad_t* served_get(server_t *server, const char *filename, stream_t *out, int *err)
+{
+	char path[PATH_MAX];
+	struct stat st;
+
+	if (!realpath(filename, path) || stat(path, &st))
+	{
+		STREAM_Printf(out, "ERROR: %s %s\n", strwaderror(WADERROR_FILE_ERROR), strerror(errno));
+		*err = ERRORSERVE_IO_ERROR + errno;
+		return NULL;
+	}
+
+	pthread_mutex_lock(&server->cache_lock);
+	served_wad_t *served = (served_wad_t*)MT_HashMapGet(server->cache, path);
+	if (!served && (served = (served_wad_t*)calloc(1, sizeof(served_wad_t))))
+	{
+		served->fd = -1;
+		if (!(served->path = strdup(path)) || pthread_rwlock_init(&served->lock, NULL) || pthread_mutex_init(&served->verify_lock, NULL) || MT_HashMapPut(server->cache, served->path, served) < 0)
+		{
+			free(served->path);
+			free(served);
+			served = NULL;
+		}
+	}
+	served_wad_t *evicted = NULL;
+	if (served)
+	{
+		served->refs++;
+		served->used = ++server->cache_clock;
+		evicted = served_evict(server);
+	}
+	pthread_mutex_unlock(&server->cache_lock);
+
+	if (evicted)
+		served_free(server, evicted);
+
+	if (!served)
+	{
+		STREAM_Printf(out, "ERROR: %s\n", strwaderror(WADERROR_OUT_OF_MEMORY));
+		*err = ERRORSERVE_WAD_ERROR + WADERROR_OUT_OF_MEMORY;
+		return NULL;
+	}
+
+	pthread_rwlock_rdlock(&served->lock);
+	if (served_current(served, &st))
+		return served;
+	pthread_rwlock_unlock(&served->lock);
+
+	// someone else may have reloaded it while this waited for the write lock.
+	pthread_rwlock_wrlock(&served->lock);
+	if (!served_current(served, &st))
+	{
+		if ((*err = served_load(server, served, &st, out)))
+		{
+			served_release(server, served);
+			return NULL;
+		}
+	}
+	pthread_rwlock_unlock(&served->lock);
+
+	pthread_rwlock_rdlock(&served->lock);
+	if (!served->wad)
+	{
+		served_release(server, served);
+		STREAM_Printf(out, "ERROR: WAD changed while loading. Try again.\n");
+		*err = ERRORSERVE_WAD_ERROR + WADERROR_FILE_ERROR;
+		return NULL;
+	}
+	return served;
+}
+
+// Finds an entry by index, name, or (in zips) path, using the indices.
+// Entries are read straight from the list: WAD_GetEntry() sets waderrno, which every thread shares.
+static int served_find_entry(served_wad_t *served, char *entry)
+{
+	void *value;
+	int result = atoi(entry);
+	if (result || strcmp(entry, "0") == 0)
+		return result;
+	strupper(entry);
+	if (MT_HashMapFind(served->name_index, entry, &value))
+		return (int)(intptr_t)value;
+	if (served->path_index && MT_HashMapFind(served->path_index, entry, &value))
+		return (int)(intptr_t)value;
+	return -1;
+}
+
+static mapindexentry_t* served_find_map(served_wad_t *served, const char *name)
+{
+	int i;
+	for (i = 0; i < MAP_IndexCount(served->maps); i++)
+	{
+		mapindexentry_t *map = MAP_IndexGet(served->maps, i);
+		if (strcmp(served->names + (map->header * 9), name) == 0)
+			return map;
+	}
+	return NULL;
+}
+
+static void push_entry(listentry_vector_t *entries, served_wad_t *served, int index)
+{
+	wadentry_t *entry = served->wad->entries[index];
+	listentry_t e = {index, entry, WAD_GetEntryPath(served->wad, entry)};
+	listentry_vector_Push(entries, e);
+}
+
+// Writes the listing of a set of entries (after its header lines).
+static void write_entries(stream_t *out, listentry_vector_t *entries)
+{
+	WADTools_ListEntriesWrite(out, entries->items, entries->size, entries->size, 0, 0, 0, 0);
+}
+
+static int exec_info(served_wad_t *served, const char *filename, stream_t *out)
+{
+	wad_t *wad = served->wad;
+	STREAM_Printf(out, "%s: %s\n", filename, wad->header.type == WADTYPE_IWAD ? "IWAD" : "PWAD");
+	STREAM_Printf(out, "%d entries\n", wad->header.entry_count);
+	STREAM_Printf(out, "%d content bytes\n", wad->header.entry_list_offset - sizeof(wadheader_t));
+	STREAM_Printf(out, "%d list bytes\n", wad->header.entry_count * sizeof(wadentry_t));
+	STREAM_Printf(out, "list at byte %d\n", wad->header.entry_list_offset);
+	STREAM_Printf(out, "%d bytes total\n", (wad->header.entry_list_offset + (sizeof(wadentry_t) * wad->header.entry_count)));
+	return ERRORSERVE_NONE;
+}
+
+static int exec_list(served_wad_t *served, const char *filename, stream_t *out)
+{
+	int i, count = WAD_EntryCount(served->wad);
+	if (!count)
+	{
+		STREAM_Printf(out, "No entries.\n");
+		return ERRORSERVE_NONE;
+	}
+
+	listentry_vector_t entries;
+	listentry_vector_Init(&entries);
+	listentry_vector_Reserve(&entries, count);
+	for (i = 0; i < count; i++)
+		push_entry(&entries, served, i);
+	STREAM_Printf(out, "Entries in %s, %d to %d\n", filename, 0, count - 1);
+	write_entries(out, &entries);
+	listentry_vector_Free(&entries);
+	return ERRORSERVE_NONE;
+}
+
+static int exec_search(served_wad_t *served, const char *filename, const char *modename, arg_parser_t *argparser, stream_t *out)
+{
+	wad_t *wad = served->wad;
+	int i, count = WAD_EntryCount(wad);
+	char *name = NULL;
+	searchtype_t mode;
+	listentry_vector_t entries;
+	listentry_vector_Init(&entries);
+
+	if (stricmp(modename, MODE_MAPS) == 0)
+	{
+		mode = ST_MAPS;
+		for (i = 0; i < MAP_IndexCount(served->maps); i++)
+			push_entry(&entries, served, MAP_IndexGet(served->maps, i)->header);
+	}
+	else if (stricmp(modename, MODE_MAP) == 0)
+	{
+		mode = ST_MAP;
+		if (!(name = takearg(argparser)))
+		{
+			STREAM_Printf(out, "ERROR: Missing map name.\n");
+			return ERRORSERVE_MISSING_PARAMETER;
+		}
+		strupper(name);
+
+		mapindexentry_t *map = served_find_map(served, name);
+		if (!map)
+		{
+			STREAM_Printf(out, "ERROR: Map name %s not found!\n", name);
+			return ERRORSERVE_MAP_NOT_FOUND;
+		}
+		// add one to count to accommodate header entry
+		for (i = 0; i < map->count + 1; i++)
+			push_entry(&entries, served, map->header + i);
+	}
+	else if (stricmp(modename, MODE_NAME) == 0)
+	{
+		mode = ST_NAME;
+		if (!(name = takearg(argparser)))
+		{
+			STREAM_Printf(out, "ERROR: Missing name.\n");
+			return ERRORSERVE_MISSING_PARAMETER;
+		}
+		strupper(name);
+
+		size_t namelen = strlen(name);
+		for (i = 0; i < count; i++)
+			if (strncmp(served->names + (i * 9), name, namelen) == 0) // starts with
+				push_entry(&entries, served, i);
+	}
+	else if (stricmp(modename, MODE_NAMESPACE) == 0)
+	{
+		mode = ST_NAMESPACE;
+		if (!(name = takearg(argparser)))
+		{
+			STREAM_Printf(out, "ERROR: Missing namespace.\n");
+			return ERRORSERVE_MISSING_PARAMETER;
+		}
+		strupper(name);
+
+		// in zip archives, namespaces are folders.
+		if (WAD_GetImplementation(wad) == WI_ZIP)
+		{
+			size_t folderlen = strlen(name);
+			for (i = 0; i < count; i++)
+			{
+				const char *path = WAD_GetEntryPath(wad, wad->entries[i]);
+				if (!strnicmp(path, name, folderlen) && path[folderlen] == '/')
+					push_entry(&entries, served, i);
+			}
+		}
+		else
+		{
+			char sname[9], ename[9];
+			void *start, *end;
+			sprintf(sname, "%.2s_START", name);
+			sprintf(ename, "%.2s_END", name);
+			if (MT_HashMapFind(served->name_index, sname, &start) && MT_HashMapFind(served->name_index, ename, &end))
+				for (i = (int)(intptr_t)start + 1; i < (int)(intptr_t)end; i++)
+					push_entry(&entries, served, i);
+		}
+	}
+	else
+	{
+		STREAM_Printf(out, "ERROR: Bad mode: %s\n", modename);
+		return ERRORSERVE_BAD_MODE;
+	}
+
+	if (!entries.size)
+	{
+		listentry_vector_Free(&entries);
+		STREAM_Printf(out, "No entries.\n");
+		return ERRORSERVE_NONE;
+	}
+
+	STREAM_Printf(out, "Entries in %s\n", filename);
+	switch (mode)
+	{
+		case ST_MAPS:
+			STREAM_Printf(out, "Listing MAPS.\n");
+			break;
+		case ST_MAP:
+			STREAM_Printf(out, "Listing entries in map %s.\n", name);
+			break;
+		case ST_NAME:
+			STREAM_Printf(out, "Listing entries starting with `%s`.\n", name);
+			break;
+		case ST_NAMESPACE:
+			if (WAD_GetImplementation(wad) == WI_ZIP)
+				STREAM_Printf(out, "Listing entries in folder %s.\n", name);
+			else
+				STREAM_Printf(out, "Listing entries in namespace %.2s_START / %.2s_END.\n", name, name);
+			break;
+	}
+	write_entries(out, &entries);
+	listentry_vector_Free(&entries);
+	return ERRORSERVE_NONE;
+}
+
+// Checks a zip entry's content against its CRC-32, once per load, so that it can be sent
+// (the length is promised up front) without a mismatch found after it has been sent. If nonzero, bad or short data.
+static int served_verify(served_wad_t *served, int index)
+{
+	wadentry_t *entry = served->wad->entries[index];
+	int verified, amount;
+	size_t total = 0;
+
+	pthread_mutex_lock(&served->verify_lock);
+	verified = served->verified[index];
+	pthread_mutex_unlock(&served->verify_lock);
+	if (verified)
+		return 0;
+
+	stream_t *in = STREAM_OpenWADStream(served->wad, entry);
+	if (!in)
+		return 1;
+
+	const unsigned char *span;
+	unsigned char buffer[SERVE_COPY_BUFFER_SIZE];
+	while ((amount = STREAM_Peek(in, &span)) > 0 || (!amount && (amount = STREAM_Read(in, buffer, 1, SERVE_COPY_BUFFER_SIZE)) > 0))
+	{
+		if (span)
+			STREAM_Advance(in, amount);
+		total += amount;
+	}
+	int bad = STREAM_Error(in) || total != (size_t)entry->length;
+	STREAM_Close(in);
+
+	if (!bad)
+	{
+		pthread_mutex_lock(&served->verify_lock);
+		served->verified[index] = 1;
+		pthread_mutex_unlock(&served->verify_lock);
+	}
+	return bad;
+}
+
+// Sends an error message as the response. Returns nonzero if the connection can't continue.
+static int send_message(int client, int status, const char *message)
+{
+	return send_header(client, status, strlen(message)) || send_all(client, message, strlen(message));
+}
+
+// Sends an entry's content as the response. Returns nonzero if the connection can't continue.
+static int exec_dump(served_wad_t *served, int client, int index)
+{
+	wad_t *wad = served->wad;
+	wadentry_t *entry = wad->entries[index];
+
+	if (WAD_GetImplementation(wad) != WI_ZIP)
+	{
+		// an entry past the end of the file can't be sent in full.
+		if ((off_t)entry->offset + entry->length > served->size)
+			return send_message(client, ERRORSERVE_WAD_ERROR + WADERROR_BAD_DATA, "ERROR: Entry data is corrupt or incomplete.\n");
+		if (send_header(client, ERRORSERVE_NONE, entry->length))
+			return 1;
+		return send_file(client, served->fd, entry->offset, entry->length);
+	}
+
+	if (served_verify(served, index))
+		return send_message(client, ERRORSERVE_WAD_ERROR + WADERROR_BAD_DATA, "ERROR: Entry data is corrupt or incomplete.\n");
+
+	// stored files are sent from the archive as they are.
+	wadzipentry_t *zipentry = WAD_GetZipEntry(wad, entry);
+	size_t offset;
+	if (zipentry && zipentry->method == WADZIP_STORED && !WAD_GetZipEntryDataOffset(wad, entry, &offset))
+	{
+		if (send_header(client, ERRORSERVE_NONE, entry->length))
+			return 1;
+		return send_file(client, served->fd, offset, entry->length);
+	}
+
+	stream_t *in = STREAM_OpenWADStream(wad, entry);
+	if (!in)
+		return send_message(client, ERRORSERVE_WAD_ERROR + WADERROR_FILE_ERROR, "ERROR: Could not read entry.\n");
+
+	// the length is promised up front, so a short read ends the connection.
+	unsigned char buffer[SERVE_COPY_BUFFER_SIZE];
+	int amount, err = send_header(client, ERRORSERVE_NONE, entry->length);
+	size_t remaining = entry->length;
+	while (!err && remaining)
+	{
+		amount = STREAM_Get(in, buffer, remaining < SERVE_COPY_BUFFER_SIZE ? remaining : SERVE_COPY_BUFFER_SIZE);
+		if (amount <= 0)
+			err = 1;
+		else
+		{
+			err = send_all(client, buffer, amount);
+			remaining -= amount;
+		}
+	}
+	STREAM_Close(in);
+	return err;
+}
+
+// Answers one request. Returns nonzero if the connection can't continue.
+static int serve_request(server_t *server, int client, char *request)
+{
+	char *argv[SERVE_ARGS_MAX];
+	int argc = WADTools_SplitArgs(request, argv, SERVE_ARGS_MAX);
+	int err = ERRORSERVE_NONE, ret;
+
+	stream_t *out = STREAM_OpenWriteBuffer(1024);
+	if (!out)
+		return 1;
+
+	arg_parser_t parser = {argc > 0 ? argc : 0, argv, 0, NULL};
+	nextarg(&parser);
+
+	int command = 0;
+	if (argc < 0)
+	{
+		STREAM_Printf(out, "ERROR: Too many arguments.\n");
+		err = ERRORSERVE_BAD_REQUEST;
+	}
+	else if (!currarg(&parser))
+	{
+		STREAM_Printf(out, "ERROR: Missing command.\n");
+		err = ERRORSERVE_BAD_COMMAND;
+	}
+	else if (matcharg(&parser, COMMAND_INFO))
+		command = 1;
+	else if (matcharg(&parser, COMMAND_LIST))
+		command = 2;
+	else if (matcharg(&parser, COMMAND_SEARCH))
+		command = 3;
+	else if (matcharg(&parser, COMMAND_DUMP))
+		command = 4;
+	else
+	{
+		STREAM_Printf(out, "ERROR: Bad command: %s\n", currarg(&parser));
+		err = ERRORSERVE_BAD_COMMAND;
+	}
+
+	// search has its mode first.
+	char *modename = NULL;
+	if (!err && command == 3 && !(modename = takearg(&parser)))
+	{
+		STREAM_Printf(out, "ERROR: Expected mode.\n");
+		err = ERRORSERVE_MISSING_PARAMETER;
+	}
+
+	char *filename = NULL;
+	if (!err && !(filename = takearg(&parser)))
+	{
+		STREAM_Printf(out, "ERROR: No WAD file.\n");
+		err = ERRORSERVE_MISSING_PARAMETER;
+	}
+
+	served_wad_t *served = NULL;
+	if (!err)
+		served = served_get(server, filename, out, &err);
+
+	if (served)
+	{
+		switch (command)
+		{
+			case 1:
+				err = exec_info(served, filename, out);
+				break;
+			case 2:
+				err = exec_list(served, filename, out);
+				break;
+			case 3:
+				err = exec_search(served, filename, modename, &parser, out);
+				break;
+			case 4:
+			{
+				char *entry = takearg(&parser);
+				int index = entry ? served_find_entry(served, entry) : -1;
+				if (!entry)
+				{
+					STREAM_Printf(out, "ERROR: Missing target entry.\n");
+					err = ERRORSERVE_MISSING_PARAMETER;
+				}
+				else if (index < 0 || index >= WAD_EntryCount(served->wad))
+				{
+					STREAM_Printf(out, "ERROR: Could not find target entry.\n");
+					err = ERRORSERVE_BAD_ENTRY;
+				}
+				else
+				{
+					// sends its own response.
+					ret = exec_dump(served, client, index);
+					served_release(server, served);
+					STREAM_Close(out);
+					return ret;
+				}
+			}
+			break;
+		}
+		served_release(server, served);
+	}
+
+	ret = send_header(client, err, STREAM_Tell(out)) || send_all(client, STREAM_GetMemory(out), STREAM_Tell(out));
+	STREAM_Close(out);
+	return ret;
+}
+
+// Answers the next request on a connection. Returns nonzero if the connection closed or can't continue.
+static int serve_next(server_t *server, int client)
+{
+	unsigned char header[4];
+	char request[SERVE_REQUEST_MAX + 1];
+
+	if (recv_all(client, header, 4))
+		return 1;
+
+	uint32_t length = get_uint32(header);
+	if (length > SERVE_REQUEST_MAX)
+	{
+		send_message(client, ERRORSERVE_BAD_REQUEST, "ERROR: Request is too long.\n");
+		return 1;
+	}
+	if (recv_all(client, request, length))
+		return 1;
+	request[length] = '\0';
+	return serve_request(server, client, request);
+}
+
+// Worker thread: answers one request at a time from connections that have one waiting.
+// Connections go back to the listening thread in between, so idle ones don't hold a worker.
+static void* serve_worker(void *arg)
+{
+	server_t *server = (server_t*)arg;
+	while (1)
+	{
+		pthread_mutex_lock(&server->queue_lock);
+		while (!server->queue_count)
+			pthread_cond_wait(&server->queue_filled, &server->queue_lock);
+		int client = server->queue[server->queue_head];
+		server->queue_head = (server->queue_head + 1) % SERVE_QUEUE_SIZE;
+		server->queue_count--;
+		pthread_cond_signal(&server->queue_drained);
+		pthread_mutex_unlock(&server->queue_lock);
+
+		int closed = serve_next(server, client);
+		if (closed)
+			close(client);
+
+		pthread_mutex_lock(&server->queue_lock);
+		if (closed)
+			server->connection_count--;
+		else
+			server->returned[server->returned_count++] = client;
+		pthread_mutex_unlock(&server->queue_lock);
+
+		// the pipe is non-blocking: if it is full, a wake-up is already pending.
+		char wake = 0;
+		if (write(server->wake[1], &wake, 1) < 0 && errno != EAGAIN)
+			perror("ERROR: Couldn't wake the listening thread");
+	}
+	return NULL;
+}
+
+// Hands a connection with a request waiting to the workers.
+static void serve_queue(server_t *server, int client)
+{
+	pthread_mutex_lock(&server->queue_lock);
+	while (server->queue_count == SERVE_QUEUE_SIZE)
+		pthread_cond_wait(&server->queue_drained, &server->queue_lock);
+	server->queue[(server->queue_head + server->queue_count) % SERVE_QUEUE_SIZE] = client;
+	server->queue_count++;
+	pthread_cond_signal(&server->queue_filled);
+	pthread_mutex_unlock(&server->queue_lock);
+}
+
+// Opens the listening socket. Returns -1 on error.
+static int serve_listen(const char *socketPath)
+{
+	struct sockaddr_un address;
+	struct stat st;
+	int fd;
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (strlen(socketPath) >= sizeof(address.sun_path))
+	{
+		fprintf(stderr, "ERROR: Socket path is too long.\n");
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	strcpy(address.sun_path, socketPath);
+
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+		return -1;
+
+	// a socket left behind by a server that is gone can be replaced.
+	if (!stat(socketPath, &st) && S_ISSOCK(st.st_mode))
+	{
+		if (!connect(fd, (struct sockaddr*)&address, sizeof(address)))
+		{
+			fprintf(stderr, "ERROR: Already serving on %s.\n", socketPath);
+			close(fd);
+			errno = EADDRINUSE;
+			return -1;
+		}
+		unlink(socketPath);
+		close(fd);
+		if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+			return -1;
+	}
+
+	// only the user running the server can connect: requests can read any file that it can.
+	mode_t mask = umask(0077);
+	int bound = bind(fd, (struct sockaddr*)&address, sizeof(address));
+	umask(mask);
+
+	if (bound || listen(fd, SOMAXCONN))
+	{
+		int err = errno;
+		close(fd);
+		errno = err;
+		return -1;
+	}
+	return fd;
+}
+
+static int exec(wadtool_options_serve_t *options)
+{
+	server_t server;
+	int i, listener;
+
+	memset(&server, 0, sizeof(server));
+	server.cache_max = options->cache;
+	if (!(server.cache = MT_HashMapCreate(16, &MT_HashString, &MT_EqualString)))
+	{
+		fprintf(stderr, "ERROR: %s\n", strwaderror(WADERROR_OUT_OF_MEMORY));
+		return ERRORSERVE_WAD_ERROR + WADERROR_OUT_OF_MEMORY;
+	}
+	pthread_mutex_init(&server.queue_lock, NULL);
+	pthread_cond_init(&server.queue_filled, NULL);
+	pthread_cond_init(&server.queue_drained, NULL);
+	pthread_mutex_init(&server.cache_lock, NULL);
+	pthread_mutex_init(&server.load_lock, NULL);
+
+	if (pipe(server.wake) || fcntl(server.wake[0], F_SETFL, O_NONBLOCK) || fcntl(server.wake[1], F_SETFL, O_NONBLOCK))
+	{
+		fprintf(stderr, "ERROR: Couldn't create pipe: %s\n", strerror(errno));
+		return ERRORSERVE_IO_ERROR + errno;
+	}
+
+	if ((listener = serve_listen(options->socketPath)) < 0)
+	{
+		fprintf(stderr, "ERROR: Couldn't listen on %s: %s\n", options->socketPath, strerror(errno));
+		return ERRORSERVE_IO_ERROR + errno;
+	}
+
+	// closed connections are seen as write errors, not signals.
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &action, NULL);
+	// no SA_RESTART: a signal interrupts poll().
+	action.sa_handler = &serve_signal;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	// the workers inherit a mask without the stop signals, so that they go to this thread.
+	sigset_t stopsignals, oldmask;
+	sigemptyset(&stopsignals);
+	sigaddset(&stopsignals, SIGINT);
+	sigaddset(&stopsignals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &stopsignals, &oldmask);
+
+	for (i = 0; i < options->threads; i++)
+	{
+		pthread_t thread;
+		int err;
+		if ((err = pthread_create(&thread, NULL, &serve_worker, &server)))
+		{
+			fprintf(stderr, "ERROR: Couldn't start threads: %s\n", strerror(err));
+			close(listener);
+			unlink(options->socketPath);
+			return ERRORSERVE_IO_ERROR + err;
+		}
+		pthread_detach(thread);
+	}
+	pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
+
+	printf("Serving on %s with %d threads.\n", options->socketPath, options->threads);
+	fflush(stdout);
+
+	// this thread waits for requests on idle connections, so that workers only answer them.
+	int idle[SERVE_CONNECTIONS_MAX];
+	int idle_count = 0;
+	struct pollfd fds[2 + SERVE_CONNECTIONS_MAX];
+
+	while (!serve_stop)
+	{
+		int accepting, count = 0, ready;
+
+		pthread_mutex_lock(&server.queue_lock);
+		while (server.returned_count)
+			idle[idle_count++] = server.returned[--server.returned_count];
+		accepting = server.connection_count < SERVE_CONNECTIONS_MAX;
+		pthread_mutex_unlock(&server.queue_lock);
+
+		fds[count].fd = server.wake[0];
+		fds[count++].events = POLLIN;
+		fds[count].fd = listener;
+		fds[count++].events = accepting ? POLLIN : 0;
+		for (i = 0; i < idle_count; i++)
+		{
+			fds[count].fd = idle[i];
+			fds[count++].events = POLLIN;
+		}
+
+		if ((ready = poll(fds, count, -1)) <= 0)
+			continue;
+
+		if (fds[0].revents)
+		{
+			char drain[64];
+			while (read(server.wake[0], drain, sizeof(drain)) > 0) ;
+		}
+
+		// readable, closed, or broken: the worker finds out which.
+		int kept = 0;
+		for (i = 0; i < idle_count; i++)
+		{
+			if (fds[2 + i].revents)
+				serve_queue(&server, idle[i]);
+			else
+				idle[kept++] = idle[i];
+		}
+		idle_count = kept;
+
+		if (fds[1].revents & POLLIN)
+		{
+			int client = accept(listener, NULL, NULL);
+			if (client < 0)
+				continue;
+
+			// a client that stops partway through a request or response can't hold a worker for long.
+			struct timeval timeout = {SERVE_IO_TIMEOUT, 0};
+			setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+			setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+			pthread_mutex_lock(&server.queue_lock);
+			server.connection_count++;
+			pthread_mutex_unlock(&server.queue_lock);
+			idle[idle_count++] = client;
+		}
+	}
+
+	// the workers end with the process.
+	close(listener);
+	unlink(options->socketPath);
+	printf("Stopped serving on %s.\n", options->socketPath);
+	return ERRORSERVE_NONE;
+}
+
+#else
+
+static int exec(wadtool_options_serve_t *options)
+{
+	fprintf(stderr, "ERROR: Serving is not supported on this platform.\n");
+	return ERRORSERVE_NOT_SUPPORTED;
+}
+
+#endif
+
+#define SWITCHSTATE_INIT		0
+#define SWITCHSTATE_SOCKET		1
+#define SWITCHSTATE_THREADS		2
+#define SWITCHSTATE_CACHE		3
+
+// If nonzero, bad parse.
+static int parse_switches(arg_parser_t *argparser, wadtool_options_serve_t *options)
+{
+	int state = SWITCHSTATE_INIT;
+	while (currarg(argparser)) switch (state)
+	{
+		case SWITCHSTATE_INIT:
+		{
+			if (matcharg(argparser, SWITCH_SOCKET) || matcharg(argparser, SWITCH_SOCKET2))
+				state = SWITCHSTATE_SOCKET;
+			else if (matcharg(argparser, SWITCH_THREADS) || matcharg(argparser, SWITCH_THREADS2))
+				state = SWITCHSTATE_THREADS;
+			else if (matcharg(argparser, SWITCH_CACHE) || matcharg(argparser, SWITCH_CACHE2))
+				state = SWITCHSTATE_CACHE;
+			else
+			{
+				fprintf(stderr, "ERROR: Bad switch: %s\n", currarg(argparser));
+				return ERRORSERVE_BAD_SWITCH;
+			}
+		}
+		break;
+
+		case SWITCHSTATE_SOCKET:
+		{
+			options->socketPath = takearg(argparser);
+			state = SWITCHSTATE_INIT;
+		}
+		break;
+
+		case SWITCHSTATE_THREADS:
+		{
+			options->threads = atoi(takearg(argparser));
+			state = SWITCHSTATE_INIT;
+		}
+		break;
+
+		case SWITCHSTATE_CACHE:
+		{
+			options->cache = atoi(takearg(argparser));
+			state = SWITCHSTATE_INIT;
+		}
+		break;
+	}
+
+	if (state == SWITCHSTATE_SOCKET)
+	{
+		fprintf(stderr, "ERROR: Missing socket path after switch.\n");
+		return ERRORSERVE_MISSING_PARAMETER;
+	}
+
+	if (state == SWITCHSTATE_THREADS)
+	{
+		fprintf(stderr, "ERROR: Missing thread count after switch.\n");
+		return ERRORSERVE_MISSING_PARAMETER;
+	}
+
+	if (state == SWITCHSTATE_CACHE)
+	{
+		fprintf(stderr, "ERROR: Missing WAD count after switch.\n");
+		return ERRORSERVE_MISSING_PARAMETER;
+	}
+
+	if (!options->socketPath)
+	{
+		fprintf(stderr, "ERROR: No socket path (use --socket).\n");
+		return ERRORSERVE_NO_SOCKET;
+	}
+
+	if (options->threads < 1 || options->threads > SERVE_MAX_THREADS)
+	{
+		fprintf(stderr, "ERROR: Thread count must be from 1 to %d.\n", SERVE_MAX_THREADS);
+		return ERRORSERVE_BAD_SWITCH;
+	}
+
+	if (options->cache < 1)
+	{
+		fprintf(stderr, "ERROR: WAD count must be at least 1.\n");
+		return ERRORSERVE_BAD_SWITCH;
+	}
+
+	return 0;
+}
+
+static int call(arg_parser_t *argparser)
+{
+	wadtool_options_serve_t options = {NULL, SERVE_DEFAULT_THREADS, SERVE_DEFAULT_CACHE};
+
+	int err;
+	if ((err = parse_switches(argparser, &options)))
+	{
+		return err;
+	}
+
+	return exec(&options);
+}
+
+static void usage()
+{
+	printf("Usage: wad serve --socket [path] [switches]\n");
+}
+
+static void help()
+{
+	printf("Keeps WAD files open and answers queries about them on a Unix domain socket,\n");
+	printf("until interrupted. WADs are opened on first use, along with indices of their\n");
+	printf("entry names and maps, and reloaded when their files change.\n");
+	printf("\n");
+	printf("The socket is only usable by the user running the server, since requests\n");
+	printf("can read any file that the server can.\n");
+	printf("\n");
+	printf("[switches]: \n");
+	printf("\n");
+	printf("        --socket [path]           The path of the socket to listen on\n");
+	printf("        -s [path]                 (REQUIRED).\n");
+	printf("\n");
+	printf("        --threads [count]         The amount of requests to answer at\n");
+	printf("        -t [count]                once (default %d).\n", SERVE_DEFAULT_THREADS);
+	printf("\n");
+	printf("        --cache [count]           The most WADs to keep open (default %d).\n", SERVE_DEFAULT_CACHE);
+	printf("        -c [count]                Past that, the least recently used are\n");
+	printf("                                  closed.\n");
+	printf("\n");
+	printf("Protocol: \n");
+	printf("\n");
+	printf("    Each request is a 4-byte length, then that many bytes of command line.\n");
+	printf("    Each response is a 4-byte status (0 if OK, else the error code), a\n");
+	printf("    4-byte length, then that many bytes: the output, the entry content\n");
+	printf("    for `dump`, or the error message. All numbers are little-endian.\n");
+	printf("    Connections stay open for more requests, and may be kept open while\n");
+	printf("    idle: a thread is only busy with a connection while answering it.\n");
+	printf("    A request or response that stalls for %d seconds closes it.\n", SERVE_IO_TIMEOUT);
+	printf("\n");
+	printf("    Commands (WAD paths are relative to the server's directory):\n");
+	printf("\n");
+	printf("        info [wadfile]\n");
+	printf("        list [wadfile]\n");
+	printf("        search maps [wadfile]\n");
+	printf("        search map [wadfile] [name]\n");
+	printf("        search name [wadfile] [prefix]\n");
+	printf("        search namespace [wadfile] [ns]\n");
+	printf("        dump [wadfile] [entry]\n");
+	printf("\n");
+	printf("    Output is the same as the matching `wad` commands without switches.\n");
+	printf("    [entry] is an index, a name (first found), or a path in a zip.\n");
+}
+
+wadtool_t WADTOOL_Serve = {
+	"serve",
+	"Answers queries about WAD files kept open, on a socket.",
+	&call,
+	&usage,
+	&help,
+};
@@ -11,6 +11,7 @@
 #include <string.h>
 #include <errno.h>
 #include "wadtool.h"
+#include "common.h"
 #include "wad/wad.h"
 #include "wad/waderrno.h"
 
@@ -111,7 +112,7 @@ static int parse_file(arg_parser_t *argparser, wadtool_options_shift_t *options)
 	}
 
 	// Open a file.
-	options->wad = WAD_Open(options->filename);
+	options->wad = WADTools_OpenWAD(options->filename);
 
 	if (!options->wad)
 	{
@@ -166,12 +167,12 @@ static int call(arg_parser_t *argparser)
 	}
 	if ((err = parse_parameters(argparser, &options)))
 	{
-		WAD_Close(options.wad);
+		WADTools_CloseWAD(options.wad);
 		return err;
 	}
 	
 	int ret = exec(&options);
-	WAD_Close(options.wad);
+	WADTools_CloseWAD(options.wad);
 	return ret;
 }
 
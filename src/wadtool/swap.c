@@ -117,7 +117,7 @@ static int parse_file(arg_parser_t *argparser, wadtool_options_swap_t *options)
 	}
 
 	// Open a file.
-	options->wad = WAD_Open(options->filename);
+	options->wad = WADTools_OpenWAD(options->filename);
 
 	if (!options->wad)
 	{
@@ -171,12 +171,12 @@ static int call(arg_parser_t *argparser)
 	}
 	if ((err = parse_switches(argparser, &options)))
 	{
-		WAD_Close(options.wad);
+		WADTools_CloseWAD(options.wad);
 		return err;
 	}
 	
 	int ret = exec(&options);
-	WAD_Close(options.wad);
+	WADTools_CloseWAD(options.wad);
 	return ret;
 }
 
@@ -20,12 +20,12 @@ inline char* currarg(arg_parser_t *argparser)
 
 inline int currargis(arg_parser_t *argparser, const char *s)
 {
-	return strieql(currarg(argparser), s);
+	return currarg(argparser) && strieql(currarg(argparser), s);
 }
 
 inline int currargstart(arg_parser_t *argparser, const char *s)
 {
-	return stristart(currarg(argparser), s);
+	return currarg(argparser) && stristart(currarg(argparser), s);
 }
 
 char* nextarg(arg_parser_t *argparser)
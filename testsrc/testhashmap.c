@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "struct/mt_hashmap.h"
+
+#define KEY_COUNT 1000
+#define ROUNDS 50
+
+char keys[KEY_COUNT][16];
+// The value each key should map to, or -1 if it should not be in the map.
+int values[KEY_COUNT];
+
+int failures = 0;
+
+void check(int cond, const char *what)
+{
+	if (!cond)
+	{
+		printf("FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+// Checks every key (and a copy of it, so lookups go by equality) against values[], and the map's length.
+void check_all(mt_hashmap_t *map, const char *when)
+{
+	char copy[16], what[64];
+	void *value;
+	int i, size = 0, position = 0;
+	void *key;
+	for (i = 0; i < KEY_COUNT; i++)
+	{
+		strcpy(copy, keys[i]);
+		if (values[i] >= 0)
+		{
+			size++;
+			sprintf(what, "%s: find %s", when, copy);
+			check(MT_HashMapFind(map, copy, &value) && (long)value == values[i], what);
+			sprintf(what, "%s: kept key instance of %s", when, copy);
+			check(MT_HashMapGetKey(map, copy) == keys[i], what);
+		}
+		else
+		{
+			sprintf(what, "%s: %s removed", when, copy);
+			check(!MT_HashMapContainsKey(map, copy), what);
+		}
+	}
+	sprintf(what, "%s: length", when);
+	check(MT_HashMapLength(map) == size, what);
+	i = 0;
+	while (MT_HashMapNext(map, &position, &key, &value))
+		i++;
+	sprintf(what, "%s: iterated mappings", when);
+	check(i == size, what);
+}
+
+// Tests hash map removal and reinsertion: removed slots must not hide keys past them,
+// and reinserting (into removed slots, or after they are dropped) must not duplicate keys.
+int main(int argc, char** argv)
+{
+	mt_hashmap_t *map = MT_HashMapCreate(16, MT_HashString, MT_EqualString);
+	int i, r;
+
+	srand(1);
+	for (i = 0; i < KEY_COUNT; i++)
+	{
+		sprintf(keys[i], "key%d", i);
+		values[i] = i;
+		check(MT_HashMapPut(map, keys[i], (void*)(long)i) == 1, "put new key");
+	}
+	check_all(map, "after put");
+
+	// remove every other key, then put them back with new values.
+	for (i = 0; i < KEY_COUNT; i += 2)
+	{
+		check((long)MT_HashMapRemove(map, keys[i]) == values[i], "remove returns value");
+		values[i] = -1;
+	}
+	check(MT_HashMapRemove(map, keys[0]) == NULL, "remove missing key");
+	check_all(map, "after remove");
+	for (i = 0; i < KEY_COUNT; i += 2)
+	{
+		values[i] = i + KEY_COUNT;
+		check(MT_HashMapPut(map, keys[i], (void*)(long)values[i]) == 1, "reinsert removed key");
+	}
+	check_all(map, "after reinsert");
+
+	// replacing a value keeps one mapping.
+	check(MT_HashMapPut(map, keys[1], (void*)(long)7) == 0, "replace value");
+	values[1] = 7;
+	check_all(map, "after replace");
+
+	// random churn, so removed slots pile up and get dropped.
+	for (r = 0; r < ROUNDS; r++)
+	{
+		for (i = 0; i < KEY_COUNT; i++)
+		{
+			int k = rand() % KEY_COUNT;
+			if (values[k] >= 0)
+			{
+				check((long)MT_HashMapRemove(map, keys[k]) == values[k], "churn remove");
+				values[k] = -1;
+			}
+			else
+			{
+				values[k] = r;
+				check(MT_HashMapPut(map, keys[k], (void*)(long)r) == 1, "churn put");
+			}
+		}
+		check_all(map, "after churn");
+	}
+
+	// remove everything, then reinsert everything.
+	for (i = 0; i < KEY_COUNT; i++)
+		if (values[i] >= 0)
+		{
+			MT_HashMapRemove(map, keys[i]);
+			values[i] = -1;
+		}
+	check_all(map, "after removing all");
+	for (i = 0; i < KEY_COUNT; i++)
+	{
+		values[i] = i;
+		MT_HashMapPut(map, keys[i], (void*)(long)i);
+	}
+	check_all(map, "after reinserting all");
+
+	MT_HashMapDestroy(map);
+
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? 1 : 0;
+}
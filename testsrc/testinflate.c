@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "io/stream.h"
+
+// Raw DEFLATE data made with zlib (wbits -15). Each decompresses to a plain_*() text below.
+
+// Stored block (level 0).
+unsigned char stored_deflate[] = {
+	0x01, 0x2D, 0x00, 0xD2, 0xFF, 0x54, 0x68, 0x65, 0x20, 0x71, 0x75, 0x69, 0x63, 0x6B, 0x20, 0x62,
+	0x72, 0x6F, 0x77, 0x6E, 0x20, 0x66, 0x6F, 0x78, 0x20, 0x6A, 0x75, 0x6D, 0x70, 0x73, 0x20, 0x6F,
+	0x76, 0x65, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6C, 0x61, 0x7A, 0x79, 0x20, 0x64, 0x6F, 0x67,
+	0x2E, 0x20
+};
+
+// One fixed-Huffman block (Z_FIXED).
+unsigned char fixed_deflate[] = {
+	0x0B, 0xC9, 0x48, 0x55, 0x28, 0x2C, 0xCD, 0x4C, 0xCE, 0x56, 0x48, 0x2A, 0xCA, 0x2F, 0xCF, 0x53,
+	0x48, 0xCB, 0xAF, 0x50, 0xC8, 0x2A, 0xCD, 0x2D, 0x28, 0x56, 0xC8, 0x2F, 0x4B, 0x2D, 0x52, 0x28,
+	0x01, 0x4A, 0xE7, 0x24, 0x56, 0x55, 0x2A, 0xA4, 0xE4, 0xA7, 0xEB, 0x29, 0x84, 0x0C, 0x0E, 0xC5,
+	0x00
+};
+
+// Dynamic-Huffman block.
+unsigned char dynamic_deflate[] = {
+	0x9D, 0xD4, 0x3B, 0x0A, 0xC2, 0x40, 0x14, 0x46, 0xE1, 0xDE, 0x55, 0xDC, 0x05, 0x88, 0x64, 0xEE,
+	0xE4, 0x69, 0x17, 0xB0, 0xB3, 0xB1, 0xB3, 0x1E, 0x99, 0x51, 0x03, 0x93, 0x07, 0x26, 0x20, 0xB8,
+	0x7A, 0x9B, 0x88, 0xED, 0xE4, 0x2C, 0xE0, 0xE7, 0xF2, 0xC1, 0xE5, 0xB8, 0x38, 0x3D, 0x9D, 0xC4,
+	0x6E, 0x08, 0x92, 0x1D, 0xE5, 0xED, 0xFC, 0x32, 0x8E, 0x51, 0x5E, 0xC1, 0xF9, 0x59, 0xAE, 0xED,
+	0x69, 0x2F, 0x97, 0xB3, 0x15, 0x37, 0x78, 0xF9, 0x74, 0x93, 0xDC, 0xBB, 0x18, 0xE6, 0xC3, 0xEE,
+	0x16, 0x96, 0x75, 0x62, 0x52, 0x27, 0x0F, 0xD7, 0xF7, 0xEB, 0x46, 0x53, 0x37, 0x3E, 0xC4, 0xDF,
+	0x1D, 0x9B, 0xBA, 0x71, 0x7F, 0x4E, 0xBE, 0x9D, 0x53, 0x00, 0x4E, 0x09, 0x38, 0x15, 0xE0, 0xD4,
+	0xDB, 0x39, 0x0D, 0xE0, 0x98, 0x0C, 0x78, 0x8C, 0x01, 0x20, 0xA3, 0xE0, 0xDF, 0x2C, 0x21, 0xE5,
+	0x84, 0x54, 0x10, 0x52, 0x09, 0x48, 0x15, 0x21, 0xD5, 0x84, 0xD4, 0x00, 0x92, 0x82, 0x2A, 0x28,
+	0xCA, 0x02, 0xE9, 0x82, 0x92, 0x30, 0x28, 0x28, 0x83, 0x92, 0x34, 0x28, 0x69, 0x83, 0x92, 0x38,
+	0x28, 0xA8, 0x83, 0x92, 0x3C, 0x58, 0x92, 0x07, 0x9B, 0xFC, 0x0F, 0x5F
+};
+
+// Dynamic-Huffman block of long runs: matches that overlap their own output (distance 1 and 7),
+// and output longer than the window.
+unsigned char overlap_deflate[] = {
+	0xED, 0xDB, 0xB1, 0x0D, 0x80, 0x30, 0x10, 0x04, 0xC1, 0x5A, 0x2D, 0x11, 0x22, 0x91, 0x20, 0xD1,
+	0x3E, 0x65, 0x3C, 0x5E, 0x66, 0x92, 0xED, 0xE0, 0x02, 0x5B, 0xBF, 0x16, 0x50, 0x77, 0x3E, 0xEB,
+	0xB8, 0xAF, 0x4B, 0x44, 0xC2, 0xB1, 0x74, 0xD0, 0x67, 0xEB, 0x44, 0xFA, 0xB1, 0x74, 0xD0, 0x67,
+	0xEB, 0x44, 0x7E, 0x10, 0x20, 0xCF, 0xD6, 0x89, 0xF4, 0x63, 0xE9, 0xE0, 0x07, 0xEF, 0xED, 0xB6,
+	0x4E, 0x24, 0x1F, 0x4B, 0x07, 0x7D, 0xB6, 0x4E, 0xC4, 0x73, 0x3B, 0xE0, 0x03, 0x5D, 0x44, 0xBE,
+	0x1F, 0x43, 0x07, 0x7D, 0xB6, 0x4E, 0xC4, 0xBD, 0x1A, 0x10, 0xF8, 0x3F, 0xB7, 0x75, 0x22, 0xEE,
+	0xD5, 0x00, 0xCF, 0xED, 0x22, 0xE2, 0x03, 0x1D, 0x18, 0x67, 0xEB, 0x44, 0xDC, 0xAB, 0x01, 0x81,
+	0xF7, 0x76, 0x5B, 0x27, 0xE2, 0x5E, 0x0D, 0xD8, 0x9E, 0xAD, 0x13, 0xF1, 0xDC, 0x0E, 0xF8, 0x40,
+	0x17, 0x11, 0xF7, 0x6A, 0xC0, 0x3C, 0x5B, 0x27, 0xE2, 0x5E, 0x0D, 0x08, 0xFC, 0x9F, 0xDB, 0x3A,
+	0x11, 0xF7, 0x6A, 0x80, 0xE7, 0x76, 0x11, 0xF1, 0x81, 0x0E, 0x8C, 0xB3, 0x75, 0x22, 0xEE, 0xD5,
+	0x80, 0xC0, 0x7B, 0xBB, 0xAD, 0x13, 0x71, 0xAF, 0x06, 0x6C, 0xCF, 0xD6, 0x89, 0x78, 0x6E, 0x07,
+	0x7C, 0xA0, 0x8B, 0x88, 0x7B, 0x35, 0x60, 0x9E, 0xAD, 0x13, 0x71, 0xAF, 0x06, 0x04, 0xFE, 0xCF,
+	0x6D, 0x9D, 0x88, 0x7B, 0x35, 0xC0, 0x73, 0xBB, 0x88, 0xF8, 0x40, 0x07, 0xC6, 0xD9, 0x3A, 0x11,
+	0xF7, 0x6A, 0x40, 0xE0, 0xBD, 0xDD, 0xD6, 0x89, 0xB8, 0x57, 0x03, 0xB6, 0x67, 0xEB, 0x44, 0x3C,
+	0xB7, 0x03, 0x3E, 0xD0, 0x45, 0xC4, 0xBD, 0x1A, 0x30, 0xCF, 0xD6, 0x89, 0xB8, 0x57, 0x03, 0x02,
+	0xFF, 0xE7, 0xB6, 0x4E, 0xC4, 0xBD, 0x1A, 0xE0, 0xB9, 0x5D, 0x44, 0x7C, 0xA0, 0x03, 0xE3, 0x6C,
+	0x9D, 0x88, 0x7B, 0x35, 0x20, 0xF0, 0xDE, 0x6E, 0xEB, 0x44, 0xDC, 0xAB, 0x01, 0xDB, 0xB3, 0x75,
+	0x22, 0x9E, 0xDB, 0x01, 0x1F, 0xE8, 0x22, 0xF2, 0xFD, 0xBC
+};
+
+// Reserved block type (11).
+unsigned char badtype_deflate[] = { 0x07 };
+// Stored block with a bad NLEN.
+unsigned char badlength_deflate[] = { 0x01, 0x05, 0x00, 0x00, 0x00, 'h', 'e', 'l', 'l', 'o' };
+// Fixed block whose first code is a match (distance past the start of the output).
+unsigned char baddistance_deflate[] = { 0x03, 0x02, 0x00 };
+
+#define TEXT "The quick brown fox jumps over the lazy dog. "
+#define OVERLAP_LENGTH 70000
+
+int failures = 0;
+
+void check(int cond, const char *name, const char *what)
+{
+	if (!cond)
+	{
+		printf("FAIL: %s: %s\n", name, what);
+		failures++;
+	}
+}
+
+// Writes the dynamic block's text into out (if not NULL), returning its length.
+size_t plain_dynamic(char *out)
+{
+	static const char *words[] = {"alpha", "beta", "gamma", "delta"};
+	char line[128];
+	size_t len = 0;
+	int i;
+	for (i = 0; i < 32; i++)
+	{
+		int n = sprintf(line, "%s line %d: wadtool reads WAD, PK3 and zip files.\n", words[i % 4], i);
+		if (out)
+			memcpy(out + len, line, n);
+		len += n;
+	}
+	return len;
+}
+
+// Writes the overlap block's text into out.
+void plain_overlap(char *out)
+{
+	int i;
+	for (i = 0; i < OVERLAP_LENGTH; i++)
+		out[i] = (i / 1000) % 2 ? "wadtool"[i % 7] : 'a';
+}
+
+// Decompresses data in odd-sized reads, twice (the second time after a reset), and checks it against the expected text.
+void check_inflate(const char *name, unsigned char *data, size_t length, const char *expected, size_t expected_length)
+{
+	char *buffer = (char*)malloc(expected_length + 1);
+	stream_t *stream = STREAM_OpenInflate(STREAM_OpenBuffer(data, length), expected_length);
+	int pass;
+	for (pass = 0; pass < 2; pass++)
+	{
+		size_t pos = 0;
+		int n;
+		while (pos < expected_length + 1 && (n = STREAM_Read(stream, buffer + pos, 1, 777 < expected_length + 1 - pos ? 777 : expected_length + 1 - pos)) > 0)
+			pos += n;
+		check(pos == expected_length, name, pass ? "length after reset" : "length");
+		check(!memcmp(buffer, expected, expected_length), name, pass ? "content after reset" : "content");
+		check(!STREAM_Error(stream), name, "no error");
+		STREAM_Reset(stream);
+	}
+	STREAM_Close(stream);
+	free(buffer);
+}
+
+// Decompresses bad data, and checks that it ends in an error rather than a clean end of stream.
+void check_corrupt(const char *name, unsigned char *data, size_t length, size_t expected_length)
+{
+	char buffer[1024];
+	stream_t *stream = STREAM_OpenInflate(STREAM_OpenBuffer(data, length), expected_length);
+	while (STREAM_Read(stream, buffer, 1, sizeof(buffer)) > 0) ;
+	check(STREAM_Error(stream), name, "error");
+	STREAM_Close(stream);
+}
+
+// Tests DEFLATE decoding (STREAM_OpenInflate) of each block type, and of bad data.
+int main(int argc, char** argv)
+{
+	char *text = (char*)malloc(OVERLAP_LENGTH);
+	size_t len;
+
+	check_inflate("stored", stored_deflate, sizeof(stored_deflate), TEXT, strlen(TEXT));
+	check_inflate("fixed", fixed_deflate, sizeof(fixed_deflate), TEXT TEXT TEXT TEXT, strlen(TEXT) * 4);
+	len = plain_dynamic(text);
+	check_inflate("dynamic", dynamic_deflate, sizeof(dynamic_deflate), text, len);
+	plain_overlap(text);
+	check_inflate("overlap", overlap_deflate, sizeof(overlap_deflate), text, OVERLAP_LENGTH);
+
+	check_corrupt("bad block type", badtype_deflate, sizeof(badtype_deflate), 10);
+	check_corrupt("bad stored length", badlength_deflate, sizeof(badlength_deflate), 5);
+	check_corrupt("bad distance", baddistance_deflate, sizeof(baddistance_deflate), 3);
+	check_corrupt("truncated", dynamic_deflate, sizeof(dynamic_deflate) / 2, plain_dynamic(NULL));
+	check_corrupt("short", stored_deflate, sizeof(stored_deflate), strlen(TEXT) + 10);
+
+	free(text);
+
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? 1 : 0;
+}
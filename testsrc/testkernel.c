@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "parser/lexer.h"
+#include "map/udmf_kernel.h"
+
+typedef struct {
+
+	char *name;
+	int type;
+
+} NAMEDTYPE;
+
+// Same as udmf.lxk.
+NAMEDTYPE delimiters[] = {
+	{"{", UDMFD_LBRACE}, {"}", UDMFD_RBRACE}, {"=", UDMFD_EQUALS},
+	{";", UDMFD_SEMICOLON}, {"-", UDMFD_MINUS}, {"+", UDMFD_PLUS},
+	{NULL, 0}
+};
+
+// Same as udmf.lxk.
+NAMEDTYPE keywords[] = {
+	{"namespace", UDMFK_NAMESPACE}, {"thing", UDMFK_THING}, {"linedef", UDMFK_LINEDEF},
+	{"sidedef", UDMFK_SIDEDEF}, {"vertex", UDMFK_VERTEX}, {"sector", UDMFK_SECTOR},
+	{"true", UDMFK_TRUE}, {"false", UDMFK_FALSE}, {"x", UDMFK_X}, {"y", UDMFK_Y},
+	{"height", UDMFK_HEIGHT}, {"angle", UDMFK_ANGLE}, {"type", UDMFK_TYPE}, {"id", UDMFK_ID},
+	{"special", UDMFK_SPECIAL}, {"arg0", UDMFK_ARG0}, {"arg1", UDMFK_ARG1}, {"arg2", UDMFK_ARG2},
+	{"arg3", UDMFK_ARG3}, {"arg4", UDMFK_ARG4}, {"v1", UDMFK_V1}, {"v2", UDMFK_V2},
+	{"sidefront", UDMFK_SIDEFRONT}, {"sideback", UDMFK_SIDEBACK}, {"offsetx", UDMFK_OFFSETX},
+	{"offsety", UDMFK_OFFSETY}, {"texturetop", UDMFK_TEXTURETOP}, {"texturebottom", UDMFK_TEXTUREBOTTOM},
+	{"texturemiddle", UDMFK_TEXTUREMIDDLE}, {"heightfloor", UDMFK_HEIGHTFLOOR},
+	{"heightceiling", UDMFK_HEIGHTCEILING}, {"texturefloor", UDMFK_TEXTUREFLOOR},
+	{"textureceiling", UDMFK_TEXTURECEILING}, {"lightlevel", UDMFK_LIGHTLEVEL},
+	{"skill1", UDMFK_SKILL1}, {"skill2", UDMFK_SKILL2}, {"skill3", UDMFK_SKILL3},
+	{"skill4", UDMFK_SKILL4}, {"skill5", UDMFK_SKILL5}, {"ambush", UDMFK_AMBUSH},
+	{"single", UDMFK_SINGLE}, {"dm", UDMFK_DM}, {"coop", UDMFK_COOP}, {"friend", UDMFK_FRIEND},
+	{"dormant", UDMFK_DORMANT}, {"class1", UDMFK_CLASS1}, {"class2", UDMFK_CLASS2},
+	{"class3", UDMFK_CLASS3}, {"blocking", UDMFK_BLOCKING}, {"blockmonsters", UDMFK_BLOCKMONSTERS},
+	{"twosided", UDMFK_TWOSIDED}, {"dontpegtop", UDMFK_DONTPEGTOP}, {"dontpegbottom", UDMFK_DONTPEGBOTTOM},
+	{"secret", UDMFK_SECRET}, {"blocksound", UDMFK_BLOCKSOUND}, {"dontdraw", UDMFK_DONTDRAW},
+	{"mapped", UDMFK_MAPPED}, {"passuse", UDMFK_PASSUSE}, {"repeatspecial", UDMFK_REPEATSPECIAL},
+	{"playercross", UDMFK_PLAYERCROSS}, {"playeruse", UDMFK_PLAYERUSE}, {"monstercross", UDMFK_MONSTERCROSS},
+	{"impact", UDMFK_IMPACT}, {"playerpush", UDMFK_PLAYERPUSH}, {"missilecross", UDMFK_MISSILECROSS},
+	{NULL, 0}
+};
+
+const char *sample =
+	"// UDMF sample\n"
+	"namespace = \"zdoom\";\n"
+	"/* block\n"
+	"   comment */\n"
+	"Thing // first\n"
+	"{\n"
+	"\tX = -32.5;\n"
+	"\ty = 0x40;\n"
+	"\tHEIGHT = 1e3;\n"
+	"\tangle = 090;\n"
+	"\ttype = 3004;\n"
+	"\tAmbush = true;\n"
+	"\tskill1 = FALSE;\n"
+	"\targ0 = +5;\n"
+	"\tuser_custom = \"escaped \\\"quote\\\" and \\\\ and \\n\";\n"
+	"\tcomment = \"multi\\\n"
+	"line\";\n"
+	"\tescaped = \"newline\\\n"
+	"\";\n"
+	"}\n"
+	"vertex { x = 0.; y = .5; }\n"
+	"sector { heightfloor = 0; texturefloor = \"FLOOR4_8\"; lightlevel = 160; }\n"
+	"linedef { v1 = 0; v2 = 1; sidefront = 0; sideback = -1; blocking = true; }\n"
+	"sidedef { offsetx = 1; texturemiddle = \"STARTAN3\"; sector = 0; }\n"
+	"things = 1; namespace2 = 2; x_ = 3; \"\" = 4;\n"
+	"@ $ # bad chars\n"
+	"\"unterminated\n"
+	"end";
+
+int failures = 0;
+
+// Builds the UDMF kernel at runtime, uncompiled, so that it uses the generic lookups.
+lexer_kernel_t* runtime_kernel()
+{
+	lexer_kernel_t *kernel = LXRK_Create();
+	NAMEDTYPE *nt;
+	LXRK_AddCommentDelimiter(kernel, "/*", "*/");
+	LXRK_AddLineCommentDelimiter(kernel, "//");
+	LXRK_AddStringDelimiters(kernel, '"', '"');
+	for (nt = delimiters; nt->name; nt++)
+		LXRK_AddDelimiter(kernel, nt->name, nt->type);
+	for (nt = keywords; nt->name; nt++)
+		LXRK_AddCaseInsensitiveKeyword(kernel, nt->name, nt->type);
+	return kernel;
+}
+
+// Lexes a buffer with two lexers, and checks that they make the same tokens.
+void compare(const char *name, lexer_kernel_t *expected_kernel, lexer_kernel_t *actual_kernel, int zero_copy, unsigned char *buffer, size_t length)
+{
+	char expected_text[LEXEME_LENGTH_MAX], actual_text[LEXEME_LENGTH_MAX];
+	lexer_t *expected = LXR_Create(expected_kernel);
+	lexer_t *actual = LXR_Create(actual_kernel);
+	lexer_token_t *e, *a;
+	int count = 0;
+
+	actual->options.zero_copy = zero_copy;
+	LXR_PushStreamBuffer(expected, "expected", buffer, length);
+	LXR_PushStreamBuffer(actual, "actual", buffer, length);
+	while ((e = LXR_NextToken(expected)))
+	{
+		LXR_GetTokenText(expected, e, expected_text, sizeof(expected_text));
+		count++;
+		if (!(a = LXR_NextToken(actual)))
+		{
+			printf("FAIL: %s: token %d: expected line %d %s \"%s\", got the end\n", name, count, e->line_number, LXR_TokenTypeName(e->type), expected_text);
+			failures++;
+			break;
+		}
+		LXR_GetTokenText(actual, a, actual_text, sizeof(actual_text));
+		if (e->type != a->type || e->subtype != a->subtype || e->line_number != a->line_number || strcmp(expected_text, actual_text))
+		{
+			printf("FAIL: %s: token %d: expected line %d %s:%d \"%s\", got line %d %s:%d \"%s\"\n", name, count,
+				e->line_number, LXR_TokenTypeName(e->type), e->subtype, expected_text,
+				a->line_number, LXR_TokenTypeName(a->type), a->subtype, actual_text
+			);
+			failures++;
+			break;
+		}
+	}
+	if (!e && (a = LXR_NextToken(actual)))
+	{
+		printf("FAIL: %s: expected the end after %d tokens, got %s\n", name, count, LXR_TokenTypeName(a->type));
+		failures++;
+	}
+
+	LXR_Destroy(expected);
+	LXR_Destroy(actual);
+}
+
+// Tests that the generated UDMF kernel (udmf_kernel.c) makes the same tokens as the same kernel built at runtime.
+// Lexes a built-in sample, every keyword in mixed case, and any files given as arguments (TEXTMAP lumps, for example).
+int main(int argc, char** argv)
+{
+	lexer_kernel_t *runtime = runtime_kernel();
+	lexer_kernel_t *generated = UDMF_CreateKernel();
+	char *buffer = (char*)malloc(4096);
+	char *p = buffer;
+	NAMEDTYPE *nt;
+	int i;
+
+	compare("sample", runtime, generated, 0, (unsigned char*)sample, strlen(sample));
+	compare("sample (zero-copy)", runtime, generated, 1, (unsigned char*)sample, strlen(sample));
+
+	for (nt = keywords; nt->name; nt++)
+	{
+		for (i = 0; nt->name[i]; i++)
+			*(p++) = i % 2 ? toupper(nt->name[i]) : nt->name[i];
+		p += sprintf(p, " %s_ %sx = 1;\n", nt->name, nt->name);
+	}
+	compare("keywords", runtime, generated, 0, (unsigned char*)buffer, p - buffer);
+	compare("keywords (zero-copy)", runtime, generated, 1, (unsigned char*)buffer, p - buffer);
+	free(buffer);
+
+	for (i = 1; i < argc; i++)
+	{
+		FILE *fp = fopen(argv[i], "rb");
+		long length;
+		if (!fp)
+		{
+			printf("ERROR: could not open %s\n", argv[i]);
+			failures++;
+			continue;
+		}
+		fseek(fp, 0, SEEK_END);
+		length = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+		buffer = (char*)malloc(length > 0 ? length : 1);
+		if (fread(buffer, 1, length, fp) == (size_t)length)
+		{
+			compare(argv[i], runtime, generated, 0, (unsigned char*)buffer, length);
+			compare(argv[i], runtime, generated, 1, (unsigned char*)buffer, length);
+		}
+		free(buffer);
+		fclose(fp);
+	}
+
+	LXRK_Destroy(runtime);
+	LXRK_Destroy(generated);
+
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parser/lexer.h"
+#include "parser/lexer_parallel.h"
+#include "map/udmf_kernel.h"
+
+#define THREADS 8
+#define BUFFER_COUNT 5
+
+char *buffer;
+size_t length = 0, capacity = 0;
+
+int failures = 0;
+
+void append(const char *text, size_t n)
+{
+	if (length + n > capacity)
+	{
+		capacity = (length + n) * 2;
+		buffer = (char*)realloc(buffer, capacity);
+	}
+	memcpy(buffer + length, text, n);
+	length += n;
+}
+
+void appends(const char *text)
+{
+	append(text, strlen(text));
+}
+
+// Adds "amount" lines of something that doesn't end on its own line: block comments, strings with
+// escaped line breaks, line comments that look like they start one, and so on.
+void generate(int amount)
+{
+	char line[128];
+	int i, j, n;
+	for (i = 0; i < amount; i++)
+	{
+		switch (rand() % 12)
+		{
+			case 0:
+				// block comment over many lines, with things that look like tokens in it.
+				n = 1 + rand() % 40;
+				appends("/* comment");
+				for (j = 0; j < n; j++)
+					appends(j % 3 ? "\nthing { x = \"1\"; } // still a comment" : "\r\n  /* not nested ");
+				appends(" */\n");
+				break;
+			case 1:
+				// string with escaped line breaks and quotes, and a comment start that isn't one
+				// (a chunk that starts in here reads it as a comment up to the next real one's end).
+				n = 1 + rand() % 20;
+				appends("comment = \"start");
+				for (j = 0; j < n; j++)
+					appends(j % 2 ? "\\\n/* not a comment \\\" " : "\\\r\n// not a comment ");
+				appends("end\";\n");
+				break;
+			case 2:
+				appends("// line comment with \"quote and /* start\n");
+				break;
+			case 3:
+				appends("\"unterminated string /* \n");
+				break;
+			case 4:
+				appends("@ $ # \x80\xff bad chars\n");
+				break;
+			case 5:
+				sprintf(line, "vertex { x = %d.%d; y = -0x%x; }\r\n", rand() % 10000, rand() % 100, rand() % 65536);
+				appends(line);
+				break;
+			default:
+				sprintf(line, "thing\n{\n\tx = %d;\n\ty = %de%d;\n\ttype = %d;\n\tskill1 = true;\n}\n", rand() - RAND_MAX / 2, rand() % 100, rand() % 5, rand() % 4000);
+				appends(line);
+				break;
+		}
+	}
+}
+
+// Lexes a buffer with one lexer, and checks that an array has the same tokens.
+void compare(char *name, lexer_kernel_t *kernel, const char *source, size_t n, lexer_token_array_t *array)
+{
+	char expected_text[LEXEME_LENGTH_MAX], actual_text[LEXEME_LENGTH_MAX];
+	lexer_t *lexer = LXR_Create(kernel);
+	lexer_token_t *e;
+	lexer_array_token_t *a;
+	int count = 0;
+
+	if (!array)
+	{
+		printf("FAIL: %s: no token array\n", name);
+		failures++;
+		return;
+	}
+
+	lexer->options.zero_copy = 1;
+	LXR_PushStreamBuffer(lexer, name, (unsigned char*)source, n);
+	while ((e = LXR_NextToken(lexer)))
+	{
+		LXR_GetTokenText(lexer, e, expected_text, sizeof(expected_text));
+		if (count >= array->count)
+		{
+			printf("FAIL: %s: token %d: expected line %d %s \"%s\", got the end\n", name, count, e->line_number, LXR_TokenTypeName(e->type), expected_text);
+			failures++;
+			break;
+		}
+		a = &(array->tokens[count++]);
+		LXR_GetArrayTokenText(kernel, a, actual_text, sizeof(actual_text));
+		if (e->type != a->type || e->subtype != a->subtype || e->line_number != a->line_number || e->offset != a->offset || strcmp(expected_text, actual_text))
+		{
+			printf("FAIL: %s: token %d: expected line %d offset %lu %s:%d \"%s\", got line %d offset %lu %s:%d \"%s\"\n", name, count - 1,
+				e->line_number, (unsigned long)e->offset, LXR_TokenTypeName(e->type), e->subtype, expected_text,
+				a->line_number, (unsigned long)a->offset, LXR_TokenTypeName(a->type), a->subtype, actual_text
+			);
+			failures++;
+			break;
+		}
+	}
+	if (!e && count < array->count)
+	{
+		printf("FAIL: %s: expected the end after %d tokens, got %d\n", name, count, array->count);
+		failures++;
+	}
+
+	LXR_Destroy(lexer);
+}
+
+// Tests that LXR_LexParallel() and LXR_LexBuffers() make the same tokens as LXR_NextToken(), on input where
+// comments and strings cross the chunk boundaries.
+int main(int argc, char** argv)
+{
+	lexer_kernel_t *kernel = UDMF_CreateKernel();
+	lexer_token_array_t *array, *arrays[BUFFER_COUNT];
+	const unsigned char *buffers[BUFFER_COUNT];
+	size_t lengths[BUFFER_COUNT], start;
+	char name[32];
+	int i, seed;
+
+	for (seed = 1; seed <= 4; seed++)
+	{
+		srand(seed);
+		length = 0;
+		generate(20000);
+		if (seed == 2)
+		{
+			// a comment bigger than a whole chunk.
+			appends("/*");
+			while (length < LEXEME_LENGTH_MAX + LEXER_PARALLEL_CHUNK_MIN * 3)
+				appends(" thing { x = 1; }\n");
+			appends("*/\n");
+			generate(5000);
+		}
+
+		sprintf(name, "parallel %d", seed);
+		array = LXR_LexParallel(kernel, (unsigned char*)buffer, length, THREADS);
+		compare(name, kernel, buffer, length, array);
+		if (array)
+			LXR_TokenArrayDestroy(array);
+	}
+
+	// the last input, cut into separate buffers at arbitrary points.
+	start = 0;
+	for (i = 0; i < BUFFER_COUNT; i++)
+	{
+		size_t end = i == BUFFER_COUNT - 1 ? length : length / BUFFER_COUNT * (i + 1) + rand() % 1000;
+		buffers[i] = (unsigned char*)buffer + start;
+		lengths[i] = end - start;
+		start = end;
+	}
+	if (LXR_LexBuffers(kernel, buffers, lengths, BUFFER_COUNT, arrays, THREADS))
+	{
+		printf("FAIL: buffers: not all lexed\n");
+		failures++;
+	}
+	for (i = 0; i < BUFFER_COUNT; i++)
+	{
+		sprintf(name, "buffer %d", i);
+		compare(name, kernel, (char*)buffers[i], lengths[i], arrays[i]);
+		if (arrays[i])
+			LXR_TokenArrayDestroy(arrays[i]);
+	}
+
+	free(buffer);
+	LXRK_Destroy(kernel);
+
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? 1 : 0;
+}
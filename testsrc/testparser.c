@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parser/parser.h"
+
+#define TOKEN_COUNT 2000
+
+int failures = 0;
+
+void check(int cond, const char *what)
+{
+	if (!cond)
+	{
+		printf("FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+// Tests token pointers across token buffer growth: Peek, Mark/Rewind, and plain Next.
+int main(int argc, char** argv)
+{
+	char *buffer = (char*)malloc(TOKEN_COUNT * 8);
+	char *p = buffer;
+	int i;
+	for (i = 0; i < TOKEN_COUNT; i++)
+		p += sprintf(p, "%d ", i);
+
+	lexer_kernel_t *kernel = LXRK_Create();
+	lexer_t *lexer = LXR_Create(kernel);
+	LXR_PushStreamBuffer(lexer, "numbers", (unsigned char*)buffer, p - buffer);
+	parser_t *parser = PARSER_Create(lexer);
+
+	// Peek far ahead while holding the current token.
+	lexer_token_t *first = PARSER_Next(parser);
+	lexer_token_t *ahead = PARSER_Peek(parser, 200);
+	check(ahead && ahead->integer == 200, "peek 200");
+	check(first->type == LXRT_NUMBER && first->integer == 0, "current token after peek");
+	check(PARSER_Current(parser) == first, "current token not moved by peek");
+
+	// Hold tokens across a mark while the buffer grows, then rewind.
+	int mark = PARSER_Mark(parser);
+	lexer_token_t *held[500];
+	for (i = 0; i < 500; i++)
+		held[i] = PARSER_Next(parser);
+	for (i = 0; i < 500; i++)
+		check(held[i] && held[i]->integer == i + 1, "token held across mark");
+	check(first->integer == 0, "marked token after 500 Next");
+
+	PARSER_Rewind(parser, mark);
+	check(PARSER_Current(parser) == first, "rewind to marked token");
+	for (i = 1; i <= 500; i++)
+		check(PARSER_Next(parser) == held[i - 1], "same tokens after rewind");
+
+	// Nested marks, released out to the end of input.
+	int outer = PARSER_Mark(parser);
+	PARSER_Mark(parser);
+	lexer_token_t *token;
+	long expected = 501;
+	while ((token = PARSER_Next(parser)))
+		check(token->integer == expected++, "token order to end");
+	check(expected == TOKEN_COUNT, "token count to end");
+	check(held[499]->integer == 500, "token held until marks are released");
+	PARSER_Release(parser, outer);
+
+	PARSER_Destroy(parser);
+	LXR_Destroy(lexer);
+	LXRK_Destroy(kernel);
+	free(buffer);
+
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? 1 : 0;
+}